@@ -0,0 +1,22 @@
+# Build the bicycle model sources for the host. These are the same sources used
+# by the firmware (BICYCLE_SOURCE in the top-level CMakeLists.txt).
+#
+# This file is included by the host projects (tests, tools) which are
+# configured separately from the firmware and defines BICYCLE_SOURCE_DIR,
+# BICYCLE_SOURCE and the static library target bicycle.
+set(BICYCLE_SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR}/../external/bicycle/src)
+set(BICYCLE_SOURCE
+    ${BICYCLE_SOURCE_DIR}/bicycle/bicycle.cc
+    ${BICYCLE_SOURCE_DIR}/bicycle/bicycle_solve_constraint_pitch.cc
+    ${BICYCLE_SOURCE_DIR}/bicycle/kinematic.cc
+    ${BICYCLE_SOURCE_DIR}/bicycle/whipple.cc
+    ${BICYCLE_SOURCE_DIR}/parameters.cc)
+find_package(Boost REQUIRED)
+add_library(bicycle STATIC ${BICYCLE_SOURCE})
+target_include_directories(bicycle SYSTEM PUBLIC
+    ${BICYCLE_SOURCE_DIR}
+    ${BICYCLE_SOURCE_DIR}/../inc
+    ${CMAKE_CURRENT_LIST_DIR}/../external/bicycle/external/eigen
+    ${Boost_INCLUDE_DIRS})
+target_compile_definitions(bicycle PUBLIC BICYCLE_USE_DOUBLE_PRECISION_REAL=false)
+target_compile_options(bicycle PRIVATE -Wno-unused-parameter)
@@ -19,6 +19,7 @@
 #include "hal.h"
 
 #include "blink.h"
+#include "periodictask.h"
 #include "usbconfig.h"
 #include "printf.h"
 
@@ -33,7 +34,20 @@ namespace {
                 0.2f, 0.1f, 0.09f, 0.08f,
                 0.07f, 0.06f, 0.05f, 0.04f).finished());
 
-    const systime_t loop_time = MS2ST(1); // loop at 1 kHz
+    /*
+     * If a deadline is missed, wait until the button is pressed before
+     * continuing. The loop restarts at the time of the button press.
+     */
+    void wait_for_button(const rt::PeriodicTask& task) {
+        printf("loop time was: %d us\r\n", RTC2US(STM32_SYSCLK, task.execution_time().last));
+        printf("Press button to continue.\r\n");
+        while (palReadLine(LINE_BUTTON)) { /* Button is active LOW. */
+            chThdSleepMilliseconds(10);
+        }
+    }
+
+    rt::PeriodicTask matrix_task({"matrix", MS2ST(1), // loop at 1 kHz
+            rt::miss_policy_t::log, wait_for_button});
 } // namespace
 
 /*
@@ -77,14 +91,9 @@ int main(void) {
      */
     uint32_t i = 0;
     matrix_t B = matrix_t::Identity();
-    rtcnt_t start = 0;
-    rtcnt_t dt = 0;
-    systime_t deadline = chVTGetSystemTimeX();
 
+    matrix_task.start();
     while (true) {
-        // Use RTC directly due to a bug in last time computation in TM module.
-        start = chSysGetRealtimeCounterX(); // measure computation/transmit time
-        deadline += loop_time; // next deadline
         B = A * B;
 
         /*
@@ -104,7 +113,8 @@ int main(void) {
          * Transmit loop time and matrix values.
          */
         if (SDU1.config->usbp->state == USB_ACTIVE || SDU1.state == SDU_READY) {
-            printf("iteration %d: %d us\r\n", ++i, RTC2US(STM32_SYSCLK, dt));
+            printf("iteration %d: %d us\r\n", ++i,
+                    RTC2US(STM32_SYSCLK, matrix_task.execution_time().last));
             real_t* data = B.data();
             for (int i = 0; i < B.size(); ++i) {
                 printf("%0.2f", *data++);
@@ -116,31 +126,6 @@ int main(void) {
             }
             printf("\r\n");
         }
-        dt = chSysGetRealtimeCounterX() - start;
-
-        /*
-         * Sleep thread until next deadline if it hasn't already been missed.
-         */
-        bool miss = false;
-        chSysLock();
-        systime_t sleep_time = deadline - chVTGetSystemTimeX();
-        if ((sleep_time > (systime_t)0) and (sleep_time < loop_time)) {
-            chThdSleepS(sleep_time);
-        } else {
-            miss = true;
-        }
-        chSysUnlock();
-
-        /*
-         * If deadline missed, wait until button is pressed before continuing.
-         */
-        if (miss) {
-            printf("loop time was: %d us\r\n", RTC2US(STM32_SYSCLK, dt));
-            printf("Press button to continue.\r\n");
-            while (palReadLine(LINE_BUTTON)) { /* Button is active LOW. */
-                chThdSleepMilliseconds(10);
-            }
-            deadline = chVTGetSystemTimeX();
-        }
+        matrix_task.wait_for_next_release();
     }
 }
@@ -4,8 +4,16 @@
 
 class Analog {
     public:
+        /*
+         * Called from the ADC interrupt with the system locked after each
+         * conversion of the sample buffer, only I-class functions may be
+         * used. A conversion callback enables the conversion events.
+         */
+        using conversion_callback_t = void (*)(void);
+
         Analog();
-        void start(gptcnt_t sample_rate, bool use_events=false);
+        void start(gptcnt_t sample_rate, bool use_events=false,
+                conversion_callback_t conversion_callback=nullptr);
         void stop();
         adcsample_t get_adc10() const;
         adcsample_t get_adc11() const;
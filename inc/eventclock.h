@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/*
+ * Clock advanced by a periodic hardware event, e.g. the completion of ADC
+ * conversions triggered by a timer, instead of the system tick. Each event
+ * advances the time by a fixed number of ticks, so that time values are in
+ * the same unit as the system time and can be used with the release time
+ * calculation of schedule.h. A task released by this clock is phase-locked
+ * to the events if its period is a multiple of the ticks per event.
+ *
+ * A single wakeup time can be set. tick() returns true for the event at which
+ * the wakeup time is reached, the waiting thread is then resumed by the
+ * caller. This class has no hardware dependencies, see periodictask.h for the
+ * firmware release clock.
+ *
+ * Time values are wrapping unsigned counters, e.g. systime_t, and a time is
+ * reached if it is not more than half the counter range in the future.
+ */
+namespace rt {
+
+template <typename T>
+class EventClock {
+    static_assert(std::is_unsigned<T>::value, "T must be an unsigned integer type");
+
+    public:
+        explicit EventClock(T ticks_per_event, T time = 0) :
+            m_time(time),
+            m_ticks_per_event(ticks_per_event),
+            m_wakeup_time(0),
+            m_wakeup_pending(false) { }
+
+        // Advance the clock by an event. Returns true if the wakeup time has
+        // been reached, the wakeup is then cleared.
+        bool tick() {
+            m_time = static_cast<T>(m_time + m_ticks_per_event);
+            if (m_wakeup_pending && reached(m_wakeup_time)) {
+                m_wakeup_pending = false;
+                return true;
+            }
+            return false;
+        }
+
+        // Set the wakeup time. Returns false, and no wakeup is set, if the
+        // time has already been reached.
+        bool set_wakeup(T time) {
+            m_wakeup_pending = !reached(time);
+            m_wakeup_time = time;
+            return m_wakeup_pending;
+        }
+
+        void clear_wakeup() {
+            m_wakeup_pending = false;
+        }
+
+        // Set the time, e.g. to continue after missing events. The wakeup is
+        // cleared.
+        void set_time(T time) {
+            m_time = time;
+            m_wakeup_pending = false;
+        }
+
+        bool reached(T time) const {
+            return static_cast<T>(m_time - time) <= std::numeric_limits<T>::max()/2;
+        }
+
+        bool wakeup_pending() const {
+            return m_wakeup_pending;
+        }
+
+        T wakeup_time() const {
+            return m_wakeup_time;
+        }
+
+        T time() const {
+            return m_time;
+        }
+
+        T ticks_per_event() const {
+            return m_ticks_per_event;
+        }
+
+    private:
+        T m_time;
+        T m_ticks_per_event;
+        T m_wakeup_time;
+        bool m_wakeup_pending;
+};
+
+// Number of events per period, zero if the period is not a multiple of the
+// event interval and a task with this period cannot be phase-locked.
+template <typename T>
+constexpr T events_per_period(T period, T ticks_per_event) {
+    return ((ticks_per_event == 0) || (period % ticks_per_event != 0)) ?
+        0 : period/ticks_per_event;
+}
+
+} // namespace rt
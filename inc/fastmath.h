@@ -0,0 +1,170 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+/*
+ * Angle wrapping and trigonometric functions for single precision floats
+ * without calls to libm on the fast path. These are used in the dynamics and
+ * kinematics loops, where std::fmod, std::sin and std::cos are software
+ * implementations with data dependent run time on the Cortex-M4.
+ *
+ * Arguments are reduced with a three part (Cody-Waite) constant so that the
+ * product of the quotient and the leading part is exact for |x| <= max_fast_angle.
+ * Larger arguments take a libm path which is not expected to be used by the
+ * firmware. Conditional expressions select between results and map to
+ * conditional moves instead of branches.
+ *
+ * Maximum absolute errors with respect to the exact result of the float
+ * arguments, as verified by tests/test_fastmath.cc with all floats in the
+ * given range (for atan2 all y with an x of each sign and magnitude):
+ *  wrap:   3.0e-7 rad (1.25 ulp of pi), for |angle| <= max_fast_angle
+ *          1.2e-7 rad (libm path), for max_fast_angle < |angle| <= 2^24
+ *  sin:    8.0e-8
+ *  cos:    8.0e-8
+ *  atan2:  3.5e-7 rad (1.5 ulp of pi)
+ *
+ * The double precision overloads forward to libm so that code templated on
+ * the scalar type can use these functions.
+ */
+namespace util {
+namespace fastmath {
+namespace detail {
+    constexpr float pi = 3.14159265358979323846f;
+    constexpr float two_pi = 6.28318530717958647692f;
+    constexpr float half_pi = 1.57079632679489661923f;
+    constexpr float inv_two_pi = 0.159154943091895335769f;
+    constexpr float two_over_pi = 0.636619772367581343076f;
+
+    // rounding errors of pi and half_pi
+    constexpr float pi_lo = -8.74227801e-8f;
+    constexpr float half_pi_lo = -4.37113901e-8f;
+
+    // two_pi = two_pi_1 + two_pi_2 + two_pi_3 where the leading parts have
+    // few significant bits
+    constexpr float two_pi_1 = 6.28125f;
+    constexpr float two_pi_2 = 1.93500518798828125e-3f;
+    constexpr float two_pi_3 = 3.01991598195675286e-7f;
+
+    // half_pi = half_pi_1 + half_pi_2 + half_pi_3
+    constexpr float half_pi_1 = 1.5703125f;
+    constexpr float half_pi_2 = 4.837512969970703125e-4f;
+    constexpr float half_pi_3 = 7.54978995489188216e-8f;
+
+    // round to nearest, halfway cases away from zero
+    inline int32_t round_to_int(float x) {
+        return static_cast<int32_t>(x + std::copysign(0.5f, x));
+    }
+
+    // minimax polynomials on [-pi/4, pi/4]
+    inline float sin_kernel(float r, float z) {
+        return ((-1.9515295891e-4f*z + 8.3321608736e-3f)*z - 1.6666654611e-1f)*z*r + r;
+    }
+
+    inline float cos_kernel(float z) {
+        return ((2.443315711809948e-5f*z - 1.388731625493765e-3f)*z +
+                4.166664568298827e-2f)*z*z - 0.5f*z + 1.0f;
+    }
+
+    // minimax polynomial for atan(t) on [0, 1]
+    inline float atan_kernel(float t) {
+        const float z = t*t;
+        float p = 2.82363896258175373077393e-3f;
+        p = p*z - 1.59569028764963150024414e-2f;
+        p = p*z + 4.25049886107444763183594e-2f;
+        p = p*z - 7.48900920152664184570312e-2f;
+        p = p*z + 1.06347933411598205566406e-1f;
+        p = p*z - 1.42027363181114196777344e-1f;
+        p = p*z + 1.99926957488059997558594e-1f;
+        p = p*z - 3.33331018686294555664062e-1f;
+        return t + t*z*p;
+    }
+} // namespace detail
+
+constexpr float max_fast_angle = 8192.0f;
+
+/*
+ * Wrap an angle to [-pi, pi), where pi is the float nearest to pi.
+ */
+inline float wrap(float angle) {
+    float r;
+    if (std::abs(angle) <= max_fast_angle) {
+        const float k = static_cast<float>(detail::round_to_int(angle*detail::inv_two_pi));
+        r = ((angle - k*detail::two_pi_1) - k*detail::two_pi_2) - k*detail::two_pi_3;
+    } else {
+        r = static_cast<float>(std::remainder(static_cast<double>(angle), 6.28318530717958647692));
+    }
+    r = (r >= detail::pi) ? r - detail::two_pi : r;
+    return (r < -detail::pi) ? r + detail::two_pi : r;
+}
+
+inline double wrap(double angle) {
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double two_pi = 6.28318530717958647692;
+    angle = std::remainder(angle, two_pi);
+    angle = (angle >= pi) ? angle - two_pi : angle;
+    return (angle < -pi) ? angle + two_pi : angle;
+}
+
+/*
+ * Compute the sine and cosine of an angle with a single argument reduction.
+ */
+inline void sincos(float x, float* s, float* c) {
+    if (!(std::abs(x) <= max_fast_angle)) {
+        *s = std::sin(x);
+        *c = std::cos(x);
+        return;
+    }
+    const int32_t k = detail::round_to_int(x*detail::two_over_pi);
+    const float kf = static_cast<float>(k);
+    const float r = ((x - kf*detail::half_pi_1) - kf*detail::half_pi_2) - kf*detail::half_pi_3;
+    const float z = r*r;
+    const float sr = detail::sin_kernel(r, z);
+    const float cr = detail::cos_kernel(z);
+
+    // quadrant k mod 4
+    const float sq = (k & 1) ? cr : sr;
+    const float cq = (k & 1) ? sr : cr;
+    *s = (k & 2) ? -sq : sq;
+    *c = ((k + 1) & 2) ? -cq : cq;
+}
+
+inline void sincos(double x, double* s, double* c) {
+    *s = std::sin(x);
+    *c = std::cos(x);
+}
+
+template <typename T>
+T sin(T x) {
+    T s, c;
+    sincos(x, &s, &c);
+    return s;
+}
+
+template <typename T>
+T cos(T x) {
+    T s, c;
+    sincos(x, &s, &c);
+    return c;
+}
+
+/*
+ * Compute the angle of (x, y) in [-pi, pi]. Unlike std::atan2, infinite
+ * arguments are not supported and atan2(+-0, +-0) is +-0.
+ */
+inline float atan2(float y, float x) {
+    const float ax = std::abs(x);
+    const float ay = std::abs(y);
+    const float lo = (ay < ax) ? ay : ax;
+    const float hi = (ay < ax) ? ax : ay;
+    const float t = (hi > 0.0f) ? lo/hi : 0.0f;
+    float a = detail::atan_kernel(t);
+    a = (ay > ax) ? (detail::half_pi - a) + detail::half_pi_lo : a;
+    a = (x < 0.0f) ? (detail::pi - a) + detail::pi_lo : a;
+    return std::copysign(a, y);
+}
+
+inline double atan2(double y, double x) {
+    return std::atan2(y, x);
+}
+} // namespace fastmath
+} // namespace util
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/*
+ * Q31 fixed-point arithmetic with saturation.
+ *
+ * A Q31 value q with exponent e represents the real value q*2^(e - 31) and
+ * has the range [-2^e, 2^e). The exponent is not stored and must be tracked
+ * by the user.
+ *
+ * On Cortex-M4 (__ARM_FEATURE_DSP), saturating addition and subtraction use
+ * the QADD and QSUB instructions. Products are accumulated in 64 bits, which
+ * the compiler maps to SMLAL.
+ */
+namespace util {
+
+using q31_t = int32_t;
+
+constexpr q31_t q31_max = std::numeric_limits<q31_t>::max();
+constexpr q31_t q31_min = std::numeric_limits<q31_t>::min();
+
+// 2^k, exact for the range of float exponents
+constexpr float pow2(int k) {
+    return (k == 0) ? 1.0f : ((k > 0) ? 2.0f*pow2(k - 1) : 0.5f*pow2(k + 1));
+}
+
+// scale factor from real value to Q31 value with exponent e
+constexpr float q31_scale(int exponent) {
+    return pow2(31 - exponent);
+}
+
+inline q31_t saturate_q31(int64_t value) {
+    if (value > q31_max) {
+        return q31_max;
+    }
+    if (value < q31_min) {
+        return q31_min;
+    }
+    return static_cast<q31_t>(value);
+}
+
+// convert a real value, multiplied by q31_scale(e), to Q31 with saturation
+inline q31_t to_q31_scaled(float scaled_value) {
+    // 2^31 is exactly representable as float while q31_max is not
+    static constexpr float limit = 2147483648.0f;
+    if (scaled_value >= limit) {
+        return q31_max;
+    }
+    if (scaled_value < -limit) {
+        return q31_min;
+    }
+    if (!(scaled_value == scaled_value)) {
+        return 0; // NaN
+    }
+    return static_cast<q31_t>(scaled_value);
+}
+
+inline q31_t to_q31(float value, int exponent) {
+    return to_q31_scaled(value*q31_scale(exponent));
+}
+
+inline float from_q31(q31_t value, int exponent) {
+    return static_cast<float>(value)*pow2(exponent - 31);
+}
+
+inline q31_t add_q31(q31_t a, q31_t b) {
+#if defined(__ARM_FEATURE_DSP)
+    q31_t result;
+    asm ("qadd %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+#else
+    return saturate_q31(static_cast<int64_t>(a) + b);
+#endif
+}
+
+inline q31_t sub_q31(q31_t a, q31_t b) {
+#if defined(__ARM_FEATURE_DSP)
+    q31_t result;
+    asm ("qsub %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+#else
+    return saturate_q31(static_cast<int64_t>(a) - b);
+#endif
+}
+
+/*
+ * Compute y = saturate(round(A x / 2^shift)) for an R x C row-major matrix A.
+ * If A has exponent e_A, x has exponent e_x and shift is 31 - e_A, y has
+ * exponent e_x. The 64-bit accumulator cannot overflow if the absolute row
+ * sums of A, as Q31 values, are less than 2^31.
+ */
+template <size_t R, size_t C>
+void multiply_q31(const q31_t* A, const q31_t* x, unsigned int shift, q31_t* y) {
+    const int64_t half = (shift > 0) ? (int64_t(1) << (shift - 1)) : 0;
+    for (size_t i = 0; i < R; ++i) {
+        int64_t acc = half;
+        for (size_t j = 0; j < C; ++j) {
+            acc += static_cast<int64_t>(A[i*C + j])*x[j];
+        }
+        y[i] = saturate_q31(acc >> shift);
+    }
+}
+
+} // namespace util
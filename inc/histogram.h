@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+/*
+ * Histogram of N fixed-width buckets. Bucket i counts values in
+ * [i*bucket_width, (i + 1)*bucket_width) and the last bucket counts all values
+ * from (N - 1)*bucket_width. The maximum value is recorded exactly.
+ *
+ * Values are accumulated without allocation and counts saturate. This class
+ * is not synchronized, values must be added and read by the same thread or
+ * by threads that do not preempt each other.
+ */
+template <size_t N>
+class Histogram {
+    public:
+        explicit Histogram(uint32_t bucket_width);
+        void add(uint32_t value);
+        void reset();
+
+        uint32_t bucket_width() const;
+        const std::array<uint32_t, N>& counts() const;
+        uint32_t total() const; // number of added values, saturates
+        uint32_t max() const;
+
+    private:
+        std::array<uint32_t, N> m_counts;
+        uint32_t m_bucket_width;
+        uint32_t m_total;
+        uint32_t m_max;
+};
+
+/*
+ * Upper bound of the q-quantile (0 < q <= 1) of a histogram of n buckets: the
+ * largest value of the bucket that contains the q-quantile, limited to the
+ * maximum value. Returns 0 for an empty histogram.
+ */
+uint32_t histogram_quantile(const uint32_t* counts, size_t n, uint32_t bucket_width,
+        uint32_t max, double q);
+
+template <size_t N>
+uint32_t histogram_quantile(const Histogram<N>& histogram, double q) {
+    return histogram_quantile(histogram.counts().data(), N, histogram.bucket_width(),
+            histogram.max(), q);
+}
+
+} // namespace util
+
+#include "histogram.hh"
@@ -0,0 +1,129 @@
+#pragma once
+#include "ch.h"
+#include "hal.h"
+#include "eventclock.h"
+#include "histogram.h"
+#include "schedule.h"
+#include <cstddef>
+
+namespace rt {
+
+/*
+ * Release clock of periodic tasks driven by a hardware event, see
+ * eventclock.h. eventI() is called from the interrupt of the event, e.g. the
+ * ADC conversion complete callback, with the system locked. A task using this
+ * clock is released directly from the interrupt, in phase with the event.
+ *
+ * If no event occurs before the wakeup time plus one event interval, e.g.
+ * after an ADC error, the waiting thread is resumed by the system tick and
+ * the clock continues from the wakeup time.
+ */
+class EventReleaseClock {
+    public:
+        explicit EventReleaseClock(systime_t ticks_per_event);
+        void eventI();
+        systime_t nowX() const; // must be called with the system locked
+        void sleep_untilS(systime_t time); // a single thread may wait
+        systime_t ticks_per_event() const;
+        uint32_t timeouts() const; // number of wakeups by the system tick
+
+    private:
+        EventClock<systime_t> m_clock;
+        thread_reference_t m_thread;
+        uint32_t m_timeouts;
+};
+
+/*
+ * This class implements a periodic task with a declared period and deadline
+ * miss policy (see schedule.h). It does not own a thread. The thread that
+ * runs the task loop calls start() once and wait_for_next_release() at the
+ * end of each job:
+ *
+ *     task.start();
+ *     while (true) {
+ *         ...
+ *         task.wait_for_next_release();
+ *     }
+ *
+ * The priorities of the tasks of a project are assigned by rate with
+ * assign_priorities() before the task threads are created, and start() sets
+ * the priority of the calling thread.
+ *
+ * The execution time of each job is measured from the release (or from the
+ * call to start()) to the call to wait_for_next_release(), including the
+ * time the task is preempted. The worst measured execution time is the WCET
+ * used for the schedulability check of timing().
+ *
+ * The start jitter, the deviation of the interval between successive job
+ * starts from the period, and the execution time of each job are accumulated
+ * in histograms in microseconds. Jitter buckets are 0.1% of the period, at
+ * least 1 us, and execution time buckets are sized such that the last bucket
+ * counts the jobs that executed for a period or longer.
+ *
+ * If a miss callback is set, it is called in the task thread after a job has
+ * missed its deadline and before the next release time is determined.
+ *
+ * By default the task is released by the system tick. If a release clock is
+ * set, the task is released by its events and start() waits for the next
+ * event so that the first release is in phase. The period must be a multiple
+ * of the event interval.
+ */
+class PeriodicTask {
+    public:
+        using miss_callback_t = void (*)(const PeriodicTask& task);
+        static constexpr size_t histogram_size = 16;
+        using histogram_t = util::Histogram<histogram_size>;
+        struct config_t {
+            const char* name; // thread name
+            systime_t period; // system ticks
+            miss_policy_t miss_policy;
+            miss_callback_t miss_callback; // may be nullptr
+        };
+
+        explicit PeriodicTask(const config_t& config);
+        void set_release_clock(EventReleaseClock* clock); // must be called before start()
+        void start(); // must be called by the task thread before the first job
+        void wait_for_next_release();
+
+        const char* name() const;
+        systime_t period() const;
+        tprio_t priority() const;
+        systime_t release_time() const; // release time of the current job
+        uint32_t releases() const;
+        uint32_t deadline_misses() const;
+        uint32_t skipped_releases() const;
+        systime_t last_lateness() const; // completion time after the deadline of the last missed job
+        const time_measurement_t& execution_time() const; // realtime counter cycles
+        task_timing_t timing() const; // period and measured WCET in microseconds
+        const histogram_t& start_jitter() const; // microseconds
+        const histogram_t& execution_time_histogram() const; // microseconds
+
+    private:
+        config_t m_config;
+        tprio_t m_priority;
+        systime_t m_release_time;
+        uint32_t m_releases;
+        uint32_t m_deadline_misses;
+        uint32_t m_skipped_releases;
+        systime_t m_last_lateness;
+        time_measurement_t m_execution_time;
+        EventReleaseClock* m_clock;
+        rtcnt_t m_start_count; // realtime counter at the start of the current job
+        histogram_t m_start_jitter;
+        histogram_t m_execution_time_histogram;
+
+        systime_t nowX() const;
+
+        friend void assign_priorities(PeriodicTask* const* tasks, size_t n, tprio_t highest_priority);
+};
+
+// Assign rate-monotonic priorities, the task with the shortest period is
+// assigned highest_priority and each following task a priority one lower.
+void assign_priorities(PeriodicTask* const* tasks, size_t n, tprio_t highest_priority);
+
+template <size_t N>
+void assign_priorities(PeriodicTask* const (&tasks)[N], tprio_t highest_priority) {
+    assign_priorities(tasks, N, highest_priority);
+}
+
+} // namespace rt
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/*
+ * Release time calculation and offline schedulability analysis of periodic
+ * tasks with rate-monotonic priorities. These functions have no hardware
+ * dependencies and are also used by host tools, see periodictask.h for the
+ * firmware task executive.
+ *
+ * The deadline of a job is the next release of the task (implicit deadline).
+ */
+namespace rt {
+
+/*
+ * Action after a job has completed after its deadline:
+ *  skip      the releases that have passed are dropped and the task waits
+ *            for the next release on the original release grid,
+ *  catch_up  the missed releases are run back to back, without sleeping,
+ *            until the task is back on the original release grid,
+ *  log       the miss is recorded and the release grid restarts at the
+ *            completion time.
+ */
+enum class miss_policy_t: uint8_t {
+    skip,
+    catch_up,
+    log
+};
+
+template <typename T>
+struct release_t {
+    T time; // next release time
+    uint32_t skipped; // number of dropped releases
+    bool sleep; // next release time is in the future
+};
+
+// A job released at release_time has missed its deadline at time now. Time
+// values are wrapping unsigned counters, e.g. systime_t.
+template <typename T>
+bool deadline_missed(T release_time, T period, T now) {
+    static_assert(std::is_unsigned<T>::value, "T must be an unsigned integer type");
+    return static_cast<T>(now - release_time) >= period;
+}
+
+// Next release time of a task at time now, after the job released at
+// release_time has completed.
+template <typename T>
+release_t<T> next_release(miss_policy_t policy, T release_time, T period, T now) {
+    static_assert(std::is_unsigned<T>::value, "T must be an unsigned integer type");
+    const T elapsed = static_cast<T>(now - release_time);
+    if (elapsed < period) {
+        return release_t<T>{static_cast<T>(release_time + period), 0, true};
+    }
+    switch (policy) {
+        case miss_policy_t::skip: {
+            const T passed = elapsed/period;
+            return release_t<T>{static_cast<T>(release_time + (passed + 1)*period),
+                static_cast<uint32_t>(passed), true};
+        }
+        case miss_policy_t::catch_up:
+            return release_t<T>{static_cast<T>(release_time + period), 0, false};
+        case miss_policy_t::log:
+        default:
+            return release_t<T>{now, 0, false};
+    }
+}
+
+/*
+ * Period and worst-case execution time (WCET) of a task in a common time
+ * unit, e.g. microseconds.
+ */
+struct task_timing_t {
+    const char* name;
+    uint32_t period;
+    uint32_t wcet;
+};
+
+// Rate-monotonic priority rank of task i of n tasks, 0 is the highest
+// priority. Tasks with equal periods are ranked in declaration order.
+// period(j) returns the period of task j.
+template <typename F>
+size_t rank_by_period(F period, size_t n, size_t i) {
+    size_t rank = 0;
+    for (size_t j = 0; j < n; ++j) {
+        if ((period(j) < period(i)) || ((period(j) == period(i)) && (j < i))) {
+            ++rank;
+        }
+    }
+    return rank;
+}
+
+size_t rate_monotonic_rank(const task_timing_t* tasks, size_t n, size_t i);
+
+// total processor utilization, the sum of wcet/period
+double utilization(const task_timing_t* tasks, size_t n);
+
+// Liu and Layland utilization bound n*(2^(1/n) - 1). A task set with a
+// utilization at or below the bound is schedulable.
+double utilization_bound(size_t n);
+
+/*
+ * Calculate the worst-case response time of each task with exact response
+ * time analysis for rate-monotonic priorities:
+ *
+ *   R_i = C_i + sum_{j in hp(i)} ceil(R_i/T_j)*C_j
+ *
+ * where hp(i) are the tasks with a higher priority than task i. The
+ * response time of a task that does not meet its deadline is set to a value
+ * larger than its period. Returns true if all tasks meet their deadlines.
+ */
+bool response_times(const task_timing_t* tasks, size_t n, uint32_t* response_time);
+
+} // namespace rt
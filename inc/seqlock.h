@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/*
+ * This class implements a sequence lock (seqlock) for sharing a value between
+ * a single writer and any number of readers without blocking the writer.
+ *
+ * The writer increments a sequence counter before and after modifying the
+ * stored value. The counter is odd while a write is in progress. A reader
+ * copies the value and retries if the counter was odd or changed during the
+ * copy, so a torn value is never returned.
+ *
+ * Note: On a single core, read() must not be called from a thread with a
+ * higher priority than the writer as the reader may preempt the writer
+ * during a write and spin indefinitely. Such a thread must use try_read().
+ *
+ * In this implementation:
+ *  T is the value type and must be copy assignable
+ */
+template <typename T>
+class Seqlock {
+    public:
+        Seqlock();
+        explicit Seqlock(const T& value);
+        void write(const T& value); // must only be called by a single writer
+        T read() const; // retry until a consistent value is copied
+        bool try_read(T& value) const; // single attempt, value is unchanged on failure
+        uint32_t sequence() const;
+
+    private:
+        std::atomic<uint32_t> m_sequence; /* odd while a write is in progress */
+        T m_value;
+};
+
+#include "seqlock.hh"
@@ -22,6 +22,7 @@
 #include "encoderfoaw.h"
 
 #include "gitsha1.h"
+#include "periodictask.h"
 #include "filesystem.h"
 #include "saconfig.h"
 #include "utility.h"
@@ -53,6 +54,9 @@ namespace {
 
     std::array<uint8_t, SimulationMessage_size> encode_buffer;
 
+    // simulation loop at 200 Hz
+    rt::PeriodicTask simulation_task({"simulation", MS2ST(5), rt::miss_policy_t::skip, nullptr});
+
     dacsample_t set_handlebar_velocity(float velocity) {
         // limit velocity to a maximum magnitude of 100 deg/s
         // input is in units of rad/s
@@ -109,7 +113,8 @@ int main(void) {
     palSetLineMode(LINE_KOLLM_ACTL_TORQUE, PAL_MODE_INPUT_ANALOG);
     dacStart(sa::KOLLM_DAC, sa::KOLLM_DAC_CFG);
 
-    bicycle_t bicycle(5.0f, 1.0f/200); /* (v [m/s], dt [s]) */
+    bicycle_t bicycle(5.0f, /* (v [m/s], dt [s]) */
+            static_cast<float>(simulation_task.period())/CH_CFG_ST_FREQUENCY);
 
     // FIXME: initialize Kalman matrices here
 
@@ -122,11 +127,12 @@ int main(void) {
 
     /*
      * Normal main() thread activity, in this demo it simulates the bicycle
-     * dynamics in real-time (roughly).
+     * dynamics in real-time. SD card events are polled once per iteration.
      */
     bool delete_file = true;
+    simulation_task.start();
     while (true) {
-        chEvtDispatch(filesystem::sdc_eventhandlers, chEvtWaitOneTimeout(ALL_EVENTS, MS2ST(5)));
+        chEvtDispatch(filesystem::sdc_eventhandlers, chEvtWaitOneTimeout(ALL_EVENTS, TIME_IMMEDIATE));
 
         // TODO: write to file in a separate thread
         if (filesystem::ready()) {
@@ -155,6 +161,7 @@ int main(void) {
             res = f_close(&f);
             chDbgAssert(res == FR_OK, "file close failed");
         } else {
+            simulation_task.wait_for_next_release();
             continue;
         }
 
@@ -189,7 +196,6 @@ int main(void) {
                 encoder_steer.count(), encoder_rear_wheel.count());
         message::set_simulation_actuators(&sample, handlebar_velocity_dac);
 
-        // TODO: fix sleep amount
-        chThdSleepMilliseconds(static_cast<systime_t>(1000*bicycle.dt()));
+        simulation_task.wait_for_next_release();
     }
 }
@@ -22,6 +22,7 @@
 
 #include "gitsha1.h"
 #include "blink.h"
+#include "periodictask.h"
 #include "usbconfig.h"
 #include "saconfig.h"
 #include "utility.h"
@@ -29,7 +30,7 @@
 #include "parameters.h"
 
 namespace {
-    const float dt = 0.05f; /* ms */
+    rt::PeriodicTask print_task({"print", MS2ST(50), rt::miss_policy_t::skip, nullptr});
 
     /* sensors */
     Analog analog;
@@ -108,6 +109,7 @@ int main(void) {
      * Normal main() thread activity, in this demo it simulates the bicycle
      * dynamics in real-time (roughly).
      */
+    print_task.start();
     while (true) {
         /* get sensor measurements */
         const float steer_torque = static_cast<float>(analog.get_adc12()*2.0f*sa::MAX_KISTLER_TORQUE/4096 -
@@ -122,7 +124,7 @@ int main(void) {
         const float forward_velocity = sa::REAR_WHEEL_RADIUS*(util::encoder_rate(encoder_roller))*sa::ROLLER_TO_REAR_WHEEL_RATIO;
 
         /* generate an example torque output for testing */
-        float feedback_torque = 10.0f * std::sin(
+        float feedback_torque = 10.0f * util::fastmath::sin(
                 constants::two_pi * ST2S(static_cast<float>(chVTGetSystemTime())));
         dacsample_t aout = static_cast<dacsample_t>(
                 (feedback_torque/21.0f * 2048) + 2048); /* reduce output to half of full range */
@@ -132,6 +134,6 @@ int main(void) {
                 g_GITSHA1, steer_torque, motor_torque, steer_rate);
         printf("steer angle: %8.3f rad\trear wheel angle: %8.3f rad\tforward velocity: %8.3f m/s\r\n",
                 steer_angle, roller_angle, forward_velocity);
-        chThdSleepMilliseconds(static_cast<systime_t>(1000*dt));
+        print_task.wait_for_next_release();
     }
 }
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cmath>
+#include <cstdint>
+
+/*
+ * Flimnap dynamics loop parameters that do not depend on the kernel. These
+ * are shared with the host replay tool (tools/sim/replay.cc).
+ */
+namespace flimnap {
+
+// system tick frequency, must be equal to CH_CFG_ST_FREQUENCY in chconf.h
+constexpr uint32_t system_tick_frequency = 100000; // Hz
+
+constexpr uint32_t dynamics_loop_period_ms = 1; // 1 kHz
+
+// ADC conversions are triggered by timer GPT8 at this frequency.
+constexpr uint32_t adc_sample_frequency = 10000; // Hz
+
+// Release the dynamics loop from the ADC conversion complete interrupt
+// instead of the system tick. GPT8 and the system tick are derived from the
+// same clock, so the loop is phase-locked to the sensor sampling and reads
+// the ADC samples directly after conversion. If false, the samples are read
+// at an arbitrary phase relative to the conversions.
+constexpr bool dynamics_loop_adc_release = true;
+
+// Bicycle models are cached for each quantized speed from 0 m/s to 6 m/s.
+constexpr size_t model_cache_size = 61;
+
+// Kalman filter error covariance propagation period after a model speed
+// change, before the steady-state gain is used
+constexpr uint32_t kalman_settle_period_ms = 20;
+
+// Kalman filter noise covariances relative to the default values of the
+// bicycle submodule (parameters::defaultvalue::kalman). Measurement noise
+// scale factors are ordered as the model output (yaw angle, steer angle).
+// These can be tuned with recorded runs using tools/sim/kalmantune.
+constexpr float kalman_process_noise_scale = 1.0f;
+constexpr float kalman_measurement_noise_scale[] = {1.0f/1000, 1.0f/1000};
+
+// Integrate the auxiliary states (x, y, rear wheel angle) in the pose thread
+// from a history of dynamic states instead of in every dynamics loop
+// iteration, see sim::Bicycle::set_auxiliary_state_update().
+constexpr bool auxiliary_state_update_in_pose_thread = true;
+
+// Haptic loop frequency. The handlebar reference is set in a timer interrupt
+// from the latest dynamics loop samples and a fresh steer torque measurement,
+// see haptic::ReferenceInterpolator. If zero, the reference is set in the
+// dynamics loop.
+constexpr uint32_t haptic_loop_frequency = 5000; // Hz
+// The reference is held if the dynamics loop is late by more than this.
+constexpr float haptic_max_extrapolation = 0.002f; // s
+
+// period of the simulation checkpoint saved to backup SRAM, used to resume
+// after a firmware restart
+constexpr uint32_t checkpoint_period_ms = 100;
+
+// Period of the loop timing telemetry. Start jitter, execution and
+// transmission time histograms and deadline miss counters of the periodic
+// loops are accumulated from the start and added to a simulation message
+// with this period. If the message is dropped, the next message carries the
+// telemetry.
+constexpr uint32_t telemetry_period_ms = 1000;
+constexpr uint32_t transmission_histogram_bucket_width_us = 4;
+
+// virtual roll and steer torque assistance enabled for
+constexpr float assistance_velocity_limit = 1.0f; // [m/s] values less than this
+// we gradually increase/decrease torque assistance over this period
+// after the velocity crosses the velocity limit
+constexpr uint32_t assistance_fade_period_ms = 50;
+
+/*
+ * Scale the variances of covariance matrix R by scale factors s, one per
+ * element, and the covariances such that the correlations are retained:
+ *     R_ij*sqrt(s_i*s_j)
+ */
+template <typename Matrix, typename Scale>
+Matrix scale_covariance(const Matrix& R, const Scale& s) {
+    Matrix S = R;
+    for (int i = 0; i < R.rows(); ++i) {
+        for (int j = 0; j < R.cols(); ++j) {
+            S(i, j) *= (i == j) ? s[i] : std::sqrt(s[i]*s[j]);
+        }
+    }
+    return S;
+}
+
+} // namespace flimnap
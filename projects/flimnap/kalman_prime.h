@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+ * Placeholder for the checkpoint of the flimnap Kalman filter observer after
+ * priming and the steady-state Kalman gain schedule. KALMAN_PRIME_GENERATED is
+ * not defined, the observer is primed and the gain schedule is solved at boot.
+ *
+ * The checkpoint and schedule are generated at build time with host tool
+ * kalmanprime (tools/sim) and the generated header is used instead of this
+ * file, see CMakeLists.txt. This file may only be used if priming at boot has
+ * been selected with PHOBOS_FLIMNAP_PRIME_AT_BOOT.
+ */
+#if !defined(FLIMNAP_PRIME_AT_BOOT)
+#error "kalman_prime.h has not been generated. Build with the host tools, set PHOBOS_KALMANPRIME_EXECUTABLE or enable PHOBOS_FLIMNAP_PRIME_AT_BOOT."
+#endif
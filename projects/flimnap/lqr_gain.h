@@ -0,0 +1,181 @@
+#pragma once
+#include <cstddef>
+
+/*
+ * Whipple bicycle model LQR feedback gains for uniformly spaced velocities.
+ * Sample period 0.001 s, state weights [100000, 1000, 1000, 100], input weights [1, 1].
+ * Generated with:
+ *     tools/lqrgain 8 81
+ */
+namespace lqr_gain {
+
+constexpr float v_min = 0.0f; // m/s
+constexpr float v_max = 8.0f; // m/s
+constexpr size_t size = 81;
+
+constexpr float K[size][10] = {
+    {0, -1645.67216019, -48.35882521, -515.86093222, -14.57377284, // v = 0.00
+     0, -50.04643727, -41.53080145, -26.19375759, -11.45589428},
+    {0, -1610.17746504, -56.51779328, -506.52454851, -14.06850604, // v = 0.10
+     0, 212.58952976, -32.93282671, 55.30901608, -9.06389098},
+    {0, -1481.64082208, -59.08055988, -467.72206275, -12.72191441, // v = 0.20
+     0, 465.65492096, -22.10551971, 134.56608818, -6.81890666},
+    {0, -1276.94987721, -55.72406107, -404.27479566, -10.71818499, // v = 0.30
+     0, 660.56737173, -12.03036258, 196.04843380, -5.15490160},
+    {0, -1040.27822749, -48.15489021, -329.90903279, -8.47657260, // v = 0.40
+     0, 772.41632758, -5.14714712, 231.45955656, -4.27290588},
+    {0, -815.67210746, -38.91396767, -258.61122638, -6.39406701, // v = 0.50
+     0, 808.42307389, -2.21133563, 242.65998080, -4.08127949},
+    {0, -627.74216734, -29.98682727, -198.40263903, -4.67921255, // v = 0.60
+     0, 793.38002316, -2.56430369, 237.24738735, -4.33987301},
+    {0, -482.02634202, -22.35526313, -151.30828681, -3.36725703, // v = 0.70
+     0, 752.18808183, -5.05688754, 223.07262410, -4.81841895},
+    {0, -373.76144683, -16.26524475, -116.01945523, -2.40413557, // v = 0.80
+     0, 702.24077104, -8.66590331, 205.72733560, -5.36083451},
+    {0, -294.99440509, -11.58944403, -90.13843578, -1.71139983, // v = 0.90
+     0, 653.30357834, -12.68905915, 188.43083788, -5.88214779},
+    {0, -238.03818733, -8.06950405, -71.29901945, -1.21644262, // v = 1.00
+     0, 609.77702405, -16.71951515, 172.71921027, -6.34546956},
+    {0, -196.64750527, -5.43622131, -57.54253776, -0.86144134, // v = 1.10
+     0, 572.90979559, -20.56087304, 159.09398130, -6.74158913},
+    {0, -166.19400380, -3.46009559, -47.39888002, -0.60415098, // v = 1.20
+     0, 542.40912023, -24.14509651, 147.54061984, -7.07448582},
+    {0, -143.39097774, -1.96306649, -39.80962144, -0.41484094, // v = 1.30
+     0, 517.37274112, -27.46994738, 137.82070354, -7.35299610},
+    {0, -125.97831861, -0.81356045, -34.03470023, -0.27312013, // v = 1.40
+     0, 496.79950021, -30.56375666, 129.63461976, -7.58684575},
+    {0, -112.39879736, 0.08438137, -29.55887067, -0.16502056, // v = 1.50
+     0, 479.77050500, -33.46365993, 122.69797146, -7.78475163},
+    {0, -101.59139331, 0.79874830, -26.02608454, -0.08103214, // v = 1.60
+     0, 465.53518731, -36.20531394, 116.76727084, -7.95391848},
+    {0, -92.82916969, 1.37688743, -23.18979569, -0.01465515, // v = 1.70
+     0, 453.50897864, -38.81900427, 111.64638526, -8.09995962},
+    {0, -85.60010154, 1.85360771, -20.87541243, 0.03866579, // v = 1.80
+     0, 443.23441456, -41.32976728, 107.17998709, -8.22734556},
+    {0, -79.54739244, 2.25280003, -18.96023573, 0.08209945, // v = 1.90
+     0, 434.36975555, -43.75775539, 103.24825737, -8.33947197},
+    {0, -74.40938431, 2.59242180, -17.35457280, 0.11794460, // v = 2.00
+     0, 426.64610486, -46.11835402, 99.75796933, -8.43894594},
+    {0, -69.99585508, 2.88560689, -15.99259662, 0.14787094, // v = 2.10
+     0, 419.85814622, -48.42410912, 96.63453981, -8.52788175},
+    {0, -66.16400700, 3.14222032, -14.82492206, 0.17311993, // v = 2.20
+     0, 413.84444062, -50.68456766, 93.81834855, -8.60794794},
+    {0, -62.80661244, 3.36951951, -13.81474198, 0.19461505, // v = 2.30
+     0, 408.47954261, -52.90767842, 91.26420237, -8.68043571},
+    {0, -59.84052149, 3.57301967, -12.93329373, 0.21306475, // v = 2.40
+     0, 403.66270330, -55.09956414, 88.93316525, -8.74635881},
+    {0, -57.20050457, 3.75732100, -12.15832247, 0.22902236, // v = 2.50
+     0, 399.31231857, -57.26509114, 86.79531083, -8.80665548},
+    {0, -54.83524130, 3.92570408, -11.47211738, 0.24291537, // v = 2.60
+     0, 395.36271896, -59.40820473, 84.82391792, -8.86200789},
+    {0, -52.70333685, 4.08092999, -10.86074603, 0.25508475, // v = 2.70
+     0, 391.75951728, -61.53187883, 82.99887909, -8.91299704},
+    {0, -50.77217884, 4.22506690, -10.31320030, 0.26579863, // v = 2.80
+     0, 388.45926921, -63.63958925, 81.30369755, -8.96011540},
+    {0, -49.01356062, 4.35997022, -9.81991939, 0.27528245, // v = 2.90
+     0, 385.42313255, -65.73233391, 79.72196914, -9.00379879},
+    {0, -47.40596994, 4.48688292, -9.37369373, 0.28370916, // v = 3.00
+     0, 382.62155325, -67.81343354, 78.24208126, -9.04438433},
+    {0, -45.93003474, 4.60710794, -8.96823134, 0.29123050, // v = 3.10
+     0, 380.02694012, -69.88349932, 76.85403523, -9.08218123},
+    {0, -44.57008707, 4.72152892, -8.59819783, 0.29796763, // v = 3.20
+     0, 377.61684715, -71.94396346, 75.54712452, -9.11746858},
+    {0, -43.31274869, 4.83098759, -8.25933056, 0.30402350, // v = 3.30
+     0, 375.37177572, -73.99567455, 74.31451538, -9.15046852},
+    {0, -42.14670558, 4.93608541, -7.94788096, 0.30948222, // v = 3.40
+     0, 373.27508328, -76.03975032, 73.14859161, -9.18135873},
+    {0, -41.06238566, 5.03741340, -7.66078060, 0.31441714, // v = 3.50
+     0, 371.31246668, -78.07724761, 72.04379185, -9.21035407},
+    {0, -40.05146383, 5.13541602, -7.39536176, 0.31888902, // v = 3.60
+     0, 369.47143834, -80.10926502, 70.99488944, -9.23758950},
+    {0, -39.10642460, 5.23053370, -7.14929631, 0.32295147, // v = 3.70
+     0, 367.74041734, -82.13549129, 69.99759461, -9.26316302},
+    {0, -38.22088399, 5.32307516, -6.92042432, 0.32665039, // v = 3.80
+     0, 366.10953588, -84.15615002, 69.04605906, -9.28727967},
+    {0, -37.38958451, 5.41332762, -6.70717709, 0.33002340, // v = 3.90
+     0, 364.57068657, -86.17287232, 68.13785941, -9.30999765},
+    {0, -36.60745748, 5.50155041, -6.50795711, 0.33310509, // v = 4.00
+     0, 363.11586506, -88.18518231, 67.26919683, -9.33142633},
+    {0, -35.87030905, 5.58797209, -6.32151274, 0.33592480, // v = 4.10
+     0, 361.73843234, -90.19381363, 66.43780680, -9.35162798},
+    {0, -35.17435826, 5.67279224, -6.14665421, 0.33850959, // v = 4.20
+     0, 360.43232886, -92.19914650, 65.64074909, -9.37073646},
+    {0, -34.51610880, 5.75616071, -5.98232115, 0.34088128, // v = 4.30
+     0, 359.19192029, -94.20103117, 64.87551304, -9.38879132},
+    {0, -33.89258772, 5.83821402, -5.82758956, 0.34305991, // v = 4.40
+     0, 358.01236757, -96.19986044, 64.13968945, -9.40586724},
+    {0, -33.30093743, 5.91907008, -5.68163080, 0.34506234, // v = 4.50
+     0, 356.88902405, -98.19492535, 63.43145626, -9.42197646},
+    {0, -32.73908729, 5.99887177, -5.54380992, 0.34690533, // v = 4.60
+     0, 355.81848814, -100.18872422, 62.74937527, -9.43724660},
+    {0, -32.20458163, 6.07768847, -5.41338939, 0.34860238, // v = 4.70
+     0, 354.79666172, -102.17964349, 62.09127039, -9.45169719},
+    {0, -31.69547196, 6.15563155, -5.28983099, 0.35016661, // v = 4.80
+     0, 353.82028783, -104.16781796, 61.45619201, -9.46537013},
+    {0, -31.20994169, 6.23274879, -5.17256861, 0.35160817, // v = 4.90
+     0, 352.88632896, -106.15334207, 60.84223743, -9.47830257},
+    {0, -30.74639951, 6.30910892, -5.06114008, 0.35293702, // v = 5.00
+     0, 351.99210164, -108.13660285, 60.24820007, -9.49053864},
+    {0, -30.30354542, 6.38483258, -4.95521024, 0.35416331, // v = 5.10
+     0, 351.13541637, -110.11890344, 59.67383046, -9.50213084},
+    {0, -29.87968869, 6.45988125, -4.85424226, 0.35529358, // v = 5.20
+     0, 350.31334746, -112.09760639, 59.11673738, -9.51307872},
+    {0, -29.47388756, 6.53437269, -4.75798932, 0.35633594, // v = 5.30
+     0, 349.52432665, -114.07553619, 58.57673487, -9.52344336},
+    {0, -29.08484305, 6.60831424, -4.66608755, 0.35729728, // v = 5.40
+     0, 348.76606887, -116.05061568, 58.05271260, -9.53324646},
+    {0, -28.71165379, 6.68177560, -4.57827876, 0.35818320, // v = 5.50
+     0, 348.03705075, -118.02467700, 57.54398770, -9.54251628},
+    {0, -28.35325085, 6.75476585, -4.49426695, 0.35899914, // v = 5.60
+     0, 347.33538746, -119.99635911, 57.04963951, -9.55126481},
+    {0, -28.00878461, 6.82730868, -4.41380033, 0.35974916, // v = 5.70
+     0, 346.65962264, -121.96613636, 56.56875085, -9.55950178},
+    {0, -27.67751371, 6.89947455, -4.33669791, 0.36043945, // v = 5.80
+     0, 346.00842923, -123.93456875, 56.10115143, -9.56728867},
+    {0, -27.35863695, 6.97125475, -4.26271402, 0.36107384, // v = 5.90
+     0, 345.38038256, -125.90121605, 55.64571696, -9.57464993},
+    {0, -27.05087498, 7.04264101, -4.19163277, 0.36165427, // v = 6.00
+     0, 344.76698898, -127.86547666, 55.20159796, -9.58155704},
+    {0, -26.75477246, 7.11372360, -4.12334791, 0.36218608, // v = 6.10
+     0, 344.18174049, -129.82874774, 54.76900645, -9.58805951},
+    {0, -26.46917027, 7.18450908, -4.05768834, 0.36267272, // v = 6.20
+     0, 343.61629622, -131.79033814, 54.34737428, -9.59417887},
+    {0, -26.19344056, 7.25497381, -3.99446471, 0.36311547, // v = 6.30
+     0, 343.06954066, -133.74979487, 53.93574468, -9.59990201},
+    {0, -25.92716761, 7.32518270, -3.93358365, 0.36351899, // v = 6.40
+     0, 342.54069956, -135.70796286, 53.53415284, -9.60528714},
+    {0, -25.66978259, 7.39509908, -3.87487401, 0.36388349, // v = 6.50
+     0, 342.02878685, -137.66392338, 53.14169160, -9.61028649},
+    {0, -25.42086028, 7.46474715, -3.81822331, 0.36421203, // v = 6.60
+     0, 341.53301430, -139.61813243, 52.75799625, -9.61495301},
+    {0, -25.18003395, 7.53416806, -3.76354301, 0.36450751, // v = 6.70
+     0, 341.05270869, -141.57117422, 52.38292930, -9.61930414},
+    {0, -24.94691793, 7.60338451, -3.71074157, 0.36477281, // v = 6.80
+     0, 340.58715368, -143.52297518, 52.01632599, -9.62337777},
+    {0, -24.72102511, 7.67232084, -3.65966483, 0.36500596, // v = 6.90
+     0, 340.13552653, -145.47187195, 51.65717446, -9.62708343},
+    {0, -24.50214985, 7.74107977, -3.61029389, 0.36521292, // v = 7.00
+     0, 339.69736636, -147.41933087, 51.30601644, -9.63053443},
+    {0, -24.28993942, 7.80964596, -3.56251872, 0.36539407, // v = 7.10
+     0, 339.27206455, -149.36559160, 50.96216858, -9.63372962},
+    {0, -24.08396442, 7.87793282, -3.51619507, 0.36554730, // v = 7.20
+     0, 338.85886460, -151.30883747, 50.62452062, -9.63659502},
+    {0, -23.88414417, 7.94610315, -3.47136092, 0.36567868, // v = 7.30
+     0, 338.45757377, -153.25168171, 50.29423709, -9.63922085},
+    {0, -23.69009249, 8.01406672, -3.42789278, 0.36578784, // v = 7.40
+     0, 338.06747710, -155.19201223, 49.97041026, -9.64159891},
+    {0, -23.50155591, 8.08183181, -3.38570900, 0.36587506, // v = 7.50
+     0, 337.68812328, -157.13063234, 49.65247517, -9.64372448},
+    {0, -23.31832534, 8.14942168, -3.34478105, 0.36594250, // v = 7.60
+     0, 337.31911398, -159.06699651, 49.34072382, -9.64560990},
+    {0, -23.14021549, 8.21687896, -3.30506125, 0.36599198, // v = 7.70
+     0, 336.96009769, -161.00240748, 49.03498868, -9.64728894},
+    {0, -22.96689176, 8.28410101, -3.26643518, 0.36602160, // v = 7.80
+     0, 336.61046386, -162.93481346, 48.73427549, -9.64871715},
+    {0, -22.79831518, 8.35123261, -3.22893015, 0.36603483, // v = 7.90
+     0, 336.27014426, -164.86698882, 48.43938905, -9.64993418},
+    {0, -22.63414444, 8.41813172, -3.19243155, 0.36603102, // v = 8.00
+     0, 335.93847593, -166.79545595, 48.14931037, -9.65093219},
+};
+
+} // namespace lqr_gain
@@ -25,7 +25,11 @@
 #include "filter/movingaverage.h"
 
 #include "blink.h"
+#include "flimnapconf.h"
+#include "gitsha1.h"
+#include "periodictask.h"
 #include "saconfig.h"
+#include "seqlock.h"
 #include "utility.h"
 
 #include "parameters.h"
@@ -34,6 +38,8 @@
 #include <type_traits>
 
 #include "haptic.h"
+#include "hapticreference.h"
+#include "kalmanschedule.h"
 #include "simbicycle.h"
 #include "transmitter.h"
 
@@ -41,8 +47,16 @@
 #include "bicycle/kinematic.h" // simplified bicycle model
 #else // defined(USE_BICYCLE_KINEMATIC_MODEL)
 #include "bicycle/whipple.h" // whipple bicycle model
+#if defined(FLIMNAP_FIXED_POINT)
+#include "fixedpointmodel.h" // Q31 state update
+#include "fixedpointobserver.h" // Q31 steady-state Kalman filter observer
+#else // defined(FLIMNAP_FIXED_POINT)
 #include "kalman.h" // Kalman filter observer
-#include "interpolated_lqr.h" // LQR controller
+#endif // defined(FLIMNAP_FIXED_POINT)
+#include "kalman_prime.h" // primed Kalman filter observer checkpoint and gain schedule
+#include "scheduled_lqr.h" // LQR controller
+#include "lqrassistance.h" // low speed LQR assistance
+#include "lqr_gain.h" // LQR feedback gain table
 #endif // defined(USE_BICYCLE_KINEMATIC_MODEL)
 
 namespace {
@@ -50,10 +64,15 @@ namespace {
     using model_t = model::BicycleKinematic;
     using observer_t = std::nullptr_t;
     using haptic_drive_t = haptic::HandlebarStatic;
+#elif defined(FLIMNAP_FIXED_POINT)
+    using model_t = sim::FixedPointModel<model::BicycleWhipple>;
+    using observer_t = sim::FixedPointObserver<model_t>;
+    using lqr_t = controller::ScheduledLqr<model_t, lqr_gain::size>;
 #else // defined(USE_BICYCLE_KINEMATIC_MODEL)
     using model_t = model::BicycleWhipple;
-    using observer_t = observer::Kalman<model_t>;
-    using lqr_t = controller::InterpolatedLqr<model_t>;
+    // Measurement noise covariance is diagonal, see observer_initializer.
+    using observer_t = sim::ScheduledKalman<model_t, sim::SequentialMeasurementUpdate>;
+    using lqr_t = controller::ScheduledLqr<model_t, lqr_gain::size>;
 #endif // defined(USE_BICYCLE_KINEMATIC_MODEL)
     using bicycle_t = sim::Bicycle<model_t, observer_t>;
 
@@ -68,94 +87,303 @@ namespace {
     // pose calculation loop
     constexpr systime_t pose_loop_period = US2ST(8333); // update pose at 120 Hz
 
+    static_assert(flimnap::system_tick_frequency == CH_CFG_ST_FREQUENCY,
+            "System tick frequency does not match kernel configuration");
+
     // dynamics loop
-    constexpr systime_t dynamics_loop_period = MS2ST(1); // 1 ms -> 1 kHz
+    constexpr systime_t dynamics_loop_period = MS2ST(flimnap::dynamics_loop_period_ms);
+
+    // The auxiliary state history must hold the dynamics loop iterations of a
+    // pose loop period, with margin for a delayed pose update.
+    static_assert(pose_loop_period/dynamics_loop_period < bicycle_t::auxiliary_state_history_size/2,
+            "Auxiliary state history is too small for the pose loop period");
+
+    // Periodic tasks, with priorities assigned by rate in main(). A late
+    // dynamics loop iteration is caught up to keep the simulation in real
+    // time. A late pose update is skipped as only the most recent pose is
+    // used by the receiver.
+    rt::PeriodicTask dynamics_task({"dynamics", dynamics_loop_period,
+            rt::miss_policy_t::catch_up, nullptr});
+    rt::PeriodicTask pose_task({"pose", pose_loop_period,
+            rt::miss_policy_t::skip, nullptr});
+    rt::PeriodicTask* const periodic_tasks[] = {&dynamics_task, &pose_task};
+
+    // Release clock of the dynamics loop, advanced by each completed ADC
+    // conversion, see flimnap::dynamics_loop_adc_release.
+    constexpr systime_t adc_sample_period = CH_CFG_ST_FREQUENCY/flimnap::adc_sample_frequency;
+    static_assert(adc_sample_period*flimnap::adc_sample_frequency == CH_CFG_ST_FREQUENCY,
+            "ADC sample period is not a multiple of the system tick");
+    static_assert(rt::events_per_period(dynamics_loop_period, adc_sample_period) > 0,
+            "Dynamics loop period is not a multiple of the ADC sample period");
+    rt::EventReleaseClock adc_release_clock(adc_sample_period);
+
+    void adc_conversion_callback() {
+        adc_release_clock.eventI();
+    }
+
+    // Transmission time histograms of the periodic loops in microseconds, see
+    // flimnap::telemetry_period_ms. Each histogram and the timing of each
+    // task are only accessed by the thread of that loop. The dynamics loop
+    // preempts the pose loop, possibly during an update of the pose loop
+    // timing, so the pose loop publishes a copy of its timing through a
+    // seqlock. As the reader has the higher priority, it uses try_read().
+    constexpr uint32_t telemetry_period =
+        MS2ST(flimnap::telemetry_period_ms)/dynamics_loop_period; // in iterations
+    constexpr rtcnt_t cycles_per_us = STM32_SYSCLK/1000000U;
+    rt::PeriodicTask::histogram_t dynamics_transmission_time(
+            flimnap::transmission_histogram_bucket_width_us);
+    rt::PeriodicTask::histogram_t pose_transmission_time(
+            flimnap::transmission_histogram_bucket_width_us);
+    LoopTimingMessage pose_loop_timing = LoopTimingMessage_init_zero; // written by pose loop
+    Seqlock<LoopTimingMessage> pose_loop_timing_snapshot;
+
+    // Bicycle models discretized before entering main() for each quantized
+    // speed from 0 m/s to 6 m/s. A speed change in the dynamics loop then only
+    // requires a model copy instead of a discretization. Speeds outside this
+    // range are discretized in the loop.
+    // RAM usage is model_cache_size*sizeof(model_t).
+    constexpr size_t model_cache_size = flimnap::model_cache_size;
+    sim::ModelCache<model_t, model_cache_size> model_cache(
+            model_t(0.0, static_cast<model::real_t>(dynamics_loop_period)/CH_CFG_ST_FREQUENCY),
+            0.0, bicycle_t::v_quantization_resolution);
+
+    // Pitch angles solved for a grid of roll and steer angles. The pose
+    // thread interpolates pitch instead of solving the constraint
+    // iteratively, and refines it with a Newton step from the previous pitch
+    // only if the interpolation error exceeds the allowed error. The table is
+    // filled in main() before the loops start, not during static
+    // initialization.
+    constexpr size_t pitch_table_size = 33;
+    constexpr float pitch_table_max_error = 0.1f*constants::as_radians; // rad
+    sim::PitchTable<pitch_table_size> pitch_table;
+
+    // Kalman filter iterations with error covariance propagation after a
+    // model speed change, before the steady-state gain is used
+    constexpr uint32_t kalman_settle_iterations =
+        MS2ST(flimnap::kalman_settle_period_ms)/dynamics_loop_period;
+
+    // Simulation checkpoint in backup SRAM, which is retained over a system
+    // reset. The checkpoint is saved periodically in the dynamics loop and
+    // restored at startup if it has been saved by the same firmware version,
+    // so that a session resumes without priming the observer.
+    using backup_checkpoint_t = sim::VersionedCheckpoint<bicycle_t::checkpoint_t>;
+    static_assert(sizeof(backup_checkpoint_t) <= 4096,
+            "Checkpoint exceeds backup SRAM size");
+    backup_checkpoint_t* const backup_checkpoint =
+        reinterpret_cast<backup_checkpoint_t*>(BKPSRAM_BASE);
+    constexpr uint32_t checkpoint_period =
+        MS2ST(flimnap::checkpoint_period_ms)/dynamics_loop_period; // in iterations
 
     // virtual roll and steer torque assistance enabled for
-    constexpr float assistance_velocity_limit = 1.0f; // [m/s] values less than this
+    constexpr float assistance_velocity_limit = flimnap::assistance_velocity_limit; // [m/s] values less than this
+#if !defined(USE_BICYCLE_KINEMATIC_MODEL)
+    // LQR gains are scheduled over the full speed range of the gain table and
+    // the limit may be raised up to lqr_gain::v_max.
+    static_assert(assistance_velocity_limit <= lqr_gain::v_max,
+            "Assistance velocity limit exceeds LQR gain table range");
+#endif // !defined(USE_BICYCLE_KINEMATIC_MODEL)
     // we gradually increase/decrease torque assistance over this period
     // after the velocity crosses the velocity limit
-    constexpr systime_t assistance_fade_period = MS2ST(50)/dynamics_loop_period; // in iterations
-    systime_t assistance_fade_counter = 0;
-
-    // Suspends the invoking thread until the system time arrives to the
-    // specified value.
-    // The system time is assumed to be between prev and time else the call is
-    // assumed to have been called outside the allowed time interval, in this
-    // case the thread yields the time slot and no sleep is performed.
-    systime_t chThdSleepUntilWindowedOrYield(systime_t prev, systime_t next) {
-        systime_t time;
-
-        chSysLock();
-        time = chVTGetSystemTimeX();
-        if (chVTIsTimeWithinX(time, prev, next)) {
-            chThdSleepS(next - time);
-        } else {
-            chSchDoYieldS();
-        }
-        chSysUnlock();
+    constexpr systime_t assistance_fade_period =
+        MS2ST(flimnap::assistance_fade_period_ms)/dynamics_loop_period; // in iterations
 
-        return next;
-    }
+    // handlebar torque reference for the kinematic model, velocity reference otherwise
+    constexpr float MAX_REF_VALUE = std::is_same<observer_t, std::nullptr_t>::value ?
+        sa::MAX_KOLLMORGEN_TORQUE :
+        sa::MAX_KOLLMORGEN_VELOCITY;
 
     dacsample_t set_handlebar_reference(float reference) {
         // Calculate channel value based on DAC device params
         // regshift = 0 -> CH1 -> channel value 0
         // regshift = 16 -> CH2 -> channel value 1
         static const dacchannel_t channel = sa::KOLLM_DAC->params->regshift/16;
-        constexpr float MAX_REF_VALUE = std::is_same<observer_t, std::nullptr_t>::value ?
-            sa::MAX_KOLLMORGEN_TORQUE :
-            sa::MAX_KOLLMORGEN_VELOCITY;
 
-        const float saturated_reference = util::clamp(reference, -MAX_REF_VALUE, MAX_REF_VALUE);
-        const dacsample_t aout = saturated_reference/MAX_REF_VALUE*sa::DAC_HALF_RANGE + sa::DAC_HALF_RANGE;
+        const dacsample_t aout = sa::reference_to_dac(reference, MAX_REF_VALUE);
         dacPutChannelX(sa::KOLLM_DAC, channel, aout);
         return aout;
     }
 
-    constexpr float adc_to_nm(adcsample_t value, adcsample_t adc_zero, float magnitude) {
-        // Convert torque from ADC samples to Nm.
-        // ADC samples are 12 bits.
-        // It's not clear when scaling should be applied as data was never saved after the scale
-        // factors were determined.
-        const int16_t shifted_value = static_cast<int16_t>(value) - static_cast<int16_t>(adc_zero);
-        return static_cast<float>(shifted_value)*magnitude/static_cast<float>(sa::ADC_HALF_RANGE);
+    // Haptic loop. The handlebar reference is evaluated in the TIM7 interrupt
+    // from the dynamics loop samples and the Kistler torque measured in the
+    // interrupt. The reference is extrapolated from the latest dynamics state,
+    // using the model steer acceleration with the measured torque.
+    constexpr bool use_haptic_loop = flimnap::haptic_loop_frequency > 0;
+    static_assert(!use_haptic_loop ||
+            (flimnap::haptic_loop_frequency > 1000/flimnap::dynamics_loop_period_ms),
+            "Haptic loop frequency must exceed the dynamics loop frequency");
+    haptic::ReferenceInterpolator handlebar_reference(1.0f/CH_CFG_ST_FREQUENCY,
+            flimnap::haptic_max_extrapolation,
+            haptic::ReferenceInterpolator::mode_t::extrapolate);
+    // Last DAC value written by the haptic loop, reported in the dynamics
+    // loop telemetry. A 16-bit store is atomic.
+    volatile dacsample_t haptic_loop_dac = 0;
+
+    void haptic_loop_callback(GPTDriver* gptp) {
+        (void)gptp;
+        const float kistler_torque = sa::adc_to_nm(analog.get_adc12(),
+                sa::KISTLER_ADC_ZERO_OFFSET, sa::MAX_KISTLER_TORQUE);
+        haptic_loop_dac = set_handlebar_reference(
+                handlebar_reference.reference(chVTGetSystemTimeX(), kistler_torque));
     }
 
+    /*
+     * GPT7 configuration. This timer triggers the haptic loop.
+     */
+    const GPTConfig gpt7cfg = {
+      frequency:    1000000U,
+      callback:     haptic_loop_callback,
+      cr2:          0U,
+      dier:         0U
+    };
+    static_assert(!use_haptic_loop || (1000000U % flimnap::haptic_loop_frequency == 0),
+            "Haptic loop period must be a multiple of the timer period");
+
     template <typename T>
     struct observer_initializer{
         template <typename S = T>
-        typename std::enable_if<std::is_same<typename S::observer_t, observer::Kalman<model_t>>::value, void>::type
-            initialize(S& bicycle) {
+        typename std::enable_if<sim::is_kalman_observer<typename S::observer_t>::value, void>::type
+            initialize(S& bicycle, const typename S::checkpoint_t* checkpoint) {
+            typename S::observer_t& observer = bicycle.observer();
+            observer.set_Q(parameters::defaultvalue::kalman::Q(observer.dt())*
+                    flimnap::kalman_process_noise_scale);
+            // Reduce measurement noise covariance
+            observer.set_R(flimnap::scale_covariance(parameters::defaultvalue::kalman::R,
+                        flimnap::kalman_measurement_noise_scale));
+
+            if (!resume(bicycle, checkpoint)) {
+                // Prime the Kalman gain matrix, unless the observer has been
+                // primed at build time with the same noise covariances.
+                if (!restore_primed_observer(bicycle)) {
+                    bicycle.prime_observer();
+                }
+
+                // We start with steer angle equal to the measurement and all other state elements at zero.
+                model_t::state_t x0 = model_t::state_t::Zero();
+                model_t::set_state_element(x0, model_t::state_index_t::steer_angle,
+                        util::encoder_count<float>(encoder_steer));
+                observer.set_x(x0);
+            }
+
+            // With the gain schedule the error covariance is only propagated
+            // for a number of iterations after a speed change.
+            observer.set_gain_schedule(&gain_schedule(observer.Q(), observer.R()),
+                    kalman_settle_iterations);
+        }
+        template <typename S = T>
+        typename std::enable_if<sim::is_fixed_point_observer<typename S::observer_t>::value, void>::type
+            initialize(S& bicycle, const typename S::checkpoint_t* checkpoint) {
             typename S::observer_t& observer = bicycle.observer();
-            observer.set_Q(parameters::defaultvalue::kalman::Q(observer.dt()));
-            // Reduce steer measurement noise covariance
-            observer.set_R(parameters::defaultvalue::kalman::R/1000);
 
-            // prime the Kalman gain matrix
-            bicycle.prime_observer();
+            // The fixed-point observer only uses the steady-state Kalman gain,
+            // determined with the same noise covariances as the
+            // floating-point Kalman filter.
+            observer.set_gain_schedule(&gain_schedule(
+                        parameters::defaultvalue::kalman::Q(observer.dt())*
+                            flimnap::kalman_process_noise_scale,
+                        flimnap::scale_covariance(parameters::defaultvalue::kalman::R,
+                            flimnap::kalman_measurement_noise_scale)));
+            if (!resume(bicycle, checkpoint)) {
+                bicycle.prime_observer();
+
+                model_t::state_t x0 = model_t::state_t::Zero();
+                model_t::set_state_element(x0, model_t::state_index_t::steer_angle,
+                        util::encoder_count<float>(encoder_steer));
+                observer.set_x(x0);
+            }
+        }
+        template <typename S = T>
+        typename std::enable_if<!sim::is_kalman_observer<typename S::observer_t>::value &&
+                                !sim::is_fixed_point_observer<typename S::observer_t>::value, void>::type
+            initialize(S& bicycle, const typename S::checkpoint_t* checkpoint) {
+            if (checkpoint != nullptr) {
+                bicycle.restore_checkpoint(*checkpoint);
+            }
+        }
 
-            // We start with steer angle equal to the measurement and all other state elements at zero.
-            model_t::state_t x0 = model_t::state_t::Zero();
-            model_t::set_state_element(x0, model_t::state_index_t::steer_angle,
+        // Restore a checkpoint saved before a restart. As the steer encoder
+        // count is reset at startup, the steer angle of the state estimate is
+        // set to the measurement.
+        template <typename S = T>
+        bool resume(S& bicycle, const typename S::checkpoint_t* checkpoint) {
+            if ((checkpoint == nullptr) || !bicycle.restore_checkpoint(*checkpoint)) {
+                return false;
+            }
+            typename S::observer_t& observer = bicycle.observer();
+            model_t::state_t x = observer.x();
+            model_t::set_state_element(x, model_t::state_index_t::steer_angle,
                     util::encoder_count<float>(encoder_steer));
-            observer.set_x(x0);
+            observer.set_x(x);
+            return true;
         }
+
+        // Steady-state Kalman gain and error covariance for each cached
+        // model, determined with noise covariances Q and R. The schedule
+        // generated at build time (see kalman_prime.h) is copied if it is
+        // valid for the model cache and noise covariances. Otherwise the DARE
+        // is solved at boot in single precision as the FPU does not support
+        // double.
+        // RAM usage is model_cache_size*sizeof(schedule_t::steady_state_t).
         template <typename S = T>
-        typename std::enable_if<!std::is_same<typename S::observer_t, observer::Kalman<model_t>>::value, void>::type
-            initialize(S& bicycle) {
-            // no-op
+        const sim::KalmanGainSchedule<typename S::model_t, model_cache_size>& gain_schedule(
+                const typename sim::KalmanGainSchedule<typename S::model_t,
+                    model_cache_size>::process_noise_covariance_t& Q,
+                const typename sim::KalmanGainSchedule<typename S::model_t,
+                    model_cache_size>::measurement_noise_covariance_t& R) {
+            using schedule_t = sim::KalmanGainSchedule<typename S::model_t, model_cache_size>;
+            static constexpr float dare_tolerance = 1e-5f;
+#if defined(KALMAN_PRIME_GENERATED)
+            static_assert(kalman_prime::schedule_size == model_cache_size,
+                    "Generated gain schedule size must match model cache size");
+            const Eigen::Map<const typename schedule_t::process_noise_covariance_t>
+                Q_prime(kalman_prime::Q);
+            const Eigen::Map<const typename schedule_t::measurement_noise_covariance_t>
+                R_prime(kalman_prime::R);
+            const bool generated = (kalman_prime::schedule_dt == model_cache.dt()) &&
+                (kalman_prime::schedule_v_min == model_cache.v_min()) &&
+                (kalman_prime::schedule_v_resolution == model_cache.v_resolution()) &&
+                Q_prime.isApprox(Q) && R_prime.isApprox(R);
+            static const schedule_t schedule = generated ?
+                schedule_t(model_cache, kalman_prime::schedule_K, kalman_prime::schedule_P) :
+                schedule_t(model_cache, Q, R, dare_tolerance);
+#else // defined(KALMAN_PRIME_GENERATED)
+            static const schedule_t schedule(model_cache, Q, R, dare_tolerance);
+#endif // defined(KALMAN_PRIME_GENERATED)
+            return schedule;
+        }
+
+        // Restore the observer checkpoint generated at build time (see
+        // kalman_prime.h) if it is valid for the observer.
+        template <typename S = T>
+        bool restore_primed_observer(S& bicycle) {
+#if defined(KALMAN_PRIME_GENERATED)
+            using observer_t = typename S::observer_t;
+            const observer_t& observer = bicycle.observer();
+            const Eigen::Map<const typename observer_t::process_noise_covariance_t>
+                Q(kalman_prime::Q);
+            const Eigen::Map<const typename observer_t::measurement_noise_covariance_t>
+                R(kalman_prime::R);
+            // The noise covariances are computed on the host and may differ
+            // in the least significant bits.
+            if ((kalman_prime::checkpoint.dt != bicycle.dt()) ||
+                    (kalman_prime::checkpoint.v != bicycle.v()) ||
+                    !Q.isApprox(observer.Q()) || !R.isApprox(observer.R())) {
+                return false;
+            }
+            return bicycle.restore_checkpoint(kalman_prime::checkpoint);
+#else // defined(KALMAN_PRIME_GENERATED)
             (void)bicycle;
+            return false;
+#endif // defined(KALMAN_PRIME_GENERATED)
         }
 
         template <typename S = T>
-        typename std::enable_if<std::is_same<typename S::observer_t, observer::Kalman<model_t>>::value, void>::type
+        typename std::enable_if<sim::is_kalman_observer<typename S::observer_t>::value, void>::type
             set_message(S& bicycle, SimulationMessage* msg) {
             message::set_kalman_gain(&msg->kalman, bicycle.observer());
             msg->has_kalman = true;
         }
         template <typename S = T>
-        typename std::enable_if<!std::is_same<typename S::observer_t, observer::Kalman<model_t>>::value, void>::type
+        typename std::enable_if<!sim::is_kalman_observer<typename S::observer_t>::value, void>::type
             set_message(S& bicycle, SimulationMessage* msg) {
             // no-op
             (void)bicycle;
@@ -171,10 +399,13 @@ namespace {
     THD_FUNCTION(pose_thread, arg) {
         pose_thread_arg* a = static_cast<pose_thread_arg*>(arg);
 
-        chRegSetThreadName("pose");
-        systime_t deadline = chVTGetSystemTime();
+        time_measurement_t transmission_time_measurement;
+        chTMObjectInit(&transmission_time_measurement);
+
+        pose_task.start();
         while (true) {
             a->bicycle.update_kinematics();
+            chTMStartMeasurementX(&transmission_time_measurement);
             BicyclePoseMessage* msg = a->transmitter.alloc_pose_message();
             if (msg != nullptr) {
                 *msg = a->bicycle.pose();
@@ -185,8 +416,12 @@ namespace {
                     a->transmitter.free_message(msg);
                 }
             }
+            chTMStopMeasurementX(&transmission_time_measurement);
+            pose_transmission_time.add(transmission_time_measurement.last/cycles_per_us);
+            message::set_loop_timing(&pose_loop_timing, pose_task, pose_transmission_time);
+            pose_loop_timing_snapshot.write(pose_loop_timing);
 
-            deadline = chThdSleepUntilWindowedOrYield(deadline, deadline + pose_loop_period);
+            pose_task.wait_for_next_release();
         }
     }
 } // namespace
@@ -212,7 +447,12 @@ int main(void) {
     palSetLineMode(LINE_TIM5_CH2, PAL_MODE_ALTERNATE(2) | PAL_STM32_PUPDR_FLOATING);
     encoder_steer.start();
     encoder_rear_wheel.start();
-    analog.start(10000); // trigger ADC conversion at 10 kHz
+    if (flimnap::dynamics_loop_adc_release) {
+        dynamics_task.set_release_clock(&adc_release_clock);
+        analog.start(flimnap::adc_sample_frequency, false, adc_conversion_callback);
+    } else {
+        analog.start(flimnap::adc_sample_frequency);
+    }
 
     //Set torque measurement enable line low.
     //The output of the Kistler torque sensor is not valid until after a falling edge
@@ -232,20 +472,23 @@ int main(void) {
     // Initialize bicycle. The initial velocity is important as we use it to prime
     // the Kalman gain matrix.
     bicycle_t bicycle(0.0, static_cast<model::real_t>(dynamics_loop_period)/CH_CFG_ST_FREQUENCY);
+    bicycle.set_model_cache(&model_cache);
+    // Pitch depends only on bicycle geometry so any cached model can be used.
+    pitch_table.fill(model_cache.model(0), constants::pi/4, constants::pi/2); // roll, steer range [rad]
+    bicycle.set_pitch_table(&pitch_table, pitch_table_max_error);
+    if (flimnap::auxiliary_state_update_in_pose_thread) {
+        bicycle.set_auxiliary_state_update(bicycle_t::auxiliary_state_update_t::kinematics);
+    }
 
 #if defined(USE_BICYCLE_KINEMATIC_MODEL)
     haptic_drive_t haptic_drive(bicycle.model());
 #else
     // At low speed, we add an assistive roll torque to stabilize the bicycle.
-    // Gains calculated with script calculate_lqr_gain.py.
-    lqr_t controller(
-            (lqr_t::feedback_gain_t() << // v = 0
-             0, -1648.90829472, -48.43076882, -516.76805995, -14.59295354,
-             0, -50.23751925, -42.32812576, -26.53589725, -11.70135889).finished(),
-            (lqr_t::feedback_gain_t() << // v = 1 = assistance_velocity_limit
-             0, -238.99395251, -8.0805282, -71.5451519, -1.21535324,
-             0, 624.96912408, -16.89860361, 176.94881285, -6.47514655).finished()
-    );
+    // Gains for speeds from 0 m/s to 8 m/s in 0.1 m/s steps, calculated with
+    // tool lqrgain.
+    lqr_t controller(lqr_gain::K, lqr_gain::v_min, lqr_gain::v_max);
+    controller::FadedAssistance<lqr_t> assistance(controller,
+            assistance_velocity_limit, assistance_fade_period);
 #endif
 
     // Initialize HandlebarDynamic object to estimate torque due to handlebar inertia.
@@ -254,14 +497,25 @@ int main(void) {
     haptic::HandlebarDynamic handlebar_model(bicycle.model(), sa::UPPER_ASSEMBLY_INERTIA_PHYSICAL);
 #endif  // !defined(FLIMNAP_ZERO_INPUT)
 
+    // Resume from the backup SRAM checkpoint if it has been saved by this
+    // firmware version, otherwise it is invalidated. The checkpoint is also
+    // invalidated by the CRC after a power cycle.
     observer_initializer<observer_t> oi;
-    oi.initialize(bicycle);
+    oi.initialize(bicycle, backup_checkpoint->claim(g_GITSHA1));
+    uint32_t checkpoint_counter = 0;
+    uint32_t telemetry_counter = 0;
 
     // Initialize time measurements
     time_measurement_t computation_time_measurement;
     time_measurement_t transmission_time_measurement;
+    time_measurement_t state_update_time_measurement;
+    time_measurement_t covariance_update_time_measurement;
+    time_measurement_t checkpoint_time_measurement;
     chTMObjectInit(&computation_time_measurement);
     chTMObjectInit(&transmission_time_measurement);
+    chTMObjectInit(&state_update_time_measurement);
+    chTMObjectInit(&covariance_update_time_measurement);
+    chTMObjectInit(&checkpoint_time_measurement);
 
     // Initialize USB data transmission
     message::Transmitter transmitter;
@@ -274,32 +528,54 @@ int main(void) {
     }
     transmitter.start(NORMALPRIO + 1); // start transmission thread
 
-    // Start running pose calculation thread
+    // Start running pose calculation thread. The dynamics loop runs in the
+    // main() thread.
+    rt::assign_priorities(periodic_tasks, NORMALPRIO);
     pose_thread_arg a{bicycle, transmitter};
     chThdCreateStatic(wa_pose_thread, sizeof(wa_pose_thread),
-            NORMALPRIO - 1, pose_thread, static_cast<void*>(&a));
+            pose_task.priority(), pose_thread, static_cast<void*>(&a));
+
+#if !defined(USE_BICYCLE_KINEMATIC_MODEL)
+    // The velocity reference is the steer rate.
+    haptic::linear_form_t velocity_reference{model_t::state_t::Zero(), model_t::input_t::Zero()};
+    model_t::set_state_element(velocity_reference.a, model_t::state_index_t::steer_rate, 1);
+#endif // !defined(USE_BICYCLE_KINEMATIC_MODEL)
+
+    // Start haptic loop
+    if (use_haptic_loop) {
+        gptStart(&GPTD7, &gpt7cfg);
+        gptStartContinuous(&GPTD7, gpt7cfg.frequency/flimnap::haptic_loop_frequency);
+    }
 
     // Normal main() thread activity. This is the dynamics simulation loop.
-    systime_t deadline = chVTGetSystemTime();
+    dynamics_task.start();
     while (true) {
         systime_t starttime = chVTGetSystemTime();
         chTMStartMeasurementX(&computation_time_measurement);
         float roll_torque = 0.0f;
 
         // get sensor measurements
-        const float kistler_torque = adc_to_nm(analog.get_adc12(),
+        // Samples are read once and the same values are transmitted so that
+        // a recorded run can be replayed (see tools/sim/replay.cc).
+        const adcsample_t kistler_sample = analog.get_adc12();
+        const adcsample_t motor_sample = analog.get_adc13();
+        const enccnt_t steer_count = encoder_steer.count();
+        const enccnt_t rear_wheel_count = encoder_rear_wheel.count();
+        const float kistler_torque = sa::adc_to_nm(kistler_sample,
                 sa::KISTLER_ADC_ZERO_OFFSET, sa::MAX_KISTLER_TORQUE);
-        const float motor_torque = adc_to_nm(analog.get_adc13(),
+        const float motor_torque = sa::adc_to_nm(motor_sample,
                 sa::KOLLMORGEN_ADC_ZERO_OFFSET, sa::MAX_KOLLMORGEN_TORQUE);
-        const float steer_angle = util::encoder_count<float>(encoder_steer);
-        const float rear_wheel_angle = std::fmod(-util::encoder_count<float>(encoder_rear_wheel),
-                                                 constants::two_pi);
+        const float steer_angle = sa::encoder_angle<float>(steer_count,
+                encoder_steer.config().counts_per_rev);
+        const float rear_wheel_angle = util::wrap(-sa::encoder_angle<float>(rear_wheel_count,
+                    encoder_rear_wheel.config().counts_per_rev));
         const float v = velocity_filter.output(
                 -sa::REAR_WHEEL_RADIUS*(util::encoder_rate(encoder_rear_wheel)));
         (void)motor_torque; // not currently used
 
         // yaw angle, just use previous state value
-        const float yaw_angle = util::wrap(bicycle.pose().yaw);
+        const float yaw_angle = util::wrap(model_t::get_full_state_element(
+                    bicycle.full_state(), model_t::full_state_index_t::yaw_angle));
 
         // calculate rider applied torque
 #if defined(FLIMNAP_ZERO_INPUT)
@@ -313,37 +589,59 @@ int main(void) {
         // simulate bicycle
         bicycle.set_v(v);
 #if !defined(USE_BICYCLE_KINEMATIC_MODEL)
-        if (bicycle.v() < assistance_velocity_limit) {
-            const float interp = bicycle.v() / assistance_velocity_limit;
-            const model_t::input_t u = controller.control_calculate(bicycle.observer().state(), interp);
-            if (assistance_fade_counter < assistance_fade_period) {
-                ++assistance_fade_counter;
-            }
-            const float fade = static_cast<float>(assistance_fade_counter)/assistance_fade_period;
-            roll_torque += fade * model_t::get_input_element(u, model_t::input_index_t::roll_torque);
-            steer_torque += fade * model_t::get_input_element(u, model_t::input_index_t::steer_torque);
-        } else if (assistance_fade_counter != 0) {
-            const model_t::input_t u = controller.control_calculate(bicycle.observer().state(), 1.0f);
-            const float fade = static_cast<float>(assistance_fade_counter--)/assistance_fade_period;
-            roll_torque += fade * model_t::get_input_element(u, model_t::input_index_t::roll_torque);
-            steer_torque += fade * model_t::get_input_element(u, model_t::input_index_t::steer_torque);
+        model_t::input_t u;
+        if (assistance.control_calculate(bicycle.observer().state(), bicycle.v(), &u)) {
+            roll_torque += model_t::get_input_element(u, model_t::input_index_t::roll_torque);
+            steer_torque += model_t::get_input_element(u, model_t::input_index_t::steer_torque);
         }
 #endif
-        bicycle.update_dynamics(roll_torque, steer_torque, yaw_angle, steer_angle, rear_wheel_angle);
+        // Only the state is needed for the handlebar reference. The observer
+        // error covariance is updated after the handlebar reference is set.
+        chTMStartMeasurementX(&state_update_time_measurement);
+        bicycle.update_dynamics_state(roll_torque, steer_torque, yaw_angle, steer_angle, rear_wheel_angle);
+        chTMStopMeasurementX(&state_update_time_measurement);
 
         // generate handlebar velocity or torque output
+        model_t::input_t model_input;
+        model_t::set_input_element(model_input, model_t::input_index_t::roll_torque, roll_torque);
+        model_t::set_input_element(model_input, model_t::input_index_t::steer_torque, steer_torque);
 #if defined(USE_BICYCLE_KINEMATIC_MODEL)
-        const float desired_torque = haptic_drive.torque(model_t::get_state_part(bicycle.full_state()));
-        const dacsample_t handlebar_reference_dac = set_handlebar_reference(desired_torque);
+        const haptic::linear_form_t handlebar_form = haptic_drive.linear_form();
 #else // defined(USE_BICYCLE_KINEMATIC_MODEL)
-        const float desired_velocity =
-            model_t::get_full_state_element(bicycle.full_state(),
-                                            model_t::full_state_index_t::steer_rate);
-        const dacsample_t handlebar_reference_dac = set_handlebar_reference(desired_velocity);
+        const haptic::linear_form_t& handlebar_form = velocity_reference;
 #endif // defined(USE_BICYCLE_KINEMATIC_MODEL)
+        haptic::ReferenceInterpolator::sample_t reference_sample =
+            haptic::ReferenceInterpolator::make_sample(bicycle.model(), handlebar_form,
+                    model_t::get_state_part(bicycle.full_state()), model_input,
+                    starttime, kistler_torque);
+#if defined(FLIMNAP_ZERO_INPUT)
+        // measured torque is not applied to the model
+        reference_sample.torque_gain = 0.0f;
+        reference_sample.torque_rate_gain = 0.0f;
+#endif // defined(FLIMNAP_ZERO_INPUT)
+        dacsample_t handlebar_reference_dac;
+        if (use_haptic_loop) {
+            handlebar_reference.push(reference_sample);
+            handlebar_reference_dac = haptic_loop_dac;
+        } else {
+            handlebar_reference_dac = set_handlebar_reference(reference_sample.reference);
+        }
 
         chTMStopMeasurementX(&computation_time_measurement);
 
+        chTMStartMeasurementX(&covariance_update_time_measurement);
+        bicycle.update_observer_covariance();
+        chTMStopMeasurementX(&covariance_update_time_measurement);
+
+        if (++checkpoint_counter >= checkpoint_period) {
+            checkpoint_counter = 0;
+            chTMStartMeasurementX(&checkpoint_time_measurement);
+            bicycle.save_checkpoint(&backup_checkpoint->checkpoint);
+            chTMStopMeasurementX(&checkpoint_time_measurement);
+        }
+
+        ++telemetry_counter;
+        chTMStartMeasurementX(&transmission_time_measurement);
         {   // prepare message for transmission
             SimulationMessage* msg = transmitter.alloc_simulation_message();
             if (msg != nullptr) {
@@ -360,16 +658,35 @@ int main(void) {
                 oi.set_message(bicycle, msg);
                 message::set_simulation_actuators(msg, handlebar_reference_dac);
                 message::set_simulation_sensors(msg,
-                        analog.get_adc12(), analog.get_adc13(),
-                        encoder_steer.count(), encoder_rear_wheel.count());
+                        kistler_sample, motor_sample,
+                        steer_count, rear_wheel_count);
                 message::set_simulation_timing(msg,
                         computation_time_measurement.last, transmission_time_measurement.last);
+                message::set_simulation_update_timing(msg,
+                        state_update_time_measurement.last, covariance_update_time_measurement.last);
+                if (checkpoint_time_measurement.n > 0) {
+                    message::set_simulation_checkpoint_timing(msg, checkpoint_time_measurement.last);
+                }
+                const bool telemetry = telemetry_counter >= telemetry_period;
+                if (telemetry) {
+                    message::set_loop_timing(&msg->telemetry.dynamics,
+                            dynamics_task, dynamics_transmission_time);
+                    msg->telemetry.has_dynamics = true;
+                    // omitted if the pose loop is preempted during a write
+                    msg->telemetry.has_pose =
+                        pose_loop_timing_snapshot.try_read(msg->telemetry.pose);
+                    msg->has_telemetry = true;
+                }
                 if (transmitter.transmit_async(msg) != MSG_OK) {
                     // Discard simulation message if it cannot be processed quickly enough.
                     transmitter.free_message(msg);
+                } else if (telemetry) {
+                    telemetry_counter = 0;
                 }
             }
         }
-        deadline = chThdSleepUntilWindowedOrYield(deadline, deadline + dynamics_loop_period);
+        chTMStopMeasurementX(&transmission_time_measurement);
+        dynamics_transmission_time.add(transmission_time_measurement.last/cycles_per_us);
+        dynamics_task.wait_for_next_release();
     }
 }
@@ -0,0 +1,82 @@
+#include "analog.h"
+#include "ch.h"
+#include "saconversion.h"
+#include "sensorsource.h"
+
+/*
+ * Virtual ADC of the flimnap SIL build. Conversions are not simulated and
+ * each channel returns the sensor source sample at the current system time,
+ * i.e. the average over the sample buffer is the current sample:
+ *  ADC12 - Kistler steer torque
+ *  ADC13 - Kollmorgen actual torque
+ * Other channels return the half range value.
+ * The conversion callback is called from a virtual timer at the sample rate,
+ * rounded to system ticks.
+ */
+namespace {
+    virtual_timer_t conversion_timer;
+    systime_t conversion_period;
+    Analog::conversion_callback_t conversion_callback = nullptr;
+
+    void conversion_timer_callback(void* p) {
+        chSysLockFromISR();
+        chVTSetI(&conversion_timer, conversion_period, conversion_timer_callback, p);
+        conversion_callback();
+        chSysUnlockFromISR();
+    }
+} // namespace
+
+Analog::Analog() : m_adc_buffer() { }
+
+void Analog::start(gptcnt_t sample_rate, bool use_events,
+        conversion_callback_t callback) {
+    (void)use_events;
+    if (callback == nullptr) {
+        return;
+    }
+    conversion_callback = callback;
+    conversion_period = (CH_CFG_ST_FREQUENCY + sample_rate/2)/sample_rate;
+    if (conversion_period == 0) {
+        conversion_period = 1;
+    }
+    chVTObjectInit(&conversion_timer);
+    chSysLock();
+    chVTSetI(&conversion_timer, conversion_period, conversion_timer_callback, nullptr);
+    chSysUnlock();
+}
+
+void Analog::stop() {
+    chVTReset(&conversion_timer);
+}
+
+adcsample_t Analog::get_adc10() const {
+    return average_adc_conversion_value(ADC10);
+}
+
+adcsample_t Analog::get_adc11() const {
+    return average_adc_conversion_value(ADC11);
+}
+
+adcsample_t Analog::get_adc12() const {
+    return average_adc_conversion_value(ADC12);
+}
+
+adcsample_t Analog::get_adc13() const {
+    return average_adc_conversion_value(ADC13);
+}
+
+adc_channels_num_t Analog::buffer_size() {
+    return m_adc_buffer_size;
+}
+
+adcsample_t Analog::average_adc_conversion_value(sensor_t channel) const {
+    const sil::SensorSource::sample_t s = sil::sensor_source().sample(chVTGetSystemTimeX());
+    switch (channel) {
+        case ADC12:
+            return s.kistler;
+        case ADC13:
+            return s.motor;
+        default:
+            return sa::ADC_HALF_RANGE;
+    }
+}
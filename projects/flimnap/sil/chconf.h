@@ -0,0 +1,33 @@
+#ifndef _SIL_CHCONF_H_
+#define _SIL_CHCONF_H_
+
+/*
+ * Kernel configuration of the flimnap SIL build. This is the flimnap kernel
+ * configuration with the changes required by the SIMIA32 port:
+ *  - the port only supports a periodic system tick (tick mode),
+ *  - the port has no realtime counter and the kernel time measurement is
+ *    replaced by host time measurement, see hal.h,
+ *  - a system halt exits the process, see hal.cc.
+ * The system tick frequency is not changed.
+ */
+#define CH_CFG_USE_TM                       FALSE
+
+#include "../chconf.h"
+
+#undef CH_CFG_ST_TIMEDELTA
+#define CH_CFG_ST_TIMEDELTA                 0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void sil_halt(const char* reason);
+#ifdef __cplusplus
+}
+#endif
+
+#undef CH_CFG_SYSTEM_HALT_HOOK
+#define CH_CFG_SYSTEM_HALT_HOOK(reason) {                                   \
+  sil_halt(reason);                                                         \
+}
+
+#endif  /* _SIL_CHCONF_H_ */
@@ -0,0 +1,74 @@
+#include "encoder.h"
+#include "ch.h"
+#include "sensorsource.h"
+
+/*
+ * Virtual encoder timer of the flimnap SIL build. The counter value is the
+ * sensor source count at the current system time plus an offset set by
+ * set_count(), wrapped to the counts per revolution as the timer
+ * auto-reload register. The index channel is not simulated and sensor
+ * source counts are absolute, the index is found at start if configured.
+ */
+namespace {
+    gptcnt_t source_count(const GPTDriver* gptp) {
+        const sil::SensorSource::sample_t s = sil::sensor_source().sample(chVTGetSystemTimeX());
+        return (gptp->encoder == SIL_ENCODER_STEER) ? s.steer_count : s.rear_wheel_count;
+    }
+} // namespace
+
+Encoder::Encoder(GPTDriver* gptp, const EncoderConfig& config) :
+    m_gptp(gptp),
+    m_gptconfig{STM32_SYSCLK/4, nullptr, 0U, 0U},
+    m_config(config),
+    m_state(state_t::STOP),
+    m_index(index_t::NONE) { }
+
+void Encoder::start() {
+    chDbgCheck(m_gptp != nullptr);
+
+    chSysLock();
+    chDbgAssert((m_gptp->state == GPT_STOP) || (m_gptp->state == GPT_READY), "invalid state");
+    m_gptp->config = &m_gptconfig;
+    m_gptp->offset = 0;
+    m_gptp->state = GPT_READY;
+    m_state = state_t::READY;
+    m_index = (m_config.z == PAL_NOLINE) ? index_t::NONE : index_t::FOUND;
+    chSysUnlock();
+}
+
+void Encoder::stop() {
+    chDbgCheck(m_gptp != nullptr);
+
+    chSysLock();
+    m_gptp->state = GPT_STOP;
+    m_state = state_t::STOP;
+    m_index = index_t::NONE;
+    chSysUnlock();
+}
+
+void Encoder::set_count(gptcnt_t count) {
+    chDbgCheck(m_state == state_t::READY);
+    m_gptp->offset = count - source_count(m_gptp);
+}
+
+gptcnt_t Encoder::count() const volatile {
+    chDbgCheck(m_state == state_t::READY);
+    return (source_count(m_gptp) + m_gptp->offset) % m_config.counts_per_rev;
+}
+
+bool Encoder::direction() const volatile {
+    // not simulated, counting up
+    return false;
+}
+
+const EncoderConfig& Encoder::config() const {
+    return m_config;
+}
+
+Encoder::state_t Encoder::state() const {
+    return m_state;
+}
+
+Encoder::index_t Encoder::index() const volatile {
+    return m_index;
+}
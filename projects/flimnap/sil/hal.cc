@@ -0,0 +1,350 @@
+#include "hal.h"
+#include "usbconfig.h"
+#include "sensorsource.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <termios.h>
+#include <unistd.h>
+
+/*
+ * Virtual peripherals and clock of the flimnap SIL build, see hal.h.
+ *
+ * Configuration is read from environment variables in halInit():
+ *  FLIMNAP_SIL_SOURCE      recorded log or script of sensor samples
+ *  FLIMNAP_SIL_TIME_SCALE  virtual time per unit of real time, 0 runs as fast
+ *                          as possible (default 1)
+ *  FLIMNAP_SIL_DURATION    virtual time in seconds after which the process
+ *                          exits (default: duration of the source, or
+ *                          unlimited without a source)
+ *  FLIMNAP_SIL_OUTPUT      file to write the serial-over-USB stream to,
+ *                          instead of a pseudoterminal
+ *  FLIMNAP_SIL_PTY         path of a symbolic link to the pseudoterminal
+ *  FLIMNAP_SIL_BACKUP      file backing the backup SRAM, retained between
+ *                          runs
+ */
+namespace {
+    constexpr size_t bkpsram_size = 4096;
+    constexpr uint64_t ns_per_s = 1000000000ULL;
+    constexpr uint64_t tick_ns = ns_per_s/CH_CFG_ST_FREQUENCY;
+
+    sil::SensorSource source;
+
+    double time_scale = 1.0;
+    uint64_t tick_limit = 0; // 0 if unlimited
+    uint64_t tick_count = 0; // virtual time in system ticks
+    uint64_t start_ns = 0; // host time at start
+
+    int serial_fd = -1;
+    uint64_t serial_bytes_written = 0;
+    uint64_t serial_bytes_dropped = 0;
+
+    uint8_t bkpsram_buffer[bkpsram_size];
+    uint32_t pal_state[GPIOI + 1];
+
+    const DACParams dac1_params = {0};
+
+    uint64_t host_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec)*ns_per_s + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    double getenv_or(const char* name, double value) {
+        const char* s = std::getenv(name);
+        return (s != nullptr) ? std::atof(s) : value;
+    }
+
+    uint8_t* map_bkpsram() {
+        const char* filename = std::getenv("FLIMNAP_SIL_BACKUP");
+        if (filename == nullptr) {
+            return bkpsram_buffer;
+        }
+        const int fd = open(filename, O_RDWR | O_CREAT, 0644);
+        if ((fd < 0) || (ftruncate(fd, bkpsram_size) != 0)) {
+            std::fprintf(stderr, "Unable to open backup SRAM file '%s': %s\n",
+                    filename, std::strerror(errno));
+            std::exit(EXIT_FAILURE);
+        }
+        // Writes are retained if the process is killed.
+        void* p = mmap(nullptr, bkpsram_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            std::fprintf(stderr, "Unable to map backup SRAM file '%s': %s\n",
+                    filename, std::strerror(errno));
+            std::exit(EXIT_FAILURE);
+        }
+        return static_cast<uint8_t*>(p);
+    }
+
+    void open_serial() {
+        const char* output = std::getenv("FLIMNAP_SIL_OUTPUT");
+        if (output != nullptr) {
+            serial_fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (serial_fd < 0) {
+                std::fprintf(stderr, "Unable to open output file '%s': %s\n",
+                        output, std::strerror(errno));
+                std::exit(EXIT_FAILURE);
+            }
+            return;
+        }
+
+        serial_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if ((serial_fd < 0) || (grantpt(serial_fd) != 0) || (unlockpt(serial_fd) != 0)) {
+            std::fprintf(stderr, "Unable to create pseudoterminal: %s\n", std::strerror(errno));
+            std::exit(EXIT_FAILURE);
+        }
+        const char* name = ptsname(serial_fd);
+
+        // Keep the slave open in raw mode so that data is not translated and
+        // is buffered while no reader is connected.
+        const int slave_fd = open(name, O_RDWR | O_NOCTTY);
+        termios tio;
+        if ((slave_fd >= 0) && (tcgetattr(slave_fd, &tio) == 0)) {
+            cfmakeraw(&tio);
+            tcsetattr(slave_fd, TCSANOW, &tio);
+        }
+
+        const char* link = std::getenv("FLIMNAP_SIL_PTY");
+        if (link != nullptr) {
+            unlink(link);
+            if (symlink(name, link) != 0) {
+                std::fprintf(stderr, "Unable to create link '%s': %s\n", link, std::strerror(errno));
+            }
+        }
+        std::fprintf(stderr, "Serial-over-USB on %s\n", name);
+    }
+
+    void print_summary() {
+        const double virtual_s = static_cast<double>(tick_count)/CH_CFG_ST_FREQUENCY;
+        const double real_s = static_cast<double>(host_ns() - start_ns)/ns_per_s;
+        std::fprintf(stderr, "Simulated %.3f s in %.3f s (%.1fx real time), "
+                "%llu bytes written, %llu bytes dropped\n",
+                virtual_s, real_s, (real_s > 0) ? virtual_s/real_s : 0.0,
+                static_cast<unsigned long long>(serial_bytes_written),
+                static_cast<unsigned long long>(serial_bytes_dropped));
+    }
+
+    // Called for each tick of the virtual clock, from interrupt context.
+    void call_timer_callback(GPTDriver* gptp) {
+        if ((gptp->state == GPT_CONTINUOUS) && (tick_count >= gptp->next)) {
+            gptp->next += gptp->period;
+            gptp->config->callback(gptp);
+        }
+    }
+
+    // Returns true if the virtual clock has advanced by a tick.
+    bool advance_clock() {
+        if (time_scale > 0.0) {
+            const double elapsed_ns = static_cast<double>(host_ns() - start_ns)*time_scale;
+            if (elapsed_ns < static_cast<double>((tick_count + 1)*tick_ns)) {
+                return false;
+            }
+        }
+        // Without a time scale, this is only called from the idle thread and
+        // the virtual clock advances whenever all threads are waiting.
+        ++tick_count;
+        if ((tick_limit > 0) && (tick_count >= tick_limit)) {
+            print_summary();
+            std::exit(EXIT_SUCCESS);
+        }
+        return true;
+    }
+} // namespace
+
+uint8_t* sil_bkpsram(void) {
+    // mapped on first use, also during static initialization
+    static uint8_t* const p = map_bkpsram();
+    return p;
+}
+
+DACDriver DACD1 = {&dac1_params, nullptr, {0, 0}};
+GPTDriver GPTD3 = {GPT_STOP, nullptr, SIL_ENCODER_REAR_WHEEL, 0, 0, 0};
+GPTDriver GPTD5 = {GPT_STOP, nullptr, SIL_ENCODER_STEER, 0, 0, 0};
+GPTDriver GPTD7 = {GPT_STOP, nullptr, SIL_ENCODER_NONE, 0, 0, 0};
+USBDriver USBD1 = {USB_STOP};
+
+const USBConfig usbcfg = {0};
+SerialUSBConfig serusbcfg = {&USBD1, 1, 1, 2};
+// The configuration is set before sduStart() as the blink thread reads the
+// USB state through SDU1.
+SerialUSBDriver SDU1 = {SDU_STOP, &serusbcfg};
+
+namespace sil {
+const SensorSource& sensor_source() {
+    return source;
+}
+} // namespace sil
+
+void halInit(void) {
+    time_scale = getenv_or("FLIMNAP_SIL_TIME_SCALE", 1.0);
+
+    const char* filename = std::getenv("FLIMNAP_SIL_SOURCE");
+    if ((filename != nullptr) && !source.load(filename)) {
+        std::exit(EXIT_FAILURE);
+    }
+    const double duration = getenv_or("FLIMNAP_SIL_DURATION",
+            static_cast<double>(source.duration())/CH_CFG_ST_FREQUENCY);
+    tick_limit = static_cast<uint64_t>(duration*CH_CFG_ST_FREQUENCY);
+
+    open_serial();
+    start_ns = host_ns();
+}
+
+/*
+ * Called by the SIMIA32 port from the idle thread. Based on the ChibiOS
+ * POSIX simulator HAL, with the system tick generated by the virtual clock.
+ */
+extern "C" void _sim_check_for_interrupts(void) {
+    if (!advance_clock()) {
+        return;
+    }
+
+    CH_IRQ_PROLOGUE();
+    chSysLockFromISR();
+    chSysTimerHandlerI();
+    chSysUnlockFromISR();
+    call_timer_callback(&GPTD7);
+    CH_IRQ_EPILOGUE();
+
+    _dbg_check_lock();
+    if (chSchIsPreemptionRequired()) {
+        chSchDoReschedule();
+    }
+    _dbg_check_unlock();
+}
+
+/*
+ * Called from CH_CFG_SYSTEM_HALT_HOOK, see chconf.h.
+ */
+extern "C" void sil_halt(const char* reason) {
+    std::fprintf(stderr, "System halted: %s\n", (reason != nullptr) ? reason : "");
+    print_summary();
+    std::exit(EXIT_FAILURE);
+}
+
+void palSetLineMode(ioline_t line, iomode_t mode) {
+    (void)line;
+    (void)mode;
+}
+
+void palSetLine(ioline_t line) {
+    pal_state[line >> 4] |= 1U << PAL_PAD(line);
+}
+
+void palClearLine(ioline_t line) {
+    pal_state[line >> 4] &= ~(1U << PAL_PAD(line));
+}
+
+void palToggleLine(ioline_t line) {
+    pal_state[line >> 4] ^= 1U << PAL_PAD(line);
+}
+
+uint32_t palReadLine(ioline_t line) {
+    return (pal_state[line >> 4] >> PAL_PAD(line)) & 1U;
+}
+
+void dacStart(DACDriver* dacp, const DACConfig* config) {
+    dacp->config = config;
+    dacp->output[0] = config->init;
+    dacp->output[1] = config->init;
+}
+
+void dacPutChannelX(DACDriver* dacp, dacchannel_t channel, dacsample_t sample) {
+    dacp->output[channel] = sample;
+}
+
+void gptStart(GPTDriver* gptp, const GPTConfig* config) {
+    chDbgAssert((gptp->state == GPT_STOP) || (gptp->state == GPT_READY), "invalid state");
+    gptp->config = config;
+    gptp->state = GPT_READY;
+}
+
+void gptStartContinuous(GPTDriver* gptp, gptcnt_t interval) {
+    chDbgAssert(gptp->state == GPT_READY, "invalid state");
+    gptp->period = (static_cast<uint64_t>(interval)*CH_CFG_ST_FREQUENCY +
+            gptp->config->frequency/2)/gptp->config->frequency;
+    if (gptp->period == 0) {
+        gptp->period = 1;
+    }
+    gptp->next = tick_count + gptp->period;
+    gptp->state = (gptp->config->callback != nullptr) ? GPT_CONTINUOUS : GPT_READY;
+}
+
+void gptStopTimer(GPTDriver* gptp) {
+    gptp->state = GPT_READY;
+}
+
+void sduObjectInit(SerialUSBDriver* sdup) {
+    sdup->state = SDU_STOP;
+}
+
+void sduStart(SerialUSBDriver* sdup, const SerialUSBConfig* config) {
+    sdup->config = config;
+    sdup->state = SDU_READY;
+}
+
+void usbStart(USBDriver* usbp, const USBConfig* config) {
+    (void)config;
+    // The host is always connected.
+    usbp->state = USB_ACTIVE;
+}
+
+size_t usbTransmit(USBDriver* usbp, usbep_t ep, const uint8_t* buf, size_t n) {
+    (void)usbp;
+    (void)ep;
+    size_t written = 0;
+    while (written < n) {
+        const ssize_t k = write(serial_fd, buf + written, n - written);
+        if (k > 0) {
+            written += static_cast<size_t>(k);
+        } else if ((k < 0) && (errno == EINTR)) {
+            continue;
+        } else {
+            // The pseudoterminal buffer is full as data is not read. The
+            // remainder of the frame is dropped and the reader resynchronizes
+            // on the next frame delimiter.
+            break;
+        }
+    }
+    serial_bytes_written += written;
+    serial_bytes_dropped += n - written;
+    return written;
+}
+
+rtcnt_t sil_rt_counter(void) {
+    return static_cast<rtcnt_t>(host_ns()*(STM32_SYSCLK/1000000U)/1000U);
+}
+
+rtcnt_t sil_virtual_rt_counter(void) {
+    return static_cast<rtcnt_t>(tick_count*(STM32_SYSCLK/CH_CFG_ST_FREQUENCY));
+}
+
+void chTMObjectInit(time_measurement_t* tmp) {
+    tmp->best = static_cast<rtcnt_t>(-1);
+    tmp->worst = 0;
+    tmp->last = 0;
+    tmp->n = 0;
+    tmp->cumulative = 0;
+    tmp->start = 0;
+}
+
+void chTMStartMeasurementX(time_measurement_t* tmp) {
+    tmp->start = sil_rt_counter();
+}
+
+void chTMStopMeasurementX(time_measurement_t* tmp) {
+    tmp->last = sil_rt_counter() - tmp->start;
+    ++tmp->n;
+    tmp->cumulative += tmp->last;
+    if (tmp->last > tmp->worst) {
+        tmp->worst = tmp->last;
+    }
+    if (tmp->last < tmp->best) {
+        tmp->best = tmp->last;
+    }
+}
@@ -0,0 +1,253 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "ch.h"
+#include "osal.h"
+#include "hal_buffers.h"
+
+/*
+ * Software-in-the-loop (SIL) replacement for the subset of the ChibiOS HAL
+ * used by flimnap. The kernel is built for the ChibiOS POSIX simulator port
+ * (SIMIA32) and the peripherals are virtual:
+ *  - ADC and encoder timer samples are provided by a sil::SensorSource
+ *    (see sensorsource.h), loaded from a recorded log or a script,
+ *  - the DAC stores the last written sample,
+ *  - the haptic loop timer callback is called on system ticks,
+ *  - serial-over-USB data is written to a pseudoterminal or a file,
+ *  - backup SRAM is a static buffer or a memory mapped file,
+ *  - PAL lines only store their state,
+ *  - buffer queues, used by IQHandler, are the portable ChibiOS HAL
+ *    implementation (hal_buffers.c).
+ * The system tick is generated from a virtual clock that runs in real time,
+ * scaled real time or as fast as possible, see hal.cc.
+ *
+ * Line definitions are taken from the board header of the firmware. This
+ * header is also included by hal_buffers.c and the C++ declarations are
+ * excluded when compiled as C.
+ */
+
+#define HAL_USE_PAL                 TRUE
+#define HAL_USE_ADC                 FALSE
+#define HAL_USE_DAC                 FALSE
+#define HAL_USE_EXT                 FALSE
+#define HAL_USE_GPT                 FALSE
+#define HAL_USE_SERIAL_USB          FALSE
+#define HAL_USE_USB                 FALSE
+
+/* MCU constants used by flimnap, see mcuconf.h */
+#define STM32_SYSCLK                168000000U
+#define STM32_USB_OTG_THREAD_PRIO   (NORMALPRIO + 2)
+
+/*
+ * PAL
+ */
+typedef uint32_t ioline_t;
+typedef uint32_t iomode_t;
+
+#define GPIOA                       0U
+#define GPIOB                       1U
+#define GPIOC                       2U
+#define GPIOD                       3U
+#define GPIOE                       4U
+#define GPIOF                       5U
+#define GPIOG                       6U
+#define GPIOH                       7U
+#define GPIOI                       8U
+#define PAL_IOPORTS_WIDTH           16U
+#define PAL_LINE(port, pad)         ((ioline_t)(((port) << 4) | (pad)))
+#define PAL_NOLINE                  0xffffffffU
+#define PAL_PAD(line)               ((line) & 0xfU)
+
+/* Pin modes are not simulated. */
+#define PAL_MODE_RESET              0U
+#define PAL_MODE_INPUT              1U
+#define PAL_MODE_INPUT_ANALOG       2U
+#define PAL_MODE_OUTPUT_PUSHPULL    3U
+#define PAL_MODE_ALTERNATE(n)       (4U | ((n) << 8))
+#define PAL_STM32_PUPDR_FLOATING    0U
+
+#include "board.h"
+
+void palSetLineMode(ioline_t line, iomode_t mode);
+void palSetLine(ioline_t line);
+void palClearLine(ioline_t line);
+void palToggleLine(ioline_t line);
+uint32_t palReadLine(ioline_t line);
+#define palSetPad(port, pad)        palSetLine(PAL_LINE(port, pad))
+#define palClearPad(port, pad)      palClearLine(PAL_LINE(port, pad))
+
+/*
+ * ADC, samples are read by Analog, see analog.cc
+ */
+typedef uint16_t adcsample_t;
+typedef uint16_t adc_channels_num_t;
+
+/*
+ * DAC
+ */
+typedef uint16_t dacsample_t;
+typedef uint32_t dacchannel_t;
+
+typedef enum {
+    DAC_DHRM_12BIT_RIGHT = 0,
+    DAC_DHRM_12BIT_LEFT = 1,
+    DAC_DHRM_8BIT_RIGHT = 2
+} dacdhrmode_t;
+
+typedef struct {
+    uint32_t init;
+    dacdhrmode_t datamode;
+} DACConfig;
+
+typedef struct {
+    uint32_t regshift;
+} DACParams;
+
+typedef struct {
+    const DACParams* params;
+    const DACConfig* config;
+    volatile dacsample_t output[2]; /* last sample written per channel */
+} DACDriver;
+
+extern DACDriver DACD1;
+
+void dacStart(DACDriver* dacp, const DACConfig* config);
+void dacPutChannelX(DACDriver* dacp, dacchannel_t channel, dacsample_t sample);
+
+/*
+ * GPT, timers used in encoder mode (see encoder.cc) and the haptic loop
+ * timer. The callback of a continuous timer is called from the system tick
+ * interrupt and the period is rounded to system ticks.
+ */
+typedef uint32_t gptcnt_t;
+
+typedef enum {
+    GPT_UNINIT = 0,
+    GPT_STOP = 1,
+    GPT_READY = 2,
+    GPT_CONTINUOUS = 3
+} gptstate_t;
+
+typedef struct GPTDriver GPTDriver;
+typedef void (*gptcallback_t)(GPTDriver* gptp);
+
+typedef struct {
+    uint32_t frequency;
+    gptcallback_t callback;
+    uint32_t cr2; /* unused */
+    uint32_t dier; /* unused */
+} GPTConfig;
+
+typedef enum {
+    SIL_ENCODER_STEER = 0, /* TIM5 */
+    SIL_ENCODER_REAR_WHEEL = 1, /* TIM3 */
+    SIL_ENCODER_NONE = 2
+} sil_encoder_t;
+
+struct GPTDriver {
+    gptstate_t state;
+    const GPTConfig* config;
+    sil_encoder_t encoder; /* sensor source channel */
+    volatile gptcnt_t offset; /* counter value minus sensor source count */
+    uint64_t period; /* continuous timer period in system ticks */
+    uint64_t next; /* system tick of the next callback */
+};
+
+extern GPTDriver GPTD3;
+extern GPTDriver GPTD5;
+extern GPTDriver GPTD7;
+
+void gptStart(GPTDriver* gptp, const GPTConfig* config);
+void gptStartContinuous(GPTDriver* gptp, gptcnt_t interval);
+void gptStopTimer(GPTDriver* gptp);
+
+/*
+ * USB and serial-over-USB
+ */
+typedef uint8_t usbep_t;
+
+typedef enum {
+    USB_UNINIT = 0,
+    USB_STOP = 1,
+    USB_READY = 2,
+    USB_SELECTED = 3,
+    USB_ACTIVE = 4,
+    USB_SUSPENDED = 5
+} usbstate_t;
+
+typedef enum {
+    SDU_UNINIT = 0,
+    SDU_STOP = 1,
+    SDU_READY = 2
+} sdustate_t;
+
+typedef struct {
+    uint32_t unused;
+} USBConfig;
+
+typedef struct {
+    volatile usbstate_t state;
+} USBDriver;
+
+typedef struct {
+    USBDriver* usbp;
+    usbep_t bulk_in;
+    usbep_t bulk_out;
+    usbep_t int_in;
+} SerialUSBConfig;
+
+typedef struct {
+    volatile sdustate_t state;
+    const SerialUSBConfig* config;
+} SerialUSBDriver;
+
+extern USBDriver USBD1;
+
+void sduObjectInit(SerialUSBDriver* sdup);
+void sduStart(SerialUSBDriver* sdup, const SerialUSBConfig* config);
+void usbStart(USBDriver* usbp, const USBConfig* config);
+size_t usbTransmit(USBDriver* usbp, usbep_t ep, const uint8_t* buf, size_t n);
+
+/*
+ * Backup SRAM
+ */
+uint8_t* sil_bkpsram(void);
+#define BKPSRAM_BASE                ((uintptr_t)sil_bkpsram())
+
+/*
+ * Realtime counter and time measurement. The SIMIA32 port has no realtime
+ * counter and CH_CFG_USE_TM is disabled in the kernel. Both are expressed in
+ * cycles of the firmware system clock: the realtime counter, used for release
+ * jitter, follows the virtual clock so that it matches the system time at any
+ * time scale, and execution times are measured in elapsed host time.
+ */
+typedef uint32_t rtcnt_t;
+
+typedef struct {
+    rtcnt_t best;
+    rtcnt_t worst;
+    rtcnt_t last;
+    uint32_t n;
+    uint64_t cumulative;
+    rtcnt_t start;
+} time_measurement_t;
+
+rtcnt_t sil_rt_counter(void);
+rtcnt_t sil_virtual_rt_counter(void);
+#define chSysGetRealtimeCounterX()  sil_virtual_rt_counter()
+void chTMObjectInit(time_measurement_t* tmp);
+void chTMStartMeasurementX(time_measurement_t* tmp);
+void chTMStopMeasurementX(time_measurement_t* tmp);
+
+/*
+ * HAL initialization. This reads the SIL configuration from the environment,
+ * loads the sensor source and starts the virtual clock.
+ */
+void halInit(void);
+
+#ifdef __cplusplus
+namespace sil {
+class SensorSource;
+const SensorSource& sensor_source();
+} // namespace sil
+#endif
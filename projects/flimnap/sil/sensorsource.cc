@@ -0,0 +1,187 @@
+#include "sensorsource.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include "flimnapconf.h"
+#include "logreader.h"
+#include "saconversion.h"
+
+namespace {
+    constexpr double two_pi = 6.283185307179586;
+
+    uint32_t wrap_count(double count, uint32_t counts_per_rev) {
+        const double rev = static_cast<double>(counts_per_rev);
+        double c = std::fmod(std::round(count), rev);
+        if (c < 0) {
+            c += rev;
+        }
+        return static_cast<uint32_t>(c) % counts_per_rev;
+    }
+
+    uint16_t torque_to_adc(float torque, uint16_t adc_zero, float magnitude) {
+        const float value = static_cast<float>(adc_zero) +
+            std::round(torque/magnitude*static_cast<float>(sa::ADC_HALF_RANGE));
+        return static_cast<uint16_t>(std::min(std::max(value, 0.0f), 4095.0f));
+    }
+} // namespace
+
+namespace sil {
+
+SensorSource::SensorSource() : m_samples(), m_breakpoints() { }
+
+bool SensorSource::load(const char* filename) {
+    // A recorded log contains the COBS frame delimiter, a script is text.
+    std::ifstream is(filename, std::ios::binary);
+    if (!is) {
+        std::fprintf(stderr, "Unable to open '%s'\n", filename);
+        return false;
+    }
+    const bool is_log = std::find(std::istreambuf_iterator<char>(is),
+            std::istreambuf_iterator<char>(), '\0') != std::istreambuf_iterator<char>();
+    return is_log ? load_log(filename) : load_script(filename);
+}
+
+bool SensorSource::load_log(const char* filename) {
+    std::ifstream is(filename, std::ios::binary);
+    util::LogReader reader(is);
+    SimulationMessage msg;
+    bool first = true;
+    uint32_t t0 = 0;
+    while (reader.next(&msg)) {
+        if (!msg.has_sensors) {
+            continue;
+        }
+        if (first) {
+            t0 = msg.timestamp;
+            first = false;
+        }
+        const sample_t s = {
+            static_cast<uint16_t>(msg.sensors.kistler_measured_torque),
+            static_cast<uint16_t>(msg.sensors.kollmorgen_actual_torque),
+            msg.sensors.steer_encoder_count,
+            msg.sensors.has_rear_wheel_encoder_count ?
+                static_cast<uint32_t>(msg.sensors.rear_wheel_encoder_count) : 0U
+        };
+        m_samples.emplace_back(msg.timestamp - t0, s);
+    }
+    if (m_samples.empty()) {
+        std::fprintf(stderr, "No sensor samples in log '%s'\n", filename);
+        return false;
+    }
+    std::fprintf(stderr, "Loaded %zu sensor samples from log '%s' (%zu decode errors)\n",
+            m_samples.size(), filename, reader.decode_errors());
+    return true;
+}
+
+bool SensorSource::load_script(const char* filename) {
+    std::ifstream is(filename);
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(is, line)) {
+        ++line_number;
+        const size_t begin = line.find_first_not_of(" \t\r");
+        if ((begin == std::string::npos) || (line[begin] == '#')) {
+            continue;
+        }
+        std::istringstream ls(line);
+        double t;
+        breakpoint_t b;
+        if (!(ls >> t >> b.steer_torque >> b.steer_angle >> b.v)) {
+            std::fprintf(stderr, "Invalid breakpoint on line %zu of '%s'\n", line_number, filename);
+            return false;
+        }
+        b.time = static_cast<uint32_t>(std::round(t*flimnap::system_tick_frequency));
+        b.distance = 0.0;
+        if (!m_breakpoints.empty()) {
+            const breakpoint_t& a = m_breakpoints.back();
+            if (b.time <= a.time) {
+                std::fprintf(stderr, "Breakpoint times must increase, line %zu of '%s'\n",
+                        line_number, filename);
+                return false;
+            }
+            const double dt = static_cast<double>(b.time - a.time)/flimnap::system_tick_frequency;
+            b.distance = a.distance + 0.5*(a.v + b.v)*dt;
+        }
+        m_breakpoints.push_back(b);
+    }
+    if (m_breakpoints.empty()) {
+        std::fprintf(stderr, "No breakpoints in script '%s'\n", filename);
+        return false;
+    }
+    std::fprintf(stderr, "Loaded %zu breakpoints from script '%s'\n",
+            m_breakpoints.size(), filename);
+    return true;
+}
+
+SensorSource::sample_t SensorSource::sample(uint32_t time) const {
+    if (!m_samples.empty()) {
+        // most recent sample at or before time
+        auto it = std::upper_bound(m_samples.begin(), m_samples.end(), time,
+                [](uint32_t t, const std::pair<uint32_t, sample_t>& s) {
+                    return t < s.first;
+                });
+        if (it != m_samples.begin()) {
+            --it;
+        }
+        return it->second;
+    }
+    return interpolate(time);
+}
+
+SensorSource::sample_t SensorSource::interpolate(uint32_t time) const {
+    float steer_torque = 0.0f;
+    float steer_angle = 0.0f;
+    double distance = 0.0;
+
+    if (!m_breakpoints.empty()) {
+        auto it = std::upper_bound(m_breakpoints.begin(), m_breakpoints.end(), time,
+                [](uint32_t t, const breakpoint_t& b) {
+                    return t < b.time;
+                });
+        if (it == m_breakpoints.begin()) {
+            steer_torque = it->steer_torque;
+            steer_angle = it->steer_angle;
+        } else if (it == m_breakpoints.end()) {
+            const breakpoint_t& a = m_breakpoints.back();
+            steer_torque = a.steer_torque;
+            steer_angle = a.steer_angle;
+            distance = a.distance + a.v*static_cast<double>(time - a.time)/
+                flimnap::system_tick_frequency;
+        } else {
+            const breakpoint_t& a = *(it - 1);
+            const breakpoint_t& b = *it;
+            const double h = static_cast<double>(b.time - a.time)/flimnap::system_tick_frequency;
+            const double s = static_cast<double>(time - a.time)/flimnap::system_tick_frequency;
+            const float f = static_cast<float>(s/h);
+            steer_torque = a.steer_torque + f*(b.steer_torque - a.steer_torque);
+            steer_angle = a.steer_angle + f*(b.steer_angle - a.steer_angle);
+            distance = a.distance + a.v*s + 0.5*(b.v - a.v)/h*s*s;
+        }
+    }
+
+    // The rear wheel encoder count decreases for positive speed, see the
+    // speed and rear wheel angle calculation in main.cc.
+    const double rear_wheel_angle = distance/sa::REAR_WHEEL_RADIUS;
+    return {
+        torque_to_adc(steer_torque, sa::KISTLER_ADC_ZERO_OFFSET, sa::MAX_KISTLER_TORQUE),
+        sa::KOLLMORGEN_ADC_ZERO_OFFSET,
+        wrap_count(steer_angle/two_pi*sa::RLS_ROLIN_COUNTS_PER_REV, sa::RLS_ROLIN_COUNTS_PER_REV),
+        wrap_count(-rear_wheel_angle/two_pi*sa::RLS_GTS35_COUNTS_PER_REV, sa::RLS_GTS35_COUNTS_PER_REV)
+    };
+}
+
+uint32_t SensorSource::duration() const {
+    if (!m_samples.empty()) {
+        return m_samples.back().first;
+    }
+    if (!m_breakpoints.empty()) {
+        return m_breakpoints.back().time;
+    }
+    return 0;
+}
+
+} // namespace sil
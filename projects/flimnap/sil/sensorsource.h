@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace sil {
+
+/*
+ * Source of the raw sensor samples of the virtual flimnap peripherals: the
+ * Kistler and Kollmorgen torque ADC samples and the steer and rear wheel
+ * encoder counts, as a function of system time.
+ *
+ * Samples are loaded from either
+ *  - a recorded log (seriallog output, COBS framed SimulationMessages), where
+ *    the recorded sensor samples are held from each message timestamp to the
+ *    next, or
+ *  - a script, a text file with one breakpoint per line:
+ *        time [s]  steer torque [N-m]  steer angle [rad]  speed [m/s]
+ *    Values are interpolated linearly between breakpoints and converted to
+ *    raw samples with the sensor constants of saconversion.h. Empty lines and
+ *    lines starting with '#' are ignored.
+ * The last sample is held after the end of the source. Without a source, all
+ * samples correspond to zero torque, zero angle and zero speed.
+ */
+class SensorSource {
+    public:
+        struct sample_t {
+            uint16_t kistler; // ADC12
+            uint16_t motor; // ADC13
+            uint32_t steer_count; // TIM5
+            uint32_t rear_wheel_count; // TIM3
+        };
+
+        SensorSource();
+        bool load(const char* filename); // returns false on error
+        sample_t sample(uint32_t time) const; // time in system ticks
+        uint32_t duration() const; // system ticks
+
+    private:
+        struct breakpoint_t {
+            uint32_t time; // system ticks
+            float steer_torque;
+            float steer_angle;
+            float v;
+            double distance; // traveled distance at time
+        };
+
+        std::vector<std::pair<uint32_t, sample_t>> m_samples; // recorded log
+        std::vector<breakpoint_t> m_breakpoints; // script
+
+        bool load_log(const char* filename);
+        bool load_script(const char* filename);
+        sample_t interpolate(uint32_t time) const;
+};
+
+} // namespace sil
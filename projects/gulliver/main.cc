@@ -22,13 +22,14 @@
 
 #include "gitsha1.h"
 #include "blink.h"
+#include "periodictask.h"
 #include "usbconfig.h"
 #include "saconfig.h"
 
 #include "parameters.h"
 
 namespace {
-    const uint32_t dt_ms = 1; /* ms */
+    rt::PeriodicTask print_task({"print", MS2ST(1), rt::miss_policy_t::skip, nullptr});
 
     /* sensors */
     Encoder encoder_steer(sa::RLS_ROLIN_ENC, sa::RLS_ROLIN_ENC_INDEX_CFG);
@@ -82,10 +83,11 @@ int main(void) {
      * Normal main() thread activity, in this demo it prints the system time
      * and steer encoder count.
      */
+    print_task.start();
     while (true) {
         /* get sensor measurements */
         printf("[%.7s] realtime counter: %u\tsteer encoder: %u\r\n",
                 g_GITSHA1, chSysGetRealtimeCounterX(), encoder_steer.count());
-        chThdSleepMilliseconds(dt_ms);
+        print_task.wait_for_next_release();
     }
 }
@@ -21,13 +21,14 @@
 
 #include "gitsha1.h"
 #include "blink.h"
+#include "periodictask.h"
 #include "usbconfig.h"
 #include "saconfig.h"
 
 #include "parameters.h"
 
 namespace {
-    const uint32_t dt_ms = 1; /* ms */
+    rt::PeriodicTask print_task({"print", MS2ST(1), rt::miss_policy_t::skip, nullptr});
 
     /* sensors */
     Analog analog;
@@ -91,10 +92,11 @@ int main(void) {
      * Normal main() thread activity, in this demo it prints the system time
      * and measured torque values after converting from ADC counts to Nm.
      */
+    print_task.start();
     while (true) {
         /* get sensor measurements */
         printf("[%.7s] realtime counter: %u\tkistler: %u\tkollmorgen measured: %u\r\n",
                 g_GITSHA1, chSysGetRealtimeCounterX(), analog.get_adc12(), analog.get_adc13());
-        chThdSleepMilliseconds(dt_ms);
+        print_task.wait_for_next_release();
     }
 }
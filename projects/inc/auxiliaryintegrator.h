@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "seqlock.h"
+// bicycle submodule imports
+#include "bicycle/bicycle.h"
+
+namespace sim {
+
+/*
+ * This template class integrates the auxiliary states x, y and rear wheel
+ * angle of a bicycle model (template argument Model) from a history of
+ * dynamic state samples, so that the auxiliary states can be integrated at a
+ * lower rate and in a different thread than the dynamic state.
+ *
+ * The writer pushes a sample after every dynamic state update. A sample
+ * contains the speed and sample period used for the update and the yaw angle
+ * and yaw rate after the update. The reader integrates all samples pushed
+ * since the previous call to integrate() with Simpson's rule, where the yaw
+ * angle at the midpoint of a sample period is given by the cubic Hermite
+ * interpolant of the yaw angles and yaw rates at the ends:
+ *     x' = c v cos(yaw), y' = c v sin(yaw), rear wheel angle' = r v
+ * with c and r the position and rear wheel rates per unit speed of the model.
+ * The pitch angle is not integrated and must be solved by the reader.
+ *
+ * The history holds N samples (template argument N, a power of 2). If the
+ * reader falls behind by more than N samples, the missed samples are skipped
+ * and the yaw angle is interpolated over the gap. The writer sets the
+ * auxiliary state and current sample with reset(), which is applied by the
+ * reader before the next sample.
+ *
+ * The writer must be a single thread and must not have a lower priority than
+ * the reader. set_rates() must be called before samples are pushed.
+ */
+template <typename Model, size_t N>
+class AuxiliaryStateIntegrator {
+    static_assert(std::is_base_of<model::Bicycle, Model>::value,
+            "Invalid template parameter type for sim::AuxiliaryStateIntegrator");
+    static_assert((N > 1) && ((N & (N - 1)) == 0),
+            "History size must be a power of 2");
+
+    public:
+        using model_t = Model;
+        using real_t = model::real_t;
+        using state_t = typename model_t::state_t;
+        using input_t = typename model_t::input_t;
+        using auxiliary_state_t = typename model_t::auxiliary_state_t;
+        using auxiliary_state_index_t = typename model_t::auxiliary_state_index_t;
+
+        struct sample_t {
+            real_t v; // speed during the sample period
+            real_t dt; // sample period
+            real_t yaw_angle; // at the end of the sample period
+            real_t yaw_rate; // at the end of the sample period
+        };
+
+        AuxiliaryStateIntegrator();
+
+        // determine the position and rear wheel rates per unit speed from the
+        // auxiliary state integration of the model
+        void set_rates(const model_t& model);
+        real_t position_rate() const; // per unit speed
+        real_t rear_wheel_rate() const; // per unit speed
+
+        // writer
+        void reset(const auxiliary_state_t& auxiliary_state, const sample_t& sample);
+        void push(const sample_t& sample);
+
+        // reader
+        void integrate(); // integrate all samples pushed since the previous call
+        const auxiliary_state_t& auxiliary_state() const; // pitch angle is unchanged
+        uint32_t skipped_samples() const; // total number of samples missed by the reader
+
+        // sample after a dynamic state update with state x and input u
+        static sample_t make_sample(const model_t& model, const state_t& x, const input_t& u);
+
+    private:
+        struct origin_t {
+            auxiliary_state_t auxiliary_state;
+            sample_t sample;
+            uint32_t index; // index of the first sample after the reset
+        };
+
+        real_t m_position_rate; // per unit speed
+        real_t m_rear_wheel_rate; // per unit speed
+
+        // shared
+        std::array<sample_t, N> m_history;
+        std::atomic<uint32_t> m_head; // index of the next sample to be pushed
+        Seqlock<origin_t> m_origin;
+
+        // reader
+        uint32_t m_tail; // index of the next sample to be integrated
+        uint32_t m_origin_sequence;
+        sample_t m_sample; // most recently integrated sample
+        auxiliary_state_t m_auxiliary_state;
+        uint32_t m_skipped_samples;
+
+        void step(const sample_t& sample, real_t dt);
+};
+
+} // namespace sim
+
+#include "auxiliaryintegrator.hh"
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "pitchtable.h"
+// bicycle submodule imports
+#include "bicycle/bicycle.h"
+
+namespace sim {
+
+/*
+ * This template class advances a batch of bicycles sharing the same bicycle
+ * model (template argument Model), and thus the same speed and discrete state
+ * space matrices. It is intended for host-side parameter sweeps and replay.
+ *
+ * The states are stored as a structure of arrays: the values of one state
+ * element for all bicycles are contiguous. A step then computes
+ *     x = Ad x + Bd u
+ * for all bicycles with one matrix-vector product where every multiply-add
+ * operates on a vector of bicycles. AVX2 and NEON kernels are used when
+ * available for single precision models, with a scalar fallback otherwise.
+ *
+ * The auxiliary states are integrated alongside:
+ *  - x, y: rear contact point, moving at the model speed with the yaw angle
+ *    averaged over the step
+ *  - rear wheel angle: rotating at the rate given by the model
+ *  - pitch angle: looked up in a pitch table if set, otherwise
+ *    unchanged. A refinement of the table pitch starts from the previous
+ *    pitch angle. Bicycles with roll or steer outside the table keep the
+ *    previous pitch angle.
+ *
+ * Arrays are padded to a multiple of the widest vector width. Padding
+ * elements are stepped but are otherwise unused.
+ */
+template <typename Model>
+class BatchBicycle {
+    static_assert(std::is_base_of<model::Bicycle, Model>::value,
+            "Invalid template parameter type for sim::BatchBicycle");
+
+    public:
+        using model_t = Model;
+        using real_t = model::real_t;
+        using state_index_t = typename model_t::state_index_t;
+        using input_index_t = typename model_t::input_index_t;
+        using auxiliary_state_index_t = typename model_t::auxiliary_state_index_t;
+        using full_state_t = typename model_t::full_state_t;
+        using input_t = typename model_t::input_t;
+
+        static constexpr size_t n = model_t::n;
+        static constexpr size_t m = model_t::m;
+        static constexpr size_t p = 4; // number of auxiliary states
+        static constexpr size_t lane_alignment = 8; // elements, widest vector
+
+        BatchBicycle(const model_t& model, size_t size);
+
+        void set_model(const model_t& model); // change speed or sample period for all bicycles
+        void set_pitch_table(const PitchTableBase* table, // use table pitch
+                real_t max_error); // refine pitch if the table error exceeds this value
+        void step(); // advance all bicycles by one sample period with the current inputs
+        void step(size_t count);
+
+        // arrays of a single element for all bicycles, of length size()
+        real_t* state(state_index_t index);
+        const real_t* state(state_index_t index) const;
+        real_t* input(input_index_t index);
+        const real_t* input(input_index_t index) const;
+        real_t* auxiliary_state(auxiliary_state_index_t index);
+        const real_t* auxiliary_state(auxiliary_state_index_t index) const;
+
+        // gather/scatter the full state of a single bicycle
+        full_state_t full_state(size_t bicycle) const;
+        void set_full_state(size_t bicycle, const full_state_t& full_state);
+        void set_input(size_t bicycle, const input_t& u);
+
+        size_t size() const;
+        size_t stride() const; // padded array length
+        real_t v() const;
+        real_t dt() const;
+
+    private:
+        const size_t m_size;
+        const size_t m_stride;
+        real_t m_Ad[n*n]; // row-major
+        real_t m_Bd[n*m]; // row-major
+        real_t m_v;
+        real_t m_dt;
+        real_t m_position_step; // rear contact point travel per step
+        real_t m_rear_wheel_step; // rear wheel rotation per step
+        const PitchTableBase* m_pitch_table; // may be nullptr
+        real_t m_pitch_max_error; // allowed pitch table interpolation error
+        std::vector<real_t> m_state; // n arrays, double buffered
+        std::vector<real_t> m_next_state;
+        std::vector<real_t> m_input; // m arrays
+        std::vector<real_t> m_auxiliary_state; // p arrays
+
+        void update_state();
+        void update_auxiliary_state();
+
+        template <typename E>
+        static constexpr size_t index(E e) {
+            return static_cast<size_t>(e);
+        }
+};
+
+} // namespace sim
+
+#include "batchbicycle.hh"
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "observertraits.h"
+// bicycle submodule imports
+#include "bicycle/bicycle.h"
+#include "constants.h" // real_t
+
+namespace sim {
+
+/*
+ * Checkpoint of a sim::Bicycle for a bicycle model (template argument Model).
+ * This contains the model speed and sample period, the full state and the
+ * observer state estimate, error covariance and Kalman gain. Observer
+ * elements that are not provided by the observer type are zero.
+ *
+ * The checkpoint is trivially copyable and is stored as raw bytes, e.g. in
+ * backup SRAM to resume after a firmware restart or as constexpr data
+ * generated at build time. The header identifies the format and element
+ * counts and a CRC-32 of all preceding bytes is appended with seal(). A
+ * checkpoint can only be restored on the same platform (float format and
+ * byte order) with the same model type.
+ */
+template <typename Model>
+struct BicycleCheckpoint {
+    using model_t = Model;
+    using real_t = model::real_t;
+
+    static constexpr uint32_t format = 0x4b504350; // "PCPK"
+    static constexpr uint32_t version = 1;
+    static constexpr size_t n = model_t::n;
+    static constexpr size_t l = model_t::l;
+    static constexpr size_t full_n = model_t::full_state_t::RowsAtCompileTime;
+
+    enum class observer_content_t: uint32_t {
+        none = 0, // no observer state
+        state, // state estimate only
+        covariance // state estimate, error covariance and Kalman gain
+    };
+
+    uint32_t header_format;
+    uint32_t header_version;
+    uint32_t header_size; // sizeof(BicycleCheckpoint)
+    observer_content_t observer_content;
+    real_t v;
+    real_t dt;
+    real_t full_state[full_n];
+    real_t x[n]; // state estimate
+    real_t P[n*n]; // error covariance, column-major
+    real_t K[n*l]; // Kalman gain, column-major
+    uint32_t crc; // CRC-32 of all preceding bytes
+
+    void seal(); // set header and CRC
+    void invalidate(); // set a CRC that does not match
+    bool valid() const; // check header and CRC
+};
+
+/*
+ * Checkpoint tagged with the version of the firmware that saved it, e.g. the
+ * git SHA-1, as stored in backup SRAM.
+ *
+ * claim() returns the checkpoint if it has been tagged with the given
+ * version. Otherwise the checkpoint is invalidated before the tag is
+ * overwritten, so that a checkpoint saved by another version is not restored
+ * if the firmware restarts before a new checkpoint is saved.
+ */
+template <typename Checkpoint, size_t TagSize = 8>
+struct VersionedCheckpoint {
+    char tag[TagSize];
+    Checkpoint checkpoint;
+
+    // returns nullptr if the checkpoint has been saved by another version
+    const Checkpoint* claim(const char* version);
+};
+
+/* checkpoint functions for different observer variants */
+template <typename Model, typename Observer, typename Enable = void>
+struct observer_checkpoint {
+    // observer without state estimate (std::nullptr_t)
+    static void save(const Observer& observer, BicycleCheckpoint<Model>* c);
+    static void restore(Observer& observer, const BicycleCheckpoint<Model>& c);
+};
+
+template <typename Model, typename Observer>
+struct observer_checkpoint<Model, Observer,
+        typename std::enable_if<is_kalman_observer<Observer>::value>::type> {
+    // Observers with a deferred covariance update determine the Kalman gain
+    // for the next update in update_error_covariance() and the gain is
+    // restored with the error covariance. Other observers determine the gain
+    // from the error covariance in the next update.
+    static void save(const Observer& observer, BicycleCheckpoint<Model>* c);
+    static void restore(Observer& observer, const BicycleCheckpoint<Model>& c);
+
+    private:
+        static void set_P(Observer& observer, const BicycleCheckpoint<Model>& c,
+                std::true_type has_deferred_covariance_update);
+        static void set_P(Observer& observer, const BicycleCheckpoint<Model>& c,
+                std::false_type has_deferred_covariance_update);
+};
+
+template <typename Model, typename Observer>
+struct observer_checkpoint<Model, Observer,
+        typename std::enable_if<is_fixed_point_observer<Observer>::value>::type> {
+    // The steady-state gain is looked up in the gain schedule and is only
+    // saved.
+    static void save(const Observer& observer, BicycleCheckpoint<Model>* c);
+    static void restore(Observer& observer, const BicycleCheckpoint<Model>& c);
+};
+
+// CRC-32 (IEEE 802.3) of size bytes starting at data
+inline uint32_t crc32(const void* data, size_t size);
+
+} // namespace sim
+
+#include "checkpoint.hh"
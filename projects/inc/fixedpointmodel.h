@@ -0,0 +1,120 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include "fixedpoint.h"
+// bicycle submodule imports
+#include "bicycle/bicycle.h"
+
+namespace sim {
+
+/*
+ * This template class is a bicycle model (template argument Model) that
+ * performs the discrete state update and output calculation in Q31 fixed-point
+ * arithmetic. It can be used as the model of sim::Bicycle in place of the
+ * floating-point model.
+ *
+ * Each state, input and output element has a fixed exponent that determines
+ * its range (see below). The discrete state space matrices are quantized on
+ * construction and on set_v_dt(), with the ratio of the element ranges folded
+ * into the coefficients so that no shifts are required per element. Ad and Bd
+ * share a single exponent and are applied with a single 64-bit accumulator
+ * per state element, which avoids overflow as the exponent is chosen from the
+ * absolute row sums. Results are rounded and saturated.
+ *
+ * The floating-point interface (update_state(), calculate_output()) converts
+ * to and from Q31 for each call. sim::FixedPointObserver uses the fixed-point
+ * interface directly and only converts inputs and measurements.
+ *
+ * Models copied from a sim::ModelCache keep their quantized matrices so that a
+ * speed change does not require quantization.
+ *
+ * As the concrete bicycle models are final, this class derives from
+ * model::Bicycle and is initialized with a copy of a Model instance. Model must
+ * therefore differ from model::Bicycle only in its parameters.
+ */
+template <typename Model>
+class FixedPointModel : public model::Bicycle {
+    static_assert(std::is_base_of<model::Bicycle, Model>::value,
+            "Invalid template parameter type for sim::FixedPointModel");
+
+    public:
+        using real_t = model::real_t;
+        using q31_t = util::q31_t;
+        using state_t = model::Bicycle::state_t;
+        using input_t = model::Bicycle::input_t;
+        using output_t = model::Bicycle::output_t;
+        using measurement_t = model::Bicycle::measurement_t;
+        static constexpr size_t n = model::Bicycle::n;
+        static constexpr size_t m = model::Bicycle::m;
+        static constexpr size_t l = model::Bicycle::l;
+        using q_state_t = std::array<q31_t, n>;
+        using q_input_t = std::array<q31_t, m>;
+        using q_output_t = std::array<q31_t, l>;
+
+        // Element ranges are [-2^e, 2^e) with exponent e:
+        //  state: yaw angle, roll angle, steer angle [rad], roll rate, steer rate [rad/s]
+        //  input: roll torque, steer torque [N-m]
+        //  output: yaw angle, steer angle [rad]
+        static constexpr std::array<int, n> state_exponent = {{7, 2, 2, 5, 5}};
+        static constexpr std::array<int, m> input_exponent = {{10, 10}};
+        static constexpr std::array<int, l> output_exponent = {{7, 2}};
+        static_assert((n == 5) && (m == 2) && (l == 2),
+                "Fixed-point element ranges are defined for the Whipple model");
+
+        FixedPointModel(real_t v, real_t dt);
+
+        virtual void set_v_dt(real_t v, real_t dt) override;
+        virtual state_t update_state(const state_t& x, const input_t& u = input_t::Zero(),
+                const measurement_t& z = measurement_t::Zero()) const override;
+        virtual output_t calculate_output(const state_t& x,
+                const input_t& u = input_t::Zero()) const override;
+
+        // fixed-point interface
+        q_state_t update_state(const q_state_t& x, const q_input_t& u) const;
+        q_output_t calculate_output(const q_state_t& x) const;
+
+        static q_state_t state_to_q31(const state_t& x);
+        static q_input_t input_to_q31(const input_t& u);
+        static q_output_t output_to_q31(const output_t& y);
+        static state_t state_from_q31(const q_state_t& x);
+        static output_t output_from_q31(const q_output_t& y);
+
+        // Quantize the Rows x Cols matrix A with rows scaled to exponents
+        // row_exponent and columns scaled from exponents column_exponent.
+        // Coefficients are stored in row-major order. Returns the shift to
+        // use with util::multiply_q31().
+        template <size_t Rows, size_t Cols, typename Matrix>
+        static unsigned int quantize(const Matrix& A,
+                const std::array<int, Rows>& row_exponent,
+                const std::array<int, Cols>& column_exponent,
+                q31_t* coefficients);
+
+    private:
+        // conversion factors to Q31
+        static constexpr std::array<float, n> state_scale = {{
+            util::q31_scale(state_exponent[0]), util::q31_scale(state_exponent[1]),
+            util::q31_scale(state_exponent[2]), util::q31_scale(state_exponent[3]),
+            util::q31_scale(state_exponent[4])}};
+        static constexpr std::array<float, m> input_scale = {{
+            util::q31_scale(input_exponent[0]), util::q31_scale(input_exponent[1])}};
+        static constexpr std::array<float, l> output_scale = {{
+            util::q31_scale(output_exponent[0]), util::q31_scale(output_exponent[1])}};
+        // conversion factors from Q31
+        static constexpr std::array<float, n> state_inverse_scale = {{
+            1/state_scale[0], 1/state_scale[1], 1/state_scale[2],
+            1/state_scale[3], 1/state_scale[4]}};
+        static constexpr std::array<float, l> output_inverse_scale = {{
+            1/output_scale[0], 1/output_scale[1]}};
+
+        std::array<q31_t, n*(n + m)> m_ABd; // [Ad Bd]
+        unsigned int m_ABd_shift;
+        std::array<q31_t, l*n> m_Cd;
+        unsigned int m_Cd_shift;
+
+        void quantize_model();
+};
+
+} // namespace sim
+
+#include "fixedpointmodel.hh"
@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <type_traits>
+#include "fixedpoint.h"
+#include "fixedpointmodel.h"
+#include "kalmanschedule.h"
+#include "observertraits.h"
+// bicycle submodule imports
+#include "observer.h"
+
+namespace sim {
+
+/*
+ * This template class is a steady-state Kalman filter observer for a
+ * fixed-point bicycle model (template argument Model, a sim::FixedPointModel).
+ * The state estimate is kept in Q31 and is updated with
+ *     x = Ad x + Bd u
+ *     x = x + K (z - C x)
+ * using saturating fixed-point arithmetic. Only the input and measurement are
+ * converted to Q31 and the state estimate is converted to floating-point after
+ * each update.
+ *
+ * The steady-state Kalman gain K is looked up in a gain schedule and quantized
+ * when the model speed or sample period changes. If the speed is not in the
+ * schedule, the previous gain is used. Without a gain schedule, K is zero and
+ * the observer only predicts the state.
+ */
+template <typename Model>
+class FixedPointObserver final : public observer::ObserverBase {
+    public:
+        using model_t = Model;
+        using real_t = model::real_t;
+        using q31_t = util::q31_t;
+        using state_t = typename model_t::state_t;
+        using input_t = typename model_t::input_t;
+        using measurement_t = typename model_t::measurement_t;
+        using kalman_gain_t = typename KalmanGainScheduleBase<model_t>::kalman_gain_t;
+        using schedule_t = KalmanGainScheduleBase<model_t>;
+
+        FixedPointObserver(model_t& system);
+
+        void set_gain_schedule(const schedule_t* schedule);
+        void reset();
+        void update_state(const input_t& u, const measurement_t& z);
+
+        void set_x(const state_t& x);
+        const state_t& x() const;
+        const state_t& state() const;
+        const kalman_gain_t& K() const; // gain used in the most recent update
+        real_t dt() const;
+        model_t& system() const;
+
+    private:
+        model_t& m_system;
+        const schedule_t* m_schedule;
+        typename model_t::q_state_t m_x_q;
+        state_t m_x;
+        kalman_gain_t m_K;
+        std::array<q31_t, model_t::n*model_t::l> m_K_q;
+        unsigned int m_K_shift;
+        real_t m_v; // speed of quantized gain
+        real_t m_dt; // sample period of quantized gain
+
+        void update_gain();
+};
+
+template <typename Model>
+struct is_fixed_point_observer<FixedPointObserver<Model>> : std::true_type { };
+
+} // namespace sim
+
+#include "fixedpointobserver.hh"
@@ -10,10 +10,24 @@
  */
 namespace haptic {
 
+/*
+ * Coefficients of a handlebar torque that is linear in the state and input:
+ *      T_m = a'*x + b'*u
+ * The coefficients depend on the model speed and are determined once per
+ * model update, so the torque can be evaluated at a higher rate with a few
+ * multiply-adds.
+ */
+struct linear_form_t {
+    model::Bicycle::state_t a;
+    model::Bicycle::input_t b;
+};
+
 class HandlebarBase {
     public:
         virtual model::real_t torque(
                 const model::Bicycle::state_t& x, const model::Bicycle::input_t& u) const = 0;
+        // coefficients for the current model speed, torque(x, u) = a'*x + b'*u
+        virtual linear_form_t linear_form() const = 0;
 
     protected:
         ~HandlebarBase() { }
@@ -26,12 +40,18 @@ class null_t final : public HandlebarBase {
         virtual model::real_t torque(
                 const model::Bicycle::state_t& x,
                 const model::Bicycle::input_t& u = model::Bicycle::input_t::Zero()) const override;
+        virtual linear_form_t linear_form() const override;
 };
 
 /*
  * This class calculates handlebar feedback torque using a simplified static
  * equation of motion for the physical handlebars and ignoring the torque sensor
  * measurement.
+ *
+ * The Handlebar classes cache the coefficients of the torque for the model
+ * speed and recompute them when the speed changes. As sim::Bicycle quantizes
+ * the model speed, this happens only after a quantized speed change. The
+ * torque must not be calculated concurrently from different threads.
  */
 class HandlebarStatic final : public HandlebarBase {
     public:
@@ -40,9 +60,14 @@ class HandlebarStatic final : public HandlebarBase {
         virtual model::real_t torque(
                 const model::Bicycle::state_t& x,
                 const model::Bicycle::input_t& u = model::Bicycle::input_t::Zero()) const override;
+        virtual linear_form_t linear_form() const override;
 
     private:
         model::Bicycle& m_bicycle;
+        mutable model::real_t m_v; // model speed of the coefficients
+        mutable model::real_t m_steer_stiffness; // feedback torque per steer angle
+
+        void update_coefficients() const;
 };
 
 /*
@@ -55,11 +80,16 @@ class HandlebarDynamic final : public HandlebarBase {
         virtual model::real_t torque(
                 const model::Bicycle::state_t& x,
                 const model::Bicycle::input_t& u = model::Bicycle::input_t::Zero()) const override;
+        virtual linear_form_t linear_form() const override;
         model::real_t moment_of_inertia() const;
 
     private:
         model::Bicycle& m_bicycle;
         model::real_t m_I_delta;
+        mutable model::real_t m_v; // model speed of the coefficients
+        mutable linear_form_t m_form;
+
+        void update_coefficients() const;
 };
 
 } // namespace  // namespace haptic
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include "haptic.h"
+#include "seqlock.h"
+/* bicycle submodule imports */
+#include "bicycle/bicycle.h"
+
+namespace haptic {
+
+/*
+ * This class provides the handlebar motor reference (steer velocity or
+ * torque) to a haptic loop running at a higher rate than the dynamics loop.
+ *
+ * After each dynamics update the writer pushes a sample with the reference,
+ * its time derivative and its sensitivity to the measured steer torque T:
+ *      r(t, T) = r0 + g*(T - T0) + (t - t0)*(r0' + g'*(T - T0))
+ * where t0 is the time of the sensor measurements used for the update and T0
+ * the measured steer torque. The reader evaluates the reference at time t
+ * with a torque measurement made in the haptic loop, so that the reference
+ * responds to the rider before the next dynamics update. The reference is
+ * evaluated from the latest two samples in one of the following modes:
+ *  - hold: the latest reference, as set by the dynamics loop,
+ *  - interpolate: linear interpolation between the previous and latest
+ *    reference, delayed by a dynamics period and without overshoot,
+ *  - extrapolate: first order extrapolation from the latest sample, limited
+ *    to max_extrapolation after which the reference is held.
+ * The torque feedthrough g*(T - T0) is added in all modes except hold.
+ *
+ * Samples are shared with a Seqlock. The reader must be a single thread or
+ * interrupt handler and uses the previous samples if it preempts a push.
+ */
+class ReferenceInterpolator {
+    public:
+        using real_t = model::real_t;
+        enum class mode_t: uint8_t {hold, interpolate, extrapolate};
+
+        struct sample_t {
+            uint32_t time; // time of the measurements in ticks, t0
+            real_t reference; // r0
+            real_t reference_rate; // r0'
+            real_t torque; // measured steer torque, T0
+            real_t torque_gain; // g
+            real_t torque_rate_gain; // g'
+        };
+
+        ReferenceInterpolator(real_t tick_period, real_t max_extrapolation,
+                mode_t mode = mode_t::extrapolate);
+
+        // writer
+        void reset(const sample_t& sample); // set previous and latest sample
+        void push(const sample_t& sample);
+
+        // reader
+        real_t reference(uint32_t time, real_t torque);
+        uint32_t missed_reads() const; // reads that preempted a push
+        mode_t mode() const;
+
+        /*
+         * Sample of a reference r = a'*x + b'*u after a dynamics update with
+         * state x and input u, with the measured steer torque added to the
+         * steer torque input. The input is held constant:
+         *      r0' = a'*(A*x + B*u), g = b_T, g' = a'*B(:, T)
+         */
+        static sample_t make_sample(const model::Bicycle& model, const linear_form_t& form,
+                const model::Bicycle::state_t& x, const model::Bicycle::input_t& u,
+                uint32_t time, real_t torque);
+
+    private:
+        struct samples_t {
+            sample_t previous;
+            sample_t latest;
+        };
+
+        const real_t m_tick_period;
+        const real_t m_max_extrapolation;
+        const mode_t m_mode;
+
+        // writer
+        sample_t m_latest;
+
+        // shared
+        Seqlock<samples_t> m_samples;
+
+        // reader
+        samples_t m_read_samples;
+        uint32_t m_missed_reads;
+};
+
+} // namespace haptic
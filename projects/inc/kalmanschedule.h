@@ -0,0 +1,193 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "kalmanupdate.h"
+#include "modelcache.h"
+#include "observertraits.h"
+#include "smallmatrix.h"
+// bicycle submodule imports
+#include "bicycle/bicycle.h"
+#include "kalman.h"
+#include "observer.h"
+
+namespace sim {
+
+/*
+ * Interface used by sim::ScheduledKalman to look up the steady-state Kalman
+ * gain and error covariance for a quantized forward speed.
+ */
+template <typename Model>
+class KalmanGainScheduleBase {
+    public:
+        using real_t = model::real_t;
+        using kalman_gain_t = typename observer::Kalman<Model>::kalman_gain_t;
+        using error_covariance_t = typename observer::Kalman<Model>::error_covariance_t;
+        struct steady_state_t {
+            kalman_gain_t K; // steady-state Kalman gain
+            error_covariance_t P; // steady-state error covariance after measurement update
+        };
+
+        // return the steady-state solution for a model discretized at speed v
+        // and sample period dt or nullptr if the speed is not in the schedule
+        virtual const steady_state_t* steady_state(real_t v, real_t dt) const = 0;
+
+    protected:
+        ~KalmanGainScheduleBase() { }
+};
+
+/*
+ * This template class holds the steady-state Kalman gain and error covariance
+ * for each model in a sim::ModelCache (template arguments Model and N). These
+ * are determined on construction by solving the discrete algebraic Riccati
+ * equation (DARE) for the given process and measurement noise covariances.
+ *
+ * The DARE is solved with a structure-preserving doubling algorithm. By
+ * default this is done in double precision as the error covariance elements
+ * may differ by many orders of magnitude and typically converges in less than
+ * 30 iterations. The solver precision is selected with the type of the
+ * relative tolerance argument. On targets without a double precision FPU, the
+ * schedule should be solved on the host and copied from precomputed arrays
+ * instead (see tools/sim/kalmanprime.cc).
+ *
+ * The model cache must outlive the schedule as it is used for speed lookup.
+ */
+template <typename Model, size_t N>
+class KalmanGainSchedule final : public KalmanGainScheduleBase<Model> {
+    public:
+        using model_t = Model;
+        using real_t = model::real_t;
+        using cache_t = ModelCache<Model, N>;
+        using process_noise_covariance_t = typename observer::Kalman<Model>::process_noise_covariance_t;
+        using measurement_noise_covariance_t = typename observer::Kalman<Model>::measurement_noise_covariance_t;
+        using kalman_gain_t = typename KalmanGainScheduleBase<Model>::kalman_gain_t;
+        using error_covariance_t = typename KalmanGainScheduleBase<Model>::error_covariance_t;
+        using steady_state_t = typename KalmanGainScheduleBase<Model>::steady_state_t;
+
+        template <typename Scalar = double>
+        KalmanGainSchedule(const cache_t& cache, // solve DARE in precision Scalar
+                const process_noise_covariance_t& Q, const measurement_noise_covariance_t& R,
+                Scalar tolerance = 1e-12);
+        KalmanGainSchedule(const cache_t& cache, // copy N column-major solutions
+                const real_t* K, const real_t* P);
+
+        virtual const steady_state_t* steady_state(real_t v, real_t dt) const override;
+        const steady_state_t& steady_state(size_t index) const; // get solution by cache index
+        static constexpr size_t size() { return N; }
+
+    private:
+        const cache_t& m_cache;
+        std::array<steady_state_t, N> m_steady_state;
+
+        template <typename Scalar>
+        static steady_state_t solve_dare(const model_t& model,
+                const process_noise_covariance_t& Q, const measurement_noise_covariance_t& R,
+                Scalar tolerance);
+};
+
+/*
+ * This template class is a Kalman filter observer for a bicycle model
+ * (template argument Model) with the interface of observer::Kalman. When the
+ * model speed is found in a gain schedule, the state estimate is updated with
+ * the steady-state Kalman gain:
+ *     x = Ad x + Bd u + K (z - C (Ad x + Bd u))
+ * and no error covariance propagation is performed.
+ *
+ * After a change in model speed or sample period, the full Kalman filter is
+ * used for a number of iterations, starting from the previous steady-state
+ * error covariance. The full filter is also used if no schedule is set or if
+ * the speed is not found in the schedule.
+ *
+ * The update is split into two phases. update_state_estimate() only updates
+ * the state estimate and uses the Kalman gain determined by the previous
+ * call to update_error_covariance(). update_error_covariance() propagates
+ * the error covariance and determines the Kalman gain for the next state
+ * estimate update, and may be deferred until the state estimate has been
+ * used. As the Kalman gain does not depend on the measurements, this is
+ * equivalent to the Kalman filter if the model does not change between the
+ * two phases. update_state() performs both phases. P() and K() return the
+ * error covariance and Kalman gain for the next state estimate update.
+ *
+ * The measurement update of the error covariance is selected with the
+ * template argument MeasurementUpdate, see kalmanupdate.h. Measurements may
+ * be excluded from a state estimate update with a mask, for example if a
+ * measurement is stale. This requires the Kalman gain to be determined again
+ * in update_state_estimate() and the steady-state gain is not used until the
+ * full filter has settled again.
+ *
+ * The gain schedule must be computed with the same process and measurement
+ * noise covariances as set for this observer.
+ */
+template <typename Model, typename MeasurementUpdate = JointMeasurementUpdate>
+class ScheduledKalman final : public observer::ObserverBase {
+    public:
+        using model_t = Model;
+        using real_t = model::real_t;
+        using state_t = typename observer::Kalman<Model>::state_t;
+        using input_t = typename observer::Kalman<Model>::input_t;
+        using measurement_t = typename observer::Kalman<Model>::measurement_t;
+        using error_covariance_t = typename observer::Kalman<Model>::error_covariance_t;
+        using process_noise_covariance_t = typename observer::Kalman<Model>::process_noise_covariance_t;
+        using measurement_noise_covariance_t = typename observer::Kalman<Model>::measurement_noise_covariance_t;
+        using kalman_gain_t = typename observer::Kalman<Model>::kalman_gain_t;
+        using schedule_t = KalmanGainScheduleBase<Model>;
+        using measurement_mask_t = std::bitset<model_t::l>; // set bits are used in update
+
+        ScheduledKalman(model_t& system);
+
+        void set_gain_schedule(const schedule_t* schedule, // use steady-state gain when available
+                uint32_t settle_iterations); // full filter iterations after a model change
+        void reset();
+        void update_state(const input_t& u, const measurement_t& z); // perform both update phases
+        void update_state_estimate(const input_t& u, const measurement_t& z, // first update phase
+                const measurement_mask_t& mask = measurement_mask_t().set());
+        void update_error_covariance(); // second update phase
+        bool is_steady_state() const; // true if the steady-state gain is used in the next update
+
+        void set_x(const state_t& x);
+        void set_P(const error_covariance_t& P);
+        void set_P(const error_covariance_t& P, // error covariance and Kalman gain
+                const kalman_gain_t& K); // determined by update_error_covariance()
+        void set_Q(const process_noise_covariance_t& Q);
+        void set_R(const measurement_noise_covariance_t& R);
+        const state_t& x() const;
+        const state_t& state() const;
+        const error_covariance_t& P() const;
+        const process_noise_covariance_t& Q() const;
+        const measurement_noise_covariance_t& R() const;
+        const kalman_gain_t& K() const;
+        real_t dt() const;
+        model_t& system() const;
+
+    private:
+        using steady_state_t = typename schedule_t::steady_state_t;
+
+        model_t& m_system;
+        state_t m_x;
+        error_covariance_t m_P; // a posteriori error covariance for next update
+        error_covariance_t m_P_prior; // a priori error covariance for next update
+        process_noise_covariance_t m_Q;
+        measurement_noise_covariance_t m_R;
+        kalman_gain_t m_K;
+        bool m_gain_valid; // false if m_K must be determined before the next state update
+        const schedule_t* m_schedule; // may be nullptr
+        const steady_state_t* m_steady_state; // nullptr if the full filter is used
+        real_t m_v; // model speed of last update
+        real_t m_dt; // model sample period of last update
+        uint32_t m_settle_iterations;
+        uint32_t m_settle_counter; // full filter iterations remaining
+
+        void leave_steady_state(); // use full filter until settled
+};
+
+template <typename Model, typename MeasurementUpdate>
+struct has_deferred_covariance_update<ScheduledKalman<Model, MeasurementUpdate>> : std::true_type { };
+
+template <typename Model, typename MeasurementUpdate>
+struct is_kalman_observer<ScheduledKalman<Model, MeasurementUpdate>> : std::true_type { };
+
+} // namespace sim
+
+#include "kalmanschedule.hh"
@@ -0,0 +1,49 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <Eigen/Core>
+
+namespace sim {
+
+/*
+ * Kalman filter measurement update of the error covariance. Given the a priori
+ * error covariance P, output matrix C and measurement noise covariance R,
+ * these classes compute the Kalman gain K and the a posteriori error
+ * covariance. Measurements not set in the mask are not used and the
+ * corresponding columns of K are zero. The state estimate is then updated
+ * with
+ *     x = x + K (z - C x).
+ *
+ * These classes are used as a template argument to select the measurement
+ * update at compile time.
+ */
+
+/*
+ * Update with all measurements at once. This requires the inverse of the
+ * l x l innovation covariance.
+ */
+struct JointMeasurementUpdate {
+    template <typename ErrorCovariance, typename OutputMatrix,
+              typename MeasurementNoiseCovariance, typename KalmanGain, size_t L>
+    static void update(const ErrorCovariance& P_prior, const OutputMatrix& C,
+            const MeasurementNoiseCovariance& R, const std::bitset<L>& mask,
+            KalmanGain* K, ErrorCovariance* P_posterior);
+};
+
+/*
+ * Update with one measurement at a time. This requires the measurement noise
+ * to be uncorrelated and the off-diagonal elements of R are ignored. As the
+ * innovation covariance of a single measurement is a scalar, no matrix
+ * inverse is required and skipping a measurement reduces the computation.
+ */
+struct SequentialMeasurementUpdate {
+    template <typename ErrorCovariance, typename OutputMatrix,
+              typename MeasurementNoiseCovariance, typename KalmanGain, size_t L>
+    static void update(const ErrorCovariance& P_prior, const OutputMatrix& C,
+            const MeasurementNoiseCovariance& R, const std::bitset<L>& mask,
+            KalmanGain* K, ErrorCovariance* P_posterior);
+};
+
+} // namespace sim
+
+#include "kalmanupdate.hh"
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include "constants.h" // real_t
+
+namespace controller {
+using real_t = model::real_t;
+
+/*
+ * This class applies the input of a controller (template argument
+ * Controller, e.g. controller::ScheduledLqr) as assistance at low speed. The
+ * assistance is faded in linearly over fade_period iterations after the speed
+ * drops below velocity_limit and faded out over the same number of iterations
+ * after the speed rises above it. While fading out, the controller input is
+ * calculated at velocity_limit.
+ *
+ * control_calculate() must be called once per iteration of the dynamics loop
+ * as it updates the fade counter.
+ */
+template <typename Controller>
+class FadedAssistance {
+    public:
+        using controller_t = Controller;
+        using state_t = typename Controller::state_t;
+        using input_t = typename Controller::input_t;
+
+        FadedAssistance(controller_t& controller, real_t velocity_limit, uint32_t fade_period);
+
+        // Returns true and sets u to the faded controller input if
+        // assistance is active, otherwise u is not modified.
+        bool control_calculate(const state_t& x, real_t v, input_t* u);
+
+        real_t velocity_limit() const;
+        uint32_t fade_period() const;
+        uint32_t fade_counter() const;
+
+    private:
+        controller_t& m_controller;
+        const real_t m_velocity_limit;
+        const uint32_t m_fade_period;
+        uint32_t m_fade_counter;
+};
+
+} // namespace controller
+
+#include "lqrassistance.hh"
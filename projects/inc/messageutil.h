@@ -2,6 +2,8 @@
 #include "simulation.pb.h"
 #include "bicycle/bicycle.h"
 #include "kalman.h"
+#include "observertraits.h"
+#include "periodictask.h"
 #include "simbicycle.h"
 
 namespace message {
@@ -20,35 +22,35 @@ namespace message {
 
     /* functions for different observer variants */
     template <typename observer_t>
-    typename std::enable_if<std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+    typename std::enable_if<sim::is_kalman_observer<observer_t>::value, void>::type
     set_symmetric_output_matrix(SymmetricOutputMatrixMessage* pb, const typename observer_t::measurement_noise_covariance_t& m);
 
     template <typename observer_t>
-    typename std::enable_if<!std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+    typename std::enable_if<!sim::is_kalman_observer<observer_t>::value, void>::type
     set_symmetric_output_matrix(SymmetricOutputMatrixMessage* pb, const typename observer_t::measurement_noise_covariance_t& m);
 
     template <typename observer_t>
-    typename std::enable_if<std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+    typename std::enable_if<sim::is_kalman_observer<observer_t>::value, void>::type
     set_observer_gain_matrix(KalmanGainMatrixMessage* pb, const typename observer_t::kalman_gain_t& m);
 
     template <typename observer_t>
-    typename std::enable_if<!std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+    typename std::enable_if<!sim::is_kalman_observer<observer_t>::value, void>::type
     set_observer_gain_matrix(KalmanGainMatrixMessage* pb, const typename observer_t::kalman_gain_t& m);
 
     template <typename observer_t>
-    typename std::enable_if<std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+    typename std::enable_if<sim::is_kalman_observer<observer_t>::value, void>::type
     set_kalman_noise_covariances(BicycleKalmanMessage* pb, const observer_t& k);
 
     template <typename observer_t>
-    typename std::enable_if<!std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+    typename std::enable_if<!sim::is_kalman_observer<observer_t>::value, void>::type
     set_kalman_noise_covariances(BicycleKalmanMessage* pb, const observer_t& k);
 
     template <typename observer_t>
-    typename std::enable_if<std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+    typename std::enable_if<sim::is_kalman_observer<observer_t>::value, void>::type
     set_kalman_gain(BicycleKalmanMessage* pb, const observer_t& k);
 
     template <typename observer_t>
-    typename std::enable_if<!std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+    typename std::enable_if<!sim::is_kalman_observer<observer_t>::value, void>::type
     set_kalman_gain(BicycleKalmanMessage* pb, const observer_t& k);
 
     void set_simulation_gitsha1(SimulationMessage* pb);
@@ -59,6 +61,12 @@ namespace message {
             uint32_t commanded_feedback_velocity);
     void set_simulation_timing(SimulationMessage* pb,
             uint32_t computation_time, uint32_t transmission_time);
+    void set_simulation_update_timing(SimulationMessage* pb,
+            uint32_t state_update_time, uint32_t covariance_update_time);
+    void set_simulation_checkpoint_timing(SimulationMessage* pb, uint32_t checkpoint_save_time);
+    void set_histogram(HistogramMessage* pb, const rt::PeriodicTask::histogram_t& h);
+    void set_loop_timing(LoopTimingMessage* pb, const rt::PeriodicTask& task,
+            const rt::PeriodicTask::histogram_t& transmission_time);
 
     template <typename simbicycle_t>
     void set_simulation_state(SimulationMessage* pb, const simbicycle_t& b);
@@ -72,18 +80,18 @@ namespace message {
 
     /* functions for different observer variants */
     template <typename simbicycle_t>
-    typename std::enable_if<std::is_same<typename simbicycle_t::observer_t, typename observer::Kalman<typename simbicycle_t::model_t>>::value, void>::type
+    typename std::enable_if<sim::is_kalman_observer<typename simbicycle_t::observer_t>::value, void>::type
     set_simulation_full_model_observer(SimulationMessage* pb, const simbicycle_t& b);
 
     template <typename simbicycle_t>
-    typename std::enable_if<!std::is_same<typename simbicycle_t::observer_t, typename observer::Kalman<typename simbicycle_t::model_t>>::value, void>::type
+    typename std::enable_if<!sim::is_kalman_observer<typename simbicycle_t::observer_t>::value, void>::type
     set_simulation_full_model_observer(SimulationMessage* pb, const simbicycle_t& b);
 } // namespace message
 
 namespace message {
 
 template <typename observer_t>
-typename std::enable_if<std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+typename std::enable_if<sim::is_kalman_observer<observer_t>::value, void>::type
 set_symmetric_output_matrix(SymmetricOutputMatrixMessage* pb, const typename observer_t::measurement_noise_covariance_t& m) {
     // TODO: autogenerate in case state size changes in the future
     auto p = pb->m;
@@ -96,7 +104,7 @@ set_symmetric_output_matrix(SymmetricOutputMatrixMessage* pb, const typename obs
 }
 
 template <typename observer_t>
-typename std::enable_if<!std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+typename std::enable_if<!sim::is_kalman_observer<observer_t>::value, void>::type
 set_symmetric_output_matrix(SymmetricOutputMatrixMessage* pb, const typename observer_t::measurement_noise_covariance_t& m) {
     // no-op
     (void)pb;
@@ -104,14 +112,14 @@ set_symmetric_output_matrix(SymmetricOutputMatrixMessage* pb, const typename obs
 }
 
 template <typename observer_t>
-typename std::enable_if<std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+typename std::enable_if<sim::is_kalman_observer<observer_t>::value, void>::type
 set_observer_gain_matrix(KalmanGainMatrixMessage* pb, const typename observer_t::kalman_gain_t& m) {
     std::memcpy(pb->m, m.data(), sizeof(pb->m));
     pb->m_count = sizeof(pb->m)/sizeof(pb->m[0]);
 }
 
 template <typename observer_t>
-typename std::enable_if<!std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+typename std::enable_if<!sim::is_kalman_observer<observer_t>::value, void>::type
 set_observer_gain_matrix(KalmanGainMatrixMessage* pb, const typename observer_t::kalman_gain_t& m) {
     // no-op
     (void)pb;
@@ -119,7 +127,7 @@ set_observer_gain_matrix(KalmanGainMatrixMessage* pb, const typename observer_t:
 }
 
 template <typename observer_t>
-typename std::enable_if<std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+typename std::enable_if<sim::is_kalman_observer<observer_t>::value, void>::type
 set_kalman_noise_covariances(BicycleKalmanMessage* pb, const observer_t& k) {
     set_symmetric_state_matrix(&pb->process_noise_covariance, k.Q());
     set_symmetric_output_matrix<observer_t>(&pb->measurement_noise_covariance, k.R());
@@ -128,7 +136,7 @@ set_kalman_noise_covariances(BicycleKalmanMessage* pb, const observer_t& k) {
 }
 
 template <typename observer_t>
-typename std::enable_if<!std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+typename std::enable_if<!sim::is_kalman_observer<observer_t>::value, void>::type
 set_kalman_noise_covariances(BicycleKalmanMessage* pb, const observer_t& k) {
     // no-op
     (void)pb;
@@ -136,7 +144,7 @@ set_kalman_noise_covariances(BicycleKalmanMessage* pb, const observer_t& k) {
 }
 
 template <typename observer_t>
-typename std::enable_if<std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+typename std::enable_if<sim::is_kalman_observer<observer_t>::value, void>::type
 set_kalman_gain(BicycleKalmanMessage* pb, const observer_t& k) {
     set_symmetric_state_matrix(&pb->error_covariance, k.P());
     set_observer_gain_matrix<observer_t>(&pb->kalman_gain, k.K());
@@ -145,7 +153,7 @@ set_kalman_gain(BicycleKalmanMessage* pb, const observer_t& k) {
 }
 
 template <typename observer_t>
-typename std::enable_if<!std::is_same<observer_t, typename observer::Kalman<typename observer_t::model_t>>::value, void>::type
+typename std::enable_if<!sim::is_kalman_observer<observer_t>::value, void>::type
 set_kalman_gain(BicycleKalmanMessage* pb, const observer_t& k) {
     // no-op
     (void)pb;
@@ -183,18 +191,19 @@ void set_simulation_full_model(SimulationMessage* pb, const simbicycle_t& b) {
 }
 
 template <typename simbicycle_t>
-typename std::enable_if<std::is_same<typename simbicycle_t::observer_t, typename observer::Kalman<typename simbicycle_t::model_t>>::value, void>::type
+typename std::enable_if<sim::is_kalman_observer<typename simbicycle_t::observer_t>::value, void>::type
 set_simulation_full_model_observer(SimulationMessage* pb, const simbicycle_t& b) {
     set_simulation_full_model(pb, b);
 
-    // TODO: this assumes observer is kalman type
+    set_bicycle_state(&pb->kalman.state_estimate, b.observer().state());
+    pb->kalman.has_state_estimate = true;
     set_kalman_noise_covariances<typename simbicycle_t::observer_t>(&pb->kalman, b.observer());
     set_kalman_gain<typename simbicycle_t::observer_t>(&pb->kalman, b.observer());
     pb->has_kalman = true;
 }
 
 template <typename simbicycle_t>
-typename std::enable_if<!std::is_same<typename simbicycle_t::observer_t, typename observer::Kalman<typename simbicycle_t::model_t>>::value, void>::type
+typename std::enable_if<!sim::is_kalman_observer<typename simbicycle_t::observer_t>::value, void>::type
 set_simulation_full_model_observer(SimulationMessage* pb, const simbicycle_t& b) {
     set_simulation_full_model(pb, b);
 }
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+// bicycle submodule imports
+#include "bicycle/bicycle.h"
+
+namespace sim {
+
+/*
+ * Interface used by sim::Bicycle to look up a discretized bicycle model for a
+ * quantized forward speed.
+ */
+template <typename Model>
+class ModelCacheBase {
+    public:
+        using real_t = model::real_t;
+        // return a model discretized at speed v and sample period dt or nullptr
+        // if the speed is not in the cache
+        virtual const Model* model(real_t v, real_t dt) const = 0;
+
+    protected:
+        ~ModelCacheBase() { }
+};
+
+/*
+ * This template class holds N copies of a bicycle model (template argument
+ * Model), each discretized at a forward speed v_min + i*v_resolution. A change
+ * in forward speed can then be handled by copying a cached model instead of
+ * discretizing the model again.
+ *
+ * As the bicycle submodule does not allow the discretized state space matrices
+ * to be set directly, entire model objects are cached. This includes the
+ * canonical matrices M, C1, K0, K2 and the continuous and discrete state space
+ * matrices. Models are copied from a prototype so parameters set after model
+ * construction are retained.
+ *
+ * The cache is filled on construction and this requires N model
+ * discretizations. v_min is rounded to a multiple of v_resolution.
+ */
+template <typename Model, size_t N>
+class ModelCache final : public ModelCacheBase<Model> {
+    static_assert(std::is_base_of<model::Bicycle, Model>::value,
+            "Invalid template parameter type for sim::ModelCache");
+    static_assert(N > 0, "Cache size must be greater than 0.");
+
+    public:
+        using model_t = Model;
+        using real_t = model::real_t;
+
+        ModelCache(const model_t& prototype, real_t v_min, real_t v_resolution);
+        ~ModelCache();
+        ModelCache(const ModelCache&) = delete;
+        ModelCache& operator=(const ModelCache&) = delete;
+
+        virtual const model_t* model(real_t v, real_t dt) const override;
+        const model_t& model(size_t index) const; // get model by cache index
+        bool index(real_t v, size_t* index) const; // get index of nearest cached speed
+        real_t v(size_t index) const; // get speed of cache index
+        real_t v_min() const;
+        real_t v_max() const;
+        real_t v_resolution() const;
+        real_t dt() const;
+        static constexpr size_t size() { return N; }
+
+    private:
+        using storage_t = typename std::aligned_storage<sizeof(model_t), alignof(model_t)>::type;
+
+        storage_t m_models[N]; // models are constructed in place from the prototype
+        const real_t m_v_resolution;
+        const real_t m_index_offset; // v_min/v_resolution, rounded
+        const real_t m_dt;
+};
+
+} // namespace sim
+
+#include "modelcache.hh"
@@ -0,0 +1,39 @@
+#pragma once
+#include <type_traits>
+// bicycle submodule imports
+#include "kalman.h"
+
+namespace sim {
+
+/*
+ * Type trait for observer types that provide the interface of
+ * observer::Kalman, including the noise covariance, error covariance and
+ * Kalman gain matrices. This is used to select functions that initialize or
+ * transmit Kalman filter matrices.
+ *
+ * Observer types that implement this interface specialize this template.
+ */
+template <typename Observer>
+struct is_kalman_observer : std::false_type { };
+
+template <typename Model>
+struct is_kalman_observer<observer::Kalman<Model>> : std::true_type { };
+
+/*
+ * Type trait for observer types that split the update in a state estimate
+ * update, update_state_estimate(u, z), and an error covariance update,
+ * update_error_covariance(). Other observer types perform the entire update
+ * in update_state(u, z).
+ */
+template <typename Observer>
+struct has_deferred_covariance_update : std::false_type { };
+
+/*
+ * Type trait for steady-state observer types that use fixed-point arithmetic
+ * and are initialized with a Kalman gain schedule, set_gain_schedule(). These
+ * observers do not provide noise or error covariance matrices.
+ */
+template <typename Observer>
+struct is_fixed_point_observer : std::false_type { };
+
+} // namespace sim
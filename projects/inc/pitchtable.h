@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <cstddef>
+// bicycle submodule imports
+#include "bicycle/bicycle.h"
+
+namespace sim {
+
+/*
+ * Interface used by sim::Bicycle to look up the pitch angle satisfying the
+ * bicycle holonomic constraint for a given roll and steer angle.
+ */
+class PitchTableBase {
+    public:
+        using real_t = model::real_t;
+        // pitch angle, return false if roll or steer is outside the table or
+        // the table has not been filled. The interpolated pitch is refined
+        // with a Newton step if the table interpolation error exceeds
+        // max_error. The step starts from seed, e.g. the previous pitch, if
+        // it is within the interpolation error of the interpolated pitch.
+        virtual bool pitch(real_t roll, real_t steer, real_t seed, real_t max_error,
+                real_t* pitch) const = 0;
+        // maximum interpolation error measured when the table was filled
+        virtual real_t max_error() const = 0;
+
+    protected:
+        ~PitchTableBase() { }
+};
+
+/*
+ * This template class holds the pitch angle solved by the bicycle model
+ * for an N x N grid of roll and steer angles, uniformly spaced in the ranges
+ * [-roll_max, roll_max] and [-steer_max, steer_max]. The pitch angle is
+ * bilinearly interpolated between grid points. The interpolation error is
+ * measured at the cell centers when the table is filled.
+ *
+ * If a query allows a smaller error, the pitch is refined with a single
+ * Newton step of the holonomic constraint, which is evaluated from the
+ * bicycle geometry with util::fastmath. The Newton step squares the error of
+ * its starting point, so the result is accurate to float precision over the
+ * table. Starting from the previous pitch of a slowly varying trajectory
+ * gives a smaller error than starting from the interpolated pitch.
+ *
+ * As pitch only depends on bicycle geometry, the table does not need to be
+ * recomputed when the bicycle speed changes.
+ *
+ * Filling the table requires N*N + (N - 1)*(N - 1) pitch constraint
+ * solutions. A default
+ * constructed table is empty and can be filled when it is first needed, e.g.
+ * in main() instead of during static initialization.
+ */
+template <size_t N>
+class PitchTable final : public PitchTableBase {
+    static_assert(N > 1, "Table size must be greater than 1.");
+
+    public:
+        PitchTable();
+        PitchTable(const model::Bicycle& bicycle, real_t roll_max, real_t steer_max);
+        void fill(const model::Bicycle& bicycle, real_t roll_max, real_t steer_max);
+        virtual bool pitch(real_t roll, real_t steer, real_t seed, real_t max_error,
+                real_t* pitch) const override;
+        virtual real_t max_error() const override;
+        bool interpolate(real_t roll, real_t steer, real_t* pitch) const; // without refinement
+        real_t newton_step(real_t roll, real_t steer, real_t pitch) const; // refine a pitch estimate
+        bool filled() const;
+        real_t roll_max() const;
+        real_t steer_max() const;
+        static constexpr size_t size() { return N; }
+
+    private:
+        std::array<std::array<real_t, N>, N> m_pitch; // indexed by [roll][steer]
+        real_t m_roll_max;
+        real_t m_steer_max;
+        real_t m_roll_step_inverse;
+        real_t m_steer_step_inverse;
+        real_t m_max_error;
+        // bicycle geometry in the parameters of the holonomic constraint
+        real_t m_rr; // rear wheel radius
+        real_t m_rf; // front wheel radius
+        real_t m_d1; // rear wheel center to steer axis distance
+        real_t m_d2; // steer axis offset between d1 and d3
+        real_t m_d3; // steer axis to front wheel center distance
+        bool m_filled;
+
+        real_t roll(size_t index) const;
+        real_t steer(size_t index) const;
+};
+
+} // namespace sim
+
+#include "pitchtable.hh"
@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <boost/math/constants/constants.hpp>
+
+/*
+ * Sensor and actuator constants and conversions of raw sensor samples that do
+ * not depend on the HAL. These are shared by the firmware (see saconfig.h)
+ * and host tools that replay recorded sensor samples, so that both compute
+ * identical values.
+ */
+namespace sa {
+
+constexpr uint16_t ADC_HALF_RANGE = (1 << 12)/2; // ADC is 12-bit
+constexpr uint16_t DAC_HALF_RANGE = (1 << 12)/2; // DAC is 12-bit
+
+constexpr uint32_t RLS_ROLIN_COUNTS_PER_REV = 152000; // steer encoder
+constexpr uint32_t RLS_GTS35_COUNTS_PER_REV = 48 * 4 * 6; // rear wheel encoder
+
+constexpr float REAR_WHEEL_RADIUS = 0.3f; // m
+constexpr float ROLLER_TO_REAR_WHEEL_RATIO = 1.0f/6; // rear wheel radius = 6 * roller radius
+
+/*
+ * The voltage output of the Kistler torque sensor is ±10V. With the 12-bit ADC,
+ * resolution for LSB is 4.88 mV/bit or 12.2 mNm/bit.
+ */
+constexpr float MAX_KISTLER_TORQUE = 50.0f; // maximum measured steer torque, N-m
+constexpr uint16_t KISTLER_ADC_ZERO_OFFSET = 2047; // ADC value for zero torque, found experimentally
+
+constexpr float MAX_KOLLMORGEN_VELOCITY = 3*1.74533f; // max velocity of 300 deg/s in rad/s
+constexpr float MAX_KOLLMORGEN_TORQUE = 10.78125f; // max torque at 1.50 Arms/V, N-m
+constexpr uint16_t KOLLMORGEN_ADC_ZERO_OFFSET = 2026; // ADC value for zero torque, found experimentally
+
+constexpr float MAX_GYRO_RATE = 1*1.74533f; // max rate of 100 deg/s in rad/s
+constexpr uint16_t GYRO_ADC_ZERO_OFFSET = 2028; // ADC value for zero angular rate, found experimentally
+
+/*
+ * Moment of inertia of full steering assembly about the steer axis, kg-m^2
+ */
+constexpr float FULL_ASSEMBLY_INERTIA_WITH_WEIGHT = 0.1942f; // with 1 kg weight plate on each side of cross bar
+constexpr float FULL_ASSEMBLY_INERTIA_WITHOUT_WEIGHT = 0.0828f; // without weight plates
+constexpr float FULL_ASSEMBLY_INERTIA = FULL_ASSEMBLY_INERTIA_WITH_WEIGHT; // default configuration
+
+/*
+ * For the moment of inertia of the upper assembly, we use both virtual and physical values.
+ * See ICSC2017 abstract for details.
+ * The virtual term is determined from scripts/calculate_handlebar_inertia.py
+ * The physical term is determined from an experiment measuring the oscillation period.
+ */
+constexpr float UPPER_ASSEMBLY_INERTIA_VIRTUAL = 0.1314; // kg-m^2
+constexpr float UPPER_ASSEMBLY_INERTIA_PHYSICAL = 0.0413; // kg-m^2
+
+constexpr float adc_to_nm(uint16_t value, uint16_t adc_zero, float magnitude) {
+    // Convert torque from ADC samples to Nm.
+    // ADC samples are 12 bits.
+    // It's not clear when scaling should be applied as data was never saved after the scale
+    // factors were determined.
+    const int16_t shifted_value = static_cast<int16_t>(value) - static_cast<int16_t>(adc_zero);
+    return static_cast<float>(shifted_value)*magnitude/static_cast<float>(ADC_HALF_RANGE);
+}
+
+// Convert a reference value to a DAC sample. The reference is saturated to
+// [-max_reference, max_reference] which maps to the full DAC range.
+inline uint16_t reference_to_dac(float reference, float max_reference) {
+    const float saturated_reference = std::min(std::max(reference, -max_reference), max_reference);
+    return saturated_reference/max_reference*DAC_HALF_RANGE + DAC_HALF_RANGE;
+}
+
+/*
+ * Get angle from encoder count. This is identical to util::encoder_count() but
+ * takes the count instead of the encoder.
+ * Convert angle from the unsigned count to the corresponding signed type and
+ * use negative values for any count over half a revolution.
+ */
+template <typename T>
+T encoder_angle(uint32_t count, uint32_t counts_per_rev) {
+    auto position = static_cast<std::make_signed<uint32_t>::type>(count);
+    auto rev = static_cast<std::make_signed<uint32_t>::type>(counts_per_rev);
+    if (position > rev / 2) {
+        position -= rev;
+    }
+    return static_cast<T>(position) / rev * boost::math::constants::two_pi<T>();
+}
+
+} // namespace sa
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <Eigen/Core>
+#include "smallmatrix.h"
+#include "constants.h" // real_t
+#include "discrete_linear.h"
+
+namespace controller {
+using real_t = model::real_t;
+
+/*
+ * This class is a gain-scheduled LQR controller for a DiscreteLinear model.
+ * It holds a reference to a table of N precomputed feedback gain matrices,
+ * for speeds uniformly spaced in [v_min, v_max], and interpolates linearly
+ * between the two nearest speeds when calculating the feedback gain. Speeds
+ * outside this range use the gain of the nearest end of the table.
+ *
+ * Each table entry is a feedback gain matrix in row-major order. The table is
+ * not copied and can be declared constexpr so that it is stored in flash.
+ *
+ * The feedback gain of the last speed is cached and is only recalculated when
+ * the speed changes. As sim::Bicycle quantizes speed, this happens rarely.
+ */
+template <typename T, size_t N>
+class ScheduledLqr {
+    static_assert(std::is_base_of<model::DiscreteLinearBase, T>::value, "Invalid template parameter type for ScheduledLqr");
+    static_assert(N >= 2, "ScheduledLqr requires at least two gain matrices");
+    public:
+        using state_t = typename T::state_t;
+        using input_t = typename T::input_t;
+        using feedback_gain_t = typename Eigen::Matrix<real_t, T::m, T::n>;
+        using gain_table_t = real_t[N][T::m*T::n];
+
+        ScheduledLqr(const gain_table_t& gains, real_t v_min, real_t v_max);
+
+        input_t control_calculate(const state_t& x, real_t v);
+        const feedback_gain_t& K(real_t v);
+
+        real_t v_min() const;
+        real_t v_max() const;
+
+    private:
+        using gain_map_t = Eigen::Map<const Eigen::Matrix<real_t, T::m, T::n, Eigen::RowMajor>>;
+
+        const gain_table_t& m_gains;
+        const real_t m_v_min;
+        const real_t m_v_max;
+        const real_t m_inverse_step;
+        real_t m_v; // speed of cached feedback gain
+        feedback_gain_t m_K; // cached feedback gain
+
+        gain_map_t gain(size_t i) const;
+        void update_gain(real_t v);
+};
+
+} // namespace controller
+
+#include "scheduled_lqr.hh"
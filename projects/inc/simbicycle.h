@@ -1,8 +1,13 @@
 #pragma once
 #include "ch.h"
 #include "pose.pb.h"
-#include "saconfig.h"
+#include "auxiliaryintegrator.h"
+#include "checkpoint.h"
 #include "haptic.h"
+#include "modelcache.h"
+#include "observertraits.h"
+#include "pitchtable.h"
+#include "seqlock.h"
 // bicycle submodule imports
 #include "bicycle/bicycle.h"
 #include "observer.h"
@@ -20,6 +25,12 @@ namespace sim {
 #define NULL_OBSERVER_FUNCTION_DECL(return_type) \
     template <typename T = Observer> \
     typename std::enable_if<!std::is_base_of<observer::ObserverBase, T>::value, return_type>::type
+#define DEFERRED_COVARIANCE_FUNCTION_DECL(return_type) \
+    template <typename T = Observer> \
+    typename std::enable_if<has_deferred_covariance_update<T>::value, return_type>::type
+#define NON_DEFERRED_COVARIANCE_FUNCTION_DECL(return_type) \
+    template <typename T = Observer> \
+    typename std::enable_if<!has_deferred_covariance_update<T>::value, return_type>::type
 
 /*
  * This template class simulates a bicycle model (template argument Model)
@@ -27,6 +38,38 @@ namespace sim {
  *  - incorporates fields necessary for visualization, such as wheel angle
  *  - provides a single interface for using different bicycle models
  *  - allows simulation of dynamics and kinematics separately
+ *
+ * The dynamics and kinematics may be updated in different threads. Full state
+ * and pose are exchanged between threads with seqlocks so that the dynamics
+ * update never waits for the kinematics update. full_state() must only be
+ * called from the thread calling update_dynamics() and pose() must only be
+ * called from the thread calling update_kinematics(). The kinematics thread
+ * must not have a higher priority than the dynamics thread.
+ *
+ * update_dynamics() may be split into update_dynamics_state() followed by
+ * update_observer_covariance(). The full state, including the steer rate used
+ * for the handlebar reference, is available after update_dynamics_state().
+ * For observer types with a deferred error covariance update, the error
+ * covariance and Kalman gain are updated in update_observer_covariance() so
+ * that this computation can be performed after the handlebar reference has
+ * been set. For other observer types update_observer_covariance() does
+ * nothing. Both functions must be called from the same thread.
+ *
+ * By default, the auxiliary states (x, y, rear wheel angle) are integrated
+ * with the dynamic state in update_dynamics_state(). With
+ * set_auxiliary_state_update(auxiliary_state_update_t::kinematics), only the
+ * dynamic state is updated in update_dynamics_state() and a sample of the
+ * dynamic state is added to a history. The auxiliary states are then
+ * integrated from the history in update_kinematics(), see
+ * sim::AuxiliaryStateIntegrator, and are merged into the full state by the
+ * dynamics update together with the pitch angle. The auxiliary states of
+ * full_state() then lag by up to a kinematics update period. The history must
+ * hold the samples of a kinematics update period.
+ *
+ * The speed, full state and observer state can be saved to a checkpoint and
+ * restored, e.g. to skip observer priming or to resume after a restart.
+ * Checkpoints must be saved and restored from the thread calling
+ * update_dynamics().
  */
 template <typename Model, typename Observer>
 class Bicycle {
@@ -48,6 +91,15 @@ class Bicycle {
         using input_t = typename model_t::input_t;
         using measurement_t = typename model_t::output_t;
         using full_state_index_t = typename model_t::full_state_index_t;
+        using auxiliary_state_index_t = typename model_t::auxiliary_state_index_t;
+        using checkpoint_t = BicycleCheckpoint<model_t>;
+
+        enum class auxiliary_state_update_t {
+            dynamics, // integrate auxiliary states in update_dynamics_state()
+            kinematics // integrate auxiliary states in update_kinematics()
+        };
+        static constexpr size_t auxiliary_state_history_size = 64; // dynamics updates
+        using auxiliary_integrator_t = AuxiliaryStateIntegrator<model_t, auxiliary_state_history_size>;
 
         // default bicycle model parameters
         static constexpr real_t default_fs = 200.0; // sample rate, Hz
@@ -64,6 +116,10 @@ class Bicycle {
 
         void set_v(real_t v);
         void set_dt(real_t dt);
+        void set_model_cache(const ModelCacheBase<model_t>* cache); // use cached models when speed changes
+        void set_pitch_table(const PitchTableBase* table, // use table pitch in kinematics update
+                real_t max_error); // refine pitch if the table error exceeds this value
+        void set_auxiliary_state_update(auxiliary_state_update_t mode); // must be set before updates start
         OBSERVER_FUNCTION_DECL(void) reset();
         NULL_OBSERVER_FUNCTION_DECL(void) reset();
         void update_dynamics(real_t roll_torque_input, // update bicycle internal state
@@ -71,14 +127,23 @@ class Bicycle {
                 real_t yaw_angle_measurement,
                 real_t steer_angle_measurement,
                 real_t rear_wheel_angle_measurement);
+        void update_dynamics_state(real_t roll_torque_input, // update bicycle internal state
+                real_t steer_torque_input,                   // without observer error covariance
+                real_t yaw_angle_measurement,
+                real_t steer_angle_measurement,
+                real_t rear_wheel_angle_measurement);
+        void update_observer_covariance(); // update observer error covariance and gain
         void update_kinematics(); // update bicycle pose
         OBSERVER_FUNCTION_DECL(void) prime_observer(); // perform observer specific initialization routine
         NULL_OBSERVER_FUNCTION_DECL(void) prime_observer(); // perform observer specific initialization routine
+        void save_checkpoint(checkpoint_t* checkpoint) const; // save and seal checkpoint
+        bool restore_checkpoint(const checkpoint_t& checkpoint); // returns false if checkpoint is not valid
 
         const BicyclePoseMessage& pose() const; // get most recently computed pose
         real_t handlebar_feedback_torque() const; // get most recently computed feedback torque
         const input_t& input() const; // get most recently computed input
         const full_state_t& full_state() const; // get most recently computed full state
+        full_state_t full_state_snapshot() const; // get most recently published full state
 
         // common bicycle model member variables
         model_t& model();
@@ -96,18 +161,42 @@ class Bicycle {
         real_t front_wheel_radius() const;
         real_t v() const;
         real_t dt() const;
+        auxiliary_state_update_t auxiliary_state_update() const;
+        const auxiliary_integrator_t& auxiliary_integrator() const;
 
     private:
         model_t m_model; // bicycle model object
+        const ModelCacheBase<model_t>* m_model_cache; // discretized models by speed, may be nullptr
         observer_t m_observer; // observer object
         full_state_t m_full_state; // auxiliary + dynamic state
         BicyclePoseMessage m_pose; // Unity visualization message
         input_t m_input; // bicycle model input vector
         measurement_t m_measurement; // bicycle model measurement vector
-        binary_semaphore_t m_state_sem; // bsem for synchronizing kinematics update
+        const PitchTableBase* m_pitch_table; // pitch by roll and steer, may be nullptr
+        real_t m_pitch_max_error; // allowed pitch table interpolation error
+        struct state_snapshot_t {
+            full_state_t full_state;
+            real_t v; // model speed of the update
+            real_t yaw_rate;
+        };
+        Seqlock<state_snapshot_t> m_state_snapshot; // full state published by dynamics update
+        Seqlock<BicyclePoseMessage> m_pose_snapshot; // pose published by kinematics update
+        uint32_t m_pose_sequence; // pose snapshot sequence last merged by dynamics update
+        auxiliary_state_update_t m_auxiliary_state_update;
+        auxiliary_integrator_t m_auxiliary_integrator; // used for auxiliary_state_update_t::kinematics
 
+        using auxiliary_sample_t = typename auxiliary_integrator_t::sample_t;
+        auxiliary_sample_t make_auxiliary_sample() const; // of the current state and input
+        void publish_state(real_t yaw_rate);
+        void reset_auxiliary_integrator(const auxiliary_sample_t& sample);
         OBSERVER_FUNCTION_DECL(full_state_t) do_full_state_update(const full_state_t& full_state);
         NULL_OBSERVER_FUNCTION_DECL(full_state_t) do_full_state_update(const full_state_t& full_state);
+        OBSERVER_FUNCTION_DECL(full_state_t) do_state_update(const full_state_t& full_state);
+        NULL_OBSERVER_FUNCTION_DECL(full_state_t) do_state_update(const full_state_t& full_state);
+        DEFERRED_COVARIANCE_FUNCTION_DECL(void) do_observer_update();
+        NON_DEFERRED_COVARIANCE_FUNCTION_DECL(void) do_observer_update();
+        DEFERRED_COVARIANCE_FUNCTION_DECL(void) do_observer_covariance_update();
+        NON_DEFERRED_COVARIANCE_FUNCTION_DECL(void) do_observer_covariance_update();
 };
 
 } // namespace sim
@@ -0,0 +1,76 @@
+#pragma once
+#include <Eigen/Core>
+
+namespace util {
+
+/*
+ * Kernels for the small fixed-size matrix products in the bicycle dynamics,
+ * observer and haptic feedback loops:
+ *     y = A x            (e.g. 5x5*5x1, 2x5*5x1)
+ *     y = A x + B u      (5x5*5x1 + 5x2*2x1)
+ *     C = A B            (5x5*5x5)
+ *     P = A P A' + Q     (symmetric 5x5)
+ *     a = A.row(i) x     (1x5*5x1)
+ *
+ * Without vectorization support for Cortex-M, Eigen evaluates these products
+ * with generic loops. These functions are fully unrolled at compile time and
+ * each element is computed as a single chain of multiply-accumulate
+ * operations, which the compiler contracts into VFMA.F32 instructions on the
+ * Cortex-M4F. The symmetric update only computes the lower triangle of the
+ * result and copies it to the upper triangle.
+ *
+ * On targets with vector instructions supported by Eigen (e.g. SSE or AVX on
+ * the host), Eigen products are used instead. The unrolled kernels are always
+ * available in namespace util::smallmatrix::unrolled for testing and
+ * benchmarking.
+ *
+ * Matrices must be fixed-size and column-major.
+ */
+namespace smallmatrix {
+
+template <typename MatrixA, typename VectorX>
+using product_t = Eigen::Matrix<typename MatrixA::Scalar, MatrixA::RowsAtCompileTime,
+                                VectorX::ColsAtCompileTime>;
+
+template <typename Matrix>
+using symmetric_t = Eigen::Matrix<typename Matrix::Scalar, Matrix::RowsAtCompileTime,
+                                  Matrix::RowsAtCompileTime>;
+
+namespace unrolled {
+
+template <typename MatrixA, typename VectorX>
+product_t<MatrixA, VectorX> multiply(const MatrixA& A, const VectorX& x);
+
+template <typename MatrixA, typename VectorX, typename MatrixB, typename VectorU>
+product_t<MatrixA, VectorX> multiply_add(const MatrixA& A, const VectorX& x,
+        const MatrixB& B, const VectorU& u);
+
+template <typename MatrixA, typename MatrixP, typename MatrixQ>
+symmetric_t<MatrixA> symmetric_update(const MatrixA& A, const MatrixP& P, const MatrixQ& Q);
+
+template <typename MatrixA, typename VectorX>
+typename MatrixA::Scalar row_dot(const MatrixA& A, int row, const VectorX& x);
+
+} // namespace unrolled
+
+// y = A x, where x may also be a matrix
+template <typename MatrixA, typename VectorX>
+product_t<MatrixA, VectorX> multiply(const MatrixA& A, const VectorX& x);
+
+// y = A x + B u
+template <typename MatrixA, typename VectorX, typename MatrixB, typename VectorU>
+product_t<MatrixA, VectorX> multiply_add(const MatrixA& A, const VectorX& x,
+        const MatrixB& B, const VectorU& u);
+
+// A P A' + Q, for symmetric P and Q
+template <typename MatrixA, typename MatrixP, typename MatrixQ>
+symmetric_t<MatrixA> symmetric_update(const MatrixA& A, const MatrixP& P, const MatrixQ& Q);
+
+// A.row(row)*x
+template <typename MatrixA, typename VectorX>
+typename MatrixA::Scalar row_dot(const MatrixA& A, int row, const VectorX& x);
+
+} // namespace smallmatrix
+} // namespace util
+
+#include "smallmatrix.hh"
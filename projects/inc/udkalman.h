@@ -0,0 +1,95 @@
+#pragma once
+#include <type_traits>
+#include "observertraits.h"
+#include "smallmatrix.h"
+// bicycle submodule imports
+#include "bicycle/bicycle.h"
+#include "kalman.h"
+#include "observer.h"
+
+namespace sim {
+
+/*
+ * This template class is a Kalman filter observer for a bicycle model
+ * (template argument Model) with the interface of observer::Kalman. The error
+ * covariance is stored in factored form P = U D U', with U unit upper
+ * triangular and D diagonal, instead of as a full matrix.
+ *  - time update uses Thornton's modified weighted Gram-Schmidt algorithm
+ *  - measurement update uses Bierman's algorithm, processing measurements
+ *    one at a time
+ *
+ * The factored error covariance is symmetric by construction and remains
+ * positive definite as long as the elements of D are positive, which is
+ * guaranteed in exact arithmetic and, unlike the conventional covariance
+ * update, is robust to round-off in single precision.
+ *
+ * The measurement noise covariance R is decorrelated on set_R() with the
+ * factorization R = Ur Dr Ur'. If R is diagonal, Ur is the identity matrix.
+ * The process noise covariance Q is factored on set_Q().
+ *
+ * P() reconstructs the full error covariance matrix and is intended for
+ * logging only.
+ */
+template <typename Model>
+class UdKalman final : public observer::ObserverBase {
+    public:
+        using model_t = Model;
+        using real_t = model::real_t;
+        using state_t = typename observer::Kalman<Model>::state_t;
+        using input_t = typename observer::Kalman<Model>::input_t;
+        using measurement_t = typename observer::Kalman<Model>::measurement_t;
+        using error_covariance_t = typename observer::Kalman<Model>::error_covariance_t;
+        using process_noise_covariance_t = typename observer::Kalman<Model>::process_noise_covariance_t;
+        using measurement_noise_covariance_t = typename observer::Kalman<Model>::measurement_noise_covariance_t;
+        using kalman_gain_t = typename observer::Kalman<Model>::kalman_gain_t;
+        using state_matrix_t = error_covariance_t; // n x n
+        using state_diagonal_t = state_t; // n x 1
+        using output_matrix_t = Eigen::Matrix<real_t, model_t::l, model_t::n>;
+        using output_diagonal_t = measurement_t; // l x 1
+
+        UdKalman(model_t& system);
+
+        void reset();
+        void update_state(const input_t& u, const measurement_t& z);
+        void time_update(const input_t& u);
+        void measurement_update(const measurement_t& z);
+
+        void set_x(const state_t& x);
+        void set_P(const error_covariance_t& P);
+        void set_Q(const process_noise_covariance_t& Q);
+        void set_R(const measurement_noise_covariance_t& R);
+        const state_t& x() const;
+        const state_t& state() const;
+        error_covariance_t P() const; // U D U'
+        const state_matrix_t& U() const;
+        const state_diagonal_t& D() const;
+        const process_noise_covariance_t& Q() const;
+        const measurement_noise_covariance_t& R() const;
+        const kalman_gain_t& K() const;
+        real_t dt() const;
+        model_t& system() const;
+
+    private:
+        model_t& m_system;
+        state_t m_x;
+        state_matrix_t m_U; // error covariance unit upper triangular factor
+        state_diagonal_t m_D; // error covariance diagonal factor
+        process_noise_covariance_t m_Q;
+        state_matrix_t m_Uq; // process noise covariance unit upper triangular factor
+        state_diagonal_t m_Dq; // process noise covariance diagonal factor
+        measurement_noise_covariance_t m_R;
+        measurement_noise_covariance_t m_Ur_inverse; // decorrelates measurements
+        output_diagonal_t m_Dr; // decorrelated measurement noise variances
+        kalman_gain_t m_K; // gain of most recent measurement update
+
+        // factor symmetric positive semidefinite matrix M = U D U'
+        template <typename M, typename V>
+        static void factor(const M& m, M* u, V* d);
+};
+
+template <typename Model>
+struct is_kalman_observer<UdKalman<Model>> : std::true_type { };
+
+} // namespace sim
+
+#include "udkalman.hh"
@@ -0,0 +1,155 @@
+#include "fastmath.h"
+#include "smallmatrix.h"
+/*
+ * Member function definitions of sim::AuxiliaryStateIntegrator template class.
+ * See auxiliaryintegrator.h for template class declaration.
+ */
+
+namespace sim {
+
+template <typename Model, size_t N>
+AuxiliaryStateIntegrator<Model, N>::AuxiliaryStateIntegrator() :
+m_position_rate(0),
+m_rear_wheel_rate(0),
+m_history(),
+m_head(0),
+m_origin(origin_t{auxiliary_state_t::Zero(), sample_t{0, 0, 0, 0}, 0}),
+m_tail(0),
+m_origin_sequence(m_origin.sequence()),
+m_sample(sample_t{0, 0, 0, 0}),
+m_auxiliary_state(auxiliary_state_t::Zero()),
+m_skipped_samples(0) { }
+
+template <typename Model, size_t N>
+void AuxiliaryStateIntegrator<Model, N>::set_rates(const model_t& model) {
+    // Use the auxiliary state integration of the model to determine the
+    // travel and rear wheel rotation at unit speed with zero yaw angle.
+    model_t unit_model = model;
+    unit_model.set_v_dt(1, model.dt());
+    const typename model_t::full_state_t xf = unit_model.integrate_full_state(
+            model_t::full_state_t::Zero(), input_t::Zero(), model.dt());
+    const auxiliary_state_t aux = model_t::get_auxiliary_state_part(xf);
+    m_position_rate = model_t::get_auxiliary_state_element(
+            aux, auxiliary_state_index_t::x)/model.dt();
+    m_rear_wheel_rate = model_t::get_auxiliary_state_element(
+            aux, auxiliary_state_index_t::rear_wheel_angle)/model.dt();
+}
+
+template <typename Model, size_t N>
+typename AuxiliaryStateIntegrator<Model, N>::real_t AuxiliaryStateIntegrator<Model, N>::position_rate() const {
+    return m_position_rate;
+}
+
+template <typename Model, size_t N>
+typename AuxiliaryStateIntegrator<Model, N>::real_t AuxiliaryStateIntegrator<Model, N>::rear_wheel_rate() const {
+    return m_rear_wheel_rate;
+}
+
+template <typename Model, size_t N>
+void AuxiliaryStateIntegrator<Model, N>::reset(const auxiliary_state_t& auxiliary_state, const sample_t& sample) {
+    m_origin.write(origin_t{auxiliary_state, sample, m_head.load(std::memory_order_relaxed)});
+}
+
+template <typename Model, size_t N>
+void AuxiliaryStateIntegrator<Model, N>::push(const sample_t& sample) {
+    const uint32_t head = m_head.load(std::memory_order_relaxed);
+    m_history[head & (N - 1)] = sample;
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+template <typename Model, size_t N>
+void AuxiliaryStateIntegrator<Model, N>::integrate() {
+    const uint32_t origin_sequence = m_origin.sequence();
+    if (origin_sequence != m_origin_sequence) {
+        origin_t origin;
+        if (!m_origin.try_read(origin)) {
+            return; // a reset is in progress, integrate in the next call
+        }
+        m_origin_sequence = origin_sequence;
+        m_auxiliary_state = origin.auxiliary_state;
+        m_sample = origin.sample;
+        m_tail = origin.index;
+    }
+
+    const uint32_t head = m_head.load(std::memory_order_acquire);
+    uint32_t gap = 0; // samples skipped since the most recently integrated sample
+    if (head - m_tail > N) {
+        gap = head - m_tail - N;
+        m_tail = head - N;
+    }
+    for (; m_tail != head; ++m_tail) {
+        const sample_t sample = m_history[m_tail & (N - 1)];
+        // The sample is overwritten once the writer pushes sample m_tail + N.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_head.load(std::memory_order_relaxed) - m_tail >= N) {
+            ++gap;
+            continue;
+        }
+        step(sample, sample.dt*static_cast<real_t>(gap + 1));
+        m_skipped_samples += gap;
+        gap = 0;
+    }
+    m_skipped_samples += gap;
+
+    // wrap rear wheel angle so it does not grow beyond all bounds
+    model_t::set_auxiliary_state_element(m_auxiliary_state, auxiliary_state_index_t::rear_wheel_angle,
+            util::fastmath::wrap(model_t::get_auxiliary_state_element(m_auxiliary_state,
+                    auxiliary_state_index_t::rear_wheel_angle)));
+}
+
+template <typename Model, size_t N>
+void AuxiliaryStateIntegrator<Model, N>::step(const sample_t& sample, real_t dt) {
+    // The yaw angle is wrapped, unwrap it relative to the previous sample so
+    // that the midpoint is correct when the yaw angle crosses +/-pi.
+    const real_t yaw0 = m_sample.yaw_angle;
+    const real_t yaw1 = yaw0 + util::fastmath::wrap(sample.yaw_angle - yaw0);
+    const real_t yaw_mid = (yaw0 + yaw1)/2 + dt*(m_sample.yaw_rate - sample.yaw_rate)/8;
+    const real_t ds = m_position_rate*sample.v*dt/6;
+
+    const real_t x = model_t::get_auxiliary_state_element(m_auxiliary_state,
+            auxiliary_state_index_t::x);
+    const real_t y = model_t::get_auxiliary_state_element(m_auxiliary_state,
+            auxiliary_state_index_t::y);
+    const real_t rear_wheel_angle = model_t::get_auxiliary_state_element(m_auxiliary_state,
+            auxiliary_state_index_t::rear_wheel_angle);
+    real_t s0, c0, s_mid, c_mid, s1, c1;
+    util::fastmath::sincos(yaw0, &s0, &c0);
+    util::fastmath::sincos(yaw_mid, &s_mid, &c_mid);
+    util::fastmath::sincos(yaw1, &s1, &c1);
+    model_t::set_auxiliary_state_element(m_auxiliary_state, auxiliary_state_index_t::x,
+            x + ds*(c0 + 4*c_mid + c1));
+    model_t::set_auxiliary_state_element(m_auxiliary_state, auxiliary_state_index_t::y,
+            y + ds*(s0 + 4*s_mid + s1));
+    model_t::set_auxiliary_state_element(m_auxiliary_state, auxiliary_state_index_t::rear_wheel_angle,
+            rear_wheel_angle + m_rear_wheel_rate*sample.v*dt);
+    m_sample = sample;
+}
+
+template <typename Model, size_t N>
+const typename AuxiliaryStateIntegrator<Model, N>::auxiliary_state_t&
+AuxiliaryStateIntegrator<Model, N>::auxiliary_state() const {
+    return m_auxiliary_state;
+}
+
+template <typename Model, size_t N>
+uint32_t AuxiliaryStateIntegrator<Model, N>::skipped_samples() const {
+    return m_skipped_samples;
+}
+
+template <typename Model, size_t N>
+typename AuxiliaryStateIntegrator<Model, N>::sample_t
+AuxiliaryStateIntegrator<Model, N>::make_sample(const model_t& model, const state_t& x, const input_t& u) {
+    static constexpr int yaw_angle_index = static_cast<int>(model_t::state_index_t::yaw_angle);
+
+    // The yaw rate does not depend on the input for the bicycle models but
+    // the input term is included for generality.
+    return sample_t{
+        model.v(),
+        model.dt(),
+        model_t::get_state_element(x, model_t::state_index_t::yaw_angle),
+        util::smallmatrix::row_dot(model.A(), yaw_angle_index, x) +
+            util::smallmatrix::row_dot(model.B(), yaw_angle_index, u)
+    };
+}
+
+} // namespace sim
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "fastmath.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_BICYCLE_USE_AVX2
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+/*
+ * Member function definitions of sim::BatchBicycle template class.
+ * See batchbicycle.h for template class declaration.
+ */
+
+namespace sim {
+
+namespace batch {
+
+/*
+ * Compute y = A x + B u for column vectors stored in arrays of a single
+ * element each, with the given array stride. The SIMD kernels return the
+ * number of columns processed and the remaining columns are processed by the
+ * scalar kernel.
+ *
+ * On x86 the AVX2 kernel is compiled for AVX2 and FMA regardless of the
+ * compiler flags and is only used if the CPU supports these extensions.
+ */
+template <size_t N, size_t M, typename T>
+size_t update_state_simd(const T*, const T*, const T*, const T*, T*, size_t) {
+    return 0;
+}
+
+#if defined(BATCH_BICYCLE_USE_AVX2)
+template <size_t N, size_t M>
+__attribute__((target("avx2,fma")))
+size_t update_state_avx2(const float* A, const float* B,
+        const float* x, const float* u, float* y, size_t stride) {
+    static constexpr size_t width = 8;
+    __m256 a[N*N];
+    __m256 b[N*M];
+    for (size_t i = 0; i < N*N; ++i) {
+        a[i] = _mm256_set1_ps(A[i]);
+    }
+    for (size_t i = 0; i < N*M; ++i) {
+        b[i] = _mm256_set1_ps(B[i]);
+    }
+
+    size_t k = 0;
+    for (; k + width <= stride; k += width) {
+        __m256 xk[N];
+        __m256 uk[M];
+        for (size_t j = 0; j < N; ++j) {
+            xk[j] = _mm256_loadu_ps(x + j*stride + k);
+        }
+        for (size_t j = 0; j < M; ++j) {
+            uk[j] = _mm256_loadu_ps(u + j*stride + k);
+        }
+        for (size_t i = 0; i < N; ++i) {
+            __m256 yk = _mm256_mul_ps(a[i*N], xk[0]);
+            for (size_t j = 1; j < N; ++j) {
+                yk = _mm256_fmadd_ps(a[i*N + j], xk[j], yk);
+            }
+            for (size_t j = 0; j < M; ++j) {
+                yk = _mm256_fmadd_ps(b[i*M + j], uk[j], yk);
+            }
+            _mm256_storeu_ps(y + i*stride + k, yk);
+        }
+    }
+    return k;
+}
+
+template <size_t N, size_t M>
+size_t update_state_simd(const float* A, const float* B,
+        const float* x, const float* u, float* y, size_t stride) {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (has_avx2) {
+        return update_state_avx2<N, M>(A, B, x, u, y, stride);
+    }
+    return 0;
+}
+#elif defined(__ARM_NEON)
+template <size_t N, size_t M>
+size_t update_state_simd(const float* A, const float* B,
+        const float* x, const float* u, float* y, size_t stride) {
+    static constexpr size_t width = 4;
+    size_t k = 0;
+    for (; k + width <= stride; k += width) {
+        float32x4_t xk[N];
+        float32x4_t uk[M];
+        for (size_t j = 0; j < N; ++j) {
+            xk[j] = vld1q_f32(x + j*stride + k);
+        }
+        for (size_t j = 0; j < M; ++j) {
+            uk[j] = vld1q_f32(u + j*stride + k);
+        }
+        for (size_t i = 0; i < N; ++i) {
+            float32x4_t yk = vmulq_n_f32(xk[0], A[i*N]);
+            for (size_t j = 1; j < N; ++j) {
+                yk = vmlaq_n_f32(yk, xk[j], A[i*N + j]);
+            }
+            for (size_t j = 0; j < M; ++j) {
+                yk = vmlaq_n_f32(yk, uk[j], B[i*M + j]);
+            }
+            vst1q_f32(y + i*stride + k, yk);
+        }
+    }
+    return k;
+}
+#endif
+
+template <size_t N, size_t M, typename T>
+void update_state_scalar(const T* A, const T* B,
+        const T* x, const T* u, T* y, size_t stride, size_t begin) {
+    for (size_t k = begin; k < stride; ++k) {
+        for (size_t i = 0; i < N; ++i) {
+            T yk = 0;
+            for (size_t j = 0; j < N; ++j) {
+                yk += A[i*N + j]*x[j*stride + k];
+            }
+            for (size_t j = 0; j < M; ++j) {
+                yk += B[i*M + j]*u[j*stride + k];
+            }
+            y[i*stride + k] = yk;
+        }
+    }
+}
+
+} // namespace batch
+
+template <typename Model>
+BatchBicycle<Model>::BatchBicycle(const model_t& model, size_t size) :
+m_size(size),
+m_stride((size + lane_alignment - 1)/lane_alignment*lane_alignment),
+m_pitch_table(nullptr),
+m_pitch_max_error(0),
+m_state(n*m_stride, 0),
+m_next_state(n*m_stride, 0),
+m_input(m*m_stride, 0),
+m_auxiliary_state(p*m_stride, 0) {
+    set_model(model);
+}
+
+template <typename Model>
+void BatchBicycle<Model>::set_model(const model_t& model) {
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            m_Ad[i*n + j] = model.Ad()(i, j);
+        }
+        for (size_t j = 0; j < m; ++j) {
+            m_Bd[i*m + j] = model.Bd()(i, j);
+        }
+    }
+    m_v = model.v();
+    m_dt = model.dt();
+
+    // Use the auxiliary state integration of the model to determine the
+    // travel and rear wheel rotation in a step with zero yaw angle.
+    const full_state_t xf = model.integrate_full_state(
+            full_state_t::Zero(), input_t::Zero(), m_dt);
+    m_position_step = model_t::get_auxiliary_state_element(
+            model_t::get_auxiliary_state_part(xf), auxiliary_state_index_t::x);
+    m_rear_wheel_step = model_t::get_auxiliary_state_element(
+            model_t::get_auxiliary_state_part(xf), auxiliary_state_index_t::rear_wheel_angle);
+}
+
+template <typename Model>
+void BatchBicycle<Model>::set_pitch_table(const PitchTableBase* table, real_t max_error) {
+    m_pitch_table = table;
+    m_pitch_max_error = max_error;
+}
+
+template <typename Model>
+void BatchBicycle<Model>::step() {
+    update_state();
+    update_auxiliary_state();
+    std::swap(m_state, m_next_state);
+}
+
+template <typename Model>
+void BatchBicycle<Model>::step(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        step();
+    }
+}
+
+template <typename Model>
+void BatchBicycle<Model>::update_state() {
+    const size_t k = batch::update_state_simd<n, m>(m_Ad, m_Bd,
+            m_state.data(), m_input.data(), m_next_state.data(), m_stride);
+    batch::update_state_scalar<n, m>(m_Ad, m_Bd,
+            m_state.data(), m_input.data(), m_next_state.data(), m_stride, k);
+}
+
+template <typename Model>
+void BatchBicycle<Model>::update_auxiliary_state() {
+    const real_t* yaw0 = &m_state[index(state_index_t::yaw_angle)*m_stride];
+    const real_t* yaw1 = &m_next_state[index(state_index_t::yaw_angle)*m_stride];
+    real_t* x = auxiliary_state(auxiliary_state_index_t::x);
+    real_t* y = auxiliary_state(auxiliary_state_index_t::y);
+    real_t* rear_wheel = auxiliary_state(auxiliary_state_index_t::rear_wheel_angle);
+    for (size_t k = 0; k < m_size; ++k) {
+        real_t s, c;
+        util::fastmath::sincos((yaw0[k] + yaw1[k])/2, &s, &c);
+        x[k] += m_position_step*c;
+        y[k] += m_position_step*s;
+        rear_wheel[k] += m_rear_wheel_step;
+    }
+
+    if (m_pitch_table != nullptr) {
+        const real_t* roll = &m_next_state[index(state_index_t::roll_angle)*m_stride];
+        const real_t* steer = &m_next_state[index(state_index_t::steer_angle)*m_stride];
+        real_t* pitch = auxiliary_state(auxiliary_state_index_t::pitch_angle);
+        for (size_t k = 0; k < m_size; ++k) {
+            m_pitch_table->pitch(roll[k], steer[k], pitch[k], m_pitch_max_error, &pitch[k]);
+        }
+    }
+}
+
+template <typename Model>
+typename BatchBicycle<Model>::real_t* BatchBicycle<Model>::state(state_index_t index) {
+    return &m_state[this->index(index)*m_stride];
+}
+
+template <typename Model>
+const typename BatchBicycle<Model>::real_t* BatchBicycle<Model>::state(state_index_t index) const {
+    return &m_state[this->index(index)*m_stride];
+}
+
+template <typename Model>
+typename BatchBicycle<Model>::real_t* BatchBicycle<Model>::input(input_index_t index) {
+    return &m_input[this->index(index)*m_stride];
+}
+
+template <typename Model>
+const typename BatchBicycle<Model>::real_t* BatchBicycle<Model>::input(input_index_t index) const {
+    return &m_input[this->index(index)*m_stride];
+}
+
+template <typename Model>
+typename BatchBicycle<Model>::real_t* BatchBicycle<Model>::auxiliary_state(auxiliary_state_index_t index) {
+    return &m_auxiliary_state[this->index(index)*m_stride];
+}
+
+template <typename Model>
+const typename BatchBicycle<Model>::real_t* BatchBicycle<Model>::auxiliary_state(auxiliary_state_index_t index) const {
+    return &m_auxiliary_state[this->index(index)*m_stride];
+}
+
+template <typename Model>
+typename BatchBicycle<Model>::full_state_t BatchBicycle<Model>::full_state(size_t bicycle) const {
+    typename model_t::auxiliary_state_t aux;
+    typename model_t::state_t x;
+    for (size_t i = 0; i < p; ++i) {
+        aux[i] = m_auxiliary_state[i*m_stride + bicycle];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = m_state[i*m_stride + bicycle];
+    }
+    full_state_t xf;
+    xf << aux, x;
+    return xf;
+}
+
+template <typename Model>
+void BatchBicycle<Model>::set_full_state(size_t bicycle, const full_state_t& full_state) {
+    const typename model_t::auxiliary_state_t aux = model_t::get_auxiliary_state_part(full_state);
+    const typename model_t::state_t x = model_t::get_state_part(full_state);
+    for (size_t i = 0; i < p; ++i) {
+        m_auxiliary_state[i*m_stride + bicycle] = aux[i];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        m_state[i*m_stride + bicycle] = x[i];
+    }
+}
+
+template <typename Model>
+void BatchBicycle<Model>::set_input(size_t bicycle, const input_t& u) {
+    for (size_t i = 0; i < m; ++i) {
+        m_input[i*m_stride + bicycle] = u[i];
+    }
+}
+
+template <typename Model>
+size_t BatchBicycle<Model>::size() const {
+    return m_size;
+}
+
+template <typename Model>
+size_t BatchBicycle<Model>::stride() const {
+    return m_stride;
+}
+
+template <typename Model>
+model::real_t BatchBicycle<Model>::v() const {
+    return m_v;
+}
+
+template <typename Model>
+model::real_t BatchBicycle<Model>::dt() const {
+    return m_dt;
+}
+
+} // namespace sim
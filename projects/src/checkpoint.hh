@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cstring>
+/*
+ * Member function definitions of sim::BicycleCheckpoint and
+ * sim::VersionedCheckpoint template classes and sim::observer_checkpoint
+ * template class specializations.
+ * See checkpoint.h for template class declarations.
+ */
+
+namespace sim {
+
+template <typename Model>
+constexpr uint32_t BicycleCheckpoint<Model>::format;
+template <typename Model>
+constexpr uint32_t BicycleCheckpoint<Model>::version;
+
+template <typename Model>
+void BicycleCheckpoint<Model>::seal() {
+    static_assert(std::is_trivially_copyable<BicycleCheckpoint>::value,
+            "Checkpoint must be trivially copyable");
+    header_format = format;
+    header_version = version;
+    header_size = sizeof(BicycleCheckpoint);
+    crc = crc32(this, offsetof(BicycleCheckpoint, crc));
+}
+
+template <typename Model>
+void BicycleCheckpoint<Model>::invalidate() {
+    crc = ~crc32(this, offsetof(BicycleCheckpoint, crc));
+}
+
+template <typename Model>
+bool BicycleCheckpoint<Model>::valid() const {
+    return (header_format == format) &&
+           (header_version == version) &&
+           (header_size == sizeof(BicycleCheckpoint)) &&
+           (crc == crc32(this, offsetof(BicycleCheckpoint, crc)));
+}
+
+template <typename Checkpoint, size_t TagSize>
+const Checkpoint* VersionedCheckpoint<Checkpoint, TagSize>::claim(const char* version) {
+    if (std::memcmp(tag, version, TagSize) == 0) {
+        return &checkpoint;
+    }
+    checkpoint.invalidate();
+    std::memcpy(tag, version, TagSize);
+    return nullptr;
+}
+
+template <typename Model, typename Observer, typename Enable>
+void observer_checkpoint<Model, Observer, Enable>::save(
+        const Observer& observer, BicycleCheckpoint<Model>* c) {
+    (void)observer;
+    c->observer_content = BicycleCheckpoint<Model>::observer_content_t::none;
+}
+
+template <typename Model, typename Observer, typename Enable>
+void observer_checkpoint<Model, Observer, Enable>::restore(
+        Observer& observer, const BicycleCheckpoint<Model>& c) {
+    // no-op
+    (void)observer;
+    (void)c;
+}
+
+template <typename Model, typename Observer>
+void observer_checkpoint<Model, Observer,
+        typename std::enable_if<is_kalman_observer<Observer>::value>::type>::save(
+        const Observer& observer, BicycleCheckpoint<Model>* c) {
+    const typename Observer::error_covariance_t P = observer.P();
+    std::memcpy(c->x, observer.x().data(), sizeof(c->x));
+    std::memcpy(c->P, P.data(), sizeof(c->P));
+    std::memcpy(c->K, observer.K().data(), sizeof(c->K));
+    c->observer_content = BicycleCheckpoint<Model>::observer_content_t::covariance;
+}
+
+template <typename Model, typename Observer>
+void observer_checkpoint<Model, Observer,
+        typename std::enable_if<is_kalman_observer<Observer>::value>::type>::restore(
+        Observer& observer, const BicycleCheckpoint<Model>& c) {
+    using content_t = typename BicycleCheckpoint<Model>::observer_content_t;
+    if (c.observer_content != content_t::none) {
+        typename Observer::state_t x;
+        std::memcpy(x.data(), c.x, sizeof(c.x));
+        observer.set_x(x);
+    }
+    if (c.observer_content == content_t::covariance) {
+        set_P(observer, c, has_deferred_covariance_update<Observer>());
+    }
+}
+
+template <typename Model, typename Observer>
+void observer_checkpoint<Model, Observer,
+        typename std::enable_if<is_kalman_observer<Observer>::value>::type>::set_P(
+        Observer& observer, const BicycleCheckpoint<Model>& c, std::true_type) {
+    typename Observer::error_covariance_t P;
+    typename Observer::kalman_gain_t K;
+    std::memcpy(P.data(), c.P, sizeof(c.P));
+    std::memcpy(K.data(), c.K, sizeof(c.K));
+    observer.set_P(P, K);
+}
+
+template <typename Model, typename Observer>
+void observer_checkpoint<Model, Observer,
+        typename std::enable_if<is_kalman_observer<Observer>::value>::type>::set_P(
+        Observer& observer, const BicycleCheckpoint<Model>& c, std::false_type) {
+    typename Observer::error_covariance_t P;
+    std::memcpy(P.data(), c.P, sizeof(c.P));
+    observer.set_P(P);
+}
+
+template <typename Model, typename Observer>
+void observer_checkpoint<Model, Observer,
+        typename std::enable_if<is_fixed_point_observer<Observer>::value>::type>::save(
+        const Observer& observer, BicycleCheckpoint<Model>* c) {
+    std::memcpy(c->x, observer.x().data(), sizeof(c->x));
+    std::memcpy(c->K, observer.K().data(), sizeof(c->K));
+    c->observer_content = BicycleCheckpoint<Model>::observer_content_t::state;
+}
+
+template <typename Model, typename Observer>
+void observer_checkpoint<Model, Observer,
+        typename std::enable_if<is_fixed_point_observer<Observer>::value>::type>::restore(
+        Observer& observer, const BicycleCheckpoint<Model>& c) {
+    using content_t = typename BicycleCheckpoint<Model>::observer_content_t;
+    if (c.observer_content != content_t::none) {
+        typename Observer::state_t x;
+        std::memcpy(x.data(), c.x, sizeof(c.x));
+        observer.set_x(x);
+    }
+}
+
+namespace crc32_detail {
+    // CRC of each byte value for the reflected polynomial 0x04c11db7. The
+    // table is computed at compile time and placed in flash (1 KiB).
+    struct table_t {
+        uint32_t value[256];
+
+        constexpr table_t() : value() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (unsigned int k = 0; k < 8; ++k) {
+                    crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+                }
+                value[i] = crc;
+            }
+        }
+    };
+
+    constexpr table_t table;
+} // namespace crc32_detail
+
+inline uint32_t crc32(const void* data, size_t size) {
+    // table-driven, one lookup per byte
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < size; ++i) {
+        crc = (crc >> 8) ^ crc32_detail::table.value[(crc ^ p[i]) & 0xff];
+    }
+    return ~crc;
+}
+
+} // namespace sim
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Core>
+/*
+ * Member function definitions of sim::FixedPointModel template class.
+ * See fixedpointmodel.h for template class declaration.
+ */
+
+namespace sim {
+
+template <typename Model>
+constexpr std::array<int, FixedPointModel<Model>::n> FixedPointModel<Model>::state_exponent;
+template <typename Model>
+constexpr std::array<int, FixedPointModel<Model>::m> FixedPointModel<Model>::input_exponent;
+template <typename Model>
+constexpr std::array<int, FixedPointModel<Model>::l> FixedPointModel<Model>::output_exponent;
+template <typename Model>
+constexpr std::array<float, FixedPointModel<Model>::n> FixedPointModel<Model>::state_scale;
+template <typename Model>
+constexpr std::array<float, FixedPointModel<Model>::m> FixedPointModel<Model>::input_scale;
+template <typename Model>
+constexpr std::array<float, FixedPointModel<Model>::l> FixedPointModel<Model>::output_scale;
+template <typename Model>
+constexpr std::array<float, FixedPointModel<Model>::n> FixedPointModel<Model>::state_inverse_scale;
+template <typename Model>
+constexpr std::array<float, FixedPointModel<Model>::l> FixedPointModel<Model>::output_inverse_scale;
+
+template <typename Model>
+FixedPointModel<Model>::FixedPointModel(real_t v, real_t dt) : model::Bicycle(Model(v, dt)) {
+    // The base class constructor does not call the overriding set_v_dt().
+    quantize_model();
+}
+
+template <typename Model>
+void FixedPointModel<Model>::set_v_dt(real_t v, real_t dt) {
+    model::Bicycle::set_v_dt(v, dt);
+    quantize_model();
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::state_t FixedPointModel<Model>::update_state(
+        const state_t& x, const input_t& u, const measurement_t& z) const {
+    (void)z;
+    return state_from_q31(update_state(state_to_q31(x), input_to_q31(u)));
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::output_t FixedPointModel<Model>::calculate_output(
+        const state_t& x, const input_t& u) const {
+    // feedthrough matrix of the bicycle model is zero
+    (void)u;
+    return output_from_q31(calculate_output(state_to_q31(x)));
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::q_state_t FixedPointModel<Model>::update_state(
+        const q_state_t& x, const q_input_t& u) const {
+    std::array<q31_t, n + m> xu;
+    for (size_t i = 0; i < n; ++i) {
+        xu[i] = x[i];
+    }
+    for (size_t i = 0; i < m; ++i) {
+        xu[n + i] = u[i];
+    }
+    q_state_t x_next;
+    util::multiply_q31<n, n + m>(m_ABd.data(), xu.data(), m_ABd_shift, x_next.data());
+    return x_next;
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::q_output_t FixedPointModel<Model>::calculate_output(
+        const q_state_t& x) const {
+    q_output_t y;
+    util::multiply_q31<l, n>(m_Cd.data(), x.data(), m_Cd_shift, y.data());
+    return y;
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::q_state_t FixedPointModel<Model>::state_to_q31(const state_t& x) {
+    q_state_t q;
+    for (size_t i = 0; i < n; ++i) {
+        q[i] = util::to_q31_scaled(x[i]*state_scale[i]);
+    }
+    return q;
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::q_input_t FixedPointModel<Model>::input_to_q31(const input_t& u) {
+    q_input_t q;
+    for (size_t i = 0; i < m; ++i) {
+        q[i] = util::to_q31_scaled(u[i]*input_scale[i]);
+    }
+    return q;
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::q_output_t FixedPointModel<Model>::output_to_q31(const output_t& y) {
+    q_output_t q;
+    for (size_t i = 0; i < l; ++i) {
+        q[i] = util::to_q31_scaled(y[i]*output_scale[i]);
+    }
+    return q;
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::state_t FixedPointModel<Model>::state_from_q31(const q_state_t& x) {
+    state_t r;
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = static_cast<real_t>(x[i])*state_inverse_scale[i];
+    }
+    return r;
+}
+
+template <typename Model>
+typename FixedPointModel<Model>::output_t FixedPointModel<Model>::output_from_q31(const q_output_t& y) {
+    output_t r;
+    for (size_t i = 0; i < l; ++i) {
+        r[i] = static_cast<real_t>(y[i])*output_inverse_scale[i];
+    }
+    return r;
+}
+
+template <typename Model> template <size_t Rows, size_t Cols, typename Matrix>
+unsigned int FixedPointModel<Model>::quantize(const Matrix& A,
+        const std::array<int, Rows>& row_exponent,
+        const std::array<int, Cols>& column_exponent,
+        q31_t* coefficients) {
+    // Scale rows and columns to the element exponents and determine the
+    // matrix exponent from the largest absolute row sum.
+    Eigen::Matrix<double, Rows, Cols> scaled;
+    double max_row_sum = 0;
+    for (size_t i = 0; i < Rows; ++i) {
+        double row_sum = 0;
+        for (size_t j = 0; j < Cols; ++j) {
+            scaled(i, j) = std::ldexp(static_cast<double>(A(i, j)),
+                    column_exponent[j] - row_exponent[i]);
+            row_sum += std::abs(scaled(i, j));
+        }
+        max_row_sum = std::max(max_row_sum, row_sum);
+    }
+    int exponent = 0;
+    while ((exponent < 31) && (std::ldexp(1.0, exponent) <= max_row_sum)) {
+        ++exponent;
+    }
+
+    for (size_t i = 0; i < Rows; ++i) {
+        for (size_t j = 0; j < Cols; ++j) {
+            coefficients[i*Cols + j] = util::saturate_q31(
+                    std::llround(std::ldexp(scaled(i, j), 31 - exponent)));
+        }
+    }
+    return 31 - exponent;
+}
+
+template <typename Model>
+void FixedPointModel<Model>::quantize_model() {
+    Eigen::Matrix<real_t, n, n + m> ABd;
+    ABd << this->Ad(), this->Bd();
+    std::array<int, n + m> column_exponent;
+    for (size_t i = 0; i < n; ++i) {
+        column_exponent[i] = state_exponent[i];
+    }
+    for (size_t i = 0; i < m; ++i) {
+        column_exponent[n + i] = input_exponent[i];
+    }
+    m_ABd_shift = quantize<n, n + m>(ABd, state_exponent, column_exponent, m_ABd.data());
+    m_Cd_shift = quantize<l, n>(this->Cd(), output_exponent, state_exponent, m_Cd.data());
+}
+
+} // namespace sim
@@ -0,0 +1,108 @@
+/*
+ * Member function definitions of sim::FixedPointObserver template class.
+ * See fixedpointobserver.h for template class declaration.
+ */
+
+namespace sim {
+
+template <typename Model>
+FixedPointObserver<Model>::FixedPointObserver(model_t& system) :
+m_system(system),
+m_schedule(nullptr),
+m_x(state_t::Zero()),
+m_K(kalman_gain_t::Zero()),
+m_K_shift(31),
+m_v(-1),
+m_dt(0) {
+    m_x_q.fill(0);
+    m_K_q.fill(0);
+}
+
+template <typename Model>
+void FixedPointObserver<Model>::set_gain_schedule(const schedule_t* schedule) {
+    m_schedule = schedule;
+    m_dt = 0; // force gain lookup on next update
+}
+
+template <typename Model>
+void FixedPointObserver<Model>::reset() {
+    m_x_q.fill(0);
+    m_x = state_t::Zero();
+}
+
+template <typename Model>
+void FixedPointObserver<Model>::update_state(const input_t& u, const measurement_t& z) {
+    static constexpr size_t n = model_t::n;
+    static constexpr size_t l = model_t::l;
+
+    if ((m_system.v() != m_v) || (m_system.dt() != m_dt)) {
+        update_gain();
+    }
+
+    // prediction
+    m_x_q = m_system.update_state(m_x_q, model_t::input_to_q31(u));
+
+    // correction with the innovation of the prediction
+    const typename model_t::q_output_t z_q = model_t::output_to_q31(z);
+    const typename model_t::q_output_t y_q = m_system.calculate_output(m_x_q);
+    typename model_t::q_output_t innovation;
+    for (size_t i = 0; i < l; ++i) {
+        innovation[i] = util::sub_q31(z_q[i], y_q[i]);
+    }
+    typename model_t::q_state_t correction;
+    util::multiply_q31<n, l>(m_K_q.data(), innovation.data(), m_K_shift, correction.data());
+    for (size_t i = 0; i < n; ++i) {
+        m_x_q[i] = util::add_q31(m_x_q[i], correction[i]);
+    }
+
+    m_x = model_t::state_from_q31(m_x_q);
+}
+
+template <typename Model>
+void FixedPointObserver<Model>::set_x(const state_t& x) {
+    m_x_q = model_t::state_to_q31(x);
+    m_x = model_t::state_from_q31(m_x_q);
+}
+
+template <typename Model>
+const typename FixedPointObserver<Model>::state_t& FixedPointObserver<Model>::x() const {
+    return m_x;
+}
+
+template <typename Model>
+const typename FixedPointObserver<Model>::state_t& FixedPointObserver<Model>::state() const {
+    return m_x;
+}
+
+template <typename Model>
+const typename FixedPointObserver<Model>::kalman_gain_t& FixedPointObserver<Model>::K() const {
+    return m_K;
+}
+
+template <typename Model>
+model::real_t FixedPointObserver<Model>::dt() const {
+    return m_system.dt();
+}
+
+template <typename Model>
+typename FixedPointObserver<Model>::model_t& FixedPointObserver<Model>::system() const {
+    return m_system;
+}
+
+template <typename Model>
+void FixedPointObserver<Model>::update_gain() {
+    m_v = m_system.v();
+    m_dt = m_system.dt();
+    if (m_schedule == nullptr) {
+        return;
+    }
+    const typename schedule_t::steady_state_t* s = m_schedule->steady_state(m_v, m_dt);
+    if (s == nullptr) {
+        return;
+    }
+    m_K = s->K;
+    m_K_shift = model_t::template quantize<model_t::n, model_t::l>(m_K,
+            model_t::state_exponent, model_t::output_exponent, m_K_q.data());
+}
+
+} // namespace sim
@@ -20,8 +20,14 @@ model::real_t null_t::torque(const model::Bicycle::state_t& x, const model::Bicy
     return 0;
 }
 
+linear_form_t null_t::linear_form() const {
+    return linear_form_t{model::Bicycle::state_t::Zero(), model::Bicycle::input_t::Zero()};
+}
+
 HandlebarStatic::HandlebarStatic(model::Bicycle& bicycle) :
-    m_bicycle(bicycle) { }
+    m_bicycle(bicycle) {
+    update_coefficients();
+}
 
 HandlebarStatic::HandlebarStatic(model::Bicycle& bicycle, model::real_t moment_of_inertia) : HandlebarStatic(bicycle) {
     (void)moment_of_inertia;
@@ -49,16 +55,36 @@ HandlebarStatic::HandlebarStatic(model::Bicycle& bicycle, model::real_t moment_o
  */
 model::real_t HandlebarStatic::torque(const model::Bicycle::state_t& x, const model::Bicycle::input_t& u) const {
     (void)u;
+    if (m_bicycle.v() != m_v) {
+        update_coefficients();
+    }
+    return m_steer_stiffness*
+        model::Bicycle::get_state_element(x, model::Bicycle::state_index_t::steer_angle);
+}
+
+linear_form_t HandlebarStatic::linear_form() const {
+    if (m_bicycle.v() != m_v) {
+        update_coefficients();
+    }
+    linear_form_t form{model::Bicycle::state_t::Zero(), model::Bicycle::input_t::Zero()};
+    model::Bicycle::set_state_element(form.a, model::Bicycle::state_index_t::steer_angle,
+            m_steer_stiffness);
+    return form;
+}
+
+void HandlebarStatic::update_coefficients() const {
     const model::real_t v = m_bicycle.v();
     const model::Bicycle::second_order_matrix_t K = constants::g*m_bicycle.K0() + v*v*m_bicycle.K2();
 
-    return -(K(1, 1) - K(0, 1)*K(1, 0)/K(0, 0))*
-        model::Bicycle::get_state_element(x, model::Bicycle::state_index_t::steer_angle);
+    m_v = v;
+    m_steer_stiffness = -(K(1, 1) - K(0, 1)*K(1, 0)/K(0, 0));
 }
 
 HandlebarDynamic::HandlebarDynamic(model::Bicycle& bicycle, model::real_t moment_of_inertia) :
     m_bicycle(bicycle),
-    m_I_delta(moment_of_inertia) { }
+    m_I_delta(moment_of_inertia) {
+    update_coefficients();
+}
 
 /*
  * The equations of motion for the Whipple model can be written as:
@@ -91,12 +117,35 @@ HandlebarDynamic::HandlebarDynamic(model::Bicycle& bicycle, model::real_t moment
  * filter the returned value.
  */
 model::real_t HandlebarDynamic::torque(const model::Bicycle::state_t& x, const model::Bicycle::input_t& u) const {
+    if (m_bicycle.v() != m_v) {
+        update_coefficients();
+    }
+    return m_form.a.dot(x) + m_form.b.dot(u);
+}
+
+linear_form_t HandlebarDynamic::linear_form() const {
+    if (m_bicycle.v() != m_v) {
+        update_coefficients();
+    }
+    return m_form;
+}
+
+/*
+ * The torque is linear in the state and input with the coefficients:
+ *  a = I_delta*A(delta_d, :)'
+ *  b = I_delta*B(delta_d, :)' - e_T_delta
+ * where e_T_delta is the unit vector of the steer torque input.
+ */
+void HandlebarDynamic::update_coefficients() const {
     static constexpr auto steer_rate_index =
         static_cast<typename std::underlying_type<model::Bicycle::state_index_t>::type>(
                 model::Bicycle::state_index_t::steer_rate);
 
-    model::real_t steer_acceleration = (m_bicycle.A().row(steer_rate_index)*x + m_bicycle.B().row(steer_rate_index)*u).value();
-    return steer_acceleration*m_I_delta - model::Bicycle::get_input_element(u, model::Bicycle::input_index_t::steer_torque);
+    m_v = m_bicycle.v();
+    m_form.a = m_I_delta*m_bicycle.A().row(steer_rate_index).transpose();
+    m_form.b = m_I_delta*m_bicycle.B().row(steer_rate_index).transpose();
+    model::Bicycle::set_input_element(m_form.b, model::Bicycle::input_index_t::steer_torque,
+            model::Bicycle::get_input_element(m_form.b, model::Bicycle::input_index_t::steer_torque) - 1);
 }
 
 model::real_t HandlebarDynamic::moment_of_inertia() const {
@@ -0,0 +1,90 @@
+#include "hapticreference.h"
+#include <algorithm>
+#include <type_traits>
+
+namespace haptic {
+
+namespace {
+    constexpr ReferenceInterpolator::sample_t zero_sample = {0, 0, 0, 0, 0, 0};
+} // namespace
+
+ReferenceInterpolator::ReferenceInterpolator(real_t tick_period, real_t max_extrapolation, mode_t mode) :
+    m_tick_period(tick_period),
+    m_max_extrapolation(max_extrapolation),
+    m_mode(mode),
+    m_latest(zero_sample),
+    m_samples(samples_t{zero_sample, zero_sample}),
+    m_read_samples(samples_t{zero_sample, zero_sample}),
+    m_missed_reads(0) { }
+
+void ReferenceInterpolator::reset(const sample_t& sample) {
+    m_latest = sample;
+    m_samples.write(samples_t{sample, sample});
+}
+
+void ReferenceInterpolator::push(const sample_t& sample) {
+    m_samples.write(samples_t{m_latest, sample});
+    m_latest = sample;
+}
+
+model::real_t ReferenceInterpolator::reference(uint32_t time, real_t torque) {
+    if (!m_samples.try_read(m_read_samples)) {
+        ++m_missed_reads;
+    }
+    const sample_t& previous = m_read_samples.previous;
+    const sample_t& latest = m_read_samples.latest;
+
+    // Time differences are signed so that wrapping of the tick counter is
+    // handled and a sample pushed after the read time is not extrapolated
+    // backwards.
+    const int32_t elapsed = static_cast<int32_t>(time - latest.time);
+    const real_t dT = torque - latest.torque;
+
+    switch (m_mode) {
+        case mode_t::interpolate: {
+            const int32_t period = static_cast<int32_t>(latest.time - previous.time);
+            const real_t s = (period > 0) ?
+                std::min(std::max(static_cast<real_t>(elapsed)/period, real_t(0)), real_t(1)) : 1;
+            return previous.reference + s*(latest.reference - previous.reference) +
+                latest.torque_gain*dT;
+        }
+        case mode_t::extrapolate: {
+            const real_t dt = std::min(std::max(elapsed*m_tick_period, real_t(0)),
+                    m_max_extrapolation);
+            return latest.reference + latest.torque_gain*dT +
+                dt*(latest.reference_rate + latest.torque_rate_gain*dT);
+        }
+        case mode_t::hold:
+        default:
+            return latest.reference;
+    }
+}
+
+uint32_t ReferenceInterpolator::missed_reads() const {
+    return m_missed_reads;
+}
+
+ReferenceInterpolator::mode_t ReferenceInterpolator::mode() const {
+    return m_mode;
+}
+
+ReferenceInterpolator::sample_t ReferenceInterpolator::make_sample(
+        const model::Bicycle& model, const linear_form_t& form,
+        const model::Bicycle::state_t& x, const model::Bicycle::input_t& u,
+        uint32_t time, real_t torque) {
+    static constexpr auto steer_torque_index =
+        static_cast<typename std::underlying_type<model::Bicycle::input_index_t>::type>(
+                model::Bicycle::input_index_t::steer_torque);
+
+    const model::Bicycle::state_t xdot = model.A()*x + model.B()*u;
+    return sample_t{
+        time,
+        form.a.dot(x) + form.b.dot(u),
+        form.a.dot(xdot),
+        torque,
+        model::Bicycle::get_input_element(form.b, model::Bicycle::input_index_t::steer_torque),
+        form.a.dot(model.B().col(steer_torque_index))
+    };
+}
+
+} // namespace haptic
@@ -0,0 +1,292 @@
+#include <Eigen/LU>
+/*
+ * Member function definitions of sim::KalmanGainSchedule and
+ * sim::ScheduledKalman template classes.
+ * See kalmanschedule.h for template class declarations.
+ */
+
+namespace sim {
+
+template <typename Model, size_t N>
+template <typename Scalar>
+KalmanGainSchedule<Model, N>::KalmanGainSchedule(const cache_t& cache,
+        const process_noise_covariance_t& Q, const measurement_noise_covariance_t& R,
+        Scalar tolerance) :
+m_cache(cache) {
+    for (size_t i = 0; i < N; ++i) {
+        m_steady_state[i] = solve_dare(m_cache.model(i), Q, R, tolerance);
+    }
+}
+
+template <typename Model, size_t N>
+KalmanGainSchedule<Model, N>::KalmanGainSchedule(const cache_t& cache,
+        const real_t* K, const real_t* P) :
+m_cache(cache) {
+    static constexpr size_t K_size = model_t::n*model_t::l;
+    static constexpr size_t P_size = model_t::n*model_t::n;
+    for (size_t i = 0; i < N; ++i) {
+        m_steady_state[i].K = Eigen::Map<const kalman_gain_t>(K + i*K_size);
+        m_steady_state[i].P = Eigen::Map<const error_covariance_t>(P + i*P_size);
+    }
+}
+
+template <typename Model, size_t N>
+const typename KalmanGainSchedule<Model, N>::steady_state_t*
+KalmanGainSchedule<Model, N>::steady_state(real_t v, real_t dt) const {
+    size_t i;
+    if ((dt != m_cache.dt()) || !m_cache.index(v, &i)) {
+        return nullptr;
+    }
+    return &m_steady_state[i];
+}
+
+template <typename Model, size_t N>
+const typename KalmanGainSchedule<Model, N>::steady_state_t&
+KalmanGainSchedule<Model, N>::steady_state(size_t index) const {
+    return m_steady_state[index];
+}
+
+template <typename Model, size_t N>
+template <typename Scalar>
+typename KalmanGainSchedule<Model, N>::steady_state_t
+KalmanGainSchedule<Model, N>::solve_dare(const model_t& model,
+        const process_noise_covariance_t& Q, const measurement_noise_covariance_t& R,
+        Scalar tolerance) {
+    static constexpr unsigned int n = model_t::n;
+    static constexpr unsigned int l = model_t::l;
+    static constexpr unsigned int max_iterations = 64;
+    using matrix_t = Eigen::Matrix<Scalar, n, n>;
+    using output_matrix_t = Eigen::Matrix<Scalar, l, n>;
+    using output_covariance_t = Eigen::Matrix<Scalar, l, l>;
+
+    // Doubling iteration for the filter DARE
+    //     P = Ad P Ad' - Ad P C' (C P C' + R)^-1 C P Ad' + Q
+    // with A_0 = Ad', G_0 = C' R^-1 C, H_0 = Q. H_k converges to the
+    // a priori error covariance P.
+    const output_matrix_t C = model.Cd().template cast<Scalar>();
+    const output_covariance_t Rd = R.template cast<Scalar>();
+    matrix_t A = model.Ad().transpose().template cast<Scalar>();
+    matrix_t G = C.transpose()*Rd.inverse()*C;
+    matrix_t H = Q.template cast<Scalar>();
+    for (unsigned int k = 0; k < max_iterations; ++k) {
+        const Eigen::PartialPivLU<matrix_t> W(matrix_t::Identity() + G*H);
+        const matrix_t WA = W.solve(A);
+        const matrix_t WG = W.solve(G);
+        const matrix_t H_next = H + A.transpose()*H*WA;
+        G += A*WG*A.transpose();
+        A = A*WA;
+
+        const Scalar delta = (H_next - H).cwiseAbs().maxCoeff();
+        H = H_next;
+        if (delta <= tolerance*H.cwiseAbs().maxCoeff()) {
+            break;
+        }
+    }
+    H = (H + H.transpose())/2;
+
+    const Eigen::Matrix<Scalar, n, l> K =
+        H*C.transpose()*(C*H*C.transpose() + Rd).inverse();
+    matrix_t P = H - K*C*H;
+    P = (P + P.transpose())/2;
+
+    steady_state_t s;
+    s.K = K.template cast<real_t>();
+    s.P = P.template cast<real_t>();
+    return s;
+}
+
+template <typename Model, typename MeasurementUpdate>
+ScheduledKalman<Model, MeasurementUpdate>::ScheduledKalman(model_t& system) :
+m_system(system),
+m_x(state_t::Zero()),
+m_P(error_covariance_t::Identity()),
+m_P_prior(error_covariance_t::Identity()),
+m_Q(process_noise_covariance_t::Identity()),
+m_R(measurement_noise_covariance_t::Identity()),
+m_K(kalman_gain_t::Zero()),
+m_gain_valid(false),
+m_schedule(nullptr),
+m_steady_state(nullptr),
+m_v(system.v()),
+m_dt(system.dt()),
+m_settle_iterations(0),
+m_settle_counter(0) { }
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::set_gain_schedule(const schedule_t* schedule, uint32_t settle_iterations) {
+    m_schedule = schedule;
+    m_settle_iterations = settle_iterations;
+    m_steady_state = nullptr;
+    m_settle_counter = 0;
+    m_gain_valid = false;
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::reset() {
+    m_x = state_t::Zero();
+    m_P = error_covariance_t::Identity();
+    m_K = kalman_gain_t::Zero();
+    m_gain_valid = false;
+    m_steady_state = nullptr;
+    m_settle_counter = m_settle_iterations;
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::update_state(const input_t& u, const measurement_t& z) {
+    update_state_estimate(u, z);
+    update_error_covariance();
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::update_state_estimate(const input_t& u,
+        const measurement_t& z, const measurement_mask_t& mask) {
+    if ((m_system.v() != m_v) || (m_system.dt() != m_dt)) {
+        // Error covariance has not converged for the new model.
+        leave_steady_state();
+        m_v = m_system.v();
+        m_dt = m_system.dt();
+    }
+
+    if (!mask.all()) {
+        // The steady-state solution assumes all measurements are used.
+        leave_steady_state();
+    }
+
+    if ((m_steady_state == nullptr) && !m_gain_valid) {
+        // The Kalman gain must be determined now, this happens after a model
+        // change or after the filter matrices are set.
+        update_error_covariance();
+    }
+
+    if ((m_steady_state == nullptr) && !mask.all()) {
+        // Replace the gain and error covariance determined for all
+        // measurements.
+        MeasurementUpdate::update(m_P_prior, m_system.Cd(), m_R, mask, &m_K, &m_P);
+    }
+
+    const kalman_gain_t& K = (m_steady_state != nullptr) ? m_steady_state->K : m_K;
+    if ((m_steady_state == nullptr) && (m_settle_counter > 0)) {
+        --m_settle_counter;
+    }
+
+    const state_t x = util::smallmatrix::multiply_add(m_system.Ad(), m_x, m_system.Bd(), u);
+    const measurement_t innovation = z - util::smallmatrix::multiply(m_system.Cd(), x);
+    m_x = x + util::smallmatrix::multiply(K, innovation);
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::update_error_covariance() {
+    if (m_steady_state != nullptr) {
+        return;
+    }
+
+    if ((m_settle_counter == 0) && (m_schedule != nullptr)) {
+        m_steady_state = m_schedule->steady_state(m_v, m_dt);
+        if (m_steady_state != nullptr) {
+            return;
+        }
+    }
+
+    const auto& Ad = m_system.Ad();
+    m_P_prior = util::smallmatrix::symmetric_update(Ad, m_P, m_Q);
+    MeasurementUpdate::update(m_P_prior, m_system.Cd(), m_R, measurement_mask_t().set(), &m_K, &m_P);
+    m_gain_valid = true;
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::leave_steady_state() {
+    if (m_steady_state != nullptr) {
+        m_P = m_steady_state->P;
+        m_steady_state = nullptr;
+        m_gain_valid = false;
+    }
+    m_settle_counter = m_settle_iterations;
+}
+
+template <typename Model, typename MeasurementUpdate>
+bool ScheduledKalman<Model, MeasurementUpdate>::is_steady_state() const {
+    return m_steady_state != nullptr;
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::set_x(const state_t& x) {
+    m_x = x;
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::set_P(const error_covariance_t& P) {
+    // The full filter is used until the error covariance has converged.
+    m_P = P;
+    m_gain_valid = false;
+    m_steady_state = nullptr;
+    m_settle_counter = m_settle_iterations;
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::set_P(const error_covariance_t& P, const kalman_gain_t& K) {
+    // The gain is used in the next update, as if the error covariance had
+    // been updated by this observer.
+    set_P(P);
+    m_K = K;
+    m_gain_valid = true;
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::set_Q(const process_noise_covariance_t& Q) {
+    m_Q = Q;
+    m_gain_valid = false;
+}
+
+template <typename Model, typename MeasurementUpdate>
+void ScheduledKalman<Model, MeasurementUpdate>::set_R(const measurement_noise_covariance_t& R) {
+    m_R = R;
+    m_gain_valid = false;
+}
+
+template <typename Model, typename MeasurementUpdate>
+const typename ScheduledKalman<Model, MeasurementUpdate>::state_t& ScheduledKalman<Model, MeasurementUpdate>::x() const {
+    return m_x;
+}
+
+template <typename Model, typename MeasurementUpdate>
+const typename ScheduledKalman<Model, MeasurementUpdate>::state_t& ScheduledKalman<Model, MeasurementUpdate>::state() const {
+    return m_x;
+}
+
+template <typename Model, typename MeasurementUpdate>
+const typename ScheduledKalman<Model, MeasurementUpdate>::error_covariance_t& ScheduledKalman<Model, MeasurementUpdate>::P() const {
+    if (m_steady_state != nullptr) {
+        return m_steady_state->P;
+    }
+    return m_P;
+}
+
+template <typename Model, typename MeasurementUpdate>
+const typename ScheduledKalman<Model, MeasurementUpdate>::process_noise_covariance_t& ScheduledKalman<Model, MeasurementUpdate>::Q() const {
+    return m_Q;
+}
+
+template <typename Model, typename MeasurementUpdate>
+const typename ScheduledKalman<Model, MeasurementUpdate>::measurement_noise_covariance_t& ScheduledKalman<Model, MeasurementUpdate>::R() const {
+    return m_R;
+}
+
+template <typename Model, typename MeasurementUpdate>
+const typename ScheduledKalman<Model, MeasurementUpdate>::kalman_gain_t& ScheduledKalman<Model, MeasurementUpdate>::K() const {
+    if (m_steady_state != nullptr) {
+        return m_steady_state->K;
+    }
+    return m_K;
+}
+
+template <typename Model, typename MeasurementUpdate>
+model::real_t ScheduledKalman<Model, MeasurementUpdate>::dt() const {
+    return m_system.dt();
+}
+
+template <typename Model, typename MeasurementUpdate>
+typename ScheduledKalman<Model, MeasurementUpdate>::model_t& ScheduledKalman<Model, MeasurementUpdate>::system() const {
+    return m_system;
+}
+
+} // namespace sim
@@ -0,0 +1,65 @@
+#include <Eigen/LU>
+/*
+ * Member function definitions of sim::JointMeasurementUpdate and
+ * sim::SequentialMeasurementUpdate classes.
+ * See kalmanupdate.h for class declarations.
+ */
+
+namespace sim {
+
+template <typename ErrorCovariance, typename OutputMatrix,
+          typename MeasurementNoiseCovariance, typename KalmanGain, size_t L>
+void JointMeasurementUpdate::update(const ErrorCovariance& P_prior, const OutputMatrix& C,
+        const MeasurementNoiseCovariance& R, const std::bitset<L>& mask,
+        KalmanGain* K, ErrorCovariance* P_posterior) {
+    if (mask.all()) {
+        const MeasurementNoiseCovariance S = C*P_prior*C.transpose() + R;
+        *K = P_prior*C.transpose()*S.inverse();
+    } else {
+        // Remove the rows of C and the noise correlation of unused
+        // measurements. The innovation covariance is then block diagonal and
+        // the corresponding columns of K are zero.
+        OutputMatrix Cm = C;
+        MeasurementNoiseCovariance Rm = R;
+        for (size_t i = 0; i < L; ++i) {
+            if (!mask.test(i)) {
+                Cm.row(i).setZero();
+                Rm.row(i).setZero();
+                Rm.col(i).setZero();
+                Rm(i, i) = 1;
+            }
+        }
+        const MeasurementNoiseCovariance S = Cm*P_prior*Cm.transpose() + Rm;
+        *K = P_prior*Cm.transpose()*S.inverse();
+    }
+    *P_posterior = P_prior - (*K)*C*P_prior;
+}
+
+template <typename ErrorCovariance, typename OutputMatrix,
+          typename MeasurementNoiseCovariance, typename KalmanGain, size_t L>
+void SequentialMeasurementUpdate::update(const ErrorCovariance& P_prior, const OutputMatrix& C,
+        const MeasurementNoiseCovariance& R, const std::bitset<L>& mask,
+        KalmanGain* K, ErrorCovariance* P_posterior) {
+    using state_t = Eigen::Matrix<typename KalmanGain::Scalar, KalmanGain::RowsAtCompileTime, 1>;
+
+    *P_posterior = P_prior;
+    K->setZero();
+    for (size_t i = 0; i < L; ++i) {
+        if (!mask.test(i)) {
+            continue;
+        }
+        const state_t PCt = (*P_posterior)*C.row(i).transpose();
+        const state_t k = PCt/(C.row(i).dot(PCt) + R(i, i));
+        P_posterior->noalias() -= k*PCt.transpose();
+
+        // Gains of previous measurements are applied to the innovation
+        // before this update. Correct them so that K maps the innovation of
+        // the a priori state estimate to the state update.
+        for (size_t j = 0; j < i; ++j) {
+            K->col(j) -= k*C.row(i).dot(K->col(j));
+        }
+        K->col(i) = k;
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,49 @@
+/*
+ * Member function definitions of controller::FadedAssistance template class.
+ * See lqrassistance.h for template class declaration.
+ */
+
+namespace controller {
+
+template <typename Controller>
+FadedAssistance<Controller>::FadedAssistance(controller_t& controller,
+        real_t velocity_limit, uint32_t fade_period) :
+m_controller(controller),
+m_velocity_limit(velocity_limit),
+m_fade_period(fade_period),
+m_fade_counter(0) { }
+
+template <typename Controller>
+bool FadedAssistance<Controller>::control_calculate(const state_t& x, real_t v, input_t* u) {
+    if (v < m_velocity_limit) {
+        if (m_fade_counter < m_fade_period) {
+            ++m_fade_counter;
+        }
+        const real_t fade = static_cast<real_t>(m_fade_counter)/m_fade_period;
+        *u = fade*m_controller.control_calculate(x, v);
+    } else if (m_fade_counter != 0) {
+        // use the gain at the velocity limit while fading out
+        const real_t fade = static_cast<real_t>(m_fade_counter--)/m_fade_period;
+        *u = fade*m_controller.control_calculate(x, m_velocity_limit);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+template <typename Controller>
+real_t FadedAssistance<Controller>::velocity_limit() const {
+    return m_velocity_limit;
+}
+
+template <typename Controller>
+uint32_t FadedAssistance<Controller>::fade_period() const {
+    return m_fade_period;
+}
+
+template <typename Controller>
+uint32_t FadedAssistance<Controller>::fade_counter() const {
+    return m_fade_counter;
+}
+
+} // namespace controller
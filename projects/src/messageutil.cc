@@ -123,4 +123,45 @@ void set_simulation_timing(SimulationMessage* pb,
     pb->has_timing = true;
 }
 
+void set_simulation_update_timing(SimulationMessage* pb,
+        uint32_t state_update_time, uint32_t covariance_update_time) {
+    pb->timing.state_update = state_update_time;
+    pb->timing.has_state_update = true;
+    pb->timing.covariance_update = covariance_update_time;
+    pb->timing.has_covariance_update = true;
+    pb->has_timing = true;
+}
+
+void set_simulation_checkpoint_timing(SimulationMessage* pb, uint32_t checkpoint_save_time) {
+    pb->timing.checkpoint_save = checkpoint_save_time;
+    pb->timing.has_checkpoint_save = true;
+    pb->has_timing = true;
+}
+
+void set_histogram(HistogramMessage* pb, const rt::PeriodicTask::histogram_t& h) {
+    static_assert(sizeof(pb->count) == sizeof(h.counts()),
+            "Histogram size does not match HistogramMessage");
+    pb->bucket_width = h.bucket_width();
+    std::memcpy(pb->count, h.counts().data(), sizeof(pb->count));
+    pb->count_count = sizeof(pb->count)/sizeof(pb->count[0]);
+    pb->max = h.max();
+    pb->has_max = true;
+}
+
+void set_loop_timing(LoopTimingMessage* pb, const rt::PeriodicTask& task,
+        const rt::PeriodicTask::histogram_t& transmission_time) {
+    set_histogram(&pb->start_jitter, task.start_jitter());
+    pb->has_start_jitter = true;
+    set_histogram(&pb->execution, task.execution_time_histogram());
+    pb->has_execution = true;
+    set_histogram(&pb->transmission, transmission_time);
+    pb->has_transmission = true;
+    pb->releases = task.releases();
+    pb->has_releases = true;
+    pb->deadline_misses = task.deadline_misses();
+    pb->has_deadline_misses = true;
+    pb->skipped_releases = task.skipped_releases();
+    pb->has_skipped_releases = true;
+}
+
 } // namespace message
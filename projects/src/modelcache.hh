@@ -0,0 +1,79 @@
+#include <cmath>
+#include <new>
+/*
+ * Member function definitions of sim::ModelCache template class.
+ * See modelcache.h for template class declaration.
+ */
+
+namespace sim {
+
+template <typename Model, size_t N>
+ModelCache<Model, N>::ModelCache(const model_t& prototype, real_t v_min, real_t v_resolution) :
+m_v_resolution(v_resolution),
+m_index_offset(std::round(v_min/v_resolution)),
+m_dt(prototype.dt()) {
+    for (size_t i = 0; i < N; ++i) {
+        model_t* m = new (&m_models[i]) model_t(prototype);
+        m->set_v_dt(v(i), m_dt);
+    }
+}
+
+template <typename Model, size_t N>
+ModelCache<Model, N>::~ModelCache() {
+    for (size_t i = 0; i < N; ++i) {
+        reinterpret_cast<model_t*>(&m_models[i])->~model_t();
+    }
+}
+
+template <typename Model, size_t N>
+const typename ModelCache<Model, N>::model_t* ModelCache<Model, N>::model(real_t v, real_t dt) const {
+    size_t i;
+    if ((dt != m_dt) || !index(v, &i)) {
+        return nullptr;
+    }
+    return &model(i);
+}
+
+template <typename Model, size_t N>
+const typename ModelCache<Model, N>::model_t& ModelCache<Model, N>::model(size_t index) const {
+    return *reinterpret_cast<const model_t*>(&m_models[index]);
+}
+
+template <typename Model, size_t N>
+bool ModelCache<Model, N>::index(real_t v, size_t* index) const {
+    const real_t i = std::round(v/m_v_resolution) - m_index_offset;
+    if ((i < static_cast<real_t>(0)) || (i > static_cast<real_t>(N - 1))) {
+        return false;
+    }
+    *index = static_cast<size_t>(i);
+    return true;
+}
+
+template <typename Model, size_t N>
+model::real_t ModelCache<Model, N>::v(size_t index) const {
+    // Computed in the same way as the quantized speed in sim::Bicycle so that
+    // a cached speed compares equal to a quantized speed.
+    return m_v_resolution*(m_index_offset + static_cast<real_t>(index));
+}
+
+template <typename Model, size_t N>
+model::real_t ModelCache<Model, N>::v_min() const {
+    return v(0);
+}
+
+template <typename Model, size_t N>
+model::real_t ModelCache<Model, N>::v_max() const {
+    return v(N - 1);
+}
+
+template <typename Model, size_t N>
+model::real_t ModelCache<Model, N>::v_resolution() const {
+    return m_v_resolution;
+}
+
+template <typename Model, size_t N>
+model::real_t ModelCache<Model, N>::dt() const {
+    return m_dt;
+}
+
+} // namespace sim
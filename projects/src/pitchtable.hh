@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+#include "fastmath.h"
+/*
+ * Member function definitions of sim::PitchTable template class.
+ * See pitchtable.h for template class declaration.
+ */
+
+namespace sim {
+
+template <size_t N>
+PitchTable<N>::PitchTable() :
+m_pitch(),
+m_roll_max(0),
+m_steer_max(0),
+m_roll_step_inverse(0),
+m_steer_step_inverse(0),
+m_max_error(0),
+m_rr(0),
+m_rf(0),
+m_d1(0),
+m_d2(0),
+m_d3(0),
+m_filled(false) { }
+
+template <size_t N>
+PitchTable<N>::PitchTable(const model::Bicycle& bicycle, real_t roll_max, real_t steer_max) :
+PitchTable() {
+    fill(bicycle, roll_max, steer_max);
+}
+
+template <size_t N>
+void PitchTable<N>::fill(const model::Bicycle& bicycle, real_t roll_max, real_t steer_max) {
+    m_roll_max = roll_max;
+    m_steer_max = steer_max;
+    m_roll_step_inverse = static_cast<real_t>(N - 1)/(2*roll_max);
+    m_steer_step_inverse = static_cast<real_t>(N - 1)/(2*steer_max);
+
+    // Convert the benchmark geometry to the parameters used by Moore, "Human
+    // Control of a Bicycle", 2012.
+    const real_t w = bicycle.wheelbase();
+    const real_t c = bicycle.trail();
+    const real_t lambda = bicycle.steer_axis_tilt();
+    m_rr = bicycle.rear_wheel_radius();
+    m_rf = bicycle.front_wheel_radius();
+    m_d1 = std::cos(lambda)*(c + w - m_rr*std::tan(lambda));
+    m_d3 = -std::cos(lambda)*(c - m_rf*std::tan(lambda));
+    m_d2 = (m_rr + m_d1*std::sin(lambda) - m_rf + m_d3*std::sin(lambda))/std::cos(lambda);
+
+    // Use the pitch of the adjacent grid point as initial guess.
+    real_t guess = 0;
+    for (size_t r = 0; r < N; ++r) {
+        if (r > 0) {
+            guess = m_pitch[r - 1][0];
+        }
+        for (size_t s = 0; s < N; ++s) {
+            m_pitch[r][s] = bicycle.solve_constraint_pitch(roll(r), steer(s), guess);
+            guess = m_pitch[r][s];
+        }
+    }
+    m_filled = true;
+
+    // Determine the interpolation error at the center of each cell, where
+    // the bilinear interpolation error is expected to be largest.
+    m_max_error = 0;
+    for (size_t r = 0; r < N - 1; ++r) {
+        for (size_t s = 0; s < N - 1; ++s) {
+            const real_t roll_c = (roll(r) + roll(r + 1))/2;
+            const real_t steer_c = (steer(s) + steer(s + 1))/2;
+            real_t interpolated;
+            interpolate(roll_c, steer_c, &interpolated);
+            const real_t solved = bicycle.solve_constraint_pitch(roll_c, steer_c, m_pitch[r][s]);
+            m_max_error = std::max(m_max_error, std::abs(interpolated - solved));
+        }
+    }
+}
+
+template <size_t N>
+bool PitchTable<N>::pitch(real_t roll, real_t steer, real_t seed, real_t max_error,
+        real_t* pitch) const {
+    real_t interpolated;
+    if (!interpolate(roll, steer, &interpolated)) {
+        return false;
+    }
+    if (m_max_error <= max_error) {
+        *pitch = interpolated;
+    } else {
+        // a NaN seed is not used
+        const bool use_seed = std::abs(seed - interpolated) <= m_max_error;
+        *pitch = newton_step(roll, steer, use_seed ? seed : interpolated);
+    }
+    return true;
+}
+
+template <size_t N>
+model::real_t PitchTable<N>::max_error() const {
+    return m_max_error;
+}
+
+template <size_t N>
+bool PitchTable<N>::interpolate(real_t roll, real_t steer, real_t* pitch) const {
+    const real_t x = (roll + m_roll_max)*m_roll_step_inverse;
+    const real_t y = (steer + m_steer_max)*m_steer_step_inverse;
+    if (!(m_filled &&
+          (x >= 0) && (x <= static_cast<real_t>(N - 1)) &&
+          (y >= 0) && (y <= static_cast<real_t>(N - 1)))) {
+        return false; // also catches NaN
+    }
+
+    // limit the lower index so that the upper bound uses the last cell
+    const size_t r = std::min(static_cast<size_t>(x), N - 2);
+    const size_t s = std::min(static_cast<size_t>(y), N - 2);
+    const real_t u = x - static_cast<real_t>(r);
+    const real_t v = y - static_cast<real_t>(s);
+
+    const real_t p0 = m_pitch[r][s] + v*(m_pitch[r][s + 1] - m_pitch[r][s]);
+    const real_t p1 = m_pitch[r + 1][s] + v*(m_pitch[r + 1][s + 1] - m_pitch[r + 1][s]);
+    *pitch = p0 + u*(p1 - p0);
+    return true;
+}
+
+template <size_t N>
+model::real_t PitchTable<N>::newton_step(real_t roll, real_t steer, real_t pitch) const {
+    // The holonomic constraint is the height of the front wheel contact
+    // point, with the z-axis pointing down:
+    //   f = -rr*cos(roll) - d1*cos(roll)*sin(pitch) + d2*cos(roll)*cos(pitch)
+    //       + d3*(sin(roll)*sin(steer) - cos(roll)*sin(pitch)*cos(steer))
+    //       + rf*sqrt(1 - g^2)
+    // where g = sin(roll)*cos(steer) + cos(roll)*sin(pitch)*sin(steer) is the
+    // vertical component of the front wheel axis.
+    real_t sr, cr, ss, cs, sp, cp;
+    util::fastmath::sincos(roll, &sr, &cr);
+    util::fastmath::sincos(steer, &ss, &cs);
+    util::fastmath::sincos(pitch, &sp, &cp);
+
+    const real_t g = sr*cs + cr*sp*ss;
+    const real_t h = std::sqrt(1 - g*g);
+    const real_t f = -m_rr*cr - m_d1*cr*sp + m_d2*cr*cp + m_d3*(sr*ss - cr*sp*cs) + m_rf*h;
+    const real_t df = -m_d1*cr*cp - m_d2*cr*sp - m_d3*cr*cp*cs - m_rf*g*cr*cp*ss/h;
+    return pitch - f/df;
+}
+
+template <size_t N>
+bool PitchTable<N>::filled() const {
+    return m_filled;
+}
+
+template <size_t N>
+model::real_t PitchTable<N>::roll_max() const {
+    return m_roll_max;
+}
+
+template <size_t N>
+model::real_t PitchTable<N>::steer_max() const {
+    return m_steer_max;
+}
+
+template <size_t N>
+model::real_t PitchTable<N>::roll(size_t index) const {
+    return static_cast<real_t>(index)/m_roll_step_inverse - m_roll_max;
+}
+
+template <size_t N>
+model::real_t PitchTable<N>::steer(size_t index) const {
+    return static_cast<real_t>(index)/m_steer_step_inverse - m_steer_max;
+}
+
+} // namespace sim
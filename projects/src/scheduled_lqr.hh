@@ -0,0 +1,63 @@
+#include <limits>
+/*
+ * Member function definitions of controller::ScheduledLqr template class.
+ * See scheduled_lqr.h for template class declaration.
+ */
+
+namespace controller {
+
+template <typename T, size_t N>
+ScheduledLqr<T, N>::ScheduledLqr(const gain_table_t& gains, real_t v_min, real_t v_max) :
+m_gains(gains),
+m_v_min(v_min),
+m_v_max(v_max),
+m_inverse_step(static_cast<real_t>(N - 1)/(v_max - v_min)),
+m_v(std::numeric_limits<real_t>::quiet_NaN()) {
+    update_gain(v_min);
+}
+
+template <typename T, size_t N>
+typename ScheduledLqr<T, N>::input_t ScheduledLqr<T, N>::control_calculate(const state_t& x, real_t v) {
+    return util::smallmatrix::multiply(K(v), x);
+}
+
+template <typename T, size_t N>
+const typename ScheduledLqr<T, N>::feedback_gain_t& ScheduledLqr<T, N>::K(real_t v) {
+    if (v != m_v) {
+        update_gain(v);
+    }
+    return m_K;
+}
+
+template <typename T, size_t N>
+real_t ScheduledLqr<T, N>::v_min() const {
+    return m_v_min;
+}
+
+template <typename T, size_t N>
+real_t ScheduledLqr<T, N>::v_max() const {
+    return m_v_max;
+}
+
+template <typename T, size_t N>
+typename ScheduledLqr<T, N>::gain_map_t ScheduledLqr<T, N>::gain(size_t i) const {
+    return gain_map_t(m_gains[i]);
+}
+
+template <typename T, size_t N>
+void ScheduledLqr<T, N>::update_gain(real_t v) {
+    // fractional table index, breakpoints are uniformly spaced
+    const real_t s = (v - m_v_min)*m_inverse_step;
+    if (!(s > 0)) {
+        m_K = gain(0);
+    } else if (s >= static_cast<real_t>(N - 1)) {
+        m_K = gain(N - 1);
+    } else {
+        const size_t i = static_cast<size_t>(s);
+        const real_t a = s - static_cast<real_t>(i);
+        m_K = gain(i) + a*(gain(i + 1) - gain(i));
+    }
+    m_v = v;
+}
+
+} // namespace controller
@@ -1,7 +1,9 @@
 #include <cmath>
+#include <cstring>
 #include <type_traits>
 #include <boost/math/special_functions/round.hpp>
 #include "bicycle/kinematic.h"
+#include "fastmath.h"
 #include "kalman.h"
 /*
  * Member function definitions of sim::Bicycle template class.
@@ -16,18 +18,33 @@ namespace sim {
 #define NULL_OBSERVER_FUNCTION(return_type) \
     template <typename T> \
     typename std::enable_if<!std::is_base_of<observer::ObserverBase, T>::value, return_type>::type
+#define DEFERRED_COVARIANCE_FUNCTION(return_type) \
+    template <typename T> \
+    typename std::enable_if<has_deferred_covariance_update<T>::value, return_type>::type
+#define NON_DEFERRED_COVARIANCE_FUNCTION(return_type) \
+    template <typename T> \
+    typename std::enable_if<!has_deferred_covariance_update<T>::value, return_type>::type
 #define BICYCLE_TYPE Bicycle<Model, Observer>
 
 template <typename Model, typename Observer> template <typename T>
 Bicycle<Model, Observer>::Bicycle(typename std::enable_if<std::is_base_of<observer::ObserverBase, T>::value, real_t>::type v, real_t dt) :
 m_model(v, dt),
+m_model_cache(nullptr),
 m_observer(m_model),
 m_full_state(full_state_t::Zero()),
 m_pose(BicyclePoseMessage_init_zero),
 m_input(input_t::Zero()),
-m_measurement(measurement_t::Zero()) {
+m_measurement(measurement_t::Zero()),
+m_pitch_table(nullptr),
+m_pitch_max_error(0),
+m_state_snapshot(state_snapshot_t{m_full_state, v, 0}),
+m_pose_snapshot(m_pose),
+m_pose_sequence(m_pose_snapshot.sequence()),
+m_auxiliary_state_update(auxiliary_state_update_t::dynamics),
+m_auxiliary_integrator() {
     // Note: User must initialize Kalman matrices in application.
-    chBSemObjectInit(&m_state_sem, false); // initialize to not taken
+    // The auxiliary state rates per unit speed are also used for the pose rates.
+    m_auxiliary_integrator.set_rates(m_model);
 
 static_assert((!std::is_same<Model, model::BicycleKinematic>::value) ||
               std::is_same<Observer, std::nullptr_t>::value,
@@ -37,13 +54,22 @@ static_assert((!std::is_same<Model, model::BicycleKinematic>::value) ||
 template <typename Model, typename Observer> template <typename T>
 Bicycle<Model, Observer>::Bicycle(typename std::enable_if<!std::is_base_of<observer::ObserverBase, T>::value, real_t>::type v, real_t dt) :
 m_model(v, dt),
+m_model_cache(nullptr),
 m_observer(nullptr),
 m_full_state(full_state_t::Zero()),
 m_pose(BicyclePoseMessage_init_zero),
 m_input(input_t::Zero()),
-m_measurement(measurement_t::Zero()) {
+m_measurement(measurement_t::Zero()),
+m_pitch_table(nullptr),
+m_pitch_max_error(0),
+m_state_snapshot(state_snapshot_t{m_full_state, v, 0}),
+m_pose_snapshot(m_pose),
+m_pose_sequence(m_pose_snapshot.sequence()),
+m_auxiliary_state_update(auxiliary_state_update_t::dynamics),
+m_auxiliary_integrator() {
     // Note: User must initialize Kalman matrices in application.
-    chBSemObjectInit(&m_state_sem, false); // initialize to not taken
+    // The auxiliary state rates per unit speed are also used for the pose rates.
+    m_auxiliary_integrator.set_rates(m_model);
 
 static_assert((!std::is_same<Model, model::BicycleKinematic>::value) ||
               std::is_same<Observer, std::nullptr_t>::value,
@@ -59,7 +85,17 @@ void Bicycle<Model, Observer>::set_v(real_t v)  {
     real_t v_quantized = v_quantization_resolution *
         boost::math::round(v/v_quantization_resolution, policy);
     if (v_quantized != this->v()) {
-        m_model.set_v_dt(v_quantized, m_model.dt());
+        const model_t* cached_model = nullptr;
+        if (m_model_cache != nullptr) {
+            cached_model = m_model_cache->model(v_quantized, m_model.dt());
+        }
+        if (cached_model != nullptr) {
+            // The observer holds a reference to m_model and uses the copied
+            // matrices on the next update.
+            m_model = *cached_model;
+        } else {
+            m_model.set_v_dt(v_quantized, m_model.dt());
+        }
     }
 }
 
@@ -70,14 +106,39 @@ void Bicycle<Model, Observer>::set_dt(real_t dt)  {
     }
 }
 
+template <typename Model, typename Observer>
+void Bicycle<Model, Observer>::set_model_cache(const ModelCacheBase<model_t>* cache) {
+    m_model_cache = cache;
+}
+
+template <typename Model, typename Observer>
+void Bicycle<Model, Observer>::set_pitch_table(const PitchTableBase* table, real_t max_error) {
+    m_pitch_table = table;
+    m_pitch_max_error = max_error;
+}
+
+template <typename Model, typename Observer>
+void Bicycle<Model, Observer>::set_auxiliary_state_update(auxiliary_state_update_t mode) {
+    m_auxiliary_state_update = mode;
+    if (mode == auxiliary_state_update_t::kinematics) {
+        reset_auxiliary_integrator(make_auxiliary_sample());
+    }
+}
+
 template <typename Model, typename Observer>
 OBSERVER_FUNCTION(void) Bicycle<Model, Observer>::reset() {
     m_observer.reset();
     m_full_state = full_state_t::Zero();
+    const auxiliary_sample_t sample = make_auxiliary_sample();
+    publish_state(sample.yaw_rate);
+    reset_auxiliary_integrator(sample);
 }
 template <typename Model, typename Observer>
 NULL_OBSERVER_FUNCTION(void) Bicycle<Model, Observer>::reset() {
     m_full_state = full_state_t::Zero();
+    const auxiliary_sample_t sample = make_auxiliary_sample();
+    publish_state(sample.yaw_rate);
+    reset_auxiliary_integrator(sample);
 }
 
 template <typename Model, typename Observer>
@@ -85,6 +146,16 @@ void Bicycle<Model, Observer>::update_dynamics(real_t roll_torque_input, real_t
     real_t yaw_angle_measurement,
     real_t steer_angle_measurement,
     real_t rear_wheel_angle_measurement) {
+    update_dynamics_state(roll_torque_input, steer_torque_input,
+            yaw_angle_measurement, steer_angle_measurement, rear_wheel_angle_measurement);
+    update_observer_covariance();
+}
+
+template <typename Model, typename Observer>
+void Bicycle<Model, Observer>::update_dynamics_state(real_t roll_torque_input, real_t steer_torque_input,
+    real_t yaw_angle_measurement,
+    real_t steer_angle_measurement,
+    real_t rear_wheel_angle_measurement) {
 
     //  While the rear wheel angle measurement can be used to determine velocity,
     //  it is assumed that velocity is determined outside this class and passed as
@@ -104,47 +175,98 @@ void Bicycle<Model, Observer>::update_dynamics(real_t roll_torque_input, real_t
     model_t::set_output_element(m_measurement, model_t::output_index_t::steer_angle, steer_angle_measurement);
 
     // do full state update which is observer specific
-    chBSemWait(&m_state_sem);
-    full_state_t full_state_copy = m_full_state;
-    chBSemSignal(&m_state_sem);
+    if (m_auxiliary_state_update == auxiliary_state_update_t::kinematics) {
+        // only update the dynamic state, auxiliary states are integrated in
+        // the kinematics update
+        m_full_state = do_state_update(m_full_state);
+    } else {
+        m_full_state = do_full_state_update(m_full_state);
+    }
+    // The sample is also used for the published yaw rate. Merging the pose
+    // below does not change the dynamic state.
+    const auxiliary_sample_t sample = make_auxiliary_sample();
+    if (m_auxiliary_state_update == auxiliary_state_update_t::kinematics) {
+        m_auxiliary_integrator.push(sample);
+    }
 
-    full_state_t full_state_next = do_full_state_update(full_state_copy);
+    // Merge the pitch angle solved in the most recent kinematics update. If a
+    // pose is being published at this moment, it is merged in the next update
+    // as the dynamics update must not wait for the kinematics update.
+    const uint32_t pose_sequence = m_pose_snapshot.sequence();
+    BicyclePoseMessage pose;
+    if ((pose_sequence != m_pose_sequence) && m_pose_snapshot.try_read(pose)) {
+        m_pose_sequence = pose_sequence;
+        model_t::set_full_state_element(m_full_state, full_state_index_t::pitch_angle, pose.pitch);
+
+        if (m_auxiliary_state_update == auxiliary_state_update_t::kinematics) {
+            // merge the auxiliary states integrated in the kinematics update
+            model_t::set_full_state_element(m_full_state, full_state_index_t::x, pose.x);
+            model_t::set_full_state_element(m_full_state, full_state_index_t::y, pose.y);
+            model_t::set_full_state_element(m_full_state, full_state_index_t::rear_wheel_angle,
+                    pose.rear_wheel);
+        } else {
+            // wrap rear wheel angle so it does not grow beyond all bounds
+            model_t::set_full_state_element(m_full_state, full_state_index_t::rear_wheel_angle,
+                    util::fastmath::wrap(model_t::get_full_state_element(m_full_state,
+                            full_state_index_t::rear_wheel_angle)));
+        }
+    }
 
-    chBSemWait(&m_state_sem);
-    m_full_state = full_state_next;
-    chBSemSignal(&m_state_sem);
+    publish_state(sample.yaw_rate);
+}
+
+template <typename Model, typename Observer>
+void Bicycle<Model, Observer>::update_observer_covariance() {
+    do_observer_covariance_update();
 }
 
 template <typename Model, typename Observer>
 void Bicycle<Model, Observer>::update_kinematics() {
-    chBSemWait(&m_state_sem);
-    full_state_t full_state_copy = m_full_state;
-    chBSemSignal(&m_state_sem);
+    const state_snapshot_t snapshot = m_state_snapshot.read();
+    const full_state_t& full_state = snapshot.full_state;
 
     // solve for pitch as this does not get integrated
-    const real_t roll = model_t::get_full_state_element(full_state_copy, full_state_index_t::roll_angle);
-    const real_t steer = model_t::get_full_state_element(full_state_copy, full_state_index_t::steer_angle);
-    real_t pitch = model_t::get_full_state_element(full_state_copy, full_state_index_t::pitch_angle);
-    pitch = m_model.solve_constraint_pitch(roll, steer, pitch);
-
-    // update full state with newest computed pitch angle
-    chBSemWait(&m_state_sem);
-    model_t::set_full_state_element(m_full_state, full_state_index_t::pitch_angle, pitch);
-
-    // mod rear wheel angle so it does not grow beyond all bounds
-    model_t::set_full_state_element(m_full_state, full_state_index_t::rear_wheel_angle,
-            std::fmod(model_t::get_full_state_element(full_state_copy, full_state_index_t::rear_wheel_angle),
-                      constants::two_pi)),
-    chBSemSignal(&m_state_sem);
+    const real_t roll = model_t::get_full_state_element(full_state, full_state_index_t::roll_angle);
+    const real_t steer = model_t::get_full_state_element(full_state, full_state_index_t::steer_angle);
+    real_t pitch;
+    // use the previous pitch as initial guess, roll and steer change little
+    // between pose updates
+    if ((m_pitch_table == nullptr) ||
+            !m_pitch_table->pitch(roll, steer, m_pose.pitch, m_pitch_max_error, &pitch)) {
+        pitch = m_model.solve_constraint_pitch(roll, steer, m_pose.pitch);
+    }
 
     m_pose.timestamp = chVTGetSystemTime();
-    m_pose.x = model_t::get_full_state_element(full_state_copy, full_state_index_t::x);
-    m_pose.y = model_t::get_full_state_element(full_state_copy, full_state_index_t::y);
-    m_pose.rear_wheel = model_t::get_full_state_element(full_state_copy, full_state_index_t::rear_wheel_angle);
+    if (m_auxiliary_state_update == auxiliary_state_update_t::kinematics) {
+        m_auxiliary_integrator.integrate();
+        const auxiliary_state_t& aux = m_auxiliary_integrator.auxiliary_state();
+        m_pose.x = model_t::get_auxiliary_state_element(aux, auxiliary_state_index_t::x);
+        m_pose.y = model_t::get_auxiliary_state_element(aux, auxiliary_state_index_t::y);
+        m_pose.rear_wheel = model_t::get_auxiliary_state_element(aux, auxiliary_state_index_t::rear_wheel_angle);
+    } else {
+        m_pose.x = model_t::get_full_state_element(full_state, full_state_index_t::x);
+        m_pose.y = model_t::get_full_state_element(full_state, full_state_index_t::y);
+        m_pose.rear_wheel = model_t::get_full_state_element(full_state, full_state_index_t::rear_wheel_angle);
+    }
     m_pose.pitch = pitch;
-    m_pose.yaw = model_t::get_full_state_element(full_state_copy, full_state_index_t::yaw_angle);
+    m_pose.yaw = model_t::get_full_state_element(full_state, full_state_index_t::yaw_angle);
     m_pose.roll = roll;
     m_pose.steer = steer;
+
+    // rates of the dynamics update, used by the receiver to extrapolate the pose
+    m_pose.yaw_rate = snapshot.yaw_rate;
+    m_pose.roll_rate = model_t::get_full_state_element(full_state, full_state_index_t::roll_rate);
+    m_pose.steer_rate = model_t::get_full_state_element(full_state, full_state_index_t::steer_rate);
+    m_pose.rear_wheel_rate = m_auxiliary_integrator.rear_wheel_rate()*snapshot.v;
+    m_pose.v = snapshot.v;
+    m_pose.has_yaw_rate = true;
+    m_pose.has_roll_rate = true;
+    m_pose.has_steer_rate = true;
+    m_pose.has_rear_wheel_rate = true;
+    m_pose.has_v = true;
+
+    // publish pose, pitch angle is merged into the full state by the dynamics update
+    m_pose_snapshot.write(m_pose);
 }
 
 template <typename Model, typename Observer>
@@ -166,6 +288,30 @@ NULL_OBSERVER_FUNCTION(void) Bicycle<Model, Observer>::prime_observer() {
         // do nothing
 }
 
+template <typename Model, typename Observer>
+void Bicycle<Model, Observer>::save_checkpoint(checkpoint_t* checkpoint) const {
+    checkpoint->v = v();
+    checkpoint->dt = dt();
+    std::memcpy(checkpoint->full_state, m_full_state.data(), sizeof(checkpoint->full_state));
+    observer_checkpoint<model_t, observer_t>::save(m_observer, checkpoint);
+    checkpoint->seal();
+}
+
+template <typename Model, typename Observer>
+bool Bicycle<Model, Observer>::restore_checkpoint(const checkpoint_t& checkpoint) {
+    if (!checkpoint.valid()) {
+        return false;
+    }
+    set_dt(checkpoint.dt);
+    set_v(checkpoint.v);
+    std::memcpy(m_full_state.data(), checkpoint.full_state, sizeof(checkpoint.full_state));
+    const auxiliary_sample_t sample = make_auxiliary_sample();
+    publish_state(sample.yaw_rate);
+    observer_checkpoint<model_t, observer_t>::restore(m_observer, checkpoint);
+    reset_auxiliary_integrator(sample);
+    return true;
+}
+
 template <typename Model, typename Observer>
 const BicyclePoseMessage& Bicycle<Model, Observer>::pose() const {
     return m_pose;
@@ -251,11 +397,26 @@ model::real_t Bicycle<Model, Observer>::dt() const {
     return m_model.dt();
 }
 
+template <typename Model, typename Observer>
+typename Bicycle<Model, Observer>::auxiliary_state_update_t Bicycle<Model, Observer>::auxiliary_state_update() const {
+    return m_auxiliary_state_update;
+}
+
+template <typename Model, typename Observer>
+const typename Bicycle<Model, Observer>::auxiliary_integrator_t& Bicycle<Model, Observer>::auxiliary_integrator() const {
+    return m_auxiliary_integrator;
+}
+
 template <typename Model, typename Observer>
 const typename Bicycle<Model, Observer>::full_state_t& Bicycle<Model, Observer>::full_state() const {
     return m_full_state;
 }
 
+template <typename Model, typename Observer>
+typename Bicycle<Model, Observer>::full_state_t Bicycle<Model, Observer>::full_state_snapshot() const {
+    return m_state_snapshot.read().full_state;
+}
+
 template <typename Model, typename Observer>
 OBSERVER_FUNCTION(typename BICYCLE_TYPE::full_state_t) Bicycle<Model, Observer>::do_full_state_update(const full_state_t& full_state) {
     // The auxiliary states _must_ also be integrated at the same time as the
@@ -263,7 +424,7 @@ OBSERVER_FUNCTION(typename BICYCLE_TYPE::full_state_t) Bicycle<Model, Observer>:
     full_state_t state_full = m_model.integrate_full_state(
             full_state, m_input, m_model.dt(), m_measurement);
 
-    m_observer.update_state(m_input, m_measurement);
+    do_observer_update();
 
     if (!m_observer.state().allFinite()) {
         chSysHalt("state elements with non finite values");
@@ -286,4 +447,57 @@ NULL_OBSERVER_FUNCTION(typename BICYCLE_TYPE::full_state_t) Bicycle<Model, Obser
     return m_model.integrate_full_state(full_state, m_input, m_model.dt(), m_measurement);
 }
 
+template <typename Model, typename Observer>
+OBSERVER_FUNCTION(typename BICYCLE_TYPE::full_state_t) Bicycle<Model, Observer>::do_state_update(const full_state_t& full_state) {
+    do_observer_update();
+
+    if (!m_observer.state().allFinite()) {
+        chSysHalt("state elements with non finite values");
+    }
+
+    return model_t::make_full_state(model_t::get_auxiliary_state_part(full_state),
+                                    m_observer.state());
+}
+
+template <typename Model, typename Observer>
+NULL_OBSERVER_FUNCTION(typename BICYCLE_TYPE::full_state_t) Bicycle<Model, Observer>::do_state_update(const full_state_t& full_state) {
+    return model_t::make_full_state(model_t::get_auxiliary_state_part(full_state),
+            m_model.update_state(model_t::get_state_part(full_state), m_input, m_measurement));
+}
+
+template <typename Model, typename Observer>
+typename Bicycle<Model, Observer>::auxiliary_sample_t Bicycle<Model, Observer>::make_auxiliary_sample() const {
+    return auxiliary_integrator_t::make_sample(m_model, model_t::get_state_part(m_full_state), m_input);
+}
+
+template <typename Model, typename Observer>
+void Bicycle<Model, Observer>::publish_state(real_t yaw_rate) {
+    m_state_snapshot.write(state_snapshot_t{m_full_state, m_model.v(), yaw_rate});
+}
+
+template <typename Model, typename Observer>
+void Bicycle<Model, Observer>::reset_auxiliary_integrator(const auxiliary_sample_t& sample) {
+    m_auxiliary_integrator.reset(model_t::get_auxiliary_state_part(m_full_state), sample);
+}
+
+template <typename Model, typename Observer>
+DEFERRED_COVARIANCE_FUNCTION(void) Bicycle<Model, Observer>::do_observer_update() {
+    m_observer.update_state_estimate(m_input, m_measurement);
+}
+
+template <typename Model, typename Observer>
+NON_DEFERRED_COVARIANCE_FUNCTION(void) Bicycle<Model, Observer>::do_observer_update() {
+    m_observer.update_state(m_input, m_measurement);
+}
+
+template <typename Model, typename Observer>
+DEFERRED_COVARIANCE_FUNCTION(void) Bicycle<Model, Observer>::do_observer_covariance_update() {
+    m_observer.update_error_covariance();
+}
+
+template <typename Model, typename Observer>
+NON_DEFERRED_COVARIANCE_FUNCTION(void) Bicycle<Model, Observer>::do_observer_covariance_update() {
+    // do nothing, error covariance is updated with the state estimate
+}
+
 } // namespace sim
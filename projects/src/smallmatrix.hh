@@ -0,0 +1,191 @@
+/*
+ * Definitions of util::smallmatrix functions.
+ * See smallmatrix.h for function declarations.
+ */
+
+namespace util {
+namespace smallmatrix {
+namespace detail {
+
+template <typename MatrixA, typename MatrixB>
+void check_shape() {
+    static_assert((MatrixA::RowsAtCompileTime != Eigen::Dynamic) &&
+                  (MatrixA::ColsAtCompileTime != Eigen::Dynamic) &&
+                  (MatrixB::RowsAtCompileTime != Eigen::Dynamic) &&
+                  (MatrixB::ColsAtCompileTime != Eigen::Dynamic),
+            "Matrix dimensions must be fixed");
+    static_assert(static_cast<int>(MatrixA::ColsAtCompileTime) ==
+                  static_cast<int>(MatrixB::RowsAtCompileTime),
+            "Matrix dimensions do not agree");
+}
+
+// Sum of products of K elements, evaluated as a single multiply-accumulate
+// chain starting with element 0.
+template <int K>
+struct dot {
+    // sum over k of A(i, k)*B(k, j)
+    template <typename MatrixA, typename MatrixB>
+    static typename MatrixA::Scalar row_col(const MatrixA& A, int i, const MatrixB& B, int j) {
+        return dot<K - 1>::row_col(A, i, B, j) + A.coeff(i, K - 1)*B.coeff(K - 1, j);
+    }
+    // sum over k of A(i, k)*B(j, k)
+    template <typename MatrixA, typename MatrixB>
+    static typename MatrixA::Scalar row_row(const MatrixA& A, int i, const MatrixB& B, int j) {
+        return dot<K - 1>::row_row(A, i, B, j) + A.coeff(i, K - 1)*B.coeff(j, K - 1);
+    }
+};
+
+template <>
+struct dot<1> {
+    template <typename MatrixA, typename MatrixB>
+    static typename MatrixA::Scalar row_col(const MatrixA& A, int i, const MatrixB& B, int j) {
+        return A.coeff(i, 0)*B.coeff(0, j);
+    }
+    template <typename MatrixA, typename MatrixB>
+    static typename MatrixA::Scalar row_row(const MatrixA& A, int i, const MatrixB& B, int j) {
+        return A.coeff(i, 0)*B.coeff(j, 0);
+    }
+};
+
+// Call f(i, j) for the N first elements of an R x C matrix in column-major
+// order. Indices are compile-time constants after inlining.
+template <int R, int N>
+struct for_each_element {
+    template <typename F>
+    static void apply(F& f) {
+        for_each_element<R, N - 1>::apply(f);
+        f((N - 1) % R, (N - 1) / R);
+    }
+};
+
+template <int R>
+struct for_each_element<R, 0> {
+    template <typename F>
+    static void apply(F&) { }
+};
+
+} // namespace detail
+
+namespace unrolled {
+
+template <typename MatrixA, typename VectorX>
+product_t<MatrixA, VectorX> multiply(const MatrixA& A, const VectorX& x) {
+    detail::check_shape<MatrixA, VectorX>();
+    constexpr int R = MatrixA::RowsAtCompileTime;
+    constexpr int K = MatrixA::ColsAtCompileTime;
+    constexpr int C = VectorX::ColsAtCompileTime;
+
+    product_t<MatrixA, VectorX> y;
+    auto f = [&](int i, int j) {
+        y.coeffRef(i, j) = detail::dot<K>::row_col(A, i, x, j);
+    };
+    detail::for_each_element<R, R*C>::apply(f);
+    return y;
+}
+
+template <typename MatrixA, typename VectorX, typename MatrixB, typename VectorU>
+product_t<MatrixA, VectorX> multiply_add(const MatrixA& A, const VectorX& x,
+        const MatrixB& B, const VectorU& u) {
+    detail::check_shape<MatrixA, VectorX>();
+    detail::check_shape<MatrixB, VectorU>();
+    static_assert((static_cast<int>(MatrixA::RowsAtCompileTime) ==
+                   static_cast<int>(MatrixB::RowsAtCompileTime)) &&
+                  (static_cast<int>(VectorX::ColsAtCompileTime) ==
+                   static_cast<int>(VectorU::ColsAtCompileTime)),
+            "Matrix dimensions do not agree");
+    constexpr int R = MatrixA::RowsAtCompileTime;
+    constexpr int K = MatrixA::ColsAtCompileTime;
+    constexpr int L = MatrixB::ColsAtCompileTime;
+    constexpr int C = VectorX::ColsAtCompileTime;
+
+    product_t<MatrixA, VectorX> y;
+    auto f = [&](int i, int j) {
+        y.coeffRef(i, j) = detail::dot<K>::row_col(A, i, x, j) +
+                           detail::dot<L>::row_col(B, i, u, j);
+    };
+    detail::for_each_element<R, R*C>::apply(f);
+    return y;
+}
+
+template <typename MatrixA, typename MatrixP, typename MatrixQ>
+symmetric_t<MatrixA> symmetric_update(const MatrixA& A, const MatrixP& P, const MatrixQ& Q) {
+    detail::check_shape<MatrixA, MatrixP>();
+    constexpr int N = MatrixA::RowsAtCompileTime;
+    constexpr int K = MatrixA::ColsAtCompileTime;
+    static_assert((static_cast<int>(MatrixP::RowsAtCompileTime) == K) &&
+                  (static_cast<int>(MatrixP::ColsAtCompileTime) == K) &&
+                  (static_cast<int>(MatrixQ::RowsAtCompileTime) == N) &&
+                  (static_cast<int>(MatrixQ::ColsAtCompileTime) == N),
+            "Matrix dimensions do not agree");
+
+    // AP = A P, then (A P A')(i, j) = AP.row(i) . A.row(j) for i >= j
+    const Eigen::Matrix<typename MatrixA::Scalar, N, K> AP = multiply(A, P);
+    symmetric_t<MatrixA> S;
+    auto f = [&](int i, int j) {
+        if (i >= j) {
+            S.coeffRef(i, j) = detail::dot<K>::row_row(AP, i, A, j) + Q.coeff(i, j);
+        } else {
+            S.coeffRef(i, j) = S.coeff(j, i);
+        }
+    };
+    // Elements are visited in column-major order and the lower triangle
+    // element (j, i) is set before the upper triangle element (i, j).
+    detail::for_each_element<N, N*N>::apply(f);
+    return S;
+}
+
+template <typename MatrixA, typename VectorX>
+typename MatrixA::Scalar row_dot(const MatrixA& A, int row, const VectorX& x) {
+    detail::check_shape<MatrixA, VectorX>();
+    static_assert(VectorX::ColsAtCompileTime == 1, "Argument x must be a column vector");
+    return detail::dot<MatrixA::ColsAtCompileTime>::row_col(A, row, x, 0);
+}
+
+} // namespace unrolled
+
+#if defined(EIGEN_VECTORIZE)
+template <typename MatrixA, typename VectorX>
+product_t<MatrixA, VectorX> multiply(const MatrixA& A, const VectorX& x) {
+    return A*x;
+}
+
+template <typename MatrixA, typename VectorX, typename MatrixB, typename VectorU>
+product_t<MatrixA, VectorX> multiply_add(const MatrixA& A, const VectorX& x,
+        const MatrixB& B, const VectorU& u) {
+    return A*x + B*u;
+}
+
+template <typename MatrixA, typename MatrixP, typename MatrixQ>
+symmetric_t<MatrixA> symmetric_update(const MatrixA& A, const MatrixP& P, const MatrixQ& Q) {
+    return A*P*A.transpose() + Q;
+}
+
+template <typename MatrixA, typename VectorX>
+typename MatrixA::Scalar row_dot(const MatrixA& A, int row, const VectorX& x) {
+    return (A.row(row)*x).value();
+}
+#else // defined(EIGEN_VECTORIZE)
+template <typename MatrixA, typename VectorX>
+product_t<MatrixA, VectorX> multiply(const MatrixA& A, const VectorX& x) {
+    return unrolled::multiply(A, x);
+}
+
+template <typename MatrixA, typename VectorX, typename MatrixB, typename VectorU>
+product_t<MatrixA, VectorX> multiply_add(const MatrixA& A, const VectorX& x,
+        const MatrixB& B, const VectorU& u) {
+    return unrolled::multiply_add(A, x, B, u);
+}
+
+template <typename MatrixA, typename MatrixP, typename MatrixQ>
+symmetric_t<MatrixA> symmetric_update(const MatrixA& A, const MatrixP& P, const MatrixQ& Q) {
+    return unrolled::symmetric_update(A, P, Q);
+}
+
+template <typename MatrixA, typename VectorX>
+typename MatrixA::Scalar row_dot(const MatrixA& A, int row, const VectorX& x) {
+    return unrolled::row_dot(A, row, x);
+}
+#endif // defined(EIGEN_VECTORIZE)
+
+} // namespace smallmatrix
+} // namespace util
@@ -0,0 +1,200 @@
+/*
+ * Member function definitions of sim::UdKalman template class.
+ * See udkalman.h for template class declaration.
+ */
+
+namespace sim {
+
+template <typename Model>
+UdKalman<Model>::UdKalman(model_t& system) :
+m_system(system),
+m_x(state_t::Zero()),
+m_U(state_matrix_t::Identity()),
+m_D(state_diagonal_t::Ones()),
+m_Q(process_noise_covariance_t::Identity()),
+m_Uq(state_matrix_t::Identity()),
+m_Dq(state_diagonal_t::Ones()),
+m_R(measurement_noise_covariance_t::Identity()),
+m_Ur_inverse(measurement_noise_covariance_t::Identity()),
+m_Dr(output_diagonal_t::Ones()),
+m_K(kalman_gain_t::Zero()) { }
+
+template <typename Model>
+void UdKalman<Model>::reset() {
+    m_x = state_t::Zero();
+    m_U = state_matrix_t::Identity();
+    m_D = state_diagonal_t::Ones();
+    m_K = kalman_gain_t::Zero();
+}
+
+template <typename Model>
+void UdKalman<Model>::update_state(const input_t& u, const measurement_t& z) {
+    time_update(u);
+    measurement_update(z);
+}
+
+template <typename Model>
+void UdKalman<Model>::time_update(const input_t& u) {
+    static constexpr unsigned int n = model_t::n;
+
+    m_x = util::smallmatrix::multiply_add(m_system.Ad(), m_x, m_system.Bd(), u);
+
+    // Modified weighted Gram-Schmidt orthogonalization of the rows of
+    // W = [Ad U, Uq] with weights diag(D, Dq). The transpose of W is stored
+    // so that rows of W are contiguous in memory.
+    Eigen::Matrix<real_t, 2*n, n> Wt;
+    Wt.template topRows<n>().noalias() = m_U.transpose()*m_system.Ad().transpose();
+    Wt.template bottomRows<n>() = m_Uq.transpose();
+    Eigen::Matrix<real_t, 2*n, 1> Dw;
+    Dw << m_D, m_Dq;
+
+    for (int j = n - 1; j >= 0; --j) {
+        const Eigen::Matrix<real_t, 2*n, 1> wd = Wt.col(j).cwiseProduct(Dw);
+        const real_t d = wd.dot(Wt.col(j));
+        m_D[j] = d;
+        for (int i = 0; i < j; ++i) {
+            const real_t uij = (d > 0) ? wd.dot(Wt.col(i))/d : 0;
+            m_U(i, j) = uij;
+            Wt.col(i) -= uij*Wt.col(j);
+        }
+    }
+}
+
+template <typename Model>
+void UdKalman<Model>::measurement_update(const measurement_t& z) {
+    static constexpr unsigned int n = model_t::n;
+    static constexpr unsigned int l = model_t::l;
+
+    // decorrelated measurements and output matrix
+    const measurement_t zd = m_Ur_inverse*z;
+    const output_matrix_t C = m_Ur_inverse*m_system.Cd();
+
+    // Bierman scalar measurement updates. The gain of each scalar update is
+    // applied to the gains of previous updates so that K maps the
+    // (decorrelated) innovation of the first prediction to the state update.
+    kalman_gain_t Kd;
+    for (unsigned int m = 0; m < l; ++m) {
+        const state_t f = m_U.transpose()*C.row(m).transpose();
+        const state_t v = m_D.cwiseProduct(f);
+        state_t b = state_t::Zero();
+        real_t alpha = m_Dr[m];
+        for (unsigned int j = 0; j < n; ++j) {
+            const real_t alpha_prev = alpha;
+            alpha += f[j]*v[j];
+            m_D[j] *= alpha_prev/alpha;
+            const real_t lambda = -f[j]/alpha_prev;
+            for (unsigned int i = 0; i < j; ++i) {
+                const real_t uij = m_U(i, j);
+                m_U(i, j) = uij + b[i]*lambda;
+                b[i] += uij*v[j];
+            }
+            b[j] = v[j];
+        }
+        const state_t k = b/alpha;
+
+        const real_t innovation = zd[m] - C.row(m).dot(m_x);
+        m_x += k*innovation;
+        for (unsigned int i = 0; i < m; ++i) {
+            Kd.col(i) -= k*C.row(m).dot(Kd.col(i));
+        }
+        Kd.col(m) = k;
+    }
+    m_K.noalias() = Kd*m_Ur_inverse;
+}
+
+template <typename Model>
+void UdKalman<Model>::set_x(const state_t& x) {
+    m_x = x;
+}
+
+template <typename Model>
+void UdKalman<Model>::set_P(const error_covariance_t& P) {
+    factor(P, &m_U, &m_D);
+}
+
+template <typename Model>
+void UdKalman<Model>::set_Q(const process_noise_covariance_t& Q) {
+    m_Q = Q;
+    factor(m_Q, &m_Uq, &m_Dq);
+}
+
+template <typename Model>
+void UdKalman<Model>::set_R(const measurement_noise_covariance_t& R) {
+    measurement_noise_covariance_t Ur;
+    m_R = R;
+    factor(m_R, &Ur, &m_Dr);
+    m_Ur_inverse = Ur.template triangularView<Eigen::UnitUpper>().solve(
+            measurement_noise_covariance_t::Identity());
+}
+
+template <typename Model>
+const typename UdKalman<Model>::state_t& UdKalman<Model>::x() const {
+    return m_x;
+}
+
+template <typename Model>
+const typename UdKalman<Model>::state_t& UdKalman<Model>::state() const {
+    return m_x;
+}
+
+template <typename Model>
+typename UdKalman<Model>::error_covariance_t UdKalman<Model>::P() const {
+    return m_U*m_D.asDiagonal()*m_U.transpose();
+}
+
+template <typename Model>
+const typename UdKalman<Model>::state_matrix_t& UdKalman<Model>::U() const {
+    return m_U;
+}
+
+template <typename Model>
+const typename UdKalman<Model>::state_diagonal_t& UdKalman<Model>::D() const {
+    return m_D;
+}
+
+template <typename Model>
+const typename UdKalman<Model>::process_noise_covariance_t& UdKalman<Model>::Q() const {
+    return m_Q;
+}
+
+template <typename Model>
+const typename UdKalman<Model>::measurement_noise_covariance_t& UdKalman<Model>::R() const {
+    return m_R;
+}
+
+template <typename Model>
+const typename UdKalman<Model>::kalman_gain_t& UdKalman<Model>::K() const {
+    return m_K;
+}
+
+template <typename Model>
+model::real_t UdKalman<Model>::dt() const {
+    return m_system.dt();
+}
+
+template <typename Model>
+typename UdKalman<Model>::model_t& UdKalman<Model>::system() const {
+    return m_system;
+}
+
+template <typename Model> template <typename M, typename V>
+void UdKalman<Model>::factor(const M& m, M* u, V* d) {
+    const int n = m.rows();
+    u->setIdentity();
+    for (int j = n - 1; j >= 0; --j) {
+        real_t dj = m(j, j);
+        for (int k = j + 1; k < n; ++k) {
+            dj -= (*d)[k]*(*u)(j, k)*(*u)(j, k);
+        }
+        (*d)[j] = dj;
+        for (int i = 0; i < j; ++i) {
+            real_t uij = m(i, j);
+            for (int k = j + 1; k < n; ++k) {
+                uij -= (*d)[k]*(*u)(i, k)*(*u)(j, k);
+            }
+            (*u)(i, j) = (dj > 0) ? uij/dj : 0;
+        }
+    }
+}
+
+} // namespace sim
@@ -29,6 +29,7 @@ namespace {
     const eventflags_t adc_eventflag_complete = EVENT_MASK(0);
     const eventflags_t adc_eventflag_error = EVENT_MASK(1);
     event_source_t adc_event_source;
+    Analog::conversion_callback_t adc_conversion_callback = nullptr;
 
     void adcerrorcallback(ADCDriver* adcp, adcerror_t err) {
         (void)adcp;
@@ -43,6 +44,9 @@ namespace {
         (void)n;
         chSysLockFromISR();
         chEvtBroadcastFlagsI(&adc_event_source, adc_eventflag_complete);
+        if (adc_conversion_callback != nullptr) {
+            adc_conversion_callback();
+        }
         chSysUnlockFromISR();
     }
 
@@ -175,7 +179,8 @@ namespace {
 
 Analog::Analog() : m_adc_buffer() { }
 
-void Analog::start(gptcnt_t sample_rate, bool use_events) {
+void Analog::start(gptcnt_t sample_rate, bool use_events,
+        conversion_callback_t conversion_callback) {
 #ifdef STATIC_SIMULATOR_CONFIG
     /*
      * We manually toggle the Kistler torque sensor measurement line
@@ -186,9 +191,11 @@ void Analog::start(gptcnt_t sample_rate, bool use_events) {
     chThdSleepMilliseconds(100);
     palSetLine(LINE_TORQUE_MEAS_EN);
 #endif // STATIC_SIMULATOR_CONFIG
+    chEvtObjectInit(&adc_event_source);
+    adc_conversion_callback = conversion_callback;
     gptStart(&GPTD8, &gpt8cfg1);
     adcStart(&ADCD1, nullptr);
-    if (use_events) {
+    if (use_events || (conversion_callback != nullptr)) {
         adcStartConversion(&ADCD1, &adcgrpcfg_events, m_adc_buffer.data(), 1);
     } else {
         adcStartConversion(&ADCD1, &adcgrpcfg, m_adc_buffer.data(), 1);
@@ -0,0 +1,36 @@
+#include "histogram.h"
+#include <cmath>
+
+namespace util {
+
+uint32_t histogram_quantile(const uint32_t* counts, size_t n, uint32_t bucket_width,
+        uint32_t max, double q) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; ++i) {
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // rank of the q-quantile, 1-based
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q*total));
+    if (rank < 1) {
+        rank = 1;
+    } else if (rank > total) {
+        rank = total;
+    }
+
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        cumulative += counts[i];
+        if (cumulative >= rank) {
+            const uint64_t upper = static_cast<uint64_t>(i + 1)*bucket_width - 1;
+            return (upper < max) ? static_cast<uint32_t>(upper) : max;
+        }
+    }
+    // the last bucket has no upper edge
+    return max;
+}
+
+} // namespace util
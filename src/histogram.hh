@@ -0,0 +1,63 @@
+/*
+ * Member function definitions of util::Histogram template class.
+ * See histogram.h for template class declaration.
+ */
+#include <limits>
+
+namespace util {
+
+template <size_t N>
+Histogram<N>::Histogram(uint32_t bucket_width) :
+m_counts(),
+m_bucket_width(bucket_width),
+m_total(0),
+m_max(0) {
+    static_assert(N > 0, "Histogram size must be greater than 0.");
+    if (m_bucket_width == 0) {
+        m_bucket_width = 1;
+    }
+}
+
+template <size_t N>
+void Histogram<N>::add(uint32_t value) {
+    const uint32_t i = value/m_bucket_width;
+    uint32_t& count = m_counts[(i < N) ? i : N - 1];
+    if (count < std::numeric_limits<uint32_t>::max()) {
+        ++count;
+    }
+    if (m_total < std::numeric_limits<uint32_t>::max()) {
+        ++m_total;
+    }
+    if (value > m_max) {
+        m_max = value;
+    }
+}
+
+template <size_t N>
+void Histogram<N>::reset() {
+    m_counts.fill(0);
+    m_total = 0;
+    m_max = 0;
+}
+
+template <size_t N>
+uint32_t Histogram<N>::bucket_width() const {
+    return m_bucket_width;
+}
+
+template <size_t N>
+const std::array<uint32_t, N>& Histogram<N>::counts() const {
+    return m_counts;
+}
+
+template <size_t N>
+uint32_t Histogram<N>::total() const {
+    return m_total;
+}
+
+template <size_t N>
+uint32_t Histogram<N>::max() const {
+    return m_max;
+}
+
+} // namespace util
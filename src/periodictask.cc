@@ -0,0 +1,193 @@
+#include "periodictask.h"
+
+namespace rt {
+
+namespace {
+    constexpr rtcnt_t cycles_per_tick = STM32_SYSCLK/CH_CFG_ST_FREQUENCY;
+    constexpr rtcnt_t cycles_per_us = STM32_SYSCLK/1000000U;
+
+    uint32_t ticks_to_us(systime_t ticks) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(ticks)*1000000U/CH_CFG_ST_FREQUENCY);
+    }
+} // namespace
+
+EventReleaseClock::EventReleaseClock(systime_t ticks_per_event) :
+    m_clock(ticks_per_event),
+    m_thread(nullptr),
+    m_timeouts(0) {
+    chDbgAssert(ticks_per_event > 0, "event interval must be nonzero");
+}
+
+void EventReleaseClock::eventI() {
+    if (m_clock.tick()) {
+        chThdResumeI(&m_thread, MSG_OK);
+    }
+}
+
+systime_t EventReleaseClock::nowX() const {
+    return m_clock.time();
+}
+
+void EventReleaseClock::sleep_untilS(systime_t time) {
+    if (!m_clock.set_wakeup(time)) {
+        return;
+    }
+    const systime_t timeout = static_cast<systime_t>(time - m_clock.time()) +
+        m_clock.ticks_per_event();
+    if (chThdSuspendTimeoutS(&m_thread, timeout) == MSG_TIMEOUT) {
+        m_clock.set_time(time);
+        ++m_timeouts;
+    }
+}
+
+systime_t EventReleaseClock::ticks_per_event() const {
+    return m_clock.ticks_per_event();
+}
+
+uint32_t EventReleaseClock::timeouts() const {
+    return m_timeouts;
+}
+
+PeriodicTask::PeriodicTask(const config_t& config) :
+    m_config(config),
+    m_priority(NORMALPRIO),
+    m_release_time(0),
+    m_releases(0),
+    m_deadline_misses(0),
+    m_skipped_releases(0),
+    m_last_lateness(0),
+    m_clock(nullptr),
+    m_start_count(0),
+    m_start_jitter(ticks_to_us(config.period)/1000),
+    m_execution_time_histogram((ticks_to_us(config.period) + histogram_size - 2)/(histogram_size - 1)) {
+    chDbgAssert(config.period > 0, "period must be nonzero");
+    chTMObjectInit(&m_execution_time);
+}
+
+void PeriodicTask::set_release_clock(EventReleaseClock* clock) {
+    chDbgAssert((clock == nullptr) ||
+            (events_per_period(m_config.period, clock->ticks_per_event()) > 0),
+            "period must be a multiple of the event interval");
+    m_clock = clock;
+}
+
+void PeriodicTask::start() {
+    chRegSetThreadName(m_config.name);
+    chThdSetPriority(m_priority);
+    chSysLock();
+    if (m_clock != nullptr) {
+        // the first release is the next event
+        m_clock->sleep_untilS(m_clock->nowX() + 1);
+    }
+    m_release_time = nowX();
+    chSysUnlock();
+    m_releases = 1;
+    m_start_count = chSysGetRealtimeCounterX();
+    chTMStartMeasurementX(&m_execution_time);
+}
+
+void PeriodicTask::wait_for_next_release() {
+    chTMStopMeasurementX(&m_execution_time);
+    m_execution_time_histogram.add(m_execution_time.last/cycles_per_us);
+
+    chSysLock();
+    const systime_t completion_time = nowX();
+    chSysUnlock();
+    if (deadline_missed(m_release_time, m_config.period, completion_time)) {
+        ++m_deadline_misses;
+        m_last_lateness = completion_time - (m_release_time + m_config.period);
+        if (m_config.miss_callback != nullptr) {
+            m_config.miss_callback(*this);
+        }
+    }
+
+    chSysLock();
+    const systime_t now = nowX();
+    const release_t<systime_t> release = next_release(m_config.miss_policy,
+            m_release_time, m_config.period, now);
+    if (release.sleep) {
+        if (m_clock != nullptr) {
+            m_clock->sleep_untilS(release.time);
+        } else {
+            chThdSleepS(release.time - now);
+        }
+    } else {
+        chSchDoYieldS();
+    }
+    chSysUnlock();
+
+    // skipped releases are not counted as jitter
+    const rtcnt_t start_count = chSysGetRealtimeCounterX();
+    const rtcnt_t interval = start_count - m_start_count;
+    const rtcnt_t period = (release.skipped + 1)*m_config.period*cycles_per_tick;
+    m_start_jitter.add(((interval > period) ? interval - period : period - interval)/cycles_per_us);
+    m_start_count = start_count;
+
+    m_release_time = release.time;
+    m_skipped_releases += release.skipped;
+    ++m_releases;
+    chTMStartMeasurementX(&m_execution_time);
+}
+
+const char* PeriodicTask::name() const {
+    return m_config.name;
+}
+
+systime_t PeriodicTask::period() const {
+    return m_config.period;
+}
+
+tprio_t PeriodicTask::priority() const {
+    return m_priority;
+}
+
+systime_t PeriodicTask::release_time() const {
+    return m_release_time;
+}
+
+uint32_t PeriodicTask::releases() const {
+    return m_releases;
+}
+
+uint32_t PeriodicTask::deadline_misses() const {
+    return m_deadline_misses;
+}
+
+uint32_t PeriodicTask::skipped_releases() const {
+    return m_skipped_releases;
+}
+
+systime_t PeriodicTask::last_lateness() const {
+    return m_last_lateness;
+}
+
+const time_measurement_t& PeriodicTask::execution_time() const {
+    return m_execution_time;
+}
+
+task_timing_t PeriodicTask::timing() const {
+    return task_timing_t{m_config.name, ticks_to_us(m_config.period),
+        static_cast<uint32_t>(RTC2US(STM32_SYSCLK, m_execution_time.worst))};
+}
+
+const PeriodicTask::histogram_t& PeriodicTask::start_jitter() const {
+    return m_start_jitter;
+}
+
+const PeriodicTask::histogram_t& PeriodicTask::execution_time_histogram() const {
+    return m_execution_time_histogram;
+}
+
+systime_t PeriodicTask::nowX() const {
+    return (m_clock != nullptr) ? m_clock->nowX() : chVTGetSystemTimeX();
+}
+
+void assign_priorities(PeriodicTask* const* tasks, size_t n, tprio_t highest_priority) {
+    const auto period = [tasks](size_t j) { return tasks[j]->m_config.period; };
+    for (size_t i = 0; i < n; ++i) {
+        tasks[i]->m_priority = static_cast<tprio_t>(
+                highest_priority - rank_by_period(period, n, i));
+    }
+}
+
+} // namespace rt
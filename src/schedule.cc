@@ -0,0 +1,54 @@
+#include "schedule.h"
+#include <cmath>
+
+namespace rt {
+
+size_t rate_monotonic_rank(const task_timing_t* tasks, size_t n, size_t i) {
+    return rank_by_period([tasks](size_t j) { return tasks[j].period; }, n, i);
+}
+
+double utilization(const task_timing_t* tasks, size_t n) {
+    double u = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        u += static_cast<double>(tasks[i].wcet)/tasks[i].period;
+    }
+    return u;
+}
+
+double utilization_bound(size_t n) {
+    if (n == 0) {
+        return 1.0;
+    }
+    return n*(std::pow(2.0, 1.0/n) - 1.0);
+}
+
+bool response_times(const task_timing_t* tasks, size_t n, uint32_t* response_time) {
+    bool schedulable = true;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t rank = rate_monotonic_rank(tasks, n, i);
+        const uint64_t period = tasks[i].period;
+
+        // fixed-point iteration, R increases monotonically and stops at the
+        // first value larger than the deadline
+        uint64_t r = tasks[i].wcet;
+        while (r <= period) {
+            uint64_t next = tasks[i].wcet;
+            for (size_t j = 0; j < n; ++j) {
+                if (rate_monotonic_rank(tasks, n, j) < rank) {
+                    next += ((r + tasks[j].period - 1)/tasks[j].period)*tasks[j].wcet;
+                }
+            }
+            if (next == r) {
+                break;
+            }
+            r = next;
+        }
+        if (r > period) {
+            schedulable = false;
+        }
+        response_time[i] = (r > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(r);
+    }
+    return schedulable;
+}
+
+} // namespace rt
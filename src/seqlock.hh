@@ -0,0 +1,57 @@
+/*
+ * Member function definitions of Seqlock template class.
+ * See seqlock.h for template class declaration.
+ */
+
+template <typename T>
+Seqlock<T>::Seqlock() :
+m_sequence(0),
+m_value() { }
+
+template <typename T>
+Seqlock<T>::Seqlock(const T& value) :
+m_sequence(0),
+m_value(value) { }
+
+template <typename T>
+void Seqlock<T>::write(const T& value) {
+    const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    // Prevent the value stores from being reordered before the odd sequence.
+    std::atomic_thread_fence(std::memory_order_release);
+    m_value = value;
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template <typename T>
+T Seqlock<T>::read() const {
+    T value;
+    while (!try_read(value)) {
+        // a write is in progress, try again
+    }
+    return value;
+}
+
+template <typename T>
+bool Seqlock<T>::try_read(T& value) const {
+    const uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+    if ((sequence & 1) != 0) {
+        return false;
+    }
+
+    T copy = m_value;
+    // Prevent the value loads from being reordered after the sequence check.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_sequence.load(std::memory_order_relaxed) != sequence) {
+        return false;
+    }
+
+    value = copy;
+    return true;
+}
+
+template <typename T>
+uint32_t Seqlock<T>::sequence() const {
+    return m_sequence.load(std::memory_order_acquire);
+}
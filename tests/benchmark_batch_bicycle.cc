@@ -0,0 +1,86 @@
+/*
+ * Compare the throughput, in bicycle-steps per second, of stepping a batch of
+ * bicycles sharing the same model one Eigen state vector at a time
+ * (model::Bicycle::update_state) against sim::BatchBicycle with the scalar
+ * kernel and with the SIMD kernel. The state update alone and a full step,
+ * including the auxiliary states, are reported.
+ */
+#include "benchmark_util.h"
+#include "batchbicycle.h"
+#include "bicycle/whipple.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using batch_t = sim::BatchBicycle<model_t>;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001; // s, flimnap dynamics loop period
+    constexpr size_t steps = 1000;
+
+    // convert mean time per batch step to bicycle-steps per second
+    double throughput(double step_ns, size_t size) {
+        return size/step_ns*1e9;
+    }
+} // namespace
+
+int main() {
+    const model_t model(4.0, dt);
+
+    std::printf("%10s %14s %14s %14s %14s\n", "bicycles",
+            "eigen [1/s]", "scalar [1/s]", "simd [1/s]", "step [1/s]");
+    for (size_t size: {8, 64, 1024, 16384}) {
+        std::vector<model_t::state_t> x(size, model_t::state_t::Constant(0.01f));
+        std::vector<model_t::input_t> u(size, model_t::input_t::Constant(0.1f));
+        const double eigen_ns = benchmark::mean_call_time_ns([&](size_t) {
+                for (size_t k = 0; k < size; ++k) {
+                    x[k] = model.update_state(x[k], u[k]);
+                }
+                benchmark::do_not_optimize(x);
+            }, steps);
+
+        batch_t batch(model, size);
+        for (size_t k = 0; k < size; ++k) {
+            batch.set_full_state(k, model_t::full_state_t::Constant(0.01f));
+            batch.set_input(k, model_t::input_t::Constant(0.1f));
+        }
+        real_t Ad[model_t::n*model_t::n];
+        real_t Bd[model_t::n*model_t::m];
+        for (size_t i = 0; i < model_t::n; ++i) {
+            for (size_t j = 0; j < model_t::n; ++j) {
+                Ad[i*model_t::n + j] = model.Ad()(i, j);
+            }
+            for (size_t j = 0; j < model_t::m; ++j) {
+                Bd[i*model_t::m + j] = model.Bd()(i, j);
+            }
+        }
+        std::vector<real_t> xs(model_t::n*batch.stride(), 0.01f);
+        std::vector<real_t> us(model_t::m*batch.stride(), 0.1f);
+        std::vector<real_t> ys(model_t::n*batch.stride());
+        const double scalar_ns = benchmark::mean_call_time_ns([&](size_t) {
+                sim::batch::update_state_scalar<model_t::n, model_t::m>(
+                        Ad, Bd, xs.data(), us.data(), ys.data(), batch.stride(), 0);
+                std::swap(xs, ys);
+                benchmark::do_not_optimize(xs);
+            }, steps);
+        const double simd_ns = benchmark::mean_call_time_ns([&](size_t) {
+                const size_t k = sim::batch::update_state_simd<model_t::n, model_t::m>(
+                        Ad, Bd, xs.data(), us.data(), ys.data(), batch.stride());
+                sim::batch::update_state_scalar<model_t::n, model_t::m>(
+                        Ad, Bd, xs.data(), us.data(), ys.data(), batch.stride(), k);
+                std::swap(xs, ys);
+                benchmark::do_not_optimize(xs);
+            }, steps);
+        const double step_ns = benchmark::mean_call_time_ns([&](size_t) {
+                batch.step();
+                benchmark::do_not_optimize(batch);
+            }, steps);
+
+        std::printf("%10zu %14.3e %14.3e %14.3e %14.3e\n", size,
+                throughput(eigen_ns, size), throughput(scalar_ns, size),
+                throughput(simd_ns, size), throughput(step_ns, size));
+    }
+    return EXIT_SUCCESS;
+}
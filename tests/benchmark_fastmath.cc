@@ -0,0 +1,73 @@
+/*
+ * Compare the cost of the util::fastmath kernels and the libm functions they
+ * replace for angles in the range of the dynamics and kinematics loops.
+ */
+#include "benchmark_util.h"
+#include "fastmath.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    namespace fm = util::fastmath;
+
+    constexpr float two_pi = 6.28318530717958647692f;
+    constexpr size_t iterations = 10000000;
+    constexpr size_t angle_count = 1024;
+    float angles[angle_count];
+
+    // previous implementation of util::wrap
+    float fmod_wrap(float angle) {
+        angle = std::fmod(angle, two_pi);
+        if (angle >= two_pi/2) {
+            angle -= two_pi;
+        }
+        if (angle < -two_pi/2) {
+            angle += two_pi;
+        }
+        return angle;
+    }
+
+    float angle(size_t i) {
+        return angles[i % angle_count];
+    }
+
+    template <typename F, typename G>
+    void compare(const char* name, F libm, G fast) {
+        const double libm_ns = benchmark::mean_call_time_ns(libm, iterations);
+        const double fast_ns = benchmark::mean_call_time_ns(fast, iterations);
+        std::printf("  %-20s %8.2f ns %8.2f ns (%.1fx)\n",
+                name, libm_ns, fast_ns, libm_ns/fast_ns);
+    }
+} // namespace
+
+int main() {
+    // angles of a yaw angle that has turned a few revolutions
+    std::srand(0);
+    for (float& a: angles) {
+        a = (static_cast<float>(std::rand())/RAND_MAX - 0.5f)*8*two_pi;
+    }
+
+    std::printf("  %-20s %11s %11s\n", "function", "libm", "fastmath");
+    compare("wrap",
+            [](size_t i) { benchmark::do_not_optimize(fmod_wrap(angle(i))); },
+            [](size_t i) { benchmark::do_not_optimize(fm::wrap(angle(i))); });
+    compare("sin + cos",
+            [](size_t i) {
+                const float s = std::sin(angle(i));
+                const float c = std::cos(angle(i));
+                benchmark::do_not_optimize(s);
+                benchmark::do_not_optimize(c);
+            },
+            [](size_t i) {
+                float s, c;
+                fm::sincos(angle(i), &s, &c);
+                benchmark::do_not_optimize(s);
+                benchmark::do_not_optimize(c);
+            });
+    compare("atan2",
+            [](size_t i) { benchmark::do_not_optimize(std::atan2(angle(i), angle(i + 1))); },
+            [](size_t i) { benchmark::do_not_optimize(fm::atan2(angle(i), angle(i + 1))); });
+
+    return EXIT_SUCCESS;
+}
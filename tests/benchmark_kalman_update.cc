@@ -0,0 +1,71 @@
+/*
+ * Compare the cost of the Kalman filter error covariance measurement update
+ * for the Whipple model with all measurements at once
+ * (sim::JointMeasurementUpdate) and one measurement at a time
+ * (sim::SequentialMeasurementUpdate), with and without a skipped
+ * measurement.
+ */
+#include "benchmark_util.h"
+#include "kalmanupdate.h"
+#include "bicycle/whipple.h"
+#include "kalman.h"
+#include "parameters.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using kalman_t = observer::Kalman<model_t>;
+    using real_t = model::real_t;
+    using mask_t = std::bitset<model_t::l>;
+
+    constexpr real_t dt = 0.001; // s, flimnap dynamics loop period
+    constexpr size_t iterations = 1000000;
+
+    template <typename Update>
+    double update_time_ns(const model_t& model, const kalman_t::measurement_noise_covariance_t& R,
+            const mask_t& mask) {
+        const kalman_t::process_noise_covariance_t Q = parameters::defaultvalue::kalman::Q(dt);
+        kalman_t::error_covariance_t P = kalman_t::error_covariance_t::Identity();
+        kalman_t::error_covariance_t P_prior;
+        kalman_t::kalman_gain_t K;
+
+        // Time update is included so the error covariance converges as in the
+        // observer. It is timed separately and subtracted.
+        const double time_update_ns = benchmark::mean_call_time_ns([&](size_t) {
+                P_prior = model.Ad()*P*model.Ad().transpose() + Q;
+                benchmark::do_not_optimize(P_prior);
+            }, iterations);
+        const double total_ns = benchmark::mean_call_time_ns([&](size_t) {
+                P_prior = model.Ad()*P*model.Ad().transpose() + Q;
+                Update::update(P_prior, model.Cd(), R, mask, &K, &P);
+                benchmark::do_not_optimize(K);
+                benchmark::do_not_optimize(P);
+            }, iterations);
+        return total_ns - time_update_ns;
+    }
+} // namespace
+
+int main() {
+    const model_t model(4.0, dt);
+    const kalman_t::measurement_noise_covariance_t R = parameters::defaultvalue::kalman::R/1000;
+
+    mask_t all;
+    all.set();
+    mask_t steer_only;
+    steer_only.set(1);
+
+    const double joint_ns = update_time_ns<sim::JointMeasurementUpdate>(model, R, all);
+    const double sequential_ns = update_time_ns<sim::SequentialMeasurementUpdate>(model, R, all);
+    const double joint_skip_ns = update_time_ns<sim::JointMeasurementUpdate>(model, R, steer_only);
+    const double sequential_skip_ns = update_time_ns<sim::SequentialMeasurementUpdate>(model, R, steer_only);
+
+    std::printf("measurement update, all measurements:\n");
+    std::printf("  joint:      %8.1f ns/update\n", joint_ns);
+    std::printf("  sequential: %8.1f ns/update (%.1fx)\n", sequential_ns, joint_ns/sequential_ns);
+    std::printf("measurement update, yaw angle skipped:\n");
+    std::printf("  joint:      %8.1f ns/update\n", joint_skip_ns);
+    std::printf("  sequential: %8.1f ns/update (%.1fx)\n", sequential_skip_ns, joint_skip_ns/sequential_skip_ns);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*
+ * Compare the cost of changing the bicycle model speed with a model
+ * discretization (set_v_dt) against a sim::ModelCache lookup and copy.
+ * The error of the cached discrete state space matrices is reported relative
+ * to a discretization at the quantized speed and at the unquantized speed.
+ */
+#include "benchmark_util.h"
+#include "modelcache.h"
+#include "bicycle/whipple.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001; // s, flimnap dynamics loop period
+    constexpr real_t v_resolution = 0.1; // m/s, sim::Bicycle quantization
+    constexpr size_t cache_size = 81; // [0, 8] m/s
+    constexpr size_t iterations = 2000;
+
+    template <typename M>
+    real_t max_abs_difference(const M& a, const M& b) {
+        return (a - b).cwiseAbs().maxCoeff();
+    }
+
+    real_t quantize(real_t v) {
+        return v_resolution*std::round(v/v_resolution);
+    }
+} // namespace
+
+int main() {
+    const model_t prototype(0.0, dt);
+    sim::ModelCache<model_t, cache_size> cache(prototype, 0.0, v_resolution);
+
+    // speeds a rider could pass through while accelerating and braking
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<real_t> dist(0.0, cache.v_max());
+    std::vector<real_t> speeds(iterations);
+    for (auto& v: speeds) {
+        v = dist(gen);
+    }
+
+    model_t model(prototype);
+    const double discretize_ns = benchmark::mean_call_time_ns([&](size_t i) {
+            model.set_v_dt(quantize(speeds[i]), dt);
+            benchmark::do_not_optimize(model);
+        }, iterations);
+
+    const double lookup_ns = benchmark::mean_call_time_ns([&](size_t i) {
+            const model_t* m = cache.model(quantize(speeds[i]), dt);
+            model = *m;
+            benchmark::do_not_optimize(model);
+        }, iterations);
+
+    // accuracy of cached models
+    real_t quantized_error = 0;
+    real_t unquantized_error = 0;
+    model_t reference(prototype);
+    for (auto v: speeds) {
+        const model_t* m = cache.model(quantize(v), dt);
+
+        reference.set_v_dt(quantize(v), dt);
+        quantized_error = std::max(quantized_error, max_abs_difference(m->Ad(), reference.Ad()));
+        quantized_error = std::max(quantized_error, max_abs_difference(m->Bd(), reference.Bd()));
+
+        reference.set_v_dt(v, dt);
+        unquantized_error = std::max(unquantized_error, max_abs_difference(m->Ad(), reference.Ad()));
+        unquantized_error = std::max(unquantized_error, max_abs_difference(m->Bd(), reference.Bd()));
+    }
+
+    std::printf("model cache: %zu entries, %zu bytes\n", cache.size(), sizeof(cache));
+    std::printf("set_v_dt:            %10.1f ns/call\n", discretize_ns);
+    std::printf("cache lookup + copy: %10.1f ns/call (%.1fx)\n",
+            lookup_ns, discretize_ns/lookup_ns);
+    std::printf("max |Ad, Bd| error vs set_v_dt at quantized speed:   %g\n", quantized_error);
+    std::printf("max |Ad, Bd| error vs set_v_dt at unquantized speed: %g\n", unquantized_error);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+/*
+ * Compare the cost and accuracy of the pitch angle computed by the iterative
+ * constraint solver with a sim::PitchTable lookup, with and without the
+ * Newton step refinement. The refinement is started from the interpolated
+ * pitch and from the previous pitch.
+ *
+ * Roll and steer follow a slowly varying trajectory sampled at the pose
+ * thread rate so the iterative solver is warm started from the previous
+ * pitch as in sim::Bicycle::update_kinematics().
+ */
+#include "benchmark_util.h"
+#include "pitchtable.h"
+#include "bicycle/whipple.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+
+    constexpr real_t pose_rate = 240; // Hz
+    constexpr size_t iterations = 20000;
+    constexpr size_t table_size = 33;
+    constexpr real_t roll_max = constants::pi/4;
+    constexpr real_t steer_max = constants::pi/2;
+
+    struct Angles {
+        real_t roll;
+        real_t steer;
+    };
+} // namespace
+
+int main() {
+    const model_t bicycle(5.0, 0.001);
+    const sim::PitchTable<table_size> table(bicycle, roll_max, steer_max);
+
+    std::vector<Angles> trajectory(iterations);
+    for (size_t i = 0; i < iterations; ++i) {
+        const real_t t = static_cast<real_t>(i)/pose_rate;
+        trajectory[i].roll = 0.6f*roll_max*std::sin(0.7f*t);
+        trajectory[i].steer = 0.6f*steer_max*std::sin(1.3f*t + 0.5f);
+    }
+
+    std::vector<real_t> solved(iterations);
+    real_t pitch = 0;
+    const double solver_ns = benchmark::mean_call_time_ns([&](size_t i) {
+            pitch = bicycle.solve_constraint_pitch(trajectory[i].roll, trajectory[i].steer, pitch);
+            solved[i] = pitch;
+        }, iterations);
+
+    std::vector<real_t> interpolated(iterations);
+    const double table_ns = benchmark::mean_call_time_ns([&](size_t i) {
+            table.interpolate(trajectory[i].roll, trajectory[i].steer, &interpolated[i]);
+        }, iterations);
+
+    // refinement is forced with an allowed error of zero
+    std::vector<real_t> refined(iterations);
+    const double refined_ns = benchmark::mean_call_time_ns([&](size_t i) {
+            table.pitch(trajectory[i].roll, trajectory[i].steer, std::nan(""), 0, &refined[i]);
+        }, iterations);
+
+    std::vector<real_t> warm(iterations);
+    pitch = solved[0];
+    const double warm_ns = benchmark::mean_call_time_ns([&](size_t i) {
+            table.pitch(trajectory[i].roll, trajectory[i].steer, pitch, 0, &pitch);
+            warm[i] = pitch;
+        }, iterations);
+
+    real_t table_error = 0;
+    real_t refined_error = 0;
+    real_t warm_error = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        table_error = std::max(table_error, std::abs(interpolated[i] - solved[i]));
+        refined_error = std::max(refined_error, std::abs(refined[i] - solved[i]));
+        warm_error = std::max(warm_error, std::abs(warm[i] - solved[i]));
+    }
+
+    std::printf("pitch table: %zu x %zu, %zu bytes, max error %g rad at cell centers\n",
+            table_size, table_size, sizeof(table), table.max_error());
+    std::printf("iterative solver (warm start): %8.1f ns/call\n", solver_ns);
+    std::printf("table interpolation:           %8.1f ns/call (%.1fx), max error %g rad\n",
+            table_ns, solver_ns/table_ns, table_error);
+    std::printf("table + Newton step:           %8.1f ns/call (%.1fx), max error %g rad\n",
+            refined_ns, solver_ns/refined_ns, refined_error);
+    std::printf("table + warm Newton step:      %8.1f ns/call (%.1fx), max error %g rad\n",
+            warm_ns, solver_ns/warm_ns, warm_error);
+
+    return EXIT_SUCCESS;
+}
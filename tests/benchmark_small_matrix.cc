@@ -0,0 +1,70 @@
+/*
+ * Compare the cost of Eigen products and the unrolled util::smallmatrix
+ * kernels for the matrix shapes of the Whipple model, Kalman filter and
+ * haptic feedback.
+ */
+#include "benchmark_util.h"
+#include "smallmatrix.h"
+#include "bicycle/whipple.h"
+#include "parameters.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+    using matrix_t = model_t::state_matrix_t;
+
+    constexpr real_t dt = 0.001; // s, flimnap dynamics loop period
+    constexpr size_t iterations = 10000000;
+
+    template <typename F, typename G>
+    void compare(const char* name, F eigen, G unrolled) {
+        const double eigen_ns = benchmark::mean_call_time_ns(eigen, iterations);
+        const double unrolled_ns = benchmark::mean_call_time_ns(unrolled, iterations);
+        std::printf("  %-20s %8.2f ns %8.2f ns (%.1fx)\n",
+                name, eigen_ns, unrolled_ns, eigen_ns/unrolled_ns);
+    }
+} // namespace
+
+int main() {
+    namespace sm = util::smallmatrix;
+    const model_t model(4.0, dt);
+    const matrix_t Q = parameters::defaultvalue::kalman::Q(dt);
+    const model_t::state_t x0 = (model_t::state_t() << 0.1, 0.2, -0.1, 0.3, 0.4).finished();
+    const model_t::input_t u = (model_t::input_t() << 0.5, -0.5).finished();
+    matrix_t P = matrix_t::Identity();
+    model_t::state_t x = x0;
+    real_t a = 0;
+
+#if defined(EIGEN_VECTORIZE)
+    std::printf("Eigen vectorization enabled, util::smallmatrix uses Eigen products\n");
+#else // defined(EIGEN_VECTORIZE)
+    std::printf("Eigen vectorization disabled, util::smallmatrix uses unrolled kernels\n");
+#endif // defined(EIGEN_VECTORIZE)
+    std::printf("  %-20s %11s %11s\n", "shape", "Eigen", "unrolled");
+
+    compare("5x5*5x1",
+            [&](size_t) { x = model.Ad()*x; benchmark::do_not_optimize(x); },
+            [&](size_t) { x = sm::unrolled::multiply(model.Ad(), x); benchmark::do_not_optimize(x); });
+    x = x0;
+    compare("5x5*5x1 + 5x2*2x1",
+            [&](size_t) { x = model.Ad()*x + model.Bd()*u; benchmark::do_not_optimize(x); },
+            [&](size_t) { x = sm::unrolled::multiply_add(model.Ad(), x, model.Bd(), u); benchmark::do_not_optimize(x); });
+    x = x0;
+    compare("2x5*5x1",
+            [&](size_t) { benchmark::do_not_optimize((model.Cd()*x).eval()); },
+            [&](size_t) { benchmark::do_not_optimize(sm::unrolled::multiply(model.Cd(), x)); });
+    compare("5x5*5x5",
+            [&](size_t) { P = model.Ad()*P; P /= P(0, 0); benchmark::do_not_optimize(P); },
+            [&](size_t) { P = sm::unrolled::multiply(model.Ad(), P); P /= P(0, 0); benchmark::do_not_optimize(P); });
+    P = matrix_t::Identity();
+    compare("5x5*5x5*5x5' + 5x5",
+            [&](size_t) { P = model.Ad()*P*model.Ad().transpose() + Q; benchmark::do_not_optimize(P); },
+            [&](size_t) { P = sm::unrolled::symmetric_update(model.Ad(), P, Q); benchmark::do_not_optimize(P); });
+    compare("1x5*5x1",
+            [&](size_t) { a = (model.A().row(4)*x).value(); benchmark::do_not_optimize(a); },
+            [&](size_t) { a = sm::unrolled::row_dot(model.A(), 4, x); benchmark::do_not_optimize(a); });
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+/*
+ * Compare the cost of an update of observer::Kalman with sim::UdKalman for
+ * the Whipple model. The error covariance of each filter is checked for
+ * symmetry and definiteness after a long run in single precision.
+ */
+#include "benchmark_util.h"
+#include "udkalman.h"
+#include "bicycle/whipple.h"
+#include "kalman.h"
+#include "parameters.h"
+#include <Eigen/Eigenvalues>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001; // s, flimnap dynamics loop period
+    constexpr size_t iterations = 600000; // 10 minutes at 1 kHz
+
+    template <typename T>
+    void report(const char* name, double ns, const T& P) {
+        const real_t asymmetry = (P - P.transpose()).cwiseAbs().maxCoeff();
+        const real_t min_eigenvalue = P.template selfadjointView<Eigen::Lower>().eigenvalues().minCoeff();
+        std::printf("%-16s %8.1f ns/update, max |P - P'| %g, min eig(P) %g\n",
+                name, ns, asymmetry, min_eigenvalue);
+    }
+} // namespace
+
+int main() {
+    model_t model(3.0, dt);
+    observer::Kalman<model_t> kalman(model);
+    sim::UdKalman<model_t> ud(model);
+    kalman.set_Q(parameters::defaultvalue::kalman::Q(dt));
+    kalman.set_R(parameters::defaultvalue::kalman::R/1000);
+    ud.set_Q(kalman.Q());
+    ud.set_R(kalman.R());
+
+    // measurements of a bicycle weaving from side to side
+    std::mt19937 gen(0);
+    std::normal_distribution<real_t> noise(0, 1e-3);
+    std::vector<model_t::measurement_t> measurements(iterations);
+    for (size_t i = 0; i < iterations; ++i) {
+        const real_t t = static_cast<real_t>(i)*dt;
+        measurements[i] << 0.2f*std::sin(0.5f*t) + noise(gen),
+                           0.1f*std::sin(2.0f*t) + noise(gen);
+    }
+
+    const model_t::input_t u = model_t::input_t::Zero();
+    const double kalman_ns = benchmark::mean_call_time_ns([&](size_t i) {
+            kalman.update_state(u, measurements[i]);
+            benchmark::do_not_optimize(kalman.x());
+        }, iterations);
+    const double ud_ns = benchmark::mean_call_time_ns([&](size_t i) {
+            ud.update_state(u, measurements[i]);
+            benchmark::do_not_optimize(ud.x());
+        }, iterations);
+
+    std::printf("%zu updates, real_t is %zu bytes\n", iterations, sizeof(real_t));
+    report("observer::Kalman", kalman_ns, kalman.P());
+    report("sim::UdKalman", ud_ns, ud.P());
+    std::printf("max |x_kalman - x_ud| %g\n", (kalman.x() - ud.x()).cwiseAbs().maxCoeff());
+
+    return EXIT_SUCCESS;
+}
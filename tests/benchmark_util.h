@@ -0,0 +1,28 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+namespace benchmark {
+
+/**
+Prevent the compiler from optimizing away a computed value.
+*/
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+Call f() count times and return the mean duration of a call in nanoseconds.
+*/
+template <typename F>
+double mean_call_time_ns(F f, size_t count) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        f(i);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count()/count;
+}
+
+} // namespace benchmark
@@ -0,0 +1,147 @@
+#include "auxiliaryintegrator.h"
+#include "bicycle/whipple.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+    constexpr size_t history_size = 64;
+    using integrator_t = sim::AuxiliaryStateIntegrator<model_t, history_size>;
+    using full_state_t = model_t::full_state_t;
+    using aux_index_t = model_t::auxiliary_state_index_t;
+    using full_index_t = model_t::full_state_index_t;
+
+    constexpr real_t dt = 0.001;
+    constexpr unsigned int kinematics_period = 8; // dynamics updates, ~120 Hz
+
+    real_t angle_difference(real_t a, real_t b) {
+        return std::remainder(a - b, static_cast<real_t>(constants::two_pi));
+    }
+
+    class AuxiliaryIntegratorTest: public ::testing::Test {
+        public:
+            AuxiliaryIntegratorTest() : model(4.0, dt) {
+                integrator.set_rates(model);
+            }
+
+        protected:
+            model_t model;
+            integrator_t integrator;
+
+            // Integrate the full state with the model, as done by sim::Bicycle
+            // for auxiliary_state_update_t::dynamics, and the dynamic state
+            // only with the auxiliary states integrated from the history every
+            // kinematics period. Returns the maximum position difference.
+            real_t compare_trajectories(full_state_t xf, unsigned int steps, real_t steer_torque) {
+                model_t::state_t x = model_t::get_state_part(xf);
+                integrator.reset(model_t::get_auxiliary_state_part(xf),
+                        integrator_t::make_sample(model, x, model_t::input_t::Zero()));
+
+                real_t max_error = 0;
+                for (unsigned int i = 0; i < steps; ++i) {
+                    model_t::input_t u = model_t::input_t::Zero();
+                    if (i < steps/10) {
+                        model_t::set_input_element(u, model_t::input_index_t::steer_torque, steer_torque);
+                    }
+                    xf = model.integrate_full_state(xf, u, dt);
+                    model_t::set_full_state_element(xf, full_index_t::rear_wheel_angle,
+                            std::fmod(model_t::get_full_state_element(xf, full_index_t::rear_wheel_angle),
+                                constants::two_pi));
+                    x = model.update_state(x, u);
+                    integrator.push(integrator_t::make_sample(model, x, u));
+
+                    if ((i + 1) % kinematics_period == 0) {
+                        integrator.integrate();
+                        const model_t::auxiliary_state_t& aux = integrator.auxiliary_state();
+                        const real_t error = std::hypot(
+                                model_t::get_auxiliary_state_element(aux, aux_index_t::x) -
+                                model_t::get_full_state_element(xf, full_index_t::x),
+                                model_t::get_auxiliary_state_element(aux, aux_index_t::y) -
+                                model_t::get_full_state_element(xf, full_index_t::y));
+                        max_error = std::max(max_error, error);
+                        EXPECT_NEAR(0, angle_difference(
+                                    model_t::get_auxiliary_state_element(aux, aux_index_t::rear_wheel_angle),
+                                    model_t::get_full_state_element(xf, full_index_t::rear_wheel_angle)),
+                                1e-3f) << "at iteration " << i;
+                    }
+                }
+                EXPECT_EQ(integrator.skipped_samples(), 0u);
+                return max_error;
+            }
+    };
+} // namespace
+
+TEST_F(AuxiliaryIntegratorTest, straight_line) {
+    EXPECT_LT(compare_trajectories(full_state_t::Zero(), 5000, 0), 1e-3f);
+}
+
+TEST_F(AuxiliaryIntegratorTest, trajectory_matches_full_state_integration) {
+    full_state_t xf = full_state_t::Zero();
+    model_t::set_full_state_element(xf, full_index_t::x, 2.0f);
+    model_t::set_full_state_element(xf, full_index_t::y, -1.0f);
+    model_t::set_full_state_element(xf, full_index_t::yaw_angle, 0.5f);
+    model_t::set_full_state_element(xf, full_index_t::roll_angle, 0.05f);
+    // a steer torque pulse results in a turn over 40 m of travel
+    EXPECT_LT(compare_trajectories(xf, 10000, 1.0f), 1e-2f);
+}
+
+TEST_F(AuxiliaryIntegratorTest, yaw_angle_crosses_pi) {
+    // Circle at constant speed and yaw rate with the yaw angle wrapped to
+    // [-pi, pi), as in the firmware, crossing pi after 50 samples.
+    const real_t v = model.v();
+    const real_t yaw_rate = 1.0f;
+    const real_t yaw0 = static_cast<real_t>(constants::pi) - 0.05f;
+    const real_t radius = integrator.position_rate()*v/yaw_rate;
+    const auto sample = [&](unsigned int i) {
+        return integrator_t::sample_t{v, dt,
+            static_cast<real_t>(std::remainder(yaw0 + yaw_rate*dt*i, constants::two_pi)),
+            yaw_rate};
+    };
+
+    integrator.reset(model_t::auxiliary_state_t::Zero(), sample(0));
+    const unsigned int steps = 200;
+    for (unsigned int i = 1; i <= steps; ++i) {
+        integrator.push(sample(i));
+        if (i % kinematics_period == 0) {
+            integrator.integrate();
+            const real_t yaw = yaw0 + yaw_rate*dt*i;
+            const model_t::auxiliary_state_t& aux = integrator.auxiliary_state();
+            EXPECT_NEAR(model_t::get_auxiliary_state_element(aux, aux_index_t::x),
+                    radius*(std::sin(yaw) - std::sin(yaw0)), 1e-5f) << "at iteration " << i;
+            EXPECT_NEAR(model_t::get_auxiliary_state_element(aux, aux_index_t::y),
+                    -radius*(std::cos(yaw) - std::cos(yaw0)), 1e-5f) << "at iteration " << i;
+        }
+    }
+}
+
+TEST_F(AuxiliaryIntegratorTest, reset_sets_auxiliary_state) {
+    model_t::auxiliary_state_t aux;
+    aux << 1.0f, 2.0f, 3.0f, 0.0f;
+    integrator.reset(aux, integrator_t::make_sample(model, model_t::state_t::Zero(), model_t::input_t::Zero()));
+    integrator.integrate();
+    EXPECT_EQ(integrator.auxiliary_state(), aux);
+
+    // samples pushed before the reset are not integrated
+    integrator.push(integrator_t::make_sample(model, model_t::state_t::Zero(), model_t::input_t::Zero()));
+    integrator.reset(aux, integrator_t::make_sample(model, model_t::state_t::Zero(), model_t::input_t::Zero()));
+    integrator.integrate();
+    EXPECT_EQ(integrator.auxiliary_state(), aux);
+}
+
+TEST_F(AuxiliaryIntegratorTest, skips_overwritten_samples) {
+    const integrator_t::sample_t sample =
+        integrator_t::make_sample(model, model_t::state_t::Zero(), model_t::input_t::Zero());
+    integrator.reset(model_t::auxiliary_state_t::Zero(), sample);
+    const unsigned int steps = 3*history_size;
+    for (unsigned int i = 0; i < steps; ++i) {
+        integrator.push(sample);
+    }
+    integrator.integrate();
+    EXPECT_EQ(integrator.skipped_samples(), steps - (history_size - 1));
+
+    // travel over the gap is interpolated
+    EXPECT_NEAR(model_t::get_auxiliary_state_element(integrator.auxiliary_state(), aux_index_t::x),
+            model.v()*dt*steps, 1e-4f);
+}
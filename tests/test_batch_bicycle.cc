@@ -0,0 +1,100 @@
+#include "batchbicycle.h"
+#include "pitchtable.h"
+#include "bicycle/whipple.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using batch_t = sim::BatchBicycle<model_t>;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001;
+    constexpr size_t size = 13; // not a multiple of the vector width
+
+    class BatchBicycleTest: public ::testing::Test {
+        public:
+            BatchBicycleTest() : model(4.0, dt), batch(model, size), x(size), gen(0) {
+                std::uniform_real_distribution<real_t> angle(-0.1f, 0.1f);
+                for (size_t k = 0; k < size; ++k) {
+                    x[k] = model_t::full_state_t::Zero();
+                    model_t::set_full_state_element(x[k], model_t::full_state_index_t::roll_angle, angle(gen));
+                    model_t::set_full_state_element(x[k], model_t::full_state_index_t::steer_angle, angle(gen));
+                    batch.set_full_state(k, x[k]);
+                }
+            }
+
+        protected:
+            model_t model;
+            batch_t batch;
+            std::vector<model_t::full_state_t> x;
+            std::mt19937 gen;
+
+            std::vector<model_t::input_t> random_input() {
+                std::normal_distribution<real_t> torque(0.0f, 1.0f);
+                std::vector<model_t::input_t> u(size);
+                for (size_t k = 0; k < size; ++k) {
+                    u[k] << torque(gen), torque(gen);
+                    batch.set_input(k, u[k]);
+                }
+                return u;
+            }
+    };
+} // namespace
+
+TEST_F(BatchBicycleTest, state_matches_model) {
+    for (int i = 0; i < 1000; ++i) {
+        const std::vector<model_t::input_t> u = random_input();
+        batch.step();
+        for (size_t k = 0; k < size; ++k) {
+            const model_t::state_t xk = model.update_state(model_t::get_state_part(x[k]), u[k]);
+            x[k] << model_t::get_auxiliary_state_part(x[k]), xk;
+            ASSERT_TRUE(model_t::get_state_part(batch.full_state(k)).isApprox(xk, 1e-4f) ||
+                        (model_t::get_state_part(batch.full_state(k)) - xk).cwiseAbs().maxCoeff() < 1e-6f)
+                << "bicycle " << k << " at iteration " << i;
+        }
+    }
+}
+
+TEST_F(BatchBicycleTest, state_arrays) {
+    const real_t* roll = batch.state(model_t::state_index_t::roll_angle);
+    for (size_t k = 0; k < size; ++k) {
+        EXPECT_EQ(roll[k], model_t::get_full_state_element(x[k], model_t::full_state_index_t::roll_angle));
+    }
+    EXPECT_EQ(batch.stride() % batch_t::lane_alignment, 0u);
+    EXPECT_GE(batch.stride(), size);
+}
+
+TEST_F(BatchBicycleTest, auxiliary_state) {
+    // With zero roll, steer and input, the bicycle moves straight ahead at
+    // the model speed.
+    for (size_t k = 0; k < size; ++k) {
+        batch.set_full_state(k, model_t::full_state_t::Zero());
+    }
+    batch.step(1000);
+    const model_t::full_state_t xf = model.integrate_full_state(
+            model_t::full_state_t::Zero(), model_t::input_t::Zero(), dt);
+    for (size_t k = 0; k < size; ++k) {
+        EXPECT_NEAR(batch.auxiliary_state(model_t::auxiliary_state_index_t::x)[k], 4.0f, 1e-3f);
+        EXPECT_NEAR(batch.auxiliary_state(model_t::auxiliary_state_index_t::y)[k], 0.0f, 1e-6f);
+        EXPECT_NEAR(batch.auxiliary_state(model_t::auxiliary_state_index_t::rear_wheel_angle)[k],
+                1000*model_t::get_full_state_element(xf, model_t::full_state_index_t::rear_wheel_angle),
+                1e-2f);
+    }
+}
+
+TEST_F(BatchBicycleTest, pitch_table) {
+    const sim::PitchTable<17> table(model, constants::pi/4, constants::pi/2);
+    batch.set_pitch_table(&table, 0);
+    batch.step();
+    const real_t* roll = batch.state(model_t::state_index_t::roll_angle);
+    const real_t* steer = batch.state(model_t::state_index_t::steer_angle);
+    for (size_t k = 0; k < size; ++k) {
+        real_t pitch;
+        // refined from the initial pitch of zero
+        ASSERT_TRUE(table.pitch(roll[k], steer[k], 0, 0, &pitch));
+        EXPECT_EQ(batch.auxiliary_state(model_t::auxiliary_state_index_t::pitch_angle)[k], pitch);
+    }
+}
@@ -0,0 +1,126 @@
+#include "checkpoint.h"
+#include "kalmanschedule.h"
+#include "bicycle/whipple.h"
+#include "parameters.h"
+#include "gtest/gtest.h"
+#include <cstring>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using observer_t = sim::ScheduledKalman<model_t, sim::SequentialMeasurementUpdate>;
+    using checkpoint_t = sim::BicycleCheckpoint<model_t>;
+    using observer_checkpoint_t = sim::observer_checkpoint<model_t, observer_t>;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001;
+    constexpr real_t v = 3.0;
+
+    class CheckpointTest: public ::testing::Test {
+        public:
+            CheckpointTest() : model(v, dt), observer(model) {
+                observer.set_Q(parameters::defaultvalue::kalman::Q(dt));
+                observer.set_R(parameters::defaultvalue::kalman::R/1000);
+
+                // converge error covariance
+                model_t::state_t x = model_t::state_t::Zero();
+                model_t::set_state_element(x, model_t::state_index_t::steer_angle, 0.1f);
+                for (unsigned int i = 0; i < 1000; ++i) {
+                    x = model.update_state(x);
+                    observer.update_state(model_t::input_t::Zero(), model.calculate_output(x));
+                }
+            }
+
+        protected:
+            model_t model;
+            observer_t observer;
+
+            checkpoint_t save() const {
+                checkpoint_t checkpoint;
+                std::memset(&checkpoint, 0, sizeof(checkpoint));
+                checkpoint.v = v;
+                checkpoint.dt = dt;
+                observer_checkpoint_t::save(observer, &checkpoint);
+                checkpoint.seal();
+                return checkpoint;
+            }
+    };
+} // namespace
+
+TEST(Crc32, check_value) {
+    const char data[] = "123456789";
+    EXPECT_EQ(sim::crc32(data, sizeof(data) - 1), 0xcbf43926u);
+}
+
+TEST_F(CheckpointTest, valid_after_seal) {
+    const checkpoint_t checkpoint = save();
+    EXPECT_TRUE(checkpoint.valid());
+    EXPECT_EQ(checkpoint.observer_content, checkpoint_t::observer_content_t::covariance);
+}
+
+TEST_F(CheckpointTest, invalid_after_corruption) {
+    checkpoint_t checkpoint = save();
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(&checkpoint);
+    for (size_t i = 0; i < sizeof(checkpoint); i += 7) {
+        checkpoint_t corrupted = checkpoint;
+        reinterpret_cast<unsigned char*>(&corrupted)[i] ^= 0x10;
+        EXPECT_FALSE(corrupted.valid()) << "at byte " << i;
+    }
+    bytes[0] ^= 0x01; // header format
+    checkpoint.crc = sim::crc32(&checkpoint, offsetof(checkpoint_t, crc));
+    EXPECT_FALSE(checkpoint.valid());
+}
+
+TEST_F(CheckpointTest, invalid_after_invalidate) {
+    checkpoint_t checkpoint = save();
+    checkpoint.invalidate();
+    EXPECT_FALSE(checkpoint.valid());
+}
+
+TEST_F(CheckpointTest, version_mismatch_invalidates) {
+    using versioned_checkpoint_t = sim::VersionedCheckpoint<checkpoint_t>;
+    constexpr char old_version[] = "0123456789abcdef";
+    constexpr char new_version[] = "fedcba9876543210";
+
+    versioned_checkpoint_t backup;
+    std::memcpy(backup.tag, old_version, sizeof(backup.tag));
+    backup.checkpoint = save();
+
+    // same version
+    const checkpoint_t* c = backup.claim(old_version);
+    ASSERT_NE(c, nullptr);
+    EXPECT_TRUE(c->valid());
+
+    // The checkpoint of another version is not returned and must not be
+    // restored after a restart before a new checkpoint is saved.
+    EXPECT_EQ(backup.claim(new_version), nullptr);
+    c = backup.claim(new_version);
+    ASSERT_NE(c, nullptr);
+    EXPECT_FALSE(c->valid());
+
+    backup.checkpoint = save();
+    EXPECT_TRUE(backup.claim(new_version)->valid());
+}
+
+TEST_F(CheckpointTest, restore_observer) {
+    const checkpoint_t checkpoint = save();
+
+    model_t restored_model(v, dt);
+    observer_t restored(restored_model);
+    restored.set_Q(observer.Q());
+    restored.set_R(observer.R());
+    observer_checkpoint_t::restore(restored, checkpoint);
+    EXPECT_EQ(restored.x(), observer.x());
+    EXPECT_EQ(restored.P(), observer.P());
+
+    // Both observers must compute the same Kalman gain and state estimate in
+    // subsequent updates.
+    const model_t::input_t u = model_t::input_t::Zero();
+    const model_t::measurement_t z = model_t::measurement_t::Constant(0.01f);
+    for (unsigned int i = 0; i < 10; ++i) {
+        observer.update_state(u, z);
+        restored.update_state(u, z);
+        EXPECT_EQ(restored.K(), observer.K());
+        EXPECT_EQ(restored.x(), observer.x());
+        EXPECT_EQ(restored.P(), observer.P());
+    }
+}
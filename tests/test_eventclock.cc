@@ -0,0 +1,198 @@
+#include "eventclock.h"
+#include "schedule.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace {
+    // 10 kHz ADC conversions with a 100 kHz system tick and a 1 kHz task
+    constexpr uint32_t ticks_per_event = 10;
+    constexpr uint32_t period = 100;
+
+    /*
+     * Mocked task thread released by an event clock, as rt::PeriodicTask with
+     * a rt::EventReleaseClock. Each job executes for a number of events and
+     * the release time of each job is recorded together with the clock time
+     * at which the job is woken.
+     */
+    class MockTask {
+        public:
+            MockTask(rt::EventClock<uint32_t>* clock, rt::miss_policy_t policy) :
+                m_clock(clock), m_policy(policy), m_release_time(0),
+                m_busy_events(0), m_running(false) { }
+
+            void start() {
+                wait_until(m_clock->time() + 1);
+            }
+
+            // called for each event
+            void event(uint32_t execution_events) {
+                if (m_clock->tick()) {
+                    release(execution_events);
+                } else if (m_running && (--m_busy_events == 0)) {
+                    complete(execution_events);
+                }
+            }
+
+            std::vector<uint32_t> release_times;
+            std::vector<uint32_t> wakeup_times;
+
+        private:
+            rt::EventClock<uint32_t>* m_clock;
+            rt::miss_policy_t m_policy;
+            uint32_t m_release_time;
+            uint32_t m_busy_events;
+            bool m_running;
+
+            void wait_until(uint32_t time) {
+                m_release_time = time;
+                m_running = false;
+                ASSERT_TRUE(m_clock->set_wakeup(time));
+            }
+
+            void release(uint32_t execution_events) {
+                if (release_times.empty()) {
+                    m_release_time = m_clock->time();
+                }
+                release_times.push_back(m_release_time);
+                wakeup_times.push_back(m_clock->time());
+                m_running = true;
+                m_busy_events = execution_events;
+            }
+
+            void complete(uint32_t execution_events) {
+                const rt::release_t<uint32_t> r = rt::next_release(m_policy,
+                        m_release_time, period, m_clock->time());
+                if (r.sleep) {
+                    wait_until(r.time);
+                } else {
+                    m_release_time = r.time;
+                    release_times.push_back(m_release_time);
+                    wakeup_times.push_back(m_clock->time());
+                    m_busy_events = execution_events;
+                }
+            }
+    };
+} // namespace
+
+TEST(EventClock, tick) {
+    rt::EventClock<uint32_t> clock(ticks_per_event, 3);
+    EXPECT_EQ(clock.time(), 3u);
+    EXPECT_FALSE(clock.tick());
+    EXPECT_EQ(clock.time(), 13u);
+    EXPECT_FALSE(clock.wakeup_pending());
+}
+
+TEST(EventClock, wakeup) {
+    rt::EventClock<uint32_t> clock(ticks_per_event, 0);
+    ASSERT_TRUE(clock.set_wakeup(30));
+    EXPECT_FALSE(clock.tick());
+    EXPECT_FALSE(clock.tick());
+    EXPECT_TRUE(clock.tick());
+    EXPECT_EQ(clock.time(), 30u);
+    EXPECT_FALSE(clock.wakeup_pending());
+    // the wakeup is cleared after it has been reached
+    EXPECT_FALSE(clock.tick());
+}
+
+TEST(EventClock, wakeup_reached) {
+    rt::EventClock<uint32_t> clock(ticks_per_event, 100);
+    EXPECT_FALSE(clock.set_wakeup(100));
+    EXPECT_FALSE(clock.set_wakeup(90));
+    EXPECT_FALSE(clock.wakeup_pending());
+    EXPECT_TRUE(clock.set_wakeup(101));
+    clock.clear_wakeup();
+    EXPECT_FALSE(clock.tick());
+}
+
+TEST(EventClock, wakeup_between_events) {
+    // a wakeup time between events is reached at the next event
+    rt::EventClock<uint32_t> clock(ticks_per_event, 0);
+    ASSERT_TRUE(clock.set_wakeup(15));
+    EXPECT_FALSE(clock.tick());
+    EXPECT_TRUE(clock.tick());
+    EXPECT_EQ(clock.time(), 20u);
+}
+
+TEST(EventClock, set_time) {
+    rt::EventClock<uint32_t> clock(ticks_per_event, 0);
+    ASSERT_TRUE(clock.set_wakeup(50));
+    clock.set_time(50);
+    EXPECT_FALSE(clock.wakeup_pending());
+    EXPECT_FALSE(clock.tick());
+    EXPECT_EQ(clock.time(), 60u);
+}
+
+TEST(EventClock, time_wraps) {
+    const uint32_t t0 = std::numeric_limits<uint32_t>::max() - 15;
+    rt::EventClock<uint32_t> clock(ticks_per_event, t0);
+    ASSERT_TRUE(clock.set_wakeup(t0 + 20));
+    EXPECT_FALSE(clock.tick());
+    EXPECT_TRUE(clock.tick());
+    EXPECT_EQ(clock.time(), t0 + 20);
+    EXPECT_TRUE(clock.reached(t0));
+
+    // 16-bit system time
+    const uint16_t s0 = std::numeric_limits<uint16_t>::max() - 5;
+    rt::EventClock<uint16_t> s(10, s0);
+    ASSERT_TRUE(s.set_wakeup(static_cast<uint16_t>(s0 + 10)));
+    EXPECT_TRUE(s.tick());
+    EXPECT_EQ(s.time(), 4u);
+}
+
+TEST(EventClock, events_per_period) {
+    EXPECT_EQ(rt::events_per_period(period, ticks_per_event), 10u);
+    EXPECT_EQ(rt::events_per_period(105u, ticks_per_event), 0u);
+    EXPECT_EQ(rt::events_per_period(period, 0u), 0u);
+    static_assert(rt::events_per_period<uint32_t>(100, 10) == 10, "");
+}
+
+TEST(EventClock, phase_locked_release) {
+    // The clock starts between events. Each job is woken by the event at its
+    // release time.
+    rt::EventClock<uint32_t> clock(ticks_per_event, 7);
+    MockTask task(&clock, rt::miss_policy_t::skip);
+    task.start();
+    for (int i = 0; i < 1000; ++i) {
+        task.event(3);
+    }
+    ASSERT_EQ(task.release_times.size(), 100u);
+    EXPECT_EQ(task.release_times[0], 17u);
+    for (size_t i = 0; i < task.release_times.size(); ++i) {
+        EXPECT_EQ(task.release_times[i], 17u + i*period);
+        EXPECT_EQ(task.wakeup_times[i], task.release_times[i]);
+    }
+}
+
+TEST(EventClock, catch_up_stays_on_grid) {
+    // Jobs that execute for 1.5 periods are released back to back, on the
+    // release grid of the events.
+    rt::EventClock<uint32_t> clock(ticks_per_event, 0);
+    MockTask task(&clock, rt::miss_policy_t::catch_up);
+    task.start();
+    for (int i = 0; i < 100; ++i) {
+        task.event(15);
+    }
+    ASSERT_GE(task.release_times.size(), 6u);
+    for (size_t i = 0; i < task.release_times.size(); ++i) {
+        EXPECT_EQ(task.release_times[i], 10u + i*period);
+        EXPECT_EQ(task.wakeup_times[i] % ticks_per_event, 0u);
+        EXPECT_GE(task.wakeup_times[i], task.release_times[i]);
+    }
+}
+
+TEST(EventClock, skip_stays_on_grid) {
+    rt::EventClock<uint32_t> clock(ticks_per_event, 0);
+    MockTask task(&clock, rt::miss_policy_t::skip);
+    task.start();
+    for (int i = 0; i < 100; ++i) {
+        task.event(15);
+    }
+    // every other release is skipped
+    ASSERT_EQ(task.release_times.size(), 5u);
+    for (size_t i = 0; i < task.release_times.size(); ++i) {
+        EXPECT_EQ(task.release_times[i], 10u + 2*i*period);
+        EXPECT_EQ(task.wakeup_times[i], task.release_times[i]);
+    }
+}
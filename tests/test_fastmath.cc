@@ -0,0 +1,159 @@
+/*
+ * Accuracy tests of util::fastmath against libm in double precision.
+ *
+ * By default every 1021st float bit pattern is tested. Set the environment
+ * variable FASTMATH_TEST_STRIDE=1 to test all floats, which takes several
+ * minutes. The exhaustive run is registered as ctest test
+ * test_fastmath_exhaustive with label "slow".
+ */
+#include "fastmath.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+    namespace fm = util::fastmath;
+
+    constexpr long double two_pi = 6.283185307179586476925286766559L;
+    constexpr float pi = 3.14159265358979323846f;
+
+    // documented maximum absolute errors
+    constexpr double wrap_error = 3.0e-7;
+    constexpr double wrap_libm_error = 1.2e-7;
+    constexpr double sincos_error = 8.0e-8;
+    constexpr double atan2_error = 3.5e-7;
+
+    uint64_t stride() {
+        const char* s = std::getenv("FASTMATH_TEST_STRIDE");
+        const long n = (s != nullptr) ? std::strtol(s, nullptr, 10) : 0;
+        return (n > 0) ? static_cast<uint64_t>(n) : 1021;
+    }
+
+    float from_bits(uint32_t bits) {
+        float x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    // call f(x) for finite floats in [lo, hi] with the test stride over the bit patterns
+    template <typename F>
+    void for_floats(float lo, float hi, F f) {
+        const uint64_t n = stride();
+        for (uint64_t bits = 0; bits <= UINT32_MAX; bits += n) {
+            const float x = from_bits(static_cast<uint32_t>(bits));
+            if (std::isfinite(x) && x >= lo && x <= hi) {
+                f(x);
+            }
+        }
+    }
+
+    constexpr float max_float = 3.40282347e38f;
+} // namespace
+
+TEST(FastMath, wrap_range) {
+    for_floats(-max_float, max_float, [](float x) {
+        const float r = fm::wrap(x);
+        ASSERT_GE(r, -pi) << "x = " << x;
+        ASSERT_LT(r, pi) << "x = " << x;
+    });
+    // the float nearest to pi is larger than pi
+    EXPECT_GT(fm::wrap(pi), -pi);
+    EXPECT_LT(fm::wrap(pi), -pi + 1e-6f);
+    EXPECT_LT(fm::wrap(-pi), pi);
+    EXPECT_GT(fm::wrap(-pi), pi - 1e-6f);
+    EXPECT_EQ(fm::wrap(0.0f), 0.0f);
+}
+
+TEST(FastMath, wrap_error) {
+    double max_error = 0;
+    for_floats(-fm::max_fast_angle, fm::max_fast_angle, [&max_error](float x) {
+        const long double e = std::remainder(
+                static_cast<long double>(fm::wrap(x)) - std::remainder(static_cast<long double>(x), two_pi),
+                two_pi);
+        max_error = std::max(max_error, static_cast<double>(std::abs(e)));
+    });
+    EXPECT_LE(max_error, wrap_error);
+}
+
+TEST(FastMath, wrap_error_libm_path) {
+    // Beyond max_fast_angle the result is the correctly rounded remainder.
+    // Beyond 2^24 the float spacing is larger than 1 and the remainder is not
+    // meaningful.
+    double max_error = 0;
+    for_floats(-16777216.0f, 16777216.0f, [&max_error](float x) {
+        if (std::abs(x) <= fm::max_fast_angle) {
+            return;
+        }
+        const long double e = std::remainder(
+                static_cast<long double>(fm::wrap(x)) - std::remainder(static_cast<long double>(x), two_pi),
+                two_pi);
+        max_error = std::max(max_error, static_cast<double>(std::abs(e)));
+    });
+    EXPECT_LE(max_error, wrap_libm_error);
+}
+
+TEST(FastMath, sincos_error) {
+    double max_sin_error = 0;
+    double max_cos_error = 0;
+    for_floats(-max_float, max_float, [&](float x) {
+        float s, c;
+        fm::sincos(x, &s, &c);
+        max_sin_error = std::max(max_sin_error, std::abs(s - std::sin(static_cast<double>(x))));
+        max_cos_error = std::max(max_cos_error, std::abs(c - std::cos(static_cast<double>(x))));
+    });
+    EXPECT_LE(max_sin_error, sincos_error);
+    EXPECT_LE(max_cos_error, sincos_error);
+}
+
+TEST(FastMath, sincos_quadrants) {
+    // exact values at multiples of pi/2 up to rounding of the argument
+    for (int k = -16; k <= 16; ++k) {
+        const float x = static_cast<float>(k)*1.57079632679489661923f;
+        EXPECT_NEAR(fm::sin(x), std::sin(static_cast<double>(x)), sincos_error) << "k = " << k;
+        EXPECT_NEAR(fm::cos(x), std::cos(static_cast<double>(x)), sincos_error) << "k = " << k;
+    }
+    EXPECT_EQ(fm::sin(0.0f), 0.0f);
+    EXPECT_EQ(fm::cos(0.0f), 1.0f);
+}
+
+TEST(FastMath, atan_kernel_error) {
+    // atan2(t, 1) evaluates the polynomial directly for t in [0, 1]
+    double max_error = 0;
+    for_floats(0.0f, 1.0f, [&max_error](float t) {
+        max_error = std::max(max_error,
+                std::abs(fm::atan2(t, 1.0f) - std::atan(static_cast<double>(t))));
+    });
+    EXPECT_LE(max_error, atan2_error);
+}
+
+TEST(FastMath, atan2_error) {
+    double max_error = 0;
+    for_floats(-max_float, max_float, [&max_error](float y) {
+        for (float x: {-3.0f, -1e-3f, 1.0f, 1e30f}) {
+            max_error = std::max(max_error,
+                    std::abs(fm::atan2(y, x) - std::atan2(static_cast<double>(y), static_cast<double>(x))));
+        }
+    });
+    EXPECT_LE(max_error, atan2_error);
+}
+
+TEST(FastMath, atan2_special_values) {
+    EXPECT_EQ(fm::atan2(0.0f, 0.0f), 0.0f);
+    EXPECT_EQ(fm::atan2(0.0f, 1.0f), 0.0f);
+    EXPECT_FLOAT_EQ(fm::atan2(0.0f, -1.0f), pi);
+    EXPECT_FLOAT_EQ(fm::atan2(-0.0f, -1.0f), -pi);
+    EXPECT_FLOAT_EQ(fm::atan2(1.0f, 0.0f), pi/2);
+    EXPECT_FLOAT_EQ(fm::atan2(-1.0f, 0.0f), -pi/2);
+    EXPECT_FLOAT_EQ(fm::atan2(1.0f, 1.0f), pi/4);
+    EXPECT_FLOAT_EQ(fm::atan2(-1.0f, -1.0f), -3*pi/4);
+}
+
+TEST(FastMath, double_overloads) {
+    EXPECT_DOUBLE_EQ(fm::wrap(7.0), 7.0 - 6.283185307179586);
+    EXPECT_DOUBLE_EQ(fm::sin(0.5), std::sin(0.5));
+    EXPECT_DOUBLE_EQ(fm::cos(0.5), std::cos(0.5));
+    EXPECT_DOUBLE_EQ(fm::atan2(1.0, -2.0), std::atan2(1.0, -2.0));
+}
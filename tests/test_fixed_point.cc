@@ -0,0 +1,132 @@
+#include "fixedpoint.h"
+#include "fixedpointmodel.h"
+#include "fixedpointobserver.h"
+#include "kalmanschedule.h"
+#include "bicycle/whipple.h"
+#include "parameters.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <random>
+
+namespace {
+    using float_model_t = model::BicycleWhipple;
+    using model_t = sim::FixedPointModel<float_model_t>;
+    using observer_t = sim::FixedPointObserver<model_t>;
+    using real_t = model::real_t;
+    using q31_t = util::q31_t;
+
+    constexpr real_t dt = 0.001;
+    constexpr real_t v = 5.0; // m/s, within the stable speed range
+    constexpr size_t cache_size = 61; // [0, 6] m/s
+    constexpr size_t iterations = 1000000; // 1000 s at 1 kHz
+
+    using double_state_t = Eigen::Matrix<double, model_t::n, 1>;
+    using double_input_t = Eigen::Matrix<double, model_t::m, 1>;
+
+    model_t::input_t input(size_t i) {
+        const double t = i*dt;
+        model_t::input_t u;
+        u << 5.0*std::sin(2.0*t), 0.5*std::sin(3.1*t + 1.0);
+        return u;
+    }
+
+    double_state_t max_state_range() {
+        double_state_t r;
+        for (size_t i = 0; i < model_t::n; ++i) {
+            r[i] = std::ldexp(1.0, model_t::state_exponent[i]);
+        }
+        return r;
+    }
+} // namespace
+
+TEST(FixedPoint, saturation) {
+    EXPECT_EQ(util::add_q31(util::q31_max, 1), util::q31_max);
+    EXPECT_EQ(util::sub_q31(util::q31_min, 1), util::q31_min);
+    EXPECT_EQ(util::add_q31(-5, 3), -2);
+    EXPECT_EQ(util::to_q31(3.0f, 1), util::q31_max);
+    EXPECT_EQ(util::to_q31(-3.0f, 1), util::q31_min);
+    EXPECT_EQ(util::to_q31(std::nanf(""), 1), 0);
+    EXPECT_EQ(util::to_q31(0.5f, 0), q31_t(1) << 30);
+    EXPECT_EQ(util::from_q31(q31_t(1) << 30, 2), 2.0f);
+}
+
+TEST(FixedPoint, multiply) {
+    // A = [0.5, -0.25] with exponent 0, rounded to nearest
+    const q31_t A[2] = {q31_t(1) << 30, -(q31_t(1) << 29)};
+    const q31_t x[2] = {3, 2};
+    q31_t y;
+    util::multiply_q31<1, 2>(A, x, 31, &y);
+    EXPECT_EQ(y, 1); // 1.5 - 0.5
+    const q31_t x_max[2] = {util::q31_max, util::q31_min};
+    util::multiply_q31<1, 2>(A, x_max, 31, &y);
+    EXPECT_EQ(y, q31_t(3) << 29); // 0.75*2^31 - 0.5, rounded up
+}
+
+TEST(FixedPoint, model_trajectory) {
+    // Compare a fixed-point trajectory with a double precision reference
+    // over a long run.
+    const model_t model(v, dt);
+    const Eigen::Matrix<double, model_t::n, model_t::n> Ad = model.Ad().cast<double>();
+    const Eigen::Matrix<double, model_t::n, model_t::m> Bd = model.Bd().cast<double>();
+    const double_state_t range = max_state_range();
+
+    double_state_t x_ref = double_state_t::Zero();
+    x_ref[1] = 0.1;
+    model_t::q_state_t x = model_t::state_to_q31(x_ref.cast<real_t>());
+    double max_error = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        const model_t::input_t u = input(i);
+        x_ref = Ad*x_ref + Bd*u.cast<double>();
+        x = model.update_state(x, model_t::input_to_q31(u));
+        const double_state_t error = (model_t::state_from_q31(x).cast<double>() - x_ref).cwiseQuotient(range);
+        max_error = std::max(max_error, error.cwiseAbs().maxCoeff());
+        ASSERT_LT(max_error, 1e-5) << "at iteration " << i;
+    }
+    EXPECT_GT(x_ref.cwiseQuotient(range).cwiseAbs().maxCoeff(), 1e-3); // not decayed to zero
+}
+
+TEST(FixedPoint, float_interface) {
+    const model_t model(v, dt);
+    const float_model_t float_model(v, dt);
+    model_t::state_t x;
+    x << 0.5f, 0.1f, -0.2f, 1.0f, -2.0f;
+    const model_t::input_t u = input(100);
+    EXPECT_TRUE(model.update_state(x, u).isApprox(float_model.update_state(x, u), 1e-5f));
+    EXPECT_TRUE(model.calculate_output(x).isApprox(float_model.calculate_output(x), 1e-5f));
+}
+
+TEST(FixedPoint, observer_matches_steady_state_kalman) {
+    // Track a noisy simulated bicycle with the fixed-point observer and a
+    // floating-point steady-state Kalman filter with the same gain.
+    const sim::ModelCache<model_t, cache_size> cache(model_t(0.0, dt), 0.0, 0.1);
+    const sim::KalmanGainSchedule<model_t, cache_size> schedule(cache,
+            parameters::defaultvalue::kalman::Q(dt), parameters::defaultvalue::kalman::R/1000);
+    model_t model(v, dt);
+    observer_t observer(model);
+    observer.set_gain_schedule(&schedule);
+    sim::ScheduledKalman<model_t> kalman(model);
+    kalman.set_Q(parameters::defaultvalue::kalman::Q(dt));
+    kalman.set_R(parameters::defaultvalue::kalman::R/1000);
+    kalman.set_gain_schedule(&schedule, 1);
+
+    const Eigen::Matrix<double, model_t::n, model_t::n> Ad = model.Ad().cast<double>();
+    const Eigen::Matrix<double, model_t::n, model_t::m> Bd = model.Bd().cast<double>();
+    const double_state_t range = max_state_range();
+    std::mt19937 gen(0);
+    std::normal_distribution<double> noise(0, 1e-3);
+
+    double_state_t x = double_state_t::Zero();
+    x[1] = 0.1;
+    for (size_t i = 0; i < iterations; ++i) {
+        const model_t::input_t u = input(i);
+        x = Ad*x + Bd*u.cast<double>();
+        model_t::measurement_t z;
+        z << x[0] + noise(gen), x[2] + noise(gen);
+        observer.update_state(u, z);
+        kalman.update_state(u, z);
+        ASSERT_TRUE(kalman.is_steady_state());
+        const double error = (observer.x() - kalman.x()).cast<double>().cwiseQuotient(range).cwiseAbs().maxCoeff();
+        ASSERT_LT(error, 1e-5) << "at iteration " << i;
+    }
+    EXPECT_EQ(observer.K(), schedule.steady_state(50).K);
+}
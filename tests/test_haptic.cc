@@ -0,0 +1,59 @@
+#include "haptic.h"
+#include "bicycle/whipple.h"
+#include "constants.h"
+#include "gtest/gtest.h"
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001;
+    constexpr real_t I_delta = 0.0413;
+    constexpr int steer_rate_index = static_cast<int>(model_t::state_index_t::steer_rate);
+    constexpr real_t speeds[] = {0.0f, 1.0f, 1.0f, 4.5f, 2.0f, 0.0f};
+
+    class HapticTest: public ::testing::Test {
+        public:
+            HapticTest() : model(speeds[0], dt) {
+                x << 0.05f, -0.02f, 0.3f, 0.8f, -0.4f;
+                u << 0.1f, 1.5f;
+            }
+
+        protected:
+            model_t model;
+            model_t::state_t x;
+            model_t::input_t u;
+    };
+
+    // torque calculated from the model matrices for every call
+    real_t static_torque(const model_t& model, const model_t::state_t& x) {
+        const real_t v = model.v();
+        const model_t::second_order_matrix_t K = constants::g*model.K0() + v*v*model.K2();
+        return -(K(1, 1) - K(0, 1)*K(1, 0)/K(0, 0))*
+            model_t::get_state_element(x, model_t::state_index_t::steer_angle);
+    }
+
+    real_t dynamic_torque(const model_t& model, const model_t::state_t& x, const model_t::input_t& u) {
+        const real_t steer_acceleration = model.A().row(steer_rate_index).dot(x) +
+            model.B().row(steer_rate_index).dot(u);
+        return steer_acceleration*I_delta -
+            model_t::get_input_element(u, model_t::input_index_t::steer_torque);
+    }
+} // namespace
+
+TEST_F(HapticTest, static_coefficients_follow_model_speed) {
+    const haptic::HandlebarStatic handlebar(model);
+    for (real_t v: speeds) {
+        model.set_v_dt(v, dt);
+        EXPECT_NEAR(handlebar.torque(x, u), static_torque(model, x), 1e-4f) << "at speed " << v;
+    }
+}
+
+TEST_F(HapticTest, dynamic_coefficients_follow_model_speed) {
+    const haptic::HandlebarDynamic handlebar(model, I_delta);
+    for (real_t v: speeds) {
+        model.set_v_dt(v, dt);
+        EXPECT_NEAR(handlebar.torque(x, u), dynamic_torque(model, x, u), 1e-4f) << "at speed " << v;
+        EXPECT_EQ(handlebar.moment_of_inertia(), I_delta);
+    }
+}
@@ -0,0 +1,153 @@
+#include "hapticreference.h"
+#include "bicycle/whipple.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+    using interpolator_t = haptic::ReferenceInterpolator;
+
+    constexpr real_t tick_period = 0.00001; // 100 kHz system tick
+    constexpr uint32_t dynamics_period = 100; // ticks, 1 kHz
+    constexpr uint32_t haptic_period = 20; // ticks, 5 kHz
+    constexpr real_t dt = dynamics_period*tick_period;
+
+    class HapticReferenceTest: public ::testing::Test {
+        public:
+            HapticReferenceTest() : model(4.0, dt) {
+                x << 0.05f, -0.02f, 0.3f, 0.8f, -0.4f;
+                u << 0.0f, 1.5f;
+                velocity_form.a.setZero();
+                velocity_form.b.setZero();
+                model_t::set_state_element(velocity_form.a, model_t::state_index_t::steer_rate, 1);
+            }
+
+        protected:
+            model_t model;
+            model_t::state_t x;
+            model_t::input_t u;
+            haptic::linear_form_t velocity_form;
+    };
+
+    real_t steer_rate(const model_t::state_t& x) {
+        return model_t::get_state_element(x, model_t::state_index_t::steer_rate);
+    }
+
+    interpolator_t::sample_t constant_rate_sample(uint32_t time, real_t reference, real_t rate) {
+        return interpolator_t::sample_t{time, reference, rate, 0, 0, 0};
+    }
+} // namespace
+
+TEST_F(HapticReferenceTest, static_linear_form_matches_torque) {
+    haptic::HandlebarStatic handlebar(model);
+    const haptic::linear_form_t form = handlebar.linear_form();
+    EXPECT_FLOAT_EQ(form.a.dot(x) + form.b.dot(u), handlebar.torque(x, u));
+}
+
+TEST_F(HapticReferenceTest, dynamic_linear_form_matches_torque) {
+    haptic::HandlebarDynamic handlebar(model, 0.0413f);
+    const haptic::linear_form_t form = handlebar.linear_form();
+    EXPECT_NEAR(form.a.dot(x) + form.b.dot(u), handlebar.torque(x, u), 1e-4f);
+
+    // the linear form is updated with the model speed
+    model.set_v_dt(2.0, dt);
+    const haptic::linear_form_t form2 = handlebar.linear_form();
+    EXPECT_NEAR(form2.a.dot(x) + form2.b.dot(u), handlebar.torque(x, u), 1e-4f);
+}
+
+TEST_F(HapticReferenceTest, make_sample) {
+    const real_t torque = 1.2f;
+    const interpolator_t::sample_t s = interpolator_t::make_sample(model, velocity_form, x, u, 7, torque);
+    const model_t::state_t xdot = model.A()*x + model.B()*u;
+    EXPECT_EQ(s.time, 7u);
+    EXPECT_FLOAT_EQ(s.reference, steer_rate(x));
+    EXPECT_FLOAT_EQ(s.reference_rate, steer_rate(xdot));
+    EXPECT_FLOAT_EQ(s.torque, torque);
+    EXPECT_FLOAT_EQ(s.torque_gain, 0);
+    EXPECT_FLOAT_EQ(s.torque_rate_gain,
+            model.B()(static_cast<int>(model_t::state_index_t::steer_rate),
+                static_cast<int>(model_t::input_index_t::steer_torque)));
+}
+
+TEST_F(HapticReferenceTest, hold) {
+    interpolator_t interpolator(tick_period, dt, interpolator_t::mode_t::hold);
+    interpolator.reset(constant_rate_sample(0, 1, 0));
+    interpolator.push(interpolator_t::sample_t{dynamics_period, 2, 100, 0, 1, 1});
+    EXPECT_FLOAT_EQ(interpolator.reference(dynamics_period + haptic_period, 3), 2);
+    EXPECT_EQ(interpolator.mode(), interpolator_t::mode_t::hold);
+}
+
+TEST_F(HapticReferenceTest, interpolate) {
+    interpolator_t interpolator(tick_period, dt, interpolator_t::mode_t::interpolate);
+    interpolator.reset(constant_rate_sample(0, 1, 0));
+    interpolator.push(constant_rate_sample(dynamics_period, 2, 0));
+    EXPECT_FLOAT_EQ(interpolator.reference(dynamics_period, 0), 1);
+    EXPECT_FLOAT_EQ(interpolator.reference(dynamics_period + dynamics_period/4, 0), 1.25f);
+    EXPECT_FLOAT_EQ(interpolator.reference(2*dynamics_period, 0), 2);
+    // no overshoot if the next sample is late
+    EXPECT_FLOAT_EQ(interpolator.reference(3*dynamics_period, 0), 2);
+}
+
+TEST_F(HapticReferenceTest, extrapolation_is_limited) {
+    interpolator_t interpolator(tick_period, 2*dt);
+    interpolator.reset(constant_rate_sample(0, 1, 10));
+    EXPECT_FLOAT_EQ(interpolator.reference(haptic_period, 0), 1 + 10*haptic_period*tick_period);
+    EXPECT_FLOAT_EQ(interpolator.reference(10*dynamics_period, 0), 1 + 10*2*dt);
+    // a sample pushed after the read time is not extrapolated backwards
+    interpolator.push(constant_rate_sample(5*dynamics_period, 1, 10));
+    EXPECT_FLOAT_EQ(interpolator.reference(5*dynamics_period - 1, 0), 1);
+}
+
+TEST_F(HapticReferenceTest, tick_counter_wraps) {
+    interpolator_t interpolator(tick_period, dt);
+    const uint32_t t0 = std::numeric_limits<uint32_t>::max() - haptic_period/2;
+    interpolator.reset(constant_rate_sample(t0, 1, 10));
+    EXPECT_FLOAT_EQ(interpolator.reference(t0 + haptic_period, 0), 1 + 10*haptic_period*tick_period);
+}
+
+TEST_F(HapticReferenceTest, torque_feedthrough) {
+    interpolator_t interpolator(tick_period, dt);
+    interpolator.reset(interpolator_t::sample_t{0, 1, 0, 2, 0.5f, 3});
+    EXPECT_FLOAT_EQ(interpolator.reference(0, 2), 1);
+    EXPECT_FLOAT_EQ(interpolator.reference(0, 4), 1 + 0.5f*2);
+    EXPECT_FLOAT_EQ(interpolator.reference(dynamics_period, 4), 1 + 0.5f*2 + dt*3*2);
+}
+
+TEST_F(HapticReferenceTest, extrapolation_tracks_steer_rate) {
+    // Simulate a dynamics period in haptic loop steps and compare the
+    // extrapolated steer rate with the held steer rate.
+    constexpr uint32_t steps = dynamics_period/haptic_period;
+    model_t fine_model(model.v(), haptic_period*tick_period);
+    interpolator_t interpolator(tick_period, dt);
+    interpolator.reset(interpolator_t::make_sample(model, velocity_form, x, u, 0, 0));
+
+    // A steer torque step at the start of the period is measured by the
+    // haptic loop but not by the dynamics loop.
+    const real_t torque_step = 2.0f;
+    model_t::input_t u_step = u;
+    model_t::set_input_element(u_step, model_t::input_index_t::steer_torque,
+            model_t::get_input_element(u, model_t::input_index_t::steer_torque) + torque_step);
+
+    model_t::state_t xf = x;
+    real_t max_hold_error = 0;
+    real_t max_extrapolation_error = 0;
+    for (uint32_t i = 1; i <= steps; ++i) {
+        xf = fine_model.update_state(xf, u_step);
+        const real_t r = interpolator.reference(i*haptic_period, torque_step);
+        max_hold_error = std::max(max_hold_error, std::abs(steer_rate(x) - steer_rate(xf)));
+        max_extrapolation_error = std::max(max_extrapolation_error, std::abs(r - steer_rate(xf)));
+    }
+    EXPECT_GT(max_hold_error, 0.0f);
+    EXPECT_LT(max_extrapolation_error, max_hold_error/10);
+}
+
+TEST_F(HapticReferenceTest, missed_reads) {
+    interpolator_t interpolator(tick_period, dt);
+    interpolator.reset(constant_rate_sample(0, 1, 0));
+    interpolator.reference(0, 0);
+    EXPECT_EQ(interpolator.missed_reads(), 0u);
+}
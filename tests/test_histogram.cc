@@ -0,0 +1,79 @@
+#include "histogram.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <limits>
+
+TEST(Histogram, add) {
+    util::Histogram<4> h(10);
+    h.add(0);
+    h.add(9);
+    h.add(10);
+    h.add(35);
+    h.add(1000);
+    EXPECT_EQ(h.counts()[0], 2u);
+    EXPECT_EQ(h.counts()[1], 1u);
+    EXPECT_EQ(h.counts()[2], 0u);
+    // the last bucket counts all values from 30
+    EXPECT_EQ(h.counts()[3], 2u);
+    EXPECT_EQ(h.total(), 5u);
+    EXPECT_EQ(h.max(), 1000u);
+
+    h.reset();
+    EXPECT_EQ(h.total(), 0u);
+    EXPECT_EQ(h.max(), 0u);
+    EXPECT_EQ(h.counts()[3], 0u);
+    EXPECT_EQ(h.bucket_width(), 10u);
+}
+
+TEST(Histogram, zero_bucket_width) {
+    util::Histogram<4> h(0);
+    EXPECT_EQ(h.bucket_width(), 1u);
+    h.add(2);
+    EXPECT_EQ(h.counts()[2], 1u);
+}
+
+TEST(Histogram, quantile_empty) {
+    util::Histogram<4> h(10);
+    EXPECT_EQ(util::histogram_quantile(h, 0.5), 0u);
+    EXPECT_EQ(util::histogram_quantile(h, 0.99), 0u);
+}
+
+TEST(Histogram, quantile) {
+    util::Histogram<16> h(10);
+    for (uint32_t i = 0; i < 100; ++i) {
+        h.add(i); // 10 values in each of the first 10 buckets
+    }
+    EXPECT_EQ(util::histogram_quantile(h, 0.5), 49u);
+    EXPECT_EQ(util::histogram_quantile(h, 0.51), 59u);
+    EXPECT_EQ(util::histogram_quantile(h, 0.01), 9u);
+    // limited to the maximum value
+    EXPECT_EQ(util::histogram_quantile(h, 0.99), 99u);
+    EXPECT_EQ(util::histogram_quantile(h, 1.0), 99u);
+
+    h.add(95);
+    EXPECT_EQ(util::histogram_quantile(h, 1.0), 99u);
+}
+
+TEST(Histogram, quantile_tail) {
+    // p99 of 1000 values with 10 in the last bucket, bucket [10, 15) holds the
+    // other values
+    util::Histogram<8> h(5);
+    for (int i = 0; i < 990; ++i) {
+        h.add(12);
+    }
+    for (int i = 0; i < 10; ++i) {
+        h.add(200 + i);
+    }
+    EXPECT_EQ(util::histogram_quantile(h, 0.5), 14u);
+    EXPECT_EQ(util::histogram_quantile(h, 0.99), 14u);
+    // values in the last bucket are bounded by the maximum
+    EXPECT_EQ(util::histogram_quantile(h, 0.995), 209u);
+}
+
+TEST(Histogram, quantile_array) {
+    // counts as transmitted in a telemetry message
+    const uint32_t counts[] = {0, 3, 1, 0};
+    EXPECT_EQ(util::histogram_quantile(counts, 4, 2, 5, 0.5), 3u);
+    EXPECT_EQ(util::histogram_quantile(counts, 4, 2, 5, 0.99), 5u);
+    EXPECT_EQ(util::histogram_quantile(counts, 4, 2, 4, 1.0), 4u);
+}
@@ -0,0 +1,174 @@
+#include "kalmanschedule.h"
+#include "bicycle/whipple.h"
+#include "kalman.h"
+#include "parameters.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using kalman_t = observer::Kalman<model_t>;
+    using observer_t = sim::ScheduledKalman<model_t>;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001;
+    constexpr real_t v_resolution = 0.1;
+    constexpr size_t cache_size = 61; // [0, 6] m/s
+    constexpr uint32_t settle_iterations = 20;
+
+    const sim::ModelCache<model_t, cache_size> cache(model_t(0.0, dt), 0.0, v_resolution);
+
+    kalman_t::process_noise_covariance_t Q() {
+        return parameters::defaultvalue::kalman::Q(dt);
+    }
+
+    kalman_t::measurement_noise_covariance_t R() {
+        return parameters::defaultvalue::kalman::R/1000;
+    }
+
+    template <typename M>
+    real_t max_relative_difference(const M& a, const M& b) {
+        return (a - b).cwiseAbs().maxCoeff()/b.cwiseAbs().maxCoeff();
+    }
+
+    class KalmanScheduleTest: public ::testing::Test {
+        public:
+            KalmanScheduleTest() : schedule(cache, Q(), R()) { }
+
+        protected:
+            const sim::KalmanGainSchedule<model_t, cache_size> schedule;
+    };
+} // namespace
+
+TEST_F(KalmanScheduleTest, lookup) {
+    EXPECT_EQ(schedule.steady_state(3.0, dt), &schedule.steady_state(30));
+    EXPECT_EQ(schedule.steady_state(6.1, dt), nullptr);
+    EXPECT_EQ(schedule.steady_state(3.0, 2*dt), nullptr);
+}
+
+TEST_F(KalmanScheduleTest, riccati_fixed_point) {
+    // The steady-state solution must be unchanged by a Kalman filter update.
+    for (size_t i = 0; i < cache_size; i += 10) {
+        model_t model(cache.model(i));
+        kalman_t kalman(model);
+        kalman.set_Q(Q());
+        kalman.set_R(R());
+        kalman.set_P(schedule.steady_state(i).P);
+        kalman.update_state(model_t::input_t::Zero(), model_t::measurement_t::Zero());
+
+        EXPECT_LT(max_relative_difference(kalman.P(), schedule.steady_state(i).P), 1e-3)
+            << "at v = " << cache.v(i);
+        EXPECT_LT(max_relative_difference(kalman.K(), schedule.steady_state(i).K), 1e-3)
+            << "at v = " << cache.v(i);
+    }
+}
+
+TEST_F(KalmanScheduleTest, single_precision) {
+    // Used at boot on targets without a double precision FPU.
+    const sim::KalmanGainSchedule<model_t, cache_size> s(cache, Q(), R(), 1e-5f);
+    for (size_t i = 0; i < cache_size; ++i) {
+        EXPECT_LT(max_relative_difference(s.steady_state(i).P, schedule.steady_state(i).P), 1e-3)
+            << "at v = " << cache.v(i);
+        EXPECT_LT(max_relative_difference(s.steady_state(i).K, schedule.steady_state(i).K), 1e-3)
+            << "at v = " << cache.v(i);
+    }
+}
+
+TEST_F(KalmanScheduleTest, copy_precomputed) {
+    // Layout of the schedule generated by tools/sim/kalmanprime.
+    std::vector<real_t> K;
+    std::vector<real_t> P;
+    for (size_t i = 0; i < cache_size; ++i) {
+        const auto& s = schedule.steady_state(i);
+        K.insert(K.end(), s.K.data(), s.K.data() + s.K.size());
+        P.insert(P.end(), s.P.data(), s.P.data() + s.P.size());
+    }
+
+    const sim::KalmanGainSchedule<model_t, cache_size> s(cache, K.data(), P.data());
+    for (size_t i = 0; i < cache_size; ++i) {
+        EXPECT_EQ(s.steady_state(i).K, schedule.steady_state(i).K);
+        EXPECT_EQ(s.steady_state(i).P, schedule.steady_state(i).P);
+    }
+    EXPECT_EQ(s.steady_state(3.0, dt), &s.steady_state(30));
+}
+
+TEST_F(KalmanScheduleTest, full_filter_after_speed_change) {
+    model_t model(cache.model(30));
+    observer_t observer(model);
+    observer.set_Q(Q());
+    observer.set_R(R());
+    observer.set_gain_schedule(&schedule, settle_iterations);
+
+    const model_t::input_t u = model_t::input_t::Zero();
+    const model_t::measurement_t z = model_t::measurement_t::Zero();
+    observer.update_state(u, z);
+    EXPECT_TRUE(observer.is_steady_state());
+    EXPECT_EQ(observer.K(), schedule.steady_state(30).K);
+
+    model = cache.model(31);
+    for (uint32_t i = 1; i < settle_iterations; ++i) {
+        observer.update_state(u, z);
+        EXPECT_FALSE(observer.is_steady_state());
+    }
+    observer.update_state(u, z);
+    EXPECT_TRUE(observer.is_steady_state());
+    EXPECT_EQ(observer.K(), schedule.steady_state(31).K);
+}
+
+TEST_F(KalmanScheduleTest, full_filter_matches_kalman) {
+    // Without a schedule, the split update is equivalent to the Kalman filter.
+    model_t model(cache.model(20));
+    kalman_t kalman(model);
+    observer_t observer(model);
+    kalman.set_Q(Q());
+    kalman.set_R(R());
+    observer.set_Q(Q());
+    observer.set_R(R());
+
+    model_t::state_t x = model_t::state_t::Zero();
+    model_t::set_state_element(x, model_t::state_index_t::steer_angle, 0.1f);
+    const model_t::input_t u = model_t::input_t::Zero();
+    for (int i = 0; i < 100; ++i) {
+        x = model.update_state(x, u);
+        const model_t::measurement_t z = model.calculate_output(x);
+        kalman.update_state(u, z);
+        observer.update_state_estimate(u, z);
+        EXPECT_TRUE(observer.x().isApprox(kalman.x(), 1e-4f)) << "at iteration " << i;
+        observer.update_error_covariance();
+    }
+    EXPECT_FALSE(observer.is_steady_state());
+}
+
+TEST_F(KalmanScheduleTest, state_estimate_matches_kalman) {
+    // Compare with a Kalman filter started at the steady-state covariance
+    // while tracking a noisy simulated bicycle.
+    model_t model(cache.model(40));
+    kalman_t kalman(model);
+    observer_t observer(model);
+    kalman.set_Q(Q());
+    kalman.set_R(R());
+    kalman.set_P(schedule.steady_state(40).P);
+    observer.set_Q(Q());
+    observer.set_R(R());
+    observer.set_gain_schedule(&schedule, settle_iterations);
+
+    std::mt19937 gen(0);
+    std::normal_distribution<real_t> noise(0, 1e-3);
+    model_t::state_t x = model_t::state_t::Zero();
+    model_t::set_state_element(x, model_t::state_index_t::roll_angle, 0.05f);
+    const model_t::input_t u = model_t::input_t::Zero();
+    for (int i = 0; i < 2000; ++i) {
+        x = model.update_state(x, u);
+        model_t::measurement_t z = model.calculate_output(x);
+        z[0] += noise(gen);
+        z[1] += noise(gen);
+        kalman.update_state(u, z);
+        observer.update_state(u, z);
+        ASSERT_TRUE(observer.is_steady_state());
+        ASSERT_TRUE(observer.x().isApprox(kalman.x(), 1e-3f) ||
+                    (observer.x() - kalman.x()).cwiseAbs().maxCoeff() < 1e-5f)
+            << "at iteration " << i;
+    }
+}
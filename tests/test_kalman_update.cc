@@ -0,0 +1,92 @@
+#include "kalmanupdate.h"
+#include "kalmanschedule.h"
+#include "bicycle/whipple.h"
+#include "kalman.h"
+#include "parameters.h"
+#include "gtest/gtest.h"
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using kalman_t = observer::Kalman<model_t>;
+    using real_t = model::real_t;
+    using mask_t = std::bitset<model_t::l>;
+
+    constexpr real_t dt = 0.001;
+    constexpr unsigned int yaw = 0; // measurement index of yaw angle
+    constexpr unsigned int steer = 1; // measurement index of steer angle
+
+    template <typename M>
+    real_t max_relative_difference(const M& a, const M& b) {
+        return (a - b).cwiseAbs().maxCoeff()/b.cwiseAbs().maxCoeff();
+    }
+
+    class KalmanUpdateTest: public ::testing::Test {
+        public:
+            KalmanUpdateTest() : model(4.0, dt), R(parameters::defaultvalue::kalman::R/1000) {
+                // a priori error covariance after some time updates
+                P = kalman_t::error_covariance_t::Identity()*1e-3f;
+                for (int i = 0; i < 100; ++i) {
+                    P = model.Ad()*P*model.Ad().transpose() + parameters::defaultvalue::kalman::Q(dt);
+                }
+            }
+
+        protected:
+            model_t model;
+            kalman_t::measurement_noise_covariance_t R;
+            kalman_t::error_covariance_t P;
+    };
+} // namespace
+
+TEST_F(KalmanUpdateTest, sequential_equals_joint) {
+    kalman_t::kalman_gain_t K_joint, K_sequential;
+    kalman_t::error_covariance_t P_joint, P_sequential;
+    sim::JointMeasurementUpdate::update(P, model.Cd(), R, mask_t().set(), &K_joint, &P_joint);
+    sim::SequentialMeasurementUpdate::update(P, model.Cd(), R, mask_t().set(), &K_sequential, &P_sequential);
+
+    EXPECT_LT(max_relative_difference(K_sequential, K_joint), 1e-4);
+    EXPECT_LT(max_relative_difference(P_sequential, P_joint), 1e-4);
+}
+
+TEST_F(KalmanUpdateTest, skip_measurement) {
+    mask_t mask;
+    mask.set(steer);
+
+    kalman_t::kalman_gain_t K_joint, K_sequential;
+    kalman_t::error_covariance_t P_joint, P_sequential;
+    sim::JointMeasurementUpdate::update(P, model.Cd(), R, mask, &K_joint, &P_joint);
+    sim::SequentialMeasurementUpdate::update(P, model.Cd(), R, mask, &K_sequential, &P_sequential);
+
+    EXPECT_TRUE(K_joint.col(yaw).isZero());
+    EXPECT_TRUE(K_sequential.col(yaw).isZero());
+    EXPECT_LT(max_relative_difference(K_sequential, K_joint), 1e-4);
+    EXPECT_LT(max_relative_difference(P_sequential, P_joint), 1e-4);
+
+    // single measurement Kalman gain
+    const model_t::state_t PCt = P*model.Cd().row(steer).transpose();
+    const model_t::state_t k = PCt/(model.Cd().row(steer).dot(PCt) + R(steer, steer));
+    EXPECT_LT(max_relative_difference(model_t::state_t(K_sequential.col(steer)), k), 1e-5);
+}
+
+TEST_F(KalmanUpdateTest, observer_ignores_stale_measurement) {
+    using observer_t = sim::ScheduledKalman<model_t, sim::SequentialMeasurementUpdate>;
+    observer_t a(model);
+    observer_t b(model);
+    for (auto observer: {&a, &b}) {
+        observer->set_Q(parameters::defaultvalue::kalman::Q(dt));
+        observer->set_R(R);
+    }
+
+    observer_t::measurement_mask_t mask;
+    mask.set(steer);
+    const model_t::input_t u = model_t::input_t::Zero();
+    for (int i = 0; i < 100; ++i) {
+        const model_t::measurement_t za = (model_t::measurement_t() << 0.0f, 0.1f).finished();
+        const model_t::measurement_t zb = (model_t::measurement_t() << 1.0f, 0.1f).finished();
+        a.update_state_estimate(u, za, mask);
+        b.update_state_estimate(u, zb, mask);
+        a.update_error_covariance();
+        b.update_error_covariance();
+    }
+    EXPECT_EQ(a.x(), b.x());
+    EXPECT_NE(a.x(), model_t::state_t::Zero());
+}
@@ -0,0 +1,53 @@
+#include "lqrassistance.h"
+#include "gtest/gtest.h"
+#include <Eigen/Core>
+#include <algorithm>
+
+namespace {
+    using real_t = model::real_t;
+
+    // Returns the speed passed to control_calculate() as input.
+    struct SpeedController {
+        using state_t = Eigen::Matrix<real_t, 2, 1>;
+        using input_t = Eigen::Matrix<real_t, 2, 1>;
+
+        input_t control_calculate(const state_t& x, real_t v) const {
+            (void)x;
+            return input_t::Constant(v);
+        }
+    };
+
+    constexpr real_t velocity_limit = 1.0f;
+    constexpr uint32_t fade_period = 4;
+} // namespace
+
+TEST(FadedAssistance, fade_in) {
+    SpeedController controller;
+    controller::FadedAssistance<SpeedController> assistance(controller, velocity_limit, fade_period);
+    const SpeedController::state_t x = SpeedController::state_t::Zero();
+    SpeedController::input_t u;
+    for (uint32_t i = 1; i <= fade_period + 1; ++i) {
+        ASSERT_TRUE(assistance.control_calculate(x, 0.5f, &u));
+        const real_t fade = static_cast<real_t>(std::min(i, fade_period))/fade_period;
+        EXPECT_FLOAT_EQ(u[0], fade*0.5f);
+    }
+}
+
+TEST(FadedAssistance, fade_out_at_velocity_limit) {
+    SpeedController controller;
+    controller::FadedAssistance<SpeedController> assistance(controller, velocity_limit, fade_period);
+    const SpeedController::state_t x = SpeedController::state_t::Zero();
+    SpeedController::input_t u;
+    for (uint32_t i = 0; i < fade_period; ++i) {
+        assistance.control_calculate(x, 0.5f, &u);
+    }
+
+    // The gain is not scheduled beyond the velocity limit while fading out.
+    for (uint32_t i = fade_period; i > 0; --i) {
+        ASSERT_TRUE(assistance.control_calculate(x, 3.0f, &u));
+        EXPECT_FLOAT_EQ(u[0], static_cast<real_t>(i)/fade_period*velocity_limit);
+    }
+    u = SpeedController::input_t::Constant(-1.0f);
+    EXPECT_FALSE(assistance.control_calculate(x, 3.0f, &u));
+    EXPECT_EQ(u[0], -1.0f);
+}
@@ -0,0 +1,103 @@
+#include "pitchtable.h"
+#include "bicycle/whipple.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+
+    constexpr size_t table_size = 17;
+    constexpr real_t roll_max = constants::pi/4;
+    constexpr real_t steer_max = constants::pi/2;
+
+    const model_t bicycle(5.0, 0.001);
+    const sim::PitchTable<table_size> table(bicycle, roll_max, steer_max);
+} // namespace
+
+TEST(pitch_table, exact_at_grid_points) {
+    for (size_t r = 0; r < table_size; r += 4) {
+        for (size_t s = 0; s < table_size; s += 4) {
+            const real_t roll = -roll_max + 2*roll_max*r/(table_size - 1);
+            const real_t steer = -steer_max + 2*steer_max*s/(table_size - 1);
+            real_t pitch;
+            ASSERT_TRUE(table.interpolate(roll, steer, &pitch));
+            EXPECT_NEAR(pitch, bicycle.solve_constraint_pitch(roll, steer, pitch), 1e-5);
+        }
+    }
+}
+
+TEST(pitch_table, outside_range) {
+    real_t pitch = 1;
+    EXPECT_FALSE(table.pitch(1.01f*roll_max, 0, 0, 0, &pitch));
+    EXPECT_FALSE(table.pitch(0, -1.01f*steer_max, 0, 0, &pitch));
+    EXPECT_FALSE(table.pitch(std::nan(""), 0, 0, 0, &pitch));
+    EXPECT_EQ(pitch, 1);
+}
+
+TEST(pitch_table, not_filled) {
+    const sim::PitchTable<table_size> empty;
+    real_t pitch = 1;
+    EXPECT_FALSE(empty.filled());
+    EXPECT_FALSE(empty.pitch(0, 0, 0, 0, &pitch));
+    EXPECT_EQ(pitch, 1);
+
+    sim::PitchTable<table_size> deferred;
+    deferred.fill(bicycle, roll_max, steer_max);
+    ASSERT_TRUE(deferred.filled());
+    EXPECT_TRUE(deferred.pitch(0.1f, 0.2f, 0, 0, &pitch));
+    real_t expected;
+    ASSERT_TRUE(table.pitch(0.1f, 0.2f, 0, 0, &expected));
+    EXPECT_EQ(pitch, expected);
+    EXPECT_EQ(deferred.max_error(), table.max_error());
+}
+
+TEST(pitch_table, no_refinement_within_error) {
+    // the interpolated pitch is used if the table error is allowed
+    real_t interpolated;
+    real_t pitch;
+    ASSERT_TRUE(table.interpolate(0.3f, -0.4f, &interpolated));
+    ASSERT_TRUE(table.pitch(0.3f, -0.4f, 0, table.max_error(), &pitch));
+    EXPECT_EQ(pitch, interpolated);
+}
+
+TEST(pitch_table, newton_step_error) {
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<real_t> roll_dist(-roll_max, roll_max);
+    std::uniform_real_distribution<real_t> steer_dist(-steer_max, steer_max);
+
+    real_t max_interpolation_error = 0;
+    for (int i = 0; i < 1000; ++i) {
+        const real_t roll = roll_dist(gen);
+        const real_t steer = steer_dist(gen);
+        real_t interpolated;
+        real_t pitch;
+        ASSERT_TRUE(table.interpolate(roll, steer, &interpolated));
+        ASSERT_TRUE(table.pitch(roll, steer, std::nan(""), 1e-6f, &pitch));
+        const real_t solved = bicycle.solve_constraint_pitch(roll, steer, interpolated);
+        max_interpolation_error = std::max(max_interpolation_error, std::abs(interpolated - solved));
+        EXPECT_NEAR(pitch, solved, 1e-5);
+    }
+    // the refinement is needed for this table size
+    EXPECT_GT(max_interpolation_error, 1e-5);
+    EXPECT_GT(table.max_error(), 1e-5);
+}
+
+TEST(pitch_table, warm_start) {
+    // Roll and steer change by 0.2 degrees between queries and the
+    // Newton step starts from the previous pitch.
+    real_t previous = bicycle.solve_constraint_pitch(0.2f, 0.5f, 0);
+    real_t max_error = 0;
+    for (int i = 1; i <= 100; ++i) {
+        const real_t roll = 0.2f + 0.003f*i;
+        const real_t steer = 0.5f - 0.003f*i;
+        real_t pitch;
+        ASSERT_TRUE(table.pitch(roll, steer, previous, 1e-6f, &pitch));
+        const real_t solved = bicycle.solve_constraint_pitch(roll, steer, previous);
+        max_error = std::max(max_error, std::abs(pitch - solved));
+        previous = pitch;
+    }
+    EXPECT_LT(max_error, 1e-6);
+}
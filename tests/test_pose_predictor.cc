@@ -0,0 +1,131 @@
+#include "posepredictor.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+    constexpr double tick_frequency = 100000.0;
+    constexpr double link_delay = 0.001;
+    constexpr double max_horizon = 0.05;
+    constexpr pose::Predictor::config_t config = {tick_frequency, link_delay, max_horizon, 1e-4};
+
+    pose::pose_t moving_pose(double yaw, double yaw_rate, double v) {
+        pose::pose_t p{};
+        p.x = 1.0;
+        p.y = 2.0;
+        p.yaw = yaw;
+        p.roll = 0.1;
+        p.pitch = 0.3;
+        p.steer = -0.2;
+        p.rear_wheel = 3.0;
+        p.yaw_rate = yaw_rate;
+        p.roll_rate = 0.5;
+        p.steer_rate = -1.0;
+        p.rear_wheel_rate = -v/0.3;
+        p.v = v;
+        return p;
+    }
+
+    uint32_t ticks(double t) {
+        return static_cast<uint32_t>(std::lround(t*tick_frequency));
+    }
+} // namespace
+
+TEST(PosePredictor, invalid_before_update) {
+    pose::Predictor predictor(config);
+    EXPECT_FALSE(predictor.valid());
+    EXPECT_EQ(predictor.horizon(1.0), 0.0);
+}
+
+TEST(PosePredictor, pose_time_from_link_delay) {
+    pose::Predictor predictor(config);
+    const double receive_time = 10.0;
+    predictor.update(moving_pose(0, 0, 0), ticks(1.0), receive_time);
+    EXPECT_NEAR(predictor.pose_time(), receive_time - link_delay, 1e-9);
+    EXPECT_NEAR(predictor.horizon(receive_time + 0.007), 0.008, 1e-9);
+    // render times before the pose are not extrapolated backwards
+    EXPECT_EQ(predictor.horizon(receive_time - 0.1), 0.0);
+    EXPECT_EQ(predictor.horizon(receive_time + 1.0), max_horizon);
+}
+
+TEST(PosePredictor, clock_offset_uses_minimum_delay) {
+    pose::Predictor predictor(config);
+    const double offset = 5.0;
+    const double delays[] = {0.004, 0.002, 0.006, 0.001, 0.003};
+    constexpr uint32_t period = 833; // ticks, 120 Hz
+    uint32_t timestamp = 0;
+    for (double delay: delays) {
+        timestamp += period;
+        predictor.update(moving_pose(0, 0, 0), timestamp,
+                timestamp/tick_frequency + offset + link_delay + delay);
+    }
+    // the offset decreases to the minimum delay and increases at most by the drift
+    EXPECT_GE(predictor.clock_offset(), offset + 0.001 - 1e-9);
+    EXPECT_LE(predictor.clock_offset(), offset + 0.001 + 1e-4*period/tick_frequency + 1e-9);
+}
+
+TEST(PosePredictor, straight_line) {
+    pose::Predictor predictor(config);
+    const double yaw = 0.3;
+    const double v = 4.0;
+    predictor.update(moving_pose(yaw, 0, v), 0, link_delay);
+    const double h = 0.01;
+    const pose::pose_t p = predictor.predict(h);
+    EXPECT_NEAR(p.x, 1.0 + v*h*std::cos(yaw), 1e-12);
+    EXPECT_NEAR(p.y, 2.0 + v*h*std::sin(yaw), 1e-12);
+    EXPECT_NEAR(p.yaw, yaw, 1e-12);
+    EXPECT_NEAR(p.roll, 0.1 + 0.5*h, 1e-12);
+    EXPECT_NEAR(p.steer, -0.2 - 1.0*h, 1e-12);
+    EXPECT_NEAR(p.rear_wheel, 3.0 - v/0.3*h, 1e-12);
+    EXPECT_EQ(p.pitch, 0.3);
+}
+
+TEST(PosePredictor, rear_wheel_wraps) {
+    // The predicted angle is wrapped to [-pi, pi) like the firmware angle.
+    pose::Predictor predictor(config);
+    const double v = 4.0;
+    predictor.update(moving_pose(0, 0, -v), 0, link_delay);
+    const double h = 0.05;
+    const pose::pose_t p = predictor.predict(h);
+    EXPECT_NEAR(p.rear_wheel, 3.0 + v/0.3*h - 2*M_PI, 1e-12);
+    EXPECT_GE(p.rear_wheel, -M_PI);
+    EXPECT_LT(p.rear_wheel, M_PI);
+}
+
+TEST(PosePredictor, circular_arc) {
+    pose::Predictor predictor(config);
+    const double yaw = 1.0;
+    const double yaw_rate = 0.8;
+    const double v = 5.0;
+    predictor.update(moving_pose(yaw, yaw_rate, v), 0, link_delay);
+    const double h = 0.04;
+    const pose::pose_t p = predictor.predict(h);
+    // circle of radius v/yaw_rate
+    const double r = v/yaw_rate;
+    EXPECT_NEAR(p.x, 1.0 + r*(std::sin(yaw + yaw_rate*h) - std::sin(yaw)), 1e-12);
+    EXPECT_NEAR(p.y, 2.0 - r*(std::cos(yaw + yaw_rate*h) - std::cos(yaw)), 1e-12);
+    EXPECT_NEAR(p.yaw, yaw + yaw_rate*h, 1e-12);
+}
+
+TEST(PosePredictor, timestamp_wraps) {
+    pose::Predictor predictor(config);
+    const uint32_t t0 = std::numeric_limits<uint32_t>::max() - 100;
+    predictor.update(moving_pose(0, 0, 0), t0, 100.0);
+    const double pose_time0 = predictor.pose_time();
+    predictor.update(moving_pose(0, 0, 0), t0 + 833, 100.00833);
+    EXPECT_NEAR(predictor.pose_time() - pose_time0, 0.00833, 1e-9);
+}
+
+TEST(PosePredictor, holds_pose_without_rates) {
+    pose::Predictor predictor(config);
+    pose::pose_t p0 = moving_pose(0.5, 0, 0);
+    p0.roll_rate = 0;
+    p0.steer_rate = 0;
+    predictor.update(p0, 0, link_delay);
+    const pose::pose_t p = predictor.predict(0.02);
+    EXPECT_EQ(p.x, p0.x);
+    EXPECT_EQ(p.y, p0.y);
+    EXPECT_EQ(p.roll, p0.roll);
+    EXPECT_EQ(p.steer, p0.steer);
+}
@@ -0,0 +1,119 @@
+#include "schedule.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <limits>
+
+namespace {
+    constexpr uint32_t period = 100;
+
+    rt::release_t<uint32_t> next(rt::miss_policy_t policy, uint32_t release_time, uint32_t now) {
+        return rt::next_release(policy, release_time, period, now);
+    }
+} // namespace
+
+TEST(Schedule, release_on_time) {
+    for (auto policy: {rt::miss_policy_t::skip, rt::miss_policy_t::catch_up, rt::miss_policy_t::log}) {
+        const rt::release_t<uint32_t> r = next(policy, 1000, 1099);
+        EXPECT_EQ(r.time, 1100u);
+        EXPECT_EQ(r.skipped, 0u);
+        EXPECT_TRUE(r.sleep);
+        EXPECT_FALSE(rt::deadline_missed(1000u, period, 1099u));
+    }
+}
+
+TEST(Schedule, skip) {
+    EXPECT_TRUE(rt::deadline_missed(1000u, period, 1100u));
+    rt::release_t<uint32_t> r = next(rt::miss_policy_t::skip, 1000, 1100);
+    EXPECT_EQ(r.time, 1200u);
+    EXPECT_EQ(r.skipped, 1u);
+    EXPECT_TRUE(r.sleep);
+
+    r = next(rt::miss_policy_t::skip, 1000, 1350);
+    EXPECT_EQ(r.time, 1400u);
+    EXPECT_EQ(r.skipped, 3u);
+}
+
+TEST(Schedule, catch_up) {
+    rt::release_t<uint32_t> r = next(rt::miss_policy_t::catch_up, 1000, 1350);
+    EXPECT_EQ(r.time, 1100u);
+    EXPECT_FALSE(r.sleep);
+
+    // missed releases run back to back until the task is back on the grid
+    uint32_t now = 1350;
+    uint32_t release_time = 1000;
+    int jobs = 0;
+    while (!r.sleep) {
+        release_time = r.time;
+        now += 10;
+        r = next(rt::miss_policy_t::catch_up, release_time, now);
+        ++jobs;
+    }
+    EXPECT_EQ(r.time, 1400u);
+    EXPECT_EQ(jobs, 3);
+}
+
+TEST(Schedule, log) {
+    const rt::release_t<uint32_t> r = next(rt::miss_policy_t::log, 1000, 1350);
+    EXPECT_EQ(r.time, 1350u);
+    EXPECT_EQ(r.skipped, 0u);
+    EXPECT_FALSE(r.sleep);
+}
+
+TEST(Schedule, time_wraps) {
+    const uint32_t t0 = std::numeric_limits<uint32_t>::max() - 50;
+    EXPECT_FALSE(rt::deadline_missed(t0, period, t0 + 99));
+    rt::release_t<uint32_t> r = next(rt::miss_policy_t::skip, t0, t0 + 99);
+    EXPECT_EQ(r.time, t0 + period);
+    EXPECT_TRUE(r.sleep);
+
+    r = next(rt::miss_policy_t::skip, t0, t0 + 250);
+    EXPECT_EQ(r.time, t0 + 3*period);
+    EXPECT_EQ(r.skipped, 2u);
+
+    // 16-bit system time
+    const uint16_t s0 = std::numeric_limits<uint16_t>::max() - 10;
+    const rt::release_t<uint16_t> s = rt::next_release<uint16_t>(rt::miss_policy_t::skip,
+            s0, 20, static_cast<uint16_t>(s0 + 45));
+    EXPECT_EQ(s.time, static_cast<uint16_t>(s0 + 60));
+    EXPECT_EQ(s.skipped, 2u);
+}
+
+TEST(Schedule, rate_monotonic_rank) {
+    const rt::task_timing_t tasks[] = {
+        {"pose", 8333, 500}, {"dynamics", 1000, 400}, {"log", 8333, 100}, {"haptic", 200, 20}};
+    EXPECT_EQ(rt::rate_monotonic_rank(tasks, 4, 0), 2u);
+    EXPECT_EQ(rt::rate_monotonic_rank(tasks, 4, 1), 1u);
+    EXPECT_EQ(rt::rate_monotonic_rank(tasks, 4, 2), 3u);
+    EXPECT_EQ(rt::rate_monotonic_rank(tasks, 4, 3), 0u);
+}
+
+TEST(Schedule, utilization_bound) {
+    EXPECT_DOUBLE_EQ(rt::utilization_bound(1), 1.0);
+    EXPECT_NEAR(rt::utilization_bound(2), 0.8284, 1e-4);
+    EXPECT_NEAR(rt::utilization_bound(1000), 0.6934, 1e-4);
+
+    const rt::task_timing_t tasks[] = {{"a", 10, 2}, {"b", 40, 10}};
+    EXPECT_DOUBLE_EQ(rt::utilization(tasks, 2), 0.45);
+}
+
+TEST(Schedule, response_times) {
+    // Utilization 0.825 exceeds the Liu and Layland bound of 0.780 but the
+    // task set is schedulable.
+    const rt::task_timing_t tasks[] = {{"c", 20, 5}, {"a", 5, 1}, {"b", 8, 3}};
+    uint32_t response_time[3];
+    EXPECT_GT(rt::utilization(tasks, 3), rt::utilization_bound(3));
+    EXPECT_TRUE(rt::response_times(tasks, 3, response_time));
+    EXPECT_EQ(response_time[1], 1u);
+    EXPECT_EQ(response_time[2], 4u);
+    // R = 5 + ceil(R/5)*1 + ceil(R/8)*3 converges at 14
+    EXPECT_EQ(response_time[0], 14u);
+}
+
+TEST(Schedule, response_time_exceeds_deadline) {
+    const rt::task_timing_t tasks[] = {{"a", 5, 2}, {"b", 8, 3}, {"c", 20, 5}};
+    uint32_t response_time[3];
+    EXPECT_FALSE(rt::response_times(tasks, 3, response_time));
+    EXPECT_EQ(response_time[0], 2u);
+    EXPECT_EQ(response_time[1], 5u);
+    EXPECT_GT(response_time[2], tasks[2].period);
+}
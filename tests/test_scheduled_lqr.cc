@@ -0,0 +1,57 @@
+#include "scheduled_lqr.h"
+#include "bicycle/whipple.h"
+#include "gtest/gtest.h"
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+    using lqr_t = controller::ScheduledLqr<model_t, 3>;
+
+    constexpr real_t gains[3][model_t::m*model_t::n] = {
+        {0, -1, -2, -3, -4,
+         0, -5, -6, -7, -8}, // v = 1
+        {0, 1, 2, 3, 4,
+         0, 5, 6, 7, 8}, // v = 2
+        {0, 3, 4, 5, 6,
+         0, 7, 8, 9, 10}, // v = 3
+    };
+
+    lqr_t::feedback_gain_t gain(size_t i) {
+        lqr_t::feedback_gain_t K;
+        for (size_t r = 0; r < model_t::m; ++r) {
+            for (size_t c = 0; c < model_t::n; ++c) {
+                K(r, c) = gains[i][r*model_t::n + c];
+            }
+        }
+        return K;
+    }
+} // namespace
+
+TEST(ScheduledLqr, breakpoints) {
+    lqr_t lqr(gains, 1.0f, 3.0f);
+    EXPECT_EQ(lqr.K(1.0f), gain(0));
+    EXPECT_EQ(lqr.K(2.0f), gain(1));
+    EXPECT_EQ(lqr.K(3.0f), gain(2));
+}
+
+TEST(ScheduledLqr, interpolation) {
+    lqr_t lqr(gains, 1.0f, 3.0f);
+    EXPECT_TRUE(lqr.K(1.5f).isApprox(0.5f*(gain(0) + gain(1))));
+    EXPECT_TRUE(lqr.K(2.25f).isApprox(0.75f*gain(1) + 0.25f*gain(2)));
+}
+
+TEST(ScheduledLqr, clamp) {
+    lqr_t lqr(gains, 1.0f, 3.0f);
+    EXPECT_EQ(lqr.K(0.0f), gain(0));
+    EXPECT_EQ(lqr.K(-1.0f), gain(0));
+    EXPECT_EQ(lqr.K(10.0f), gain(2));
+}
+
+TEST(ScheduledLqr, control_calculate) {
+    lqr_t lqr(gains, 1.0f, 3.0f);
+    model_t::state_t x;
+    x << 0.1f, 0.2f, -0.3f, 0.4f, 0.5f;
+    const model_t::input_t u = lqr.control_calculate(x, 2.5f);
+    EXPECT_TRUE(u.isApprox(lqr.K(2.5f)*x));
+    EXPECT_EQ(lqr.control_calculate(x, 2.5f), u); // cached gain
+}
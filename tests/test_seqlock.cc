@@ -0,0 +1,134 @@
+#include "seqlock.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+A value large enough that a copy is not a single load or store. Every element
+is written with the same count so a torn copy contains different elements.
+*/
+struct Snapshot {
+    std::array<uint32_t, 32> count;
+};
+
+Snapshot make_snapshot(uint32_t count) {
+    Snapshot s;
+    s.count.fill(count);
+    return s;
+}
+
+bool is_consistent(const Snapshot& s) {
+    for (auto c: s.count) {
+        if (c != s.count[0]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(seqlock, read_initial_value) {
+    Seqlock<Snapshot> lock(make_snapshot(7));
+    const Snapshot s = lock.read();
+    EXPECT_TRUE(is_consistent(s));
+    EXPECT_EQ(s.count[0], 7U);
+    EXPECT_EQ(lock.sequence(), 0U);
+}
+
+TEST(seqlock, read_after_write) {
+    Seqlock<Snapshot> lock;
+    lock.write(make_snapshot(1));
+    lock.write(make_snapshot(2));
+
+    Snapshot s = make_snapshot(0);
+    ASSERT_TRUE(lock.try_read(s));
+    EXPECT_TRUE(is_consistent(s));
+    EXPECT_EQ(s.count[0], 2U);
+    EXPECT_EQ(lock.sequence(), 4U);
+}
+
+TEST(seqlock, no_torn_read_with_concurrent_writer) {
+    constexpr uint32_t write_count = 200000;
+    constexpr size_t reader_count = 3;
+
+    Seqlock<Snapshot> lock(make_snapshot(0));
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> torn_reads(0);
+    std::atomic<uint32_t> out_of_order_reads(0);
+    std::atomic<uint32_t> reads(0);
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < reader_count; ++i) {
+        readers.emplace_back([&]() {
+            uint32_t previous = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const Snapshot s = lock.read();
+                if (!is_consistent(s)) {
+                    ++torn_reads;
+                }
+                if (s.count[0] < previous) {
+                    ++out_of_order_reads;
+                }
+                previous = s.count[0];
+                ++reads;
+            }
+        });
+    }
+
+    std::thread writer([&]() {
+        for (uint32_t count = 1; count <= write_count; ++count) {
+            lock.write(make_snapshot(count));
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    writer.join();
+    for (auto& reader: readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(torn_reads.load(), 0U);
+    EXPECT_EQ(out_of_order_reads.load(), 0U);
+    EXPECT_GT(reads.load(), 0U);
+    EXPECT_EQ(lock.read().count[0], write_count);
+    EXPECT_EQ(lock.sequence(), 2*write_count);
+}
+
+TEST(seqlock, try_read_never_returns_torn_value) {
+    constexpr uint32_t write_count = 200000;
+
+    Seqlock<Snapshot> lock(make_snapshot(0));
+    std::atomic<bool> done(false);
+    uint32_t torn_reads = 0;
+    uint32_t failed_reads = 0;
+
+    std::thread writer([&]() {
+        for (uint32_t count = 1; count <= write_count; ++count) {
+            lock.write(make_snapshot(count));
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    Snapshot s = make_snapshot(0);
+    while (!done.load(std::memory_order_acquire)) {
+        if (lock.try_read(s)) {
+            if (!is_consistent(s)) {
+                ++torn_reads;
+            }
+        } else {
+            ++failed_reads;
+        }
+    }
+    writer.join();
+
+    EXPECT_EQ(torn_reads, 0U);
+    // A failed read must leave the output untouched, the last successful
+    // read is still consistent.
+    EXPECT_TRUE(is_consistent(s));
+    (void)failed_reads;
+}
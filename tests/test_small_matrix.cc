@@ -0,0 +1,81 @@
+#include "smallmatrix.h"
+#include "bicycle/whipple.h"
+#include "parameters.h"
+#include "gtest/gtest.h"
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using real_t = model::real_t;
+    using matrix_t = model_t::state_matrix_t;
+    namespace sm = util::smallmatrix;
+
+    constexpr real_t dt = 0.001;
+    constexpr real_t tolerance = 1e-6;
+
+    template <typename M>
+    real_t max_relative_difference(const M& a, const M& b) {
+        return (a - b).cwiseAbs().maxCoeff()/b.cwiseAbs().maxCoeff();
+    }
+
+    class SmallMatrixTest: public ::testing::TestWithParam<real_t> {
+        public:
+            SmallMatrixTest() : model(GetParam(), dt) {
+                x << 0.1, 0.2, -0.1, 0.3, 0.4;
+                u << 0.5, -0.5;
+                const matrix_t M = matrix_t::Random();
+                P = M*M.transpose() + matrix_t::Identity();
+                Q = parameters::defaultvalue::kalman::Q(dt);
+            }
+
+        protected:
+            model_t model;
+            model_t::state_t x;
+            model_t::input_t u;
+            matrix_t P;
+            matrix_t Q;
+    };
+} // namespace
+
+TEST_P(SmallMatrixTest, multiply_vector) {
+    const model_t::state_t y = model.Ad()*x;
+    EXPECT_LT(max_relative_difference(sm::unrolled::multiply(model.Ad(), x), y), tolerance);
+    EXPECT_LT(max_relative_difference(sm::multiply(model.Ad(), x), y), tolerance);
+
+    const model_t::output_t z = model.Cd()*x;
+    EXPECT_LT(max_relative_difference(sm::unrolled::multiply(model.Cd(), x), z), tolerance);
+}
+
+TEST_P(SmallMatrixTest, multiply_add) {
+    const model_t::state_t y = model.Ad()*x + model.Bd()*u;
+    EXPECT_LT(max_relative_difference(
+                sm::unrolled::multiply_add(model.Ad(), x, model.Bd(), u), y), tolerance);
+    EXPECT_LT(max_relative_difference(
+                sm::multiply_add(model.Ad(), x, model.Bd(), u), y), tolerance);
+}
+
+TEST_P(SmallMatrixTest, multiply_matrix) {
+    const matrix_t AP = model.Ad()*P;
+    EXPECT_LT(max_relative_difference(sm::unrolled::multiply(model.Ad(), P), AP), tolerance);
+    EXPECT_LT(max_relative_difference(sm::multiply(model.Ad(), P), AP), tolerance);
+}
+
+TEST_P(SmallMatrixTest, symmetric_update) {
+    const matrix_t S = model.Ad()*P*model.Ad().transpose() + Q;
+    const matrix_t S_unrolled = sm::unrolled::symmetric_update(model.Ad(), P, Q);
+    EXPECT_LT(max_relative_difference(S_unrolled, S), tolerance);
+    EXPECT_EQ(S_unrolled, S_unrolled.transpose());
+    EXPECT_LT(max_relative_difference(sm::symmetric_update(model.Ad(), P, Q), S), tolerance);
+}
+
+TEST_P(SmallMatrixTest, row_dot) {
+    for (int i = 0; i < static_cast<int>(model_t::n); ++i) {
+        const real_t a = (model.A().row(i)*x).value();
+        EXPECT_NEAR(sm::unrolled::row_dot(model.A(), i, x), a, tolerance*std::abs(a));
+        EXPECT_NEAR(sm::row_dot(model.A(), i, x), a, tolerance*std::abs(a));
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(
+    MultipleSpeeds,
+    SmallMatrixTest,
+    ::testing::Values(0.5, 4.0, 8.0));
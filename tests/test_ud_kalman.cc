@@ -0,0 +1,131 @@
+#include "udkalman.h"
+#include "modelcache.h"
+#include "bicycle/whipple.h"
+#include "kalman.h"
+#include "parameters.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <random>
+
+namespace {
+    using model_t = model::BicycleWhipple;
+    using kalman_t = observer::Kalman<model_t>;
+    using observer_t = sim::UdKalman<model_t>;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001;
+
+    kalman_t::process_noise_covariance_t Q() {
+        return parameters::defaultvalue::kalman::Q(dt);
+    }
+
+    kalman_t::measurement_noise_covariance_t R() {
+        return parameters::defaultvalue::kalman::R/1000;
+    }
+
+    template <typename M>
+    real_t max_relative_difference(const M& a, const M& b) {
+        return (a - b).cwiseAbs().maxCoeff()/b.cwiseAbs().maxCoeff();
+    }
+
+    class UdKalmanTest: public ::testing::Test {
+        public:
+            UdKalmanTest() : model(3.0, dt), kalman(model), observer(model), gen(0), noise(0, 1e-3) {
+                kalman.set_Q(Q());
+                kalman.set_R(R());
+                observer.set_Q(Q());
+                observer.set_R(R());
+                x = model_t::state_t::Zero();
+                model_t::set_state_element(x, model_t::state_index_t::roll_angle, 0.05f);
+                model_t::set_state_element(x, model_t::state_index_t::steer_angle, 0.1f);
+            }
+
+        protected:
+            model_t model;
+            kalman_t kalman;
+            observer_t observer;
+            model_t::state_t x;
+            std::mt19937 gen;
+            std::normal_distribution<real_t> noise;
+
+            model_t::measurement_t simulate(const model_t::input_t& u) {
+                x = model.update_state(x, u);
+                model_t::measurement_t z = model.calculate_output(x);
+                z[0] += noise(gen);
+                z[1] += noise(gen);
+                return z;
+            }
+    };
+} // namespace
+
+TEST_F(UdKalmanTest, factor) {
+    const kalman_t::error_covariance_t A = kalman_t::error_covariance_t::Random();
+    const kalman_t::error_covariance_t P = A*A.transpose() +
+        kalman_t::error_covariance_t::Identity();
+    observer.set_P(P);
+    EXPECT_LT(max_relative_difference(observer.P(), P), 1e-5);
+    EXPECT_TRUE(observer.U().isUpperTriangular());
+    EXPECT_TRUE(observer.U().diagonal().isOnes());
+}
+
+TEST_F(UdKalmanTest, matches_kalman) {
+    const model_t::input_t u = model_t::input_t::Zero();
+    for (int i = 0; i < 1000; ++i) {
+        const model_t::measurement_t z = simulate(u);
+        kalman.update_state(u, z);
+        observer.update_state(u, z);
+    }
+    EXPECT_LT(max_relative_difference(observer.x(), kalman.x()), 1e-3);
+    EXPECT_LT(max_relative_difference(observer.K(), kalman.K()), 1e-3);
+    EXPECT_LT(max_relative_difference(observer.P(), kalman.P()), 1e-2);
+}
+
+TEST_F(UdKalmanTest, matches_kalman_correlated_measurement_noise) {
+    kalman_t::measurement_noise_covariance_t Rc = R();
+    Rc(0, 1) = Rc(1, 0) = 0.5f*std::sqrt(Rc(0, 0)*Rc(1, 1));
+    kalman.set_R(Rc);
+    observer.set_R(Rc);
+
+    const model_t::input_t u = model_t::input_t::Zero();
+    for (int i = 0; i < 1000; ++i) {
+        const model_t::measurement_t z = simulate(u);
+        kalman.update_state(u, z);
+        observer.update_state(u, z);
+    }
+    EXPECT_LT(max_relative_difference(observer.x(), kalman.x()), 1e-3);
+    EXPECT_LT(max_relative_difference(observer.K(), kalman.K()), 1e-3);
+}
+
+TEST_F(UdKalmanTest, long_run_stability) {
+    // Run for 20 minutes of simulated time at 1 kHz while the speed changes
+    // every second. The factored error covariance must remain positive
+    // definite and the state estimate must keep tracking the measurements of
+    // a bicycle weaving from side to side. The state estimate and error
+    // covariance are compared with those of observer::Kalman, which uses the
+    // same model, every simulated minute.
+    constexpr size_t cache_size = 61;
+    const sim::ModelCache<model_t, cache_size> cache(model_t(0.0, dt), 0.0, 0.1);
+    std::uniform_int_distribution<size_t> speed_index(0, cache_size - 1);
+
+    const model_t::input_t u = model_t::input_t::Zero();
+    model_t::measurement_t z;
+    for (int i = 0; i < 1200000; ++i) {
+        if (i % 1000 == 0) {
+            model = cache.model(speed_index(gen));
+        }
+        const real_t t = static_cast<real_t>(i)*dt;
+        z << 0.2f*std::sin(0.5f*t) + noise(gen),
+             0.1f*std::sin(2.0f*t) + noise(gen);
+        kalman.update_state(u, z);
+        observer.update_state(u, z);
+
+        ASSERT_TRUE((observer.D().array() > 0).all()) << "at iteration " << i;
+        ASSERT_TRUE(observer.x().allFinite()) << "at iteration " << i;
+        if (i % 60000 == 59999) {
+            ASSERT_LT(max_relative_difference(observer.x(), kalman.x()), 1e-3) << "at iteration " << i;
+            ASSERT_LT(max_relative_difference(observer.P(), kalman.P()), 1e-2) << "at iteration " << i;
+        }
+    }
+    EXPECT_NEAR(model_t::get_state_element(observer.x(), model_t::state_index_t::steer_angle),
+                model_t::get_output_element(z, model_t::output_index_t::steer_angle), 1e-2);
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/LU>
+#include "bicycle/whipple.h"
+
+namespace {
+
+    using model_t = model::BicycleWhipple;
+
+    // The yaw angle is neither controllable nor part of the cost and is
+    // excluded from the Riccati equation. Its feedback gain is zero.
+    constexpr unsigned int n = model_t::n - 1;
+    constexpr unsigned int m = model_t::m;
+    static_assert(static_cast<unsigned int>(model_t::state_index_t::yaw_angle) == 0,
+            "Yaw angle must be the first state element");
+
+    using state_matrix_t = Eigen::Matrix<double, n, n>;
+    using input_matrix_t = Eigen::Matrix<double, n, m>;
+    using input_cost_t = Eigen::Matrix<double, m, m>;
+    using state_weight_t = Eigen::Matrix<double, n, 1>;
+    using input_weight_t = Eigen::Matrix<double, m, 1>;
+    using feedback_gain_t = Eigen::Matrix<double, m, model_t::n>;
+
+    // Default weights, identical to scripts/calculate_lqr_gain.py.
+    const state_weight_t default_q = (state_weight_t() << 1e5, 1e3, 1e3, 1e2).finished();
+    const input_weight_t default_r = input_weight_t::Ones();
+    constexpr double default_dt = 0.001; // flimnap dynamics loop period [s]
+
+    struct problem_t {
+        double v_max;
+        size_t size;
+        double dt;
+        state_weight_t q;
+        input_weight_t r;
+    };
+
+    double velocity(const problem_t& p, size_t i) {
+        return p.v_max*static_cast<double>(i)/static_cast<double>(p.size - 1);
+    }
+
+    // Solve the control DARE
+    //     P = Ad' P Ad - Ad' P Bd (Bd' P Bd + R)^-1 Bd' P Ad + Q
+    // with a doubling iteration and return the feedback gain u = K x.
+    // The weights are scaled by the sample period so that the cost
+    // approximates that of the continuous-time LQR.
+    feedback_gain_t solve_dlqr(const problem_t& p, double v) {
+        static constexpr unsigned int max_iterations = 64;
+        static constexpr double tolerance = 1e-12;
+
+        const model_t model(static_cast<model::real_t>(v), static_cast<model::real_t>(p.dt));
+        const state_matrix_t Ad = model.Ad().bottomRightCorner<n, n>().cast<double>();
+        const input_matrix_t Bd = model.Bd().bottomRows<n>().cast<double>();
+        const state_matrix_t Q = (p.q*p.dt).asDiagonal();
+        const input_cost_t R = (p.r*p.dt).asDiagonal();
+
+        // A_0 = Ad, G_0 = Bd R^-1 Bd', H_0 = Q. H_k converges to P.
+        state_matrix_t A = Ad;
+        state_matrix_t G = Bd*R.inverse()*Bd.transpose();
+        state_matrix_t H = Q;
+        for (unsigned int k = 0; k < max_iterations; ++k) {
+            const Eigen::PartialPivLU<state_matrix_t> W(state_matrix_t::Identity() + G*H);
+            const state_matrix_t WA = W.solve(A);
+            const state_matrix_t WG = W.solve(G);
+            const state_matrix_t H_next = H + A.transpose()*H*WA;
+            G += A*WG*A.transpose();
+            A = A*WA;
+
+            const double delta = (H_next - H).cwiseAbs().maxCoeff();
+            H = H_next;
+            if (delta <= tolerance*H.cwiseAbs().maxCoeff()) {
+                break;
+            }
+        }
+        H = (H + H.transpose())/2;
+
+        const input_cost_t S = Bd.transpose()*H*Bd + R;
+        feedback_gain_t K = feedback_gain_t::Zero();
+        K.rightCols<n>() = -S.inverse()*Bd.transpose()*H*Ad;
+        return K;
+    }
+
+    // Solve for all velocities, distributing velocities over threads.
+    std::vector<feedback_gain_t> solve_table(const problem_t& p) {
+        std::vector<feedback_gain_t> gains(p.size);
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < p.size; i = next++) {
+                gains[i] = solve_dlqr(p, velocity(p, i));
+            }
+        };
+
+        const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < std::min(num_threads, p.size); ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& t: threads) {
+            t.join();
+        }
+        return gains;
+    }
+
+    void print_header(const problem_t& p, const std::vector<feedback_gain_t>& gains,
+            int argc, char* argv[]) {
+        std::printf("#pragma once\n");
+        std::printf("#include <cstddef>\n\n");
+        std::printf("/*\n");
+        std::printf(" * Whipple bicycle model LQR feedback gains for uniformly spaced velocities.\n");
+        std::printf(" * Sample period %g s, state weights [%g, %g, %g, %g], input weights [%g, %g].\n",
+                p.dt, p.q[0], p.q[1], p.q[2], p.q[3], p.r[0], p.r[1]);
+        std::printf(" * Generated with:\n");
+        std::printf(" *     tools/lqrgain");
+        for (int i = 1; i < argc; ++i) {
+            std::printf(" %s", argv[i]);
+        }
+        std::printf("\n */\n");
+        std::printf("namespace lqr_gain {\n\n");
+        std::printf("constexpr float v_min = 0.0f; // m/s\n");
+        std::printf("constexpr float v_max = %.1ff; // m/s\n", p.v_max);
+        std::printf("constexpr size_t size = %zu;\n\n", p.size);
+        std::printf("constexpr float K[size][%u] = {\n", m*model_t::n);
+        for (size_t i = 0; i < p.size; ++i) {
+            for (unsigned int r = 0; r < m; ++r) {
+                std::printf(r == 0 ? "    {" : "     ");
+                for (unsigned int c = 0; c < model_t::n; ++c) {
+                    if (c == 0) {
+                        std::printf("0");
+                    } else {
+                        std::printf(", %.8f", gains[i](r, c));
+                    }
+                }
+                if (r == 0) {
+                    std::printf(", // v = %.2f\n", velocity(p, i));
+                } else {
+                    std::printf("},\n");
+                }
+            }
+        }
+        std::printf("};\n\n");
+        std::printf("} // namespace lqr_gain\n");
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if ((argc != 3) && (argc != 4) && (argc != 10)) {
+        std::cerr << "Usage: " << argv[0] << " <v_max> <size> [<dt> [<q0> <q1> <q2> <q3> <r0> <r1>]]\n\n"
+            << "Calculate discrete-time LQR feedback gains of the Whipple bicycle model for\n"
+            << "uniformly spaced velocities and print a C++ header with the gain table.\n"
+            << " <v_max>              maximum velocity [m/s], the minimum velocity is 0\n"
+            << " <size>               number of velocities, at least 2\n"
+            << " <dt=0.001>           sample period [s]\n"
+            << " <q0> ... <q3>        state weights (roll, steer, roll rate, steer rate),\n"
+            << "                      default 1e5 1e3 1e3 1e2\n"
+            << " <r0> <r1>            input weights (roll torque, steer torque), default 1 1\n\n"
+            << "Velocities are solved in parallel on all hardware threads.\n"
+            << "Example:\n"
+            << "  $ ./lqrgain 8 81 > ../projects/flimnap/lqr_gain.h\n";
+        return EXIT_FAILURE;
+    }
+
+    problem_t p;
+    p.v_max = std::atof(argv[1]);
+    p.size = std::strtoul(argv[2], nullptr, 10);
+    p.dt = (argc > 3) ? std::atof(argv[3]) : default_dt;
+    p.q = default_q;
+    p.r = default_r;
+    if (argc == 10) {
+        for (unsigned int i = 0; i < n; ++i) {
+            p.q[i] = std::atof(argv[4 + i]);
+        }
+        for (unsigned int i = 0; i < m; ++i) {
+            p.r[i] = std::atof(argv[4 + n + i]);
+        }
+    }
+    if ((p.size < 2) || !(p.v_max > 0) || !(p.dt > 0)) {
+        std::cerr << "Invalid velocity range or sample period.\n";
+        return EXIT_FAILURE;
+    }
+
+    print_header(p, solve_table(p), argc, argv);
+    return EXIT_SUCCESS;
+}
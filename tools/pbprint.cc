@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
@@ -8,6 +9,7 @@
 #include <asio/signal_set.hpp>
 #include <google/protobuf/io/coded_stream.h>
 #include "cobs.h"
+#include "histogram.h"
 #include "pose.pb.h"
 #include "simulation.pb.h"
 
@@ -18,6 +20,7 @@ namespace {
     asio::io_service io_service;
     asio::serial_port port(io_service);
     std::ifstream* input_file = nullptr;
+    bool print_timing = false;
 
     // serial port
     //   --[read]--> serial_buffer
@@ -47,6 +50,44 @@ namespace {
         }
     }
 
+    void print_histogram(const char* loop, const char* name, const HistogramMessage& h) {
+        const uint32_t* counts = h.count().data();
+        const size_t n = h.count_size();
+        uint64_t total = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total += counts[i];
+        }
+        std::printf("%-10s %-14s %10llu %8u %8u %8u\n", loop, name,
+                static_cast<unsigned long long>(total),
+                util::histogram_quantile(counts, n, h.bucket_width(), h.max(), 0.50),
+                util::histogram_quantile(counts, n, h.bucket_width(), h.max(), 0.99),
+                h.max());
+    }
+
+    void print_loop_timing(const char* loop, const LoopTimingMessage& t) {
+        print_histogram(loop, "start_jitter", t.start_jitter());
+        print_histogram(loop, "execution", t.execution());
+        print_histogram(loop, "transmission", t.transmission());
+        std::printf("%-10s releases %u, deadline misses %u, skipped releases %u\n",
+                loop, t.releases(), t.deadline_misses(), t.skipped_releases());
+    }
+
+    // Print the quantiles of the loop timing telemetry. Values are upper
+    // bounds with the resolution of the histogram buckets, except the maximum.
+    void print_telemetry(const SimulationMessage& msg) {
+        std::printf("timestamp %u\n", msg.timestamp());
+        std::printf("%-10s %-14s %10s %8s %8s %8s\n",
+                "loop", "[us]", "count", "p50", "p99", "max");
+        if (msg.telemetry().has_dynamics()) {
+            print_loop_timing("dynamics", msg.telemetry().dynamics());
+        }
+        if (msg.telemetry().has_pose()) {
+            print_loop_timing("pose", msg.telemetry().pose());
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
     void deserialize_packet(const uint8_t * const packet_buffer_start, const size_t packet_buffer_length) {
         google::protobuf::io::CodedInputStream input(
             packet_buffer_start,
@@ -70,7 +111,11 @@ namespace {
             exit(EXIT_FAILURE);
         }
 
-        msg.PrintDebugString();
+        if (!print_timing) {
+            msg.PrintDebugString();
+        } else if (msg.has_telemetry()) {
+            print_telemetry(msg);
+        }
     }
 
     void handle_read(const asio::error_code& error, size_t serial_buffer_write_count) {
@@ -160,9 +205,18 @@ namespace {
 int main(int argc, char* argv[]) {
     GOOGLE_PROTOBUF_VERIFY_VERSION;
 
+    const char* program = argv[0];
+    if ((argc > 1) && (std::strcmp(argv[1], "--timing") == 0)) {
+        print_timing = true;
+        --argc;
+        ++argv;
+    }
+
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <serial_device> [<baud_rate>]\n\n"
+        std::cerr << "Usage: " << program << " [--timing] <serial_device> [<baud_rate>]\n\n"
             << "Decode streaming serialized simulation protobuf messages.\n"
+            << " --timing             print only the p50, p99 and maximum of the loop\n"
+            << "                      timing telemetry histograms\n"
             << " <serial_device>      device or file from which to read serial data\n"
             << " <baud_rate=115200>   serial baud rate\n"
 
@@ -0,0 +1,90 @@
+#include "posepredictor.h"
+#include <algorithm>
+#include <cmath>
+#include "fastmath.h"
+
+namespace pose {
+
+namespace {
+    // sin(x)/x, with the series expansion near zero
+    double sinc(double x) {
+        if (std::abs(x) < 1e-4) {
+            return 1.0 - x*x/6.0;
+        }
+        return std::sin(x)/x;
+    }
+} // namespace
+
+constexpr Predictor::config_t Predictor::default_config;
+
+Predictor::Predictor(const config_t& config) :
+    m_config(config),
+    m_pose(),
+    m_valid(false),
+    m_timestamp(0),
+    m_ticks(0),
+    m_clock_offset(0.0) { }
+
+void Predictor::update(const pose_t& pose, uint32_t timestamp, double receive_time) {
+    if (m_valid) {
+        // unwrap the 32-bit timestamp, messages are received in order
+        m_ticks += static_cast<uint32_t>(timestamp - m_timestamp);
+    } else {
+        m_ticks = timestamp;
+    }
+    const double firmware_time = static_cast<double>(m_ticks)/m_config.tick_frequency;
+    const double offset = receive_time - firmware_time - m_config.link_delay;
+
+    if (!m_valid) {
+        m_clock_offset = offset;
+    } else {
+        const double elapsed = static_cast<double>(static_cast<uint32_t>(timestamp - m_timestamp))/
+            m_config.tick_frequency;
+        m_clock_offset = std::min(offset, m_clock_offset + m_config.clock_drift*elapsed);
+    }
+    m_pose = pose;
+    m_timestamp = timestamp;
+    m_valid = true;
+}
+
+void Predictor::reset() {
+    m_valid = false;
+}
+
+bool Predictor::valid() const {
+    return m_valid;
+}
+
+pose_t Predictor::predict(double render_time) const {
+    const double h = horizon(render_time);
+    pose_t p = m_pose;
+
+    // rear contact point along an arc, with the chord at the mean yaw angle
+    const double dyaw = m_pose.yaw_rate*h;
+    const double chord = m_pose.v*h*sinc(dyaw/2);
+    p.x += chord*std::cos(m_pose.yaw + dyaw/2);
+    p.y += chord*std::sin(m_pose.yaw + dyaw/2);
+    p.yaw += dyaw;
+    p.roll += m_pose.roll_rate*h;
+    p.steer += m_pose.steer_rate*h;
+    // wrapped to [-pi, pi) as in the firmware
+    p.rear_wheel = util::fastmath::wrap(m_pose.rear_wheel + m_pose.rear_wheel_rate*h);
+    return p;
+}
+
+double Predictor::pose_time() const {
+    return static_cast<double>(m_ticks)/m_config.tick_frequency + m_clock_offset;
+}
+
+double Predictor::horizon(double render_time) const {
+    if (!m_valid) {
+        return 0.0;
+    }
+    return std::min(std::max(render_time - pose_time(), 0.0), m_config.max_horizon);
+}
+
+double Predictor::clock_offset() const {
+    return m_clock_offset;
+}
+
+} // namespace pose
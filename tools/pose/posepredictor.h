@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+
+namespace pose {
+
+/*
+ * Bicycle pose as transmitted in BicyclePoseMessage, with the rates at the
+ * time of the pose. Rates are zero if they are not transmitted.
+ */
+struct pose_t {
+    double x;
+    double y;
+    double yaw;
+    double roll;
+    double pitch;
+    double steer;
+    double rear_wheel;
+    double yaw_rate;
+    double roll_rate;
+    double steer_rate;
+    double rear_wheel_rate;
+    double v; // forward speed
+};
+
+/*
+ * This class predicts the bicycle pose at a render time from the most
+ * recently received pose message, for a display running at a different rate
+ * than the firmware pose loop.
+ *
+ * Times are host times in seconds, as given by the caller. The host time of
+ * a pose is determined from the firmware timestamp and the clock offset
+ * between firmware and host. The offset is estimated as the minimum of the
+ * receive time minus the timestamp, which is attained by the message with the
+ * shortest transport delay, minus the measured (minimum) link delay. The
+ * estimate may increase by clock_drift per second of firmware time so that a
+ * slower firmware clock is followed.
+ *
+ * The pose is extrapolated with constant rates over the prediction horizon,
+ * the time from the pose to the render time limited to max_horizon. The rear
+ * contact point moves along a circular arc with constant speed and yaw rate
+ * and the pitch angle is held.
+ */
+class Predictor {
+    public:
+        struct config_t {
+            double tick_frequency; // firmware system tick frequency [Hz]
+            double link_delay; // minimum transport delay from firmware to host [s]
+            double max_horizon; // maximum prediction horizon [s]
+            double clock_drift; // maximum drift of the firmware clock [s/s]
+        };
+        static constexpr config_t default_config = {100000.0, 0.001, 0.05, 1e-4};
+
+        explicit Predictor(const config_t& config = default_config);
+
+        void update(const pose_t& pose, uint32_t timestamp, double receive_time);
+        void reset(); // forget received poses and the clock offset estimate
+
+        bool valid() const; // a pose has been received
+        pose_t predict(double render_time) const;
+        double pose_time() const; // host time of the most recent pose
+        double horizon(double render_time) const; // prediction horizon at render_time
+        double clock_offset() const; // host time minus firmware time
+
+        // pose from a message of the C++ protobuf generated BicyclePoseMessage
+        template <typename Message>
+        static pose_t make_pose(const Message& msg);
+
+    private:
+        config_t m_config;
+        pose_t m_pose;
+        bool m_valid;
+        uint32_t m_timestamp; // most recent timestamp
+        uint64_t m_ticks; // unwrapped firmware time of m_timestamp
+        double m_clock_offset;
+};
+
+template <typename Message>
+pose_t Predictor::make_pose(const Message& msg) {
+    return pose_t{
+        msg.x(), msg.y(), msg.yaw(), msg.roll(), msg.pitch(), msg.steer(), msg.rear_wheel(),
+        msg.has_yaw_rate() ? msg.yaw_rate() : 0.0,
+        msg.has_roll_rate() ? msg.roll_rate() : 0.0,
+        msg.has_steer_rate() ? msg.steer_rate() : 0.0,
+        msg.has_rear_wheel_rate() ? msg.rear_wheel_rate() : 0.0,
+        msg.has_v() ? msg.v() : 0.0
+    };
+}
+
+} // namespace pose
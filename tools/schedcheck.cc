@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "schedule.h"
+
+namespace {
+    // parse <name>:<period>:<wcet>
+    bool parse_task(char* arg, rt::task_timing_t* task) {
+        char* period = std::strchr(arg, ':');
+        if (period == nullptr) {
+            return false;
+        }
+        char* wcet = std::strchr(period + 1, ':');
+        if (wcet == nullptr) {
+            return false;
+        }
+        *period++ = '\0';
+        *wcet++ = '\0';
+        char* end;
+        task->name = arg;
+        task->period = std::strtoul(period, &end, 10);
+        if ((*end != '\0') || (task->period == 0)) {
+            return false;
+        }
+        task->wcet = std::strtoul(wcet, &end, 10);
+        return *end == '\0';
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <name>:<period>:<wcet> [<name>:<period>:<wcet> ...]\n\n"
+            << "Check if periodic tasks with rate-monotonic priorities meet their deadlines\n"
+            << "with exact response time analysis. Periods and worst-case execution times\n"
+            << "(e.g. measured with rt::PeriodicTask) are integers in a common time unit.\n"
+            << "Returns a nonzero exit status if a task misses its deadline.\n"
+            << "Example:\n"
+            << "  $ ./schedcheck dynamics:1000:420 pose:8333:1200\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<rt::task_timing_t> tasks(argc - 1);
+    for (int i = 1; i < argc; ++i) {
+        if (!parse_task(argv[i], &tasks[i - 1])) {
+            std::cerr << "Invalid task: " << argv[i] << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<uint32_t> response_time(tasks.size());
+    const bool schedulable = rt::response_times(tasks.data(), tasks.size(), response_time.data());
+    const double u = rt::utilization(tasks.data(), tasks.size());
+    const double bound = rt::utilization_bound(tasks.size());
+
+    std::printf("%-16s %8s %10s %10s %10s %12s\n",
+            "task", "priority", "period", "wcet", "response", "utilization");
+    for (size_t rank = 0; rank < tasks.size(); ++rank) {
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            if (rt::rate_monotonic_rank(tasks.data(), tasks.size(), i) != rank) {
+                continue;
+            }
+            const rt::task_timing_t& t = tasks[i];
+            std::printf("%-16s %8zu %10u %10u %10s %12.3f\n", t.name, rank, t.period, t.wcet,
+                    (response_time[i] <= t.period) ?
+                        std::to_string(response_time[i]).c_str() : "miss",
+                    static_cast<double>(t.wcet)/t.period);
+        }
+    }
+    std::printf("\ntotal utilization %.3f, Liu and Layland bound %.3f\n", u, bound);
+    std::printf("%s\n", schedulable ? "schedulable" : "not schedulable");
+    return schedulable ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+#include "modelcache.h"
+#include "scheduled_lqr.h"
+#include "simbicycle.h"
+#include "lqr_gain.h" // flimnap LQR feedback gain table
+#include "parallel.h"
+// bicycle submodule imports
+#include "bicycle/whipple.h"
+#include "kalman.h"
+#include "parameters.h"
+
+namespace {
+
+    using model_t = model::BicycleWhipple;
+    using observer_t = observer::Kalman<model_t>;
+    using bicycle_t = sim::Bicycle<model_t, observer_t>;
+    using lqr_t = controller::ScheduledLqr<model_t, lqr_gain::size>;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = 0.001; // flimnap dynamics loop period [s]
+    constexpr real_t fallen_roll_angle = 60.0f*constants::as_radians;
+    constexpr real_t settled_roll_angle = 1.0f*constants::as_radians;
+
+    // Bicycle models discretized for each quantized speed in [0, 8] m/s and
+    // shared by all scenarios.
+    constexpr size_t model_cache_size = 81;
+
+    /*
+     * Scenario parameters. The bicycle starts with an initial roll and steer
+     * angle, the speed changes linearly from v0 to v1 and a roll and steer
+     * torque disturbance pulse is applied at disturbance_time.
+     */
+    struct scenario_t {
+        uint32_t seed; // measurement noise seed
+        real_t v0; // m/s
+        real_t v1; // m/s
+        real_t roll_angle; // rad
+        real_t steer_angle; // rad
+        real_t roll_torque_disturbance; // N-m
+        real_t steer_torque_disturbance; // N-m
+        real_t disturbance_time; // s
+        real_t disturbance_duration; // s
+        real_t steer_measurement_noise; // rad, standard deviation
+    };
+
+    struct result_t {
+        bool fallen; // roll angle exceeded fallen_roll_angle or state not finite
+        real_t max_roll_angle; // rad, absolute value
+        real_t settle_time; // s, after which roll stays below settled_roll_angle, NaN if not settled
+        real_t rms_roll_angle; // rad
+        real_t rms_estimate_error; // rad, roll angle estimate error
+    };
+
+    scenario_t generate_scenario(uint32_t seed, size_t index) {
+        std::mt19937 gen(seed + static_cast<uint32_t>(index)*0x9e3779b9u);
+        std::uniform_real_distribution<real_t> speed(0.0f, 7.0f);
+        std::uniform_real_distribution<real_t> angle(-5.0f*constants::as_radians,
+                                                     5.0f*constants::as_radians);
+        std::normal_distribution<real_t> roll_torque(0.0f, 20.0f);
+        std::normal_distribution<real_t> steer_torque(0.0f, 2.0f);
+        std::uniform_real_distribution<real_t> time(0.5f, 2.0f);
+        std::uniform_real_distribution<real_t> noise(0.0f, 0.5f*constants::as_radians);
+
+        scenario_t s;
+        s.seed = gen();
+        s.v0 = speed(gen);
+        s.v1 = speed(gen);
+        s.roll_angle = angle(gen);
+        s.steer_angle = angle(gen);
+        s.roll_torque_disturbance = roll_torque(gen);
+        s.steer_torque_disturbance = steer_torque(gen);
+        s.disturbance_time = time(gen);
+        s.disturbance_duration = 0.1f;
+        s.steer_measurement_noise = noise(gen);
+        return s;
+    }
+
+    /*
+     * Simulate a scenario as in the flimnap dynamics loop. The bicycle
+     * (sim::Bicycle) estimates the state from noisy measurements of a
+     * separately simulated bicycle. Roll and steer torque assistance is
+     * calculated from the state estimate for speeds below
+     * assistance_velocity_limit.
+     */
+    result_t simulate(const scenario_t& s, real_t duration, real_t assistance_velocity_limit,
+            const sim::ModelCache<model_t, model_cache_size>& cache) {
+        bicycle_t bicycle(s.v0, dt);
+        bicycle.set_model_cache(&cache);
+        bicycle.set_v(s.v0);
+        observer_t& observer = bicycle.observer();
+        observer.set_Q(parameters::defaultvalue::kalman::Q(dt));
+        observer.set_R(parameters::defaultvalue::kalman::R/1000);
+        bicycle.prime_observer();
+
+        lqr_t lqr(lqr_gain::K, lqr_gain::v_min, lqr_gain::v_max);
+        std::mt19937 gen(s.seed);
+        std::normal_distribution<real_t> steer_noise(0.0f, s.steer_measurement_noise);
+
+        model_t::state_t x = model_t::state_t::Zero();
+        model_t::set_state_element(x, model_t::state_index_t::roll_angle, s.roll_angle);
+        model_t::set_state_element(x, model_t::state_index_t::steer_angle, s.steer_angle);
+        model_t::state_t x0 = model_t::state_t::Zero();
+        model_t::set_state_element(x0, model_t::state_index_t::steer_angle, s.steer_angle);
+        observer.set_x(x0);
+
+        result_t r = {false, 0.0f, 0.0f, 0.0f, 0.0f};
+        const size_t num_steps = static_cast<size_t>(duration/dt);
+        double roll_sum = 0.0;
+        double error_sum = 0.0;
+        size_t step = 0;
+        try {
+            for (; step < num_steps; ++step) {
+                const real_t t = step*dt;
+                bicycle.set_v(s.v0 + (s.v1 - s.v0)*t/duration);
+
+                model_t::input_t u = model_t::input_t::Zero();
+                if ((t >= s.disturbance_time) && (t < s.disturbance_time + s.disturbance_duration)) {
+                    model_t::set_input_element(u, model_t::input_index_t::roll_torque,
+                            s.roll_torque_disturbance);
+                    model_t::set_input_element(u, model_t::input_index_t::steer_torque,
+                            s.steer_torque_disturbance);
+                }
+                if (bicycle.v() < assistance_velocity_limit) {
+                    u += lqr.control_calculate(bicycle.observer().state(), bicycle.v());
+                }
+
+                // The simulated bicycle uses the same discretized model.
+                x = bicycle.model().update_state(x, u);
+                const real_t yaw_angle = model_t::get_state_element(x, model_t::state_index_t::yaw_angle);
+                const real_t steer_angle = model_t::get_state_element(x, model_t::state_index_t::steer_angle) +
+                    steer_noise(gen);
+                bicycle.update_dynamics(
+                        model_t::get_input_element(u, model_t::input_index_t::roll_torque),
+                        model_t::get_input_element(u, model_t::input_index_t::steer_torque),
+                        yaw_angle, steer_angle, 0.0f);
+
+                const real_t true_roll = model_t::get_state_element(x, model_t::state_index_t::roll_angle);
+                const real_t error = true_roll - model_t::get_state_element(
+                        bicycle.observer().state(), model_t::state_index_t::roll_angle);
+                const real_t roll = std::abs(true_roll);
+                r.max_roll_angle = std::max(r.max_roll_angle, roll);
+                if (roll > settled_roll_angle) {
+                    r.settle_time = t + dt;
+                }
+                roll_sum += roll*roll;
+                error_sum += error*error;
+                if (!(roll < fallen_roll_angle)) {
+                    r.fallen = true;
+                    ++step;
+                    break;
+                }
+            }
+        } catch (const std::exception&) {
+            // state estimate is not finite
+            r.fallen = true;
+        }
+
+        if (r.fallen || (r.settle_time >= duration)) {
+            r.settle_time = std::numeric_limits<real_t>::quiet_NaN();
+        }
+        if (step > 0) {
+            r.rms_roll_angle = std::sqrt(roll_sum/step);
+            r.rms_estimate_error = std::sqrt(error_sum/step);
+        }
+        return r;
+    }
+
+    void write_results(std::ostream& os,
+            const std::vector<scenario_t>& scenarios, const std::vector<result_t>& results) {
+        os << "index,seed,v0,v1,roll_angle,steer_angle,roll_torque_disturbance,"
+            "steer_torque_disturbance,disturbance_time,steer_measurement_noise,"
+            "fallen,max_roll_angle,settle_time,rms_roll_angle,rms_estimate_error\n";
+        for (size_t i = 0; i < scenarios.size(); ++i) {
+            const scenario_t& s = scenarios[i];
+            const result_t& r = results[i];
+            os << i << ',' << s.seed << ',' << s.v0 << ',' << s.v1 << ','
+                << s.roll_angle << ',' << s.steer_angle << ','
+                << s.roll_torque_disturbance << ',' << s.steer_torque_disturbance << ','
+                << s.disturbance_time << ',' << s.steer_measurement_noise << ','
+                << r.fallen << ',' << r.max_roll_angle << ',' << r.settle_time << ','
+                << r.rms_roll_angle << ',' << r.rms_estimate_error << '\n';
+        }
+    }
+
+    // Print count, mean, 50th, 95th percentile and maximum of values.
+    void print_statistics(const char* name, std::vector<real_t> values) {
+        if (values.empty()) {
+            std::printf("%-24s %8d\n", name, 0);
+            return;
+        }
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (auto v: values) {
+            sum += v;
+        }
+        const size_t n = values.size();
+        std::printf("%-24s %8zu %12.6f %12.6f %12.6f %12.6f\n", name, n, sum/n,
+                values[(n - 1)/2], values[(n - 1)*95/100], values.back());
+    }
+
+    void print_summary(const std::vector<result_t>& results) {
+        std::vector<real_t> max_roll;
+        std::vector<real_t> settle_time;
+        std::vector<real_t> rms_roll;
+        std::vector<real_t> rms_error;
+        size_t fallen = 0;
+        for (const auto& r: results) {
+            if (r.fallen) {
+                ++fallen;
+                continue;
+            }
+            max_roll.push_back(r.max_roll_angle);
+            rms_roll.push_back(r.rms_roll_angle);
+            rms_error.push_back(r.rms_estimate_error);
+            if (!std::isnan(r.settle_time)) {
+                settle_time.push_back(r.settle_time);
+            }
+        }
+
+        std::printf("fallen: %zu of %zu\n\n", fallen, results.size());
+        std::printf("%-24s %8s %12s %12s %12s %12s\n", "(not fallen)", "count", "mean", "p50", "p95", "max");
+        print_statistics("max roll angle [rad]", max_roll);
+        print_statistics("settle time [s]", settle_time);
+        print_statistics("rms roll angle [rad]", rms_roll);
+        print_statistics("rms roll error [rad]", rms_error);
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <num_scenarios> [<duration> [<assistance_velocity_limit> [<seed> [<output_file>]]]]\n\n"
+            << "Simulate randomly generated bicycle scenarios in parallel and print summary\n"
+            << "statistics. The bicycle is simulated with sim::Bicycle and a Kalman filter\n"
+            << "observer with the flimnap settings and LQR roll and steer torque assistance.\n"
+            << " <num_scenarios>                number of scenarios\n"
+            << " <duration=10>                  scenario duration [s]\n"
+            << " <assistance_velocity_limit=1>  assistance is enabled below this speed [m/s]\n"
+            << " <seed=0>                       scenario generation seed\n"
+            << " <output_file>                  write scenario parameters and results as CSV\n"
+            << "Scenarios vary in initial roll and steer angle, speed profile, disturbance\n"
+            << "torque and steer measurement noise.\n";
+        return EXIT_FAILURE;
+    }
+
+    const size_t num_scenarios = std::strtoul(argv[1], nullptr, 10);
+    const real_t duration = (argc > 2) ? std::atof(argv[2]) : 10.0f;
+    const real_t assistance_velocity_limit = (argc > 3) ? std::atof(argv[3]) : 1.0f;
+    const uint32_t seed = (argc > 4) ? std::strtoul(argv[4], nullptr, 10) : 0;
+    if ((num_scenarios == 0) || !(duration > 0)) {
+        std::cerr << "Invalid number of scenarios or duration.\n";
+        return EXIT_FAILURE;
+    }
+
+    const sim::ModelCache<model_t, model_cache_size> cache(model_t(0.0, dt), 0.0,
+            bicycle_t::v_quantization_resolution);
+
+    std::vector<scenario_t> scenarios(num_scenarios);
+    for (size_t i = 0; i < num_scenarios; ++i) {
+        scenarios[i] = generate_scenario(seed, i);
+    }
+
+    std::vector<result_t> results(num_scenarios);
+    const auto start = std::chrono::steady_clock::now();
+    util::parallel_for(num_scenarios, 0, [&](size_t i) {
+        results[i] = simulate(scenarios[i], duration, assistance_velocity_limit, cache);
+    });
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::printf("simulated %zu scenarios of %g s in %.3f s (%.0fx real time)\n",
+            num_scenarios, duration, elapsed.count(),
+            num_scenarios*duration/elapsed.count());
+    print_summary(results);
+
+    if (argc > 5) {
+        std::ofstream output(argv[5]);
+        write_results(output, scenarios, results);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+
+/*
+ * Host replacement for the subset of the ChibiOS kernel API used by the
+ * simulation classes in projects/inc (sim::Bicycle). This allows these
+ * classes to be built natively for host simulations.
+ *
+ * System time is not simulated and is always zero. A system halt throws an
+ * exception so that a host simulation can end the current scenario instead of
+ * the process.
+ */
+
+typedef uint32_t systime_t;
+
+inline systime_t chVTGetSystemTime() {
+    return 0;
+}
+
+[[noreturn]] inline void chSysHalt(const char* reason) {
+    throw std::runtime_error(reason);
+}
@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "flimnapconf.h" // flimnap dynamics loop and observer parameters
+#include "checkpoint.h"
+#include "kalmanschedule.h"
+#include "modelcache.h"
+#include "simbicycle.h"
+// bicycle submodule imports
+#include "bicycle/whipple.h"
+#include "parameters.h"
+
+/*
+ * Prime the flimnap Kalman filter observer as done at boot by
+ * sim::Bicycle::prime_observer() and print a C++ header with the resulting
+ * checkpoint (see projects/flimnap/kalman_prime.h). The observer uses the
+ * noise covariances and sample period of flimnapconf.h and the default speed
+ * of 0 m/s. The state estimate and full state in the checkpoint are zero.
+ *
+ * The header also contains the steady-state Kalman gain schedule for the
+ * flimnap model cache, solved in double precision, so that the DARE does not
+ * need to be solved at boot.
+ */
+namespace {
+
+    using model_t = model::BicycleWhipple;
+    using observer_t = sim::ScheduledKalman<model_t, sim::SequentialMeasurementUpdate>;
+    using bicycle_t = sim::Bicycle<model_t, observer_t>;
+    using checkpoint_t = bicycle_t::checkpoint_t;
+    using model_cache_t = sim::ModelCache<model_t, flimnap::model_cache_size>;
+    using schedule_t = sim::KalmanGainSchedule<model_t, flimnap::model_cache_size>;
+    using real_t = model::real_t;
+
+    constexpr real_t dt = static_cast<real_t>(
+            flimnap::system_tick_frequency/1000*flimnap::dynamics_loop_period_ms)/
+        flimnap::system_tick_frequency;
+
+    // print a float literal that is converted to the same value
+    void print_float(real_t value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+        std::printf("%s%sf", buffer, (std::strpbrk(buffer, ".e") == nullptr) ? ".0" : "");
+    }
+
+    void print_array(const char* name, const real_t* a, size_t size, size_t columns) {
+        std::printf("constexpr float %s[%zu] = {", name, size);
+        for (size_t i = 0; i < size; ++i) {
+            std::printf("%s", (i % columns == 0) ? "\n    " : " ");
+            print_float(a[i]);
+            std::printf("%s", (i + 1 < size) ? "," : "");
+        }
+        std::printf("};\n");
+    }
+
+    void print_array_initializer(const real_t* a, size_t size) {
+        std::printf("    {");
+        for (size_t i = 0; i < size; ++i) {
+            print_float(a[i]);
+            std::printf("%s", (i + 1 < size) ? ", " : "");
+        }
+        std::printf("},\n");
+    }
+} // namespace
+
+int main() {
+    bicycle_t bicycle(0.0, dt);
+    observer_t& observer = bicycle.observer();
+    observer.set_Q(parameters::defaultvalue::kalman::Q(observer.dt())*
+            flimnap::kalman_process_noise_scale);
+    observer.set_R(flimnap::scale_covariance(parameters::defaultvalue::kalman::R,
+                flimnap::kalman_measurement_noise_scale));
+    bicycle.prime_observer();
+    observer.set_x(model_t::state_t::Zero());
+
+    checkpoint_t checkpoint;
+    bicycle.save_checkpoint(&checkpoint);
+    const observer_t::process_noise_covariance_t Q = observer.Q();
+    const observer_t::measurement_noise_covariance_t R = observer.R();
+
+    // same model cache as in the flimnap dynamics loop
+    const model_cache_t cache(model_t(0.0, dt), 0.0, bicycle_t::v_quantization_resolution);
+    const schedule_t schedule(cache, Q, R);
+    std::vector<real_t> schedule_K;
+    std::vector<real_t> schedule_P;
+    for (size_t i = 0; i < schedule_t::size(); ++i) {
+        const schedule_t::steady_state_t& s = schedule.steady_state(i);
+        schedule_K.insert(schedule_K.end(), s.K.data(), s.K.data() + s.K.size());
+        schedule_P.insert(schedule_P.end(), s.P.data(), s.P.data() + s.P.size());
+    }
+
+    std::printf("#pragma once\n");
+    std::printf("#include <cstddef>\n");
+    std::printf("#include \"checkpoint.h\"\n");
+    std::printf("#include \"bicycle/whipple.h\"\n\n");
+    std::printf("/*\n");
+    std::printf(" * Checkpoint of the flimnap Kalman filter observer after priming, for the\n");
+    std::printf(" * Whipple bicycle model at v = %.2f m/s and sample period %g s.\n",
+            checkpoint.v, checkpoint.dt);
+    std::printf(" * The checkpoint is only valid for observers with noise covariances Q and R.\n");
+    std::printf(" * The steady-state Kalman gain schedule is solved with Q and R for the\n");
+    std::printf(" * model cache of %zu speeds from %.2f m/s in steps of %.2f m/s.\n",
+            schedule_t::size(), cache.v_min(), cache.v_resolution());
+    std::printf(" * Generated with:\n");
+    std::printf(" *     tools/sim/kalmanprime\n");
+    std::printf(" */\n");
+    std::printf("#define KALMAN_PRIME_GENERATED 1\n\n");
+    std::printf("namespace kalman_prime {\n\n");
+    std::printf("// process noise covariance, column-major\n");
+    print_array("Q", Q.data(), Q.size(), Q.rows());
+    std::printf("// measurement noise covariance, column-major\n");
+    print_array("R", R.data(), R.size(), R.rows());
+    std::printf("\nconstexpr sim::BicycleCheckpoint<model::BicycleWhipple> checkpoint = {\n");
+    std::printf("    0x%08x, %u, %u,\n", checkpoint.header_format,
+            checkpoint.header_version, checkpoint.header_size);
+    std::printf("    sim::BicycleCheckpoint<model::BicycleWhipple>::observer_content_t::covariance,\n");
+    std::printf("    ");
+    print_float(checkpoint.v);
+    std::printf(", ");
+    print_float(checkpoint.dt);
+    std::printf(",\n");
+    print_array_initializer(checkpoint.full_state, checkpoint_t::full_n);
+    print_array_initializer(checkpoint.x, checkpoint_t::n);
+    print_array_initializer(checkpoint.P, checkpoint_t::n*checkpoint_t::n);
+    print_array_initializer(checkpoint.K, checkpoint_t::n*checkpoint_t::l);
+    std::printf("    0x%08x\n", checkpoint.crc);
+    std::printf("};\n\n");
+    std::printf("constexpr size_t schedule_size = %zu;\n", schedule_t::size());
+    std::printf("constexpr float schedule_v_min = ");
+    print_float(cache.v_min());
+    std::printf(";\nconstexpr float schedule_v_resolution = ");
+    print_float(cache.v_resolution());
+    std::printf(";\nconstexpr float schedule_dt = ");
+    print_float(cache.dt());
+    std::printf(";\n");
+    std::printf("// steady-state Kalman gain for each cached model, column-major\n");
+    print_array("schedule_K", schedule_K.data(), schedule_K.size(), model_t::n*model_t::l);
+    std::printf("// steady-state error covariance for each cached model, column-major\n");
+    print_array("schedule_P", schedule_P.data(), schedule_P.size(), model_t::n*model_t::n);
+    std::printf("\n");
+    std::printf("} // namespace kalman_prime\n");
+    return 0;
+}
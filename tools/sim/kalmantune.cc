@@ -0,0 +1,491 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "simulation.pb.h"
+#include "flimnapconf.h" // flimnap dynamics loop and observer parameters
+#include "saconversion.h"
+#include "mathutility.h"
+#include "kalmanschedule.h"
+#include "logreader.h"
+#include "modelcache.h"
+#include "parallel.h"
+#include "simbicycle.h"
+#include "smallmatrix.h"
+// bicycle submodule imports
+#include "bicycle/whipple.h"
+#include "parameters.h"
+
+namespace {
+
+    using model_t = model::BicycleWhipple;
+    using observer_t = sim::ScheduledKalman<model_t, sim::SequentialMeasurementUpdate>;
+    using schedule_t = sim::KalmanGainSchedule<model_t, flimnap::model_cache_size>;
+    using model_cache_t = sim::ModelCache<model_t, flimnap::model_cache_size>;
+    using bicycle_t = sim::Bicycle<model_t, observer_t>;
+    using real_t = model::real_t;
+
+    constexpr uint32_t dynamics_loop_period =
+        flimnap::system_tick_frequency/1000*flimnap::dynamics_loop_period_ms; // system ticks
+    constexpr uint32_t kalman_settle_iterations =
+        flimnap::kalman_settle_period_ms/flimnap::dynamics_loop_period_ms;
+
+    // Innovation whiteness is determined from the autocorrelation of the
+    // steer angle innovation for lags 1 to whiteness_lags.
+    constexpr size_t whiteness_lags = 20;
+
+    // Tuned parameters are the base 10 logarithm of the yaw and steer
+    // measurement noise scales relative to the process noise scale, see
+    // flimnapconf.h. Scaling Q and R by the same factor changes neither the
+    // Kalman gains nor the innovations, so the process noise scale is held at
+    // the flimnap value during the search. The absolute scale is chosen
+    // afterwards such that the normalized innovation squared (NIS) of the
+    // best candidate is consistent, see main().
+    constexpr size_t num_parameters = 2;
+    using parameter_t = std::array<double, num_parameters>;
+    const char* const parameter_names[num_parameters] = {"R yaw/Q", "R steer/Q"};
+
+    // A dynamics loop iteration of a recorded run.
+    struct sample_t {
+        float v; // quantized speed
+        float u[model_t::m]; // roll torque, steer torque
+        float z[model_t::l]; // yaw angle, steer angle
+    };
+
+    // After dropped messages, the state estimate is set to the recorded
+    // state before the sample with this index.
+    struct resync_t {
+        size_t index;
+        model_t::state_t x;
+    };
+
+    struct session_t {
+        std::string name;
+        real_t dt;
+        model_t::state_t x0;
+        std::vector<sample_t> samples;
+        std::vector<resync_t> resyncs;
+    };
+
+    // Sums over a session, combined over sessions for a candidate.
+    struct session_result_t {
+        size_t n;
+        double sum; // steer angle innovation
+        double sum_squared;
+        double sum_nis; // e[k]^2/S[k], with S the steer angle innovation variance
+        std::array<double, whiteness_lags> lagged_product; // sum of e[k]*e[k - lag]
+    };
+
+    struct result_t {
+        parameter_t p;
+        double prediction_rms; // rad, steer angle one-step prediction error
+        double whiteness; // mean Ljung-Box statistic divided by the number of lags, 1 for white innovations
+        double nis; // mean steer angle NIS, 1 for a consistent noise covariance scale
+        double cost;
+    };
+
+    model_t::state_t state_from_message(const BicycleStateMessage& pb) {
+        model_t::state_t x = model_t::state_t::Zero();
+        std::copy(pb.x, pb.x + std::min<size_t>(pb.x_count, model_t::n), x.data());
+        return x;
+    }
+
+    /*
+     * Read the samples of a flimnap run from a log. The measurements are
+     * those of the firmware: the steer angle from the encoder count and the
+     * yaw angle from the previous state. Inputs are the recorded inputs,
+     * including the LQR assistance of the recorded run.
+     */
+    bool load_session(const std::string& name, session_t* session) {
+        std::ifstream ifs(name, std::ios::binary);
+        if (!ifs) {
+            std::cerr << "Unable to open " << name << ".\n";
+            return false;
+        }
+        util::LogReader reader(ifs);
+        SimulationMessage msg;
+
+        bool found = false;
+        while (!found && reader.next(&msg)) {
+            found = msg.has_gitsha1 && msg.has_model && msg.has_kalman;
+        }
+        if (!found || !(msg.model.dt > 0)) {
+            std::cerr << "Initial message not found in " << name << ".\n";
+            return false;
+        }
+        session->name = name;
+        session->dt = msg.model.dt;
+        session->x0 = state_from_message(msg.kalman.state_estimate);
+
+        bool first = true;
+        uint32_t last_timestamp = 0;
+        real_t yaw_angle = 0.0f;
+        while (reader.next(&msg)) {
+            if (!msg.has_sensors || !msg.has_state || !msg.has_model || !msg.has_input) {
+                continue; // pose message
+            }
+            const uint32_t elapsed = msg.timestamp - last_timestamp;
+            const uint32_t iterations = (elapsed + dynamics_loop_period/2)/dynamics_loop_period;
+            last_timestamp = msg.timestamp;
+            const model_t::state_t x = state_from_message(msg.state);
+            const real_t recorded_yaw_angle = util::wrap(
+                    model_t::get_state_element(x, model_t::state_index_t::yaw_angle));
+            if (!first && (iterations > 1)) {
+                session->resyncs.push_back(resync_t{session->samples.size(), x});
+                yaw_angle = recorded_yaw_angle;
+                continue;
+            }
+            first = false;
+
+            sample_t s;
+            s.v = msg.model.v;
+            std::copy(msg.input.u, msg.input.u + model_t::m, s.u);
+            s.z[static_cast<size_t>(model_t::output_index_t::yaw_angle)] = yaw_angle;
+            s.z[static_cast<size_t>(model_t::output_index_t::steer_angle)] =
+                sa::encoder_angle<float>(msg.sensors.steer_encoder_count, sa::RLS_ROLIN_COUNTS_PER_REV);
+            session->samples.push_back(s);
+            yaw_angle = recorded_yaw_angle;
+        }
+        return true;
+    }
+
+    observer_t::process_noise_covariance_t process_noise_covariance(real_t dt) {
+        return parameters::defaultvalue::kalman::Q(dt)*flimnap::kalman_process_noise_scale;
+    }
+
+    observer_t::measurement_noise_covariance_t measurement_noise_covariance(const parameter_t& p) {
+        const std::array<real_t, model_t::l> scale = {{
+            static_cast<real_t>(flimnap::kalman_process_noise_scale*std::pow(10.0, p[0])),
+            static_cast<real_t>(flimnap::kalman_process_noise_scale*std::pow(10.0, p[1]))}};
+        return flimnap::scale_covariance(parameters::defaultvalue::kalman::R, scale);
+    }
+
+    /*
+     * Run the observer over the samples of a session with the steady-state
+     * gain schedule for a candidate, as in the flimnap dynamics loop. The
+     * error covariance is initialized with the steady-state solution at zero
+     * speed, which the firmware approximates by priming the observer.
+     */
+    session_result_t run_session(const session_t& session, const model_cache_t& cache,
+            const schedule_t& schedule, const observer_t::process_noise_covariance_t& Q,
+            const observer_t::measurement_noise_covariance_t& R) {
+        static constexpr size_t steer = static_cast<size_t>(model_t::output_index_t::steer_angle);
+
+        model_t model(cache.model(0));
+        observer_t observer(model);
+        observer.set_Q(Q);
+        observer.set_R(R);
+        observer.set_P(schedule.steady_state(0).P);
+        observer.set_gain_schedule(&schedule, kalman_settle_iterations);
+        observer.set_x(session.x0);
+
+        session_result_t r{};
+        std::array<double, whiteness_lags> history{}; // previous innovations
+        auto resync = session.resyncs.begin();
+        for (size_t k = 0; k < session.samples.size(); ++k) {
+            const sample_t& s = session.samples[k];
+            if ((resync != session.resyncs.end()) && (resync->index == k)) {
+                observer.set_x(resync->x);
+                ++resync;
+            }
+            if (s.v != model.v()) {
+                const model_t* cached_model = cache.model(s.v, session.dt);
+                if (cached_model != nullptr) {
+                    model = *cached_model;
+                } else {
+                    model.set_v_dt(s.v, session.dt);
+                }
+            }
+
+            const model_t::input_t u = (model_t::input_t() << s.u[0], s.u[1]).finished();
+            const model_t::measurement_t z = (model_t::measurement_t() << s.z[0], s.z[1]).finished();
+            const model_t::state_t x_prior = util::smallmatrix::multiply_add(
+                    model.Ad(), observer.state(), model.Bd(), u);
+            const double e = z[steer] - util::smallmatrix::row_dot(model.Cd(), static_cast<int>(steer), x_prior);
+
+            // steer angle innovation variance c (Ad P Ad' + Q) c' + R, with c
+            // the steer angle row of Cd and P the error covariance used for
+            // this update
+            const Eigen::Matrix<double, model_t::n, 1> c =
+                model.Cd().row(steer).transpose().cast<double>();
+            const Eigen::Matrix<double, model_t::n, 1> a = model.Ad().transpose().cast<double>()*c;
+            const double S = a.dot(observer.P().cast<double>()*a) +
+                c.dot(Q.cast<double>()*c) + R(steer, steer);
+            observer.update_state(u, z);
+
+            for (size_t lag = 0; lag < std::min(r.n, whiteness_lags); ++lag) {
+                r.lagged_product[lag] += e*history[(r.n - lag - 1) % whiteness_lags];
+            }
+            history[r.n % whiteness_lags] = e;
+            r.sum += e;
+            r.sum_squared += e*e;
+            r.sum_nis += e*e/S;
+            ++r.n;
+        }
+        return r;
+    }
+
+    /*
+     * Combine the session results of a candidate. The whiteness is the
+     * Ljung-Box statistic of the innovation autocorrelation divided by the
+     * number of lags and averaged over sessions. The cost is
+     *     log(prediction_rms) + whiteness_weight*log(whiteness)
+     */
+    result_t combine(const parameter_t& p, const session_result_t* sessions, size_t num_sessions,
+            double whiteness_weight) {
+        size_t n = 0;
+        double sum_squared = 0.0;
+        double sum_nis = 0.0;
+        double whiteness = 0.0;
+        size_t num_whiteness = 0;
+        for (size_t i = 0; i < num_sessions; ++i) {
+            const session_result_t& s = sessions[i];
+            n += s.n;
+            sum_squared += s.sum_squared;
+            sum_nis += s.sum_nis;
+            if (s.n <= whiteness_lags) {
+                continue;
+            }
+            const double mean = s.sum/s.n;
+            const double variance = s.sum_squared/s.n - mean*mean;
+            if (!(variance > 0)) {
+                continue;
+            }
+            double q = 0.0;
+            for (size_t lag = 0; lag < whiteness_lags; ++lag) {
+                const size_t m = s.n - lag - 1;
+                const double rho = (s.lagged_product[lag]/m - mean*mean)/variance;
+                q += rho*rho/m;
+            }
+            whiteness += s.n*(s.n + 2)*q/whiteness_lags;
+            ++num_whiteness;
+        }
+
+        result_t r;
+        r.p = p;
+        r.prediction_rms = (n > 0) ? std::sqrt(sum_squared/n) : 0.0;
+        r.whiteness = (num_whiteness > 0) ? whiteness/num_whiteness : 1.0;
+        r.nis = (n > 0) ? sum_nis/n : 1.0;
+        r.cost = std::log(r.prediction_rms) + whiteness_weight*std::log(r.whiteness);
+        if (!std::isfinite(r.cost)) {
+            r.cost = std::numeric_limits<double>::infinity();
+        }
+        return r;
+    }
+
+    /*
+     * Evaluate candidates on all sessions. Gain schedules are determined for
+     * each candidate in parallel, then each candidate and session pair is
+     * run in parallel.
+     */
+    std::vector<result_t> evaluate(const std::vector<parameter_t>& candidates,
+            const std::vector<session_t>& sessions, const model_cache_t& cache,
+            double whiteness_weight) {
+        const observer_t::process_noise_covariance_t Q = process_noise_covariance(cache.dt());
+        std::vector<std::unique_ptr<schedule_t>> schedules(candidates.size());
+        util::parallel_for(candidates.size(), 0, [&](size_t i) {
+            schedules[i].reset(new schedule_t(cache, Q,
+                        measurement_noise_covariance(candidates[i])));
+        });
+
+        std::vector<session_result_t> session_results(candidates.size()*sessions.size());
+        util::parallel_for(session_results.size(), 0, [&](size_t k) {
+            const size_t i = k/sessions.size();
+            session_results[k] = run_session(sessions[k % sessions.size()], cache, *schedules[i],
+                    Q, measurement_noise_covariance(candidates[i]));
+        });
+
+        std::vector<result_t> results;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            results.push_back(combine(candidates[i], &session_results[i*sessions.size()],
+                        sessions.size(), whiteness_weight));
+        }
+        return results;
+    }
+
+    // Grid of grid_size values per parameter, centered at center with
+    // spacing step (in decades).
+    std::vector<parameter_t> grid(const parameter_t& center, double step, int grid_size) {
+        std::vector<parameter_t> candidates;
+        const int half = grid_size/2;
+        parameter_t p;
+        for (int i = 0; i < grid_size; ++i) {
+            p[0] = center[0] + (i - half)*step;
+            for (int j = 0; j < grid_size; ++j) {
+                p[1] = center[1] + (j - half)*step;
+                candidates.push_back(p);
+            }
+        }
+        return candidates;
+    }
+
+    /*
+     * Coordinate descent from the best grid point. Each iteration evaluates
+     * a step up and down for every parameter in parallel and moves to the
+     * best improvement. The step is halved if there is no improvement.
+     */
+    result_t coordinate_descent(result_t best, double step, double min_step,
+            const std::vector<session_t>& sessions, const model_cache_t& cache,
+            double whiteness_weight, std::vector<result_t>* evaluated) {
+        while (step >= min_step) {
+            std::vector<parameter_t> candidates;
+            for (size_t i = 0; i < num_parameters; ++i) {
+                for (double direction: {-1.0, 1.0}) {
+                    parameter_t p = best.p;
+                    p[i] += direction*step;
+                    candidates.push_back(p);
+                }
+            }
+            const std::vector<result_t> results = evaluate(candidates, sessions, cache, whiteness_weight);
+            evaluated->insert(evaluated->end(), results.begin(), results.end());
+            const auto it = std::min_element(results.begin(), results.end(),
+                    [](const result_t& a, const result_t& b) { return a.cost < b.cost; });
+            if (it->cost < best.cost) {
+                best = *it;
+            } else {
+                step /= 2;
+            }
+        }
+        return best;
+    }
+
+    // Sort results by cost and remove candidates evaluated more than once,
+    // as coordinate descent may return to a previous candidate.
+    void rank(std::vector<result_t>* results) {
+        std::sort(results->begin(), results->end(),
+                [](const result_t& a, const result_t& b) {
+                    return (a.cost < b.cost) || ((a.cost == b.cost) && (a.p < b.p));
+                });
+        results->erase(std::unique(results->begin(), results->end(),
+                    [](const result_t& a, const result_t& b) {
+                        for (size_t i = 0; i < num_parameters; ++i) {
+                            if (std::abs(a.p[i] - b.p[i]) > 1e-9) {
+                                return false;
+                            }
+                        }
+                        return true;
+                    }), results->end());
+    }
+
+    void print_result(const char* label, const result_t& r) {
+        std::printf("%-8s", label);
+        for (auto p: r.p) {
+            std::printf(" %14.4g", std::pow(10.0, p));
+        }
+        std::printf(" %14.6g %12.4g %12.4g %12.6f\n", r.prediction_rms, r.nis, r.whiteness, r.cost);
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <log_file>...\n\n"
+            << "Tune the Kalman filter process and measurement noise covariances of the\n"
+            << "flimnap observer with recorded runs. The recorded measurements and inputs are\n"
+            << "fed through the observer (sim::ScheduledKalman, as used by the firmware) for\n"
+            << "candidate measurement noise covariance scale factors, relative to the bicycle\n"
+            << "submodule defaults and the process noise scale. Scaling both covariances by\n"
+            << "the same factor does not change the gains, so only the two ratios are\n"
+            << "searched. Candidates are scored by the steer angle one-step prediction error\n"
+            << "and the whiteness of the steer angle innovation:\n"
+            << "    cost = log(prediction rms) + w*log(whiteness)\n"
+            << "where the whiteness is the Ljung-Box statistic of the innovation divided by\n"
+            << "the number of lags (1 for white innovations). The search evaluates a grid\n"
+            << "centered at the current flimnap values, followed by coordinate descent.\n"
+            << "The absolute scale of the best candidate is set such that the mean\n"
+            << "normalized innovation squared (NIS) of the steer angle is 1.\n"
+            << "Sessions and candidates are run in parallel on all hardware threads.\n\n"
+            << "Environment variables:\n"
+            << " KALMANTUNE_WHITENESS_WEIGHT=1   whiteness weight w\n"
+            << " KALMANTUNE_GRID_SIZE=5          grid points per parameter\n"
+            << " KALMANTUNE_GRID_STEP=1          grid spacing [decades]\n\n"
+            << "Prints a ranked table of candidates and the flimnapconf.h constants of the\n"
+            << "best candidate.\n";
+        return EXIT_FAILURE;
+    }
+
+    auto getenv_or = [](const char* name, double value) {
+        const char* s = std::getenv(name);
+        return (s != nullptr) ? std::atof(s) : value;
+    };
+    const double whiteness_weight = getenv_or("KALMANTUNE_WHITENESS_WEIGHT", 1.0);
+    const int grid_size = static_cast<int>(getenv_or("KALMANTUNE_GRID_SIZE", 5));
+    const double grid_step = getenv_or("KALMANTUNE_GRID_STEP", 1.0);
+    if ((grid_size < 1) || !(grid_step > 0)) {
+        std::cerr << "Invalid grid size or spacing.\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<session_t> sessions(argc - 1);
+    std::vector<char> loaded(sessions.size());
+    util::parallel_for(sessions.size(), 0, [&](size_t i) {
+        loaded[i] = load_session(argv[i + 1], &sessions[i]);
+    });
+    size_t num_samples = 0;
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        if (!loaded[i]) {
+            return EXIT_FAILURE;
+        }
+        if (sessions[i].dt != sessions[0].dt) {
+            std::cerr << "Sample period of " << sessions[i].name << " differs from "
+                << sessions[0].name << ".\n";
+            return EXIT_FAILURE;
+        }
+        num_samples += sessions[i].samples.size();
+    }
+    const real_t dt = sessions[0].dt;
+    std::printf("loaded %zu sessions, %zu samples (%.1f s)\n",
+            sessions.size(), num_samples, num_samples*dt);
+
+    const model_cache_t cache(model_t(0.0, dt), 0.0, bicycle_t::v_quantization_resolution);
+
+    const double q_scale = flimnap::kalman_process_noise_scale;
+    const parameter_t current = {{
+        std::log10(flimnap::kalman_measurement_noise_scale[0]/q_scale),
+        std::log10(flimnap::kalman_measurement_noise_scale[1]/q_scale)}};
+
+    std::vector<parameter_t> candidates = grid(current, grid_step, grid_size);
+    candidates.push_back(current);
+    std::vector<result_t> results = evaluate(candidates, sessions, cache, whiteness_weight);
+    const result_t current_result = results.back();
+    results.pop_back();
+
+    const result_t grid_best = *std::min_element(results.begin(), results.end(),
+            [](const result_t& a, const result_t& b) { return a.cost < b.cost; });
+    const result_t best = coordinate_descent(grid_best, grid_step/2, 0.05,
+            sessions, cache, whiteness_weight, &results);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const size_t num_evaluated = results.size() + 1;
+    rank(&results);
+    std::printf("evaluated %zu candidates (%zu distinct) in %.1f s\n\n",
+            num_evaluated, results.size(), elapsed.count());
+    std::printf("%-8s %14s %14s %14s %12s %12s %12s\n", "rank", parameter_names[0],
+            parameter_names[1], "pred rms [rad]", "NIS", "whiteness", "cost");
+    print_result("current", current_result);
+    const size_t num_ranked = std::min<size_t>(results.size(), 20);
+    for (size_t i = 0; i < num_ranked; ++i) {
+        char label[24];
+        std::snprintf(label, sizeof(label), "%zu", i + 1);
+        print_result(label, results[i]);
+    }
+
+    // Scaling Q and R by c scales the innovation variance by c and the mean
+    // NIS by 1/c, the consistent scale is the mean NIS of the best candidate.
+    const double scale = q_scale*best.nis;
+    std::printf("\n// projects/flimnap/flimnapconf.h\n");
+    std::printf("constexpr float kalman_process_noise_scale = %.6gf;\n", scale);
+    std::printf("constexpr float kalman_measurement_noise_scale[] = {%.6gf, %.6gf};\n",
+            scale*std::pow(10.0, best.p[0]), scale*std::pow(10.0, best.p[1]));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <vector>
+#include <pb_decode.h>
+#include "cobs.h"
+#include "simulation.pb.h"
+
+namespace util {
+
+/*
+ * Reads a log written by seriallog: a stream of COBS encoded frames, each
+ * containing a varint length delimited SimulationMessage. Frames that
+ * cannot be decoded are counted and skipped.
+ */
+class LogReader {
+    public:
+        explicit LogReader(std::istream& is) :
+            m_is(is), m_buffer(buffer_capacity), m_begin(0), m_end(0),
+            m_decode_errors(0), m_bytes_read(0) { }
+
+        // Returns false at the end of the stream.
+        bool next(SimulationMessage* msg) {
+            std::array<uint8_t, packet_capacity> packet;
+            while (true) {
+                const cobs::DecodeResult result = cobs::decode(
+                        m_buffer.data() + m_begin, m_end - m_begin,
+                        packet.data(), packet.size());
+                switch (result.status) {
+                    case cobs::DecodeResult::Status::OK: {
+                        m_begin += result.consumed;
+                        pb_istream_t stream = pb_istream_from_buffer(packet.data(), result.produced);
+                        *msg = SimulationMessage_init_zero;
+                        if (pb_decode_delimited(&stream, SimulationMessage_fields, msg)) {
+                            return true;
+                        }
+                        ++m_decode_errors;
+                        continue;
+                    }
+                    case cobs::DecodeResult::Status::UNEXPECTED_ZERO:
+                    case cobs::DecodeResult::Status::WRITE_OVERFLOW: {
+                        m_begin += std::max<size_t>(result.consumed, 1);
+                        ++m_decode_errors;
+                        continue;
+                    }
+                    case cobs::DecodeResult::Status::READ_OVERFLOW:
+                    default: {
+                        // The frame is not complete, read more data.
+                        if (!fill()) {
+                            return false;
+                        }
+                        continue;
+                    }
+                }
+            }
+        }
+
+        size_t decode_errors() const {
+            return m_decode_errors;
+        }
+
+        size_t bytes_read() const {
+            return m_bytes_read;
+        }
+
+    private:
+        static constexpr size_t buffer_capacity = 1 << 16;
+        static constexpr size_t packet_capacity = 2000;
+
+        bool fill() {
+            // Shove remaining bytes to the beginning of the buffer.
+            std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+            if (m_end == m_buffer.size()) {
+                // A frame that does not fit in the buffer is not valid.
+                m_end = 0;
+                ++m_decode_errors;
+            }
+            m_is.read(reinterpret_cast<char*>(m_buffer.data() + m_end), m_buffer.size() - m_end);
+            const size_t n = static_cast<size_t>(m_is.gcount());
+            m_end += n;
+            m_bytes_read += n;
+            return n > 0;
+        }
+
+        std::istream& m_is;
+        std::vector<uint8_t> m_buffer;
+        size_t m_begin;
+        size_t m_end;
+        size_t m_decode_errors;
+        size_t m_bytes_read;
+};
+
+} // namespace util
@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/*
+ * Call func(i) for every i in [0, count) using num_threads threads, including
+ * the calling thread. If num_threads is 0, all hardware threads are used.
+ *
+ * The indices are initially split into contiguous ranges, one per thread.
+ * A thread that has finished its own range steals the upper half of the
+ * remaining range of another thread. Work is then balanced when the cost of
+ * func(i) varies, while threads only contend on a range when stealing.
+ */
+template <typename Function>
+void parallel_for(size_t count, size_t num_threads, Function func) {
+    struct range_t {
+        std::mutex mutex;
+        size_t begin;
+        size_t end;
+    };
+
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::max<size_t>(1, std::min(num_threads, count));
+
+    std::unique_ptr<range_t[]> ranges(new range_t[num_threads]);
+    for (size_t t = 0; t < num_threads; ++t) {
+        ranges[t].begin = count*t/num_threads;
+        ranges[t].end = count*(t + 1)/num_threads;
+    }
+
+    auto steal = [&](size_t thief) {
+        for (size_t k = 1; k < num_threads; ++k) {
+            range_t& victim = ranges[(thief + k) % num_threads];
+            size_t begin;
+            size_t end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                const size_t remaining = victim.end - victim.begin;
+                if (remaining == 0) {
+                    continue;
+                }
+                end = victim.end;
+                begin = end - (remaining + 1)/2;
+                victim.end = begin;
+            }
+            std::lock_guard<std::mutex> lock(ranges[thief].mutex);
+            ranges[thief].begin = begin;
+            ranges[thief].end = end;
+            return true;
+        }
+        return false;
+    };
+
+    auto worker = [&](size_t t) {
+        range_t& own = ranges[t];
+        while (true) {
+            size_t i = 0;
+            bool has_work = false;
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (own.begin < own.end) {
+                    i = own.begin++;
+                    has_work = true;
+                }
+            }
+            if (has_work) {
+                func(i);
+            } else if (!steal(t)) {
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& thread: threads) {
+        thread.join();
+    }
+}
+
+} // namespace util
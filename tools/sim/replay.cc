@@ -0,0 +1,442 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "simulation.pb.h"
+#include "flimnapconf.h" // flimnap dynamics loop parameters
+#include "lqr_gain.h" // flimnap LQR feedback gain table
+#include "saconversion.h"
+#include "mathutility.h"
+#include "haptic.h"
+#include "kalmanschedule.h"
+#include "logreader.h"
+#include "lqrassistance.h"
+#include "modelcache.h"
+#include "scheduled_lqr.h"
+#include "simbicycle.h"
+// bicycle submodule imports
+#include "bicycle/whipple.h"
+#include "parameters.h"
+
+namespace {
+
+    using model_t = model::BicycleWhipple;
+    using observer_t = sim::ScheduledKalman<model_t, sim::SequentialMeasurementUpdate>;
+    using bicycle_t = sim::Bicycle<model_t, observer_t>;
+    using lqr_t = controller::ScheduledLqr<model_t, lqr_gain::size>;
+    using assistance_t = controller::FadedAssistance<lqr_t>;
+    using schedule_t = sim::KalmanGainSchedule<model_t, flimnap::model_cache_size>;
+    using model_cache_t = sim::ModelCache<model_t, flimnap::model_cache_size>;
+    using real_t = model::real_t;
+    // backup SRAM layout of the flimnap checkpoint, see projects/flimnap/main.cc
+    using backup_checkpoint_t = sim::VersionedCheckpoint<bicycle_t::checkpoint_t>;
+
+    constexpr uint32_t dynamics_loop_period =
+        flimnap::system_tick_frequency/1000*flimnap::dynamics_loop_period_ms; // system ticks
+
+    template <size_t N>
+    struct comparison_t {
+        size_t exact; // number of samples where all elements are bitwise equal
+        std::array<double, N> max_error; // maximum absolute difference per element
+
+        comparison_t() : exact(0) {
+            max_error.fill(0.0);
+        }
+
+        // Returns true if all elements are equal.
+        template <typename T, typename U>
+        bool add(const T& recorded, const U& replayed) {
+            bool equal = true;
+            for (size_t i = 0; i < N; ++i) {
+                equal &= (recorded[i] == replayed[i]);
+                const double error = std::abs(static_cast<double>(recorded[i]) -
+                                              static_cast<double>(replayed[i]));
+                max_error[i] = std::max(max_error[i], error);
+            }
+            exact += equal;
+            return equal;
+        }
+    };
+
+    struct statistics_t {
+        size_t messages;
+        size_t iterations; // replayed and compared
+        size_t resyncs; // observer resynchronizations after dropped messages
+        size_t dropped; // dropped dynamics loop iterations
+        size_t first_divergence; // iteration index, SIZE_MAX if none
+        uint32_t first_divergence_timestamp;
+        comparison_t<model_t::n> state;
+        comparison_t<model_t::m> input;
+        comparison_t<1> actuator;
+        comparison_t<2> position; // auxiliary state x, y
+    };
+
+    model_t::state_t state_from_message(const BicycleStateMessage& pb) {
+        model_t::state_t x = model_t::state_t::Zero();
+        std::copy(pb.x, pb.x + std::min<size_t>(pb.x_count, model_t::n), x.data());
+        return x;
+    }
+
+    // Inverse of message::set_symmetric_state_matrix(), packed columns of
+    // the lower triangle.
+    observer_t::process_noise_covariance_t
+    symmetric_from_message(const SymmetricStateMatrixMessage& pb) {
+        observer_t::process_noise_covariance_t m;
+        size_t k = 0;
+        for (int j = 0; j < m.cols(); ++j) {
+            for (int i = j; i < m.rows(); ++i) {
+                m(i, j) = pb.m[k++];
+                m(j, i) = m(i, j);
+            }
+        }
+        return m;
+    }
+
+    observer_t::measurement_noise_covariance_t
+    symmetric_from_message(const SymmetricOutputMatrixMessage& pb) {
+        observer_t::measurement_noise_covariance_t m;
+        m << pb.m[0], pb.m[1],
+             pb.m[1], pb.m[2];
+        return m;
+    }
+
+    /*
+     * Replay of the flimnap dynamics loop (projects/flimnap/main.cc) with the
+     * default configuration: Whipple model, scheduled Kalman filter with
+     * sequential measurement update, LQR assistance and handlebar inertia
+     * compensation. Each iteration uses the recorded sensor samples and
+     * speed instead of the sensors.
+     *
+     * The pitch angle and rear wheel angle of the full state are merged by
+     * the pose thread asynchronously and are not replayed. These do not
+     * affect the dynamic state.
+     *
+     * The observer is primed as at boot, unless the checkpoint restored by
+     * the firmware is given. The full state, including the yaw angle, and
+     * the observer error covariance are then restored from the checkpoint.
+     */
+    class Replay {
+        public:
+            Replay(const SimulationMessage& initial, const bicycle_t::checkpoint_t* checkpoint) :
+                m_dt(initial.model.dt),
+                m_model_cache(model_t(0.0, m_dt), 0.0, bicycle_t::v_quantization_resolution),
+                m_bicycle(0.0, m_dt),
+                m_controller(lqr_gain::K, lqr_gain::v_min, lqr_gain::v_max),
+                m_assistance(m_controller, flimnap::assistance_velocity_limit,
+                        flimnap::assistance_fade_period_ms/flimnap::dynamics_loop_period_ms),
+                m_handlebar_model(m_bicycle.model(), sa::UPPER_ASSEMBLY_INERTIA_PHYSICAL),
+                m_yaw_angle(0.0f),
+                m_x(model_t::state_t::Zero()),
+                m_u(model_t::input_t::Zero()),
+                m_dac(sa::DAC_HALF_RANGE) {
+                m_bicycle.set_model_cache(&m_model_cache);
+
+                // Use the noise covariances of the recorded run, if available.
+                observer_t& observer = m_bicycle.observer();
+                if (initial.kalman.has_process_noise_covariance &&
+                    initial.kalman.has_measurement_noise_covariance) {
+                    observer.set_Q(symmetric_from_message(initial.kalman.process_noise_covariance));
+                    observer.set_R(symmetric_from_message(initial.kalman.measurement_noise_covariance));
+                } else {
+                    observer.set_Q(parameters::defaultvalue::kalman::Q(observer.dt())*
+                            flimnap::kalman_process_noise_scale);
+                    observer.set_R(flimnap::scale_covariance(parameters::defaultvalue::kalman::R,
+                                flimnap::kalman_measurement_noise_scale));
+                }
+                if (checkpoint != nullptr) {
+                    m_bicycle.restore_checkpoint(*checkpoint);
+                    m_x = model_t::get_state_part(m_bicycle.full_state());
+                    m_yaw_angle = util::wrap(model_t::get_full_state_element(
+                                m_bicycle.full_state(), model_t::full_state_index_t::yaw_angle));
+                } else {
+                    m_bicycle.prime_observer();
+                }
+
+                // Logs recorded before the initial state estimate was
+                // transmitted start with a zero state estimate. After a
+                // restored checkpoint, the initial state estimate contains the
+                // steer angle measured at startup.
+                observer.set_x(state_from_message(initial.kalman.state_estimate));
+
+                m_schedule.reset(new schedule_t(m_model_cache, observer.Q(), observer.R()));
+                observer.set_gain_schedule(m_schedule.get(),
+                        flimnap::kalman_settle_period_ms/flimnap::dynamics_loop_period_ms);
+            }
+
+            real_t dt() const {
+                return m_dt;
+            }
+
+            // Replay a single dynamics loop iteration with the sensor samples
+            // and speed of msg.
+            void step(const SimulationMessage& msg) {
+                const SensorMessage& sensors = msg.sensors;
+                const float kistler_torque = sa::adc_to_nm(sensors.kistler_measured_torque,
+                        sa::KISTLER_ADC_ZERO_OFFSET, sa::MAX_KISTLER_TORQUE);
+                const float steer_angle = sa::encoder_angle<float>(sensors.steer_encoder_count,
+                        sa::RLS_ROLIN_COUNTS_PER_REV);
+                const float rear_wheel_angle = util::wrap(-sa::encoder_angle<float>(
+                            sensors.rear_wheel_encoder_count, sa::RLS_GTS35_COUNTS_PER_REV));
+
+                const float inertia_torque = -m_handlebar_model.torque(m_x);
+                float roll_torque = 0.0f;
+                float steer_torque = kistler_torque - inertia_torque;
+
+                // The recorded speed is already quantized and does not change
+                // when quantized again.
+                m_bicycle.set_v(msg.model.v);
+                model_t::input_t u;
+                if (m_assistance.control_calculate(m_bicycle.observer().state(), m_bicycle.v(), &u)) {
+                    roll_torque += model_t::get_input_element(u, model_t::input_index_t::roll_torque);
+                    steer_torque += model_t::get_input_element(u, model_t::input_index_t::steer_torque);
+                }
+                m_bicycle.update_dynamics_state(roll_torque, steer_torque,
+                        m_yaw_angle, steer_angle, rear_wheel_angle);
+
+                const float desired_velocity = model_t::get_full_state_element(
+                        m_bicycle.full_state(), model_t::full_state_index_t::steer_rate);
+                m_dac = sa::reference_to_dac(desired_velocity, sa::MAX_KOLLMORGEN_VELOCITY);
+                m_bicycle.update_observer_covariance();
+
+                m_u = (model_t::input_t() << roll_torque, steer_torque).finished();
+                m_x = model_t::get_state_part(m_bicycle.full_state());
+                m_yaw_angle = util::wrap(model_t::get_full_state_element(
+                            m_bicycle.full_state(), model_t::full_state_index_t::yaw_angle));
+            }
+
+            // Continue from the recorded state of msg after messages have
+            // been dropped.
+            void resync(const SimulationMessage& msg) {
+                m_x = state_from_message(msg.state);
+                m_bicycle.set_v(msg.model.v);
+                m_bicycle.observer().set_x(m_x);
+                m_yaw_angle = util::wrap(model_t::get_state_element(
+                            m_x, model_t::state_index_t::yaw_angle));
+            }
+
+            const model_t::state_t& state() const {
+                return m_x;
+            }
+
+            const model_t::input_t& input() const {
+                return m_u;
+            }
+
+            uint16_t actuator() const {
+                return m_dac;
+            }
+
+            model_t::auxiliary_state_t auxiliary_state() const {
+                return model_t::get_auxiliary_state_part(m_bicycle.full_state());
+            }
+
+        private:
+            const real_t m_dt;
+            const model_cache_t m_model_cache;
+            bicycle_t m_bicycle;
+            lqr_t m_controller;
+            assistance_t m_assistance;
+            haptic::HandlebarDynamic m_handlebar_model;
+            std::unique_ptr<schedule_t> m_schedule;
+            real_t m_yaw_angle; // yaw angle measurement of the next iteration
+            model_t::state_t m_x; // state part of the full state of the previous iteration
+            model_t::input_t m_u;
+            uint16_t m_dac;
+    };
+
+    void write_csv_header(std::ostream& os) {
+        os << "timestamp";
+        for (const char* source: {"recorded", "replayed"}) {
+            for (unsigned int i = 0; i < model_t::n; ++i) {
+                os << ",x" << i << '_' << source;
+            }
+            for (unsigned int i = 0; i < model_t::m; ++i) {
+                os << ",u" << i << '_' << source;
+            }
+            os << ",dac_" << source;
+        }
+        os << '\n';
+    }
+
+    void write_csv_row(std::ostream& os, const SimulationMessage& msg, const Replay& replay) {
+        os << msg.timestamp;
+        for (unsigned int i = 0; i < model_t::n; ++i) {
+            os << ',' << msg.state.x[i];
+        }
+        for (unsigned int i = 0; i < model_t::m; ++i) {
+            os << ',' << msg.input.u[i];
+        }
+        os << ',' << msg.actuators.kollmorgen_command_velocity;
+        for (unsigned int i = 0; i < model_t::n; ++i) {
+            os << ',' << replay.state()[i];
+        }
+        for (unsigned int i = 0; i < model_t::m; ++i) {
+            os << ',' << replay.input()[i];
+        }
+        os << ',' << replay.actuator() << '\n';
+    }
+
+    template <size_t N>
+    void print_comparison(const char* name, const comparison_t<N>& c, size_t n) {
+        std::printf("%-12s %10zu/%zu", name, c.exact, n);
+        for (auto e: c.max_error) {
+            std::printf(" %12.4g", e);
+        }
+        std::printf("\n");
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const char* program = argv[0];
+    const char* checkpoint_file = nullptr;
+    if ((argc > 2) && (std::strcmp(argv[1], "--checkpoint") == 0)) {
+        checkpoint_file = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc < 2) {
+        std::cerr << "Usage: " << program << " [--checkpoint <sram_file>] <log_file> [<output_file>]\n\n"
+            << "Replay a log of a flimnap run recorded with seriallog. The recorded sensor\n"
+            << "samples and speed are used as input for the flimnap dynamics loop\n"
+            << "(sim::Bicycle with the scheduled Kalman filter, LQR assistance and handlebar\n"
+            << "inertia compensation) and the resulting state, input and handlebar reference\n"
+            << "are compared with the recorded values.\n"
+            << " --checkpoint <sram_file>\n"
+            << "                      start from the checkpoint restored by the firmware,\n"
+            << "                      read from a dump of the backup SRAM, instead of a\n"
+            << "                      primed observer\n"
+            << " <log_file>           serialized protobuf stream data\n"
+            << " <output_file>        write recorded and replayed values as CSV\n\n"
+            << "The log must start with the initial message of the firmware. If messages\n"
+            << "were dropped, the observer continues from the next recorded state. Returns\n"
+            << "a non-zero exit status if any replayed value differs from the recorded value.\n";
+        return EXIT_FAILURE;
+    }
+
+    backup_checkpoint_t backup;
+    if (checkpoint_file != nullptr) {
+        std::ifstream cfs(checkpoint_file, std::ios::binary);
+        if (!cfs.read(reinterpret_cast<char*>(&backup), sizeof(backup))) {
+            std::cerr << "Unable to read checkpoint from " << checkpoint_file << ".\n";
+            return EXIT_FAILURE;
+        }
+        if (!backup.checkpoint.valid()) {
+            std::cerr << "Invalid checkpoint in " << checkpoint_file << ".\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ifstream ifs(argv[1], std::ios::binary);
+    if (!ifs) {
+        std::cerr << "Unable to open " << argv[1] << ".\n";
+        return EXIT_FAILURE;
+    }
+    std::ofstream csv;
+    if (argc > 2) {
+        csv.open(argv[2]);
+        write_csv_header(csv);
+    }
+
+    util::LogReader reader(ifs);
+    SimulationMessage msg;
+    statistics_t s{};
+    const auto start = std::chrono::steady_clock::now();
+
+    // The initial message contains the firmware version, model and observer.
+    bool found = false;
+    while (!found && reader.next(&msg)) {
+        ++s.messages;
+        found = msg.has_gitsha1 && msg.has_model && msg.has_kalman;
+    }
+    if (!found) {
+        std::cerr << "Initial message not found.\n";
+        return EXIT_FAILURE;
+    }
+    std::printf("firmware gitsha1: %.*s\n", static_cast<int>(sizeof(msg.gitsha1.f)),
+            reinterpret_cast<const char*>(msg.gitsha1.f));
+    if (!(msg.model.dt > 0)) {
+        std::cerr << "Invalid sample period in initial message.\n";
+        return EXIT_FAILURE;
+    }
+    if (checkpoint_file != nullptr) {
+        if (std::memcmp(backup.tag, msg.gitsha1.f, sizeof(backup.tag)) != 0) {
+            std::cerr << "Checkpoint has been saved by firmware " <<
+                std::string(backup.tag, sizeof(backup.tag)) << ".\n";
+            return EXIT_FAILURE;
+        }
+        std::printf("restored checkpoint: v = %g m/s\n", backup.checkpoint.v);
+    }
+    Replay replay(msg, (checkpoint_file != nullptr) ? &backup.checkpoint : nullptr);
+
+    bool first = true;
+    uint32_t last_timestamp = 0;
+    s.first_divergence = std::numeric_limits<size_t>::max();
+    while (reader.next(&msg)) {
+        ++s.messages;
+        if (!msg.has_sensors || !msg.has_state || !msg.has_model) {
+            continue; // pose message
+        }
+
+        const uint32_t elapsed = msg.timestamp - last_timestamp;
+        const uint32_t iterations = (elapsed + dynamics_loop_period/2)/dynamics_loop_period;
+        last_timestamp = msg.timestamp;
+        if (!first && (iterations > 1)) {
+            s.dropped += iterations - 1;
+            ++s.resyncs;
+            replay.resync(msg);
+            continue;
+        }
+        first = false;
+
+        replay.step(msg);
+        bool equal = s.state.add(msg.state.x, replay.state());
+        equal &= s.input.add(msg.input.u, replay.input());
+        const std::array<uint16_t, 1> dac = {{replay.actuator()}};
+        const std::array<uint32_t, 1> recorded_dac = {{msg.actuators.kollmorgen_command_velocity}};
+        equal &= s.actuator.add(recorded_dac, dac);
+        if (msg.has_auxiliary_state) {
+            s.position.add(msg.auxiliary_state.x, replay.auxiliary_state());
+        }
+        if (!equal && (s.first_divergence > s.iterations)) {
+            s.first_divergence = s.iterations;
+            s.first_divergence_timestamp = msg.timestamp;
+        }
+        ++s.iterations;
+
+        if (csv.is_open()) {
+            write_csv_row(csv, msg, replay);
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double duration = (s.iterations + s.dropped + s.resyncs)*replay.dt();
+    std::printf("replayed %zu iterations (%.1f s) from %zu messages, %zu bytes in %.3f s "
+            "(%.0f iterations/s, %.0fx real time)\n",
+            s.iterations, duration, s.messages, reader.bytes_read(), elapsed.count(),
+            s.iterations/elapsed.count(), duration/elapsed.count());
+    std::printf("decode errors: %zu, dropped iterations: %zu, resynchronizations: %zu\n\n",
+            reader.decode_errors(), s.dropped, s.resyncs);
+    std::printf("%-12s %10s %s\n", "", "exact", "  max absolute difference per element");
+    print_comparison("state", s.state, s.iterations);
+    print_comparison("input", s.input, s.iterations);
+    print_comparison("actuator", s.actuator, s.iterations);
+    print_comparison("x, y", s.position, s.iterations);
+
+    if (s.first_divergence < s.iterations) {
+        std::printf("\nfirst difference at iteration %zu, timestamp %u\n",
+                s.first_divergence, s.first_divergence_timestamp);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
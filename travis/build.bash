@@ -23,3 +23,7 @@ if [ -d "tests" ]; then
     popd #tests
 fi
 popd #build
+
+if [ -n "$SIL_SOAK_DURATION" ]; then
+    travis/sil-soak.bash
+fi
@@ -0,0 +1,33 @@
+#!/usr/bin/env bash
+
+# Run each flimnap SIL executable as fast as possible for SIL_SOAK_DURATION
+# seconds of virtual time with the sensor script of the SIL directory, and
+# decode the serial stream with pbprint. A system halt in the firmware, a
+# decode error or an empty stream fails the build.
+
+# Stop this script when a command fails.
+set -e
+
+# Print every line after resolving variables.
+PS4="[${BASH_SOURCE}] $ "
+set -x
+
+SOAK_DIR=build/sil/soak
+mkdir --parents $SOAK_DIR
+
+for variant in whipple kinematic zero_input whipple_fixed_point; do
+    output=$SOAK_DIR/flimnap_${variant}.log
+    FLIMNAP_SIL_SOURCE=projects/flimnap/sil/steer.txt \
+        FLIMNAP_SIL_TIME_SCALE=0 \
+        FLIMNAP_SIL_DURATION=${SIL_SOAK_DURATION:-60} \
+        FLIMNAP_SIL_OUTPUT=$output \
+        build/sil/flimnap_${variant}_sil
+    test -s $output
+
+    build/tools/pbprint $output > $output.txt
+    if grep --quiet "Unexpected zero" $output.txt; then
+        echo "Corrupt frame in serial stream of flimnap_${variant}_sil"
+        exit 1
+    fi
+    build/tools/pbprint --timing $output | tail --lines=4
+done